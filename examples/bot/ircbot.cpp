@@ -31,7 +31,8 @@ IrcBot::IrcBot(QObject* parent) : IrcConnection(parent)
 
     bufferModel.setConnection(this);
 //! [channels]
-    connect(&bufferModel, SIGNAL(channelsChanged(QStringList)), &parser, SLOT(setChannels(QStringList)));
+    connect(&bufferModel, SIGNAL(channelsAdded(QStringList)), &parser, SLOT(addChannels(QStringList)));
+    connect(&bufferModel, SIGNAL(channelsRemoved(QStringList)), &parser, SLOT(removeChannels(QStringList)));
 //! [channels]
 }
 
@@ -295,7 +295,8 @@ void IrcClient::createBufferList()
     bufferList->setModel(bufferModel);
 
     // keep the command parser aware of the context
-    connect(bufferModel, SIGNAL(channelsChanged(QStringList)), parser, SLOT(setChannels(QStringList)));
+    connect(bufferModel, SIGNAL(channelsAdded(QStringList)), parser, SLOT(addChannels(QStringList)));
+    connect(bufferModel, SIGNAL(channelsRemoved(QStringList)), parser, SLOT(removeChannels(QStringList)));
 
     // keep track of the current buffer, see also onBufferActivated()
     connect(bufferList->selectionModel(), SIGNAL(currentChanged(QModelIndex,QModelIndex)), this, SLOT(onBufferActivated(QModelIndex)));
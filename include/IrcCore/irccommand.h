@@ -154,14 +154,48 @@ private:
     Q_DISABLE_COPY(IrcCommand)
 };
 
+class IRC_CORE_EXPORT IrcCommandValue
+{
+public:
+    IrcCommandValue();
+    IrcCommandValue(IrcCommand::Type type, const QStringList& parameters);
+
+    IrcCommand::Type type() const;
+    void setType(IrcCommand::Type type);
+
+    QStringList parameters() const;
+    void setParameters(const QStringList& parameters);
+
+    QByteArray encoding() const;
+    void setEncoding(const QByteArray& encoding);
+
+    QString toString() const;
+    IrcCommand* toCommand(QObject* parent = nullptr) const;
+
+    static IrcCommandValue fromCommand(const IrcCommand* command);
+
+    static IrcCommandValue createCtcpAction(const QString& target, const QString& action);
+    static IrcCommandValue createCtcpReply(const QString& target, const QString& reply);
+    static IrcCommandValue createMessage(const QString& target, const QString& message);
+    static IrcCommandValue createNotice(const QString& target, const QString& notice);
+    static IrcCommandValue createQuote(const QString& raw);
+
+private:
+    IrcCommand::Type m_type;
+    QStringList m_parameters;
+    QByteArray m_encoding;
+};
+
 #ifndef QT_NO_DEBUG_STREAM
 IRC_CORE_EXPORT QDebug operator<<(QDebug debug, IrcCommand::Type type);
 IRC_CORE_EXPORT QDebug operator<<(QDebug debug, const IrcCommand* command);
+IRC_CORE_EXPORT QDebug operator<<(QDebug debug, const IrcCommandValue& command);
 #endif // QT_NO_DEBUG_STREAM
 
 IRC_END_NAMESPACE
 
 Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcCommand*))
 Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcCommand::Type))
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcCommandValue))
 
 #endif // IRCCOMMAND_H
@@ -40,7 +40,8 @@ class IrcCommandPrivate
 public:
     IrcCommandPrivate();
 
-    QString params(int index) const;
+    static QString params(const QStringList& parameters, int index);
+    static QString toString(IrcCommand::Type type, const QStringList& parameters);
 
     IrcCommand::Type type = IrcCommand::Custom;
     QStringList parameters;
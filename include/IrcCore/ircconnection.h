@@ -41,8 +41,11 @@
 
 IRC_BEGIN_NAMESPACE
 
+class IrcReply;
 class IrcCommand;
+class IrcCommandValue;
 class IrcProtocol;
+class IrcLineHandler;
 class IrcConnectionPrivate;
 
 class IRC_CORE_EXPORT IrcConnection : public QObject
@@ -60,6 +63,7 @@ class IRC_CORE_EXPORT IrcConnection : public QObject
     Q_PROPERTY(QString displayName READ displayName WRITE setDisplayName NOTIFY displayNameChanged)
     Q_PROPERTY(QVariantMap userData READ userData WRITE setUserData NOTIFY userDataChanged)
     Q_PROPERTY(QByteArray encoding READ encoding WRITE setEncoding)
+    Q_PROPERTY(bool encodingDetectionEnabled READ isEncodingDetectionEnabled WRITE setEncodingDetectionEnabled)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(bool active READ isActive NOTIFY statusChanged)
     Q_PROPERTY(bool connected READ isConnected NOTIFY statusChanged)
@@ -72,6 +76,17 @@ class IRC_CORE_EXPORT IrcConnection : public QObject
     Q_PROPERTY(QString saslMechanism READ saslMechanism WRITE setSaslMechanism NOTIFY saslMechanismChanged)
     Q_PROPERTY(QStringList supportedSaslMechanisms READ supportedSaslMechanisms CONSTANT)
     Q_PROPERTY(QVariantMap ctcpReplies READ ctcpReplies WRITE setCtcpReplies NOTIFY ctcpRepliesChanged)
+    Q_PROPERTY(int ctcpReplyLimit READ ctcpReplyLimit WRITE setCtcpReplyLimit)
+    Q_PROPERTY(int ctcpReplyUserLimit READ ctcpReplyUserLimit WRITE setCtcpReplyUserLimit)
+    Q_PROPERTY(int ctcpReplyInterval READ ctcpReplyInterval WRITE setCtcpReplyInterval)
+    Q_PROPERTY(int droppedCtcpRequests READ droppedCtcpRequests)
+    Q_PROPERTY(bool sessionResumptionEnabled READ isSessionResumptionEnabled WRITE setSessionResumptionEnabled)
+    Q_PROPERTY(int handshakeCount READ handshakeCount NOTIFY handshakeCountChanged)
+    Q_PROPERTY(int sessionOfferCount READ sessionOfferCount NOTIFY sessionOfferCountChanged)
+    Q_PROPERTY(bool lowDelay READ isLowDelay WRITE setLowDelay)
+    Q_PROPERTY(int keepAliveInterval READ keepAliveInterval WRITE setKeepAliveInterval)
+    Q_PROPERTY(int sendBufferSize READ sendBufferSize WRITE setSendBufferSize)
+    Q_PROPERTY(int receiveBufferSize READ receiveBufferSize WRITE setReceiveBufferSize)
     Q_PROPERTY(IrcNetwork* network READ network CONSTANT)
     Q_PROPERTY(IrcProtocol* protocol READ protocol WRITE setProtocol)
     Q_ENUMS(Status)
@@ -118,6 +133,9 @@ public:
     QByteArray encoding() const;
     void setEncoding(const QByteArray& encoding);
 
+    bool isEncodingDetectionEnabled() const;
+    void setEncodingDetectionEnabled(bool enabled);
+
     enum Status {
         Inactive,
         Waiting,
@@ -152,6 +170,38 @@ public:
     QVariantMap ctcpReplies() const;
     void setCtcpReplies(const QVariantMap& replies);
 
+    int ctcpReplyLimit() const;
+    void setCtcpReplyLimit(int limit);
+
+    int ctcpReplyUserLimit() const;
+    void setCtcpReplyUserLimit(int limit);
+
+    int ctcpReplyInterval() const;
+    void setCtcpReplyInterval(int seconds);
+
+    int droppedCtcpRequests() const;
+
+    bool isSessionResumptionEnabled() const;
+    void setSessionResumptionEnabled(bool enabled);
+
+    int handshakeCount() const;
+    int sessionOfferCount() const;
+
+    bool isLowDelay() const;
+    void setLowDelay(bool enabled);
+
+    int keepAliveInterval() const;
+    void setKeepAliveInterval(int seconds);
+
+    int sendBufferSize() const;
+    void setSendBufferSize(int size);
+
+    int receiveBufferSize() const;
+    void setReceiveBufferSize(int size);
+
+    IrcLineHandler* firehose() const;
+    void setFirehose(IrcLineHandler* handler);
+
     IrcNetwork* network() const;
 
     IrcProtocol* protocol() const;
@@ -163,6 +213,8 @@ public:
     void installCommandFilter(QObject* filter);
     void removeCommandFilter(QObject* filter);
 
+    bool sendCommand(const IrcCommandValue& command);
+
     Q_INVOKABLE QByteArray saveState(int version = 0) const;
     Q_INVOKABLE bool restoreState(const QByteArray& state, int version = 0);
 
@@ -177,6 +229,8 @@ public Q_SLOTS:
     bool sendData(const QByteArray& data);
     bool sendRaw(const QString& message);
 
+    IrcReply* sendRequest(IrcCommand* command, int timeout = 30000);
+
 Q_SIGNALS:
     void connecting();
     void connected();
@@ -229,6 +283,8 @@ Q_SIGNALS:
     void userDataChanged(const QVariantMap& data);
     void reconnectDelayChanged(int seconds);
     void connectionCountChanged(int count);
+    void handshakeCountChanged(int count);
+    void sessionOfferCountChanged(int count);
     void enabledChanged(bool enabled);
     void secureChanged(bool secure);
     void saslMechanismChanged(const QString& mechanism);
@@ -251,8 +307,11 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _irc_error(QAbstractSocket::SocketError))
     Q_PRIVATE_SLOT(d_func(), void _irc_state(QAbstractSocket::SocketState))
     Q_PRIVATE_SLOT(d_func(), void _irc_sslErrors())
+    Q_PRIVATE_SLOT(d_func(), void _irc_encrypted())
+    Q_PRIVATE_SLOT(d_func(), void _irc_sessionTicket())
     Q_PRIVATE_SLOT(d_func(), void _irc_reconnect())
     Q_PRIVATE_SLOT(d_func(), void _irc_readData())
+    Q_PRIVATE_SLOT(d_func(), void _irc_finishRequests())
     Q_PRIVATE_SLOT(d_func(), void _irc_filterDestroyed(QObject*))
 };
 
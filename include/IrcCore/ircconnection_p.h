@@ -30,6 +30,7 @@
 #define IRCCONNECTION_P_H
 
 #include "ircconnection.h"
+#include "ircreply.h"
 
 #include <QSet>
 #include <QList>
@@ -37,14 +38,56 @@
 #include <QStack>
 #include <QTimer>
 #include <QString>
+#include <QPointer>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QAbstractSocket>
 
 IRC_BEGIN_NAMESPACE
 
+class IrcLineHandler;
 class IrcMessageFilter;
 class IrcCommandFilter;
 
+struct IrcCtcpBucket
+{
+    qreal tokens = 0;
+    qint64 stamp = -1;
+};
+
+struct IrcPendingRequest
+{
+    ~IrcPendingRequest() { qDeleteAll(messages); }
+
+    // all replies have finished, been aborted or deleted
+    bool isOrphaned() const
+    {
+        foreach (const QPointer<IrcReply>& reply, replies) {
+            if (reply && !reply->isFinished())
+                return false;
+        }
+        return true;
+    }
+
+    // a timeout of 0 means the maximum, so that lost replies don't pile up
+    int deadline() const
+    {
+        static const int MAX_TIMEOUT = 120000;
+        return timeout > 0 ? qMin(timeout, MAX_TIMEOUT) : MAX_TIMEOUT;
+    }
+
+    IrcCommand::Type type = IrcCommand::Custom;
+    QString target;
+    QString label;
+    QList<QPointer<IrcReply> > replies;
+    QList<IrcMessage*> messages;
+    IrcReply::Error error = IrcReply::NoError;
+    bool ended = false;
+    bool closing = false; // end of reply seen, composed messages may follow
+    int timeout = 0;
+    QElapsedTimer started;
+};
+
 class IrcConnectionPrivate
 {
     Q_DECLARE_PUBLIC(IrcConnection)
@@ -59,8 +102,11 @@ public:
     void _irc_error(QAbstractSocket::SocketError error);
     void _irc_state(QAbstractSocket::SocketState state);
     void _irc_sslErrors();
+    void _irc_encrypted();
+    void _irc_sessionTicket();
     void _irc_reconnect();
     void _irc_readData();
+    void _irc_finishRequests();
 
     void _irc_filterDestroyed(QObject* filter);
 
@@ -70,8 +116,19 @@ public:
     void setNick(const QString& nick);
     void setStatus(IrcConnection::Status status);
     void setInfo(const QHash<QString, QString>& info);
+    void prepareSession();
+    void applySocketOptions();
+    QString sessionKey() const;
 
     bool receiveMessage(IrcMessage* msg);
+    IrcPendingRequest* findRequest(IrcCommand::Type type, const QString& target) const;
+    void collectReply(IrcMessage* msg);
+    void collectLabeledReply(IrcPendingRequest* request, IrcMessage* msg);
+    void finishRequests();
+    void scheduleRequests();
+    void abortRequests(IrcReply::Error error);
+    bool hasDefaultCtcpReply(IrcPrivateMessage* request) const;
+    bool acceptCtcpRequest(const QString& nick);
     IrcCommand* createCtcpReply(IrcPrivateMessage* request);
 
     static IrcConnectionPrivate* get(const IrcConnection* connection)
@@ -81,6 +138,7 @@ public:
 
     IrcConnection* q_ptr = nullptr;
     QByteArray encoding;
+    bool encodingDetection = false;
     IrcNetwork* network = nullptr;
     IrcProtocol* protocol = nullptr;
     QAbstractSocket* socket = nullptr;
@@ -99,6 +157,23 @@ public:
     int connectionCount = 0;
     QString saslMechanism;
     QVariantMap ctcpReplies;
+    int ctcpReplyLimit = 0;
+    int ctcpReplyUserLimit = 0;
+    int ctcpReplyInterval = 10;
+    int droppedCtcpRequests = 0;
+    QElapsedTimer ctcpClock;
+    IrcCtcpBucket ctcpBucket;
+    QHash<QString, IrcCtcpBucket> ctcpUserBuckets;
+    bool sessionResumption = true;
+    QHash<QString, QByteArray> sslSessions;
+    QByteArray offeredSession;
+    int handshakeCount = 0;
+    int sessionOfferCount = 0;
+    bool lowDelay = false;
+    int keepAliveInterval = 0;
+    int sendBufferSize = 0;
+    int receiveBufferSize = 0;
+    IrcLineHandler* firehose = nullptr;
     bool enabled = true;
     IrcConnection::Status status = IrcConnection::Inactive;
     QList<QByteArray> pendingData;
@@ -106,6 +181,9 @@ public:
     QList<QObject*> messageFilters;
     QStack<QObject*> activeCommandFilters;
     QSet<int> replies;
+    QList<IrcPendingRequest*> requests;
+    QTimer requestTimer;
+    quint32 requestLabel = 0;
     bool pendingOpen = false;
     bool closed = false;
 };
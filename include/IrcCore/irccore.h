@@ -33,10 +33,14 @@
 #include "irccommand.h"
 #include "ircconnection.h"
 #include "ircglobal.h"
+#include "ircline.h"
 #include "ircmessage.h"
+#include "ircmessagering.h"
 #include "ircfilter.h"
 #include "ircnetwork.h"
+#include "ircpipe.h"
 #include "ircprotocol.h"
+#include "ircreply.h"
 
 IRC_BEGIN_NAMESPACE
 
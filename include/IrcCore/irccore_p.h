@@ -55,6 +55,26 @@ namespace IrcPrivate {
     template <typename T>
     static inline QList<T> setToList(const QSet<T> &set) { return set.toList(); }
 #endif
+
+    // folds str as the CASEMAPPING of the network does: "ascii",
+    // "strict-rfc1459" or "rfc1459", which is the default
+    static inline QString casemap(const QString& str, const QString& mapping = QString())
+    {
+        QString mapped = str.toLower();
+        if (mapping == QLatin1String("ascii"))
+            return mapped;
+        const bool strict = mapping == QLatin1String("strict-rfc1459");
+        for (int i = 0; i < mapped.length(); ++i) {
+            switch (mapped.at(i).unicode()) {
+            case '[': mapped[i] = QLatin1Char('{'); break;
+            case ']': mapped[i] = QLatin1Char('}'); break;
+            case '\\': mapped[i] = QLatin1Char('|'); break;
+            case '~': if (!strict) mapped[i] = QLatin1Char('^'); break;
+            default: break;
+            }
+        }
+        return mapped;
+    }
 }
 
 #ifndef Q_FALLTHROUGH
@@ -0,0 +1,85 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCLINE_H
+#define IRCLINE_H
+
+#include <IrcGlobal>
+#include <QtCore/qlist.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qbytearray.h>
+#include <QtCore/qvarlengtharray.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IRC_CORE_EXPORT IrcLine
+{
+public:
+    IrcLine();
+    explicit IrcLine(const QByteArray& data);
+
+    bool isValid() const;
+    QByteArray data() const;
+
+    QByteArray tags() const;
+    QByteArray tag(const QByteArray& name) const;
+
+    QByteArray prefix() const;
+    QByteArray nick() const;
+    QByteArray command() const;
+    int code() const;
+
+    int parameterCount() const;
+    QByteArray parameter(int index) const;
+    QList<QByteArray> parameters() const;
+
+private:
+    QByteArray m_data;
+    int m_tags[2];
+    int m_prefix[2];
+    int m_command[2];
+    QVarLengthArray<int, 32> m_params; // offset and length pairs
+};
+
+class IRC_CORE_EXPORT IrcLineHandler
+{
+public:
+    virtual ~IrcLineHandler() { }
+
+    virtual void lineReceived(const IrcLine& line) = 0;
+};
+
+#ifndef QT_NO_DEBUG_STREAM
+IRC_CORE_EXPORT QDebug operator<<(QDebug debug, const IrcLine& line);
+#endif // QT_NO_DEBUG_STREAM
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcLine))
+
+#endif // IRCLINE_H
@@ -61,6 +61,7 @@ class IRC_CORE_EXPORT IrcMessage : public QObject
     Q_PROPERTY(QString host READ host)
     Q_PROPERTY(QString account READ account)
     Q_PROPERTY(QStringList parameters READ parameters WRITE setParameters)
+    Q_PROPERTY(QString route READ route)
     Q_PROPERTY(QDateTime timeStamp READ timeStamp WRITE setTimeStamp)
     Q_PROPERTY(QVariantMap tags READ tags WRITE setTags)
     Q_ENUMS(Type Flag)
@@ -139,6 +140,8 @@ public:
     QString parameter(int index) const;
     void setParameter(int index, const QString& parameter);
 
+    QString route() const;
+
     virtual bool isValid() const;
 
     QDateTime timeStamp() const;
@@ -158,6 +161,9 @@ public:
     Q_INVOKABLE static IrcMessage* fromParameters(const QString& prefix, const QString& command, const QStringList& parameters, IrcConnection* connection);
     Q_INVOKABLE IrcMessage* clone(QObject *parent = nullptr) const;
 
+    Q_INVOKABLE QByteArray toBinary() const;
+    Q_INVOKABLE static IrcMessage* fromBinary(const QByteArray& data, IrcConnection* connection);
+
 protected:
     QScopedPointer<IrcMessagePrivate> d_ptr;
     Q_DECLARE_PRIVATE(IrcMessage)
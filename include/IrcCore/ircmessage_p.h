@@ -30,8 +30,10 @@
 #define IRCMESSAGE_P_H
 
 #include <QtCore/qmap.h>
+#include <QtCore/qhash.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qstring.h>
+#include <QtCore/qvector.h>
 #include <QtCore/qvariant.h>
 #include <QtCore/qbytearray.h>
 #include <QtCore/qstringlist.h>
@@ -63,16 +65,30 @@ private:
     bool null = true;
 };
 
+// a field of the line: an offset and a length
+struct IrcMessageSlice
+{
+    int pos;
+    int len;
+};
+
 class IrcMessageData
 {
 public:
     static IrcMessageData fromData(const QByteArray& data);
+    QByteArray toData() const;
 
+    QByteArray buffer; // keeps binary decoded slices alive
     QByteArray content;
     QByteArray prefix;
     QByteArray command;
     QList<QByteArray> params;
     QMap<QByteArray, QByteArray> tags;
+
+    // where the fields are in content, when parsed from it:
+    // <prefix> (without the colon), <command>, and <params>
+    int body = -1;
+    QVector<IrcMessageSlice> slices;
 };
 
 class IrcMessagePrivate
@@ -99,6 +115,11 @@ public:
     QString param(int index) const;
     void setParams(const QStringList& params);
 
+    QString route() const;
+
+    bool decodeLine() const;
+    QString field(int index) const;
+
     QVariantMap tags() const;
     void setTags(const QVariantMap& tags);
 
@@ -106,7 +127,8 @@ public:
 
     void invalidate();
 
-    static QString decode(const QByteArray& data, const QByteArray& encoding);
+    QByteArray source() const;
+    static QString decode(const QByteArray& data, const QByteArray& encoding, const QByteArray& source = QByteArray());
     static bool parsePrefix(const QString& prefix, QString* nick, QString* ident, QString* host);
 
     IrcConnection* connection = nullptr;
@@ -122,6 +144,48 @@ public:
     mutable IrcExplicitValue<QString> m_command;
     mutable IrcExplicitValue<QStringList> m_params;
     mutable IrcExplicitValue<QVariantMap> m_tags;
+    mutable IrcExplicitValue<QString> m_route;
+
+    // the line decoded at once, with the fields as slices of it
+    mutable int m_lineState = -1;
+    mutable QString m_line;
+    mutable QVector<IrcMessageSlice> m_slices;
+};
+
+class IrcBinaryWriter
+{
+public:
+    void writeMessage(const IrcMessagePrivate* msg);
+    QByteArray finish() const;
+
+private:
+    int intern(const QByteArray& str);
+    void writeString(const QByteArray& str);
+    void writeNumber(quint64 value);
+    void writeSigned(qint64 value);
+
+    QByteArray body;
+    QList<QByteArray> strings;
+    QHash<QByteArray, int> index;
+};
+
+class IrcBinaryReader
+{
+public:
+    explicit IrcBinaryReader(const QByteArray& data);
+
+    bool readHeader();
+    IrcMessage* readMessage(IrcConnection* connection, int depth = 0);
+    bool atEnd() const;
+
+private:
+    bool readString(QByteArray* str);
+    bool readNumber(quint64* value);
+    bool readSigned(qint64* value);
+
+    QByteArray buffer;
+    int pos = 0;
+    QList<QByteArray> strings;
 };
 
 IRC_END_NAMESPACE
@@ -30,6 +30,8 @@
 #define IRCMESSAGEDECODER_P_H
 
 #include <IrcGlobal>
+#include <QtCore/qhash.h>
+#include <QtCore/qmutex.h>
 #include <QtCore/qbytearray.h>
 #include <QtCore/qtextcodec.h>
 
@@ -41,16 +43,31 @@ public:
     IrcMessageDecoder();
     ~IrcMessageDecoder();
 
-    QString decode(const QByteArray& data, const QByteArray& encoding) const;
+    QString decode(const QByteArray& data, const QByteArray& encoding, const QByteArray& source = QByteArray()) const;
+
+    QByteArray learned(const QByteArray& source) const;
+    void learn(const QByteArray& source, const QByteArray& encoding) const;
 
 private:
     void initialize();
     void uninitialize();
     QByteArray codecForData(const QByteArray& data) const;
+    void learn(const QByteArray& source, QTextCodec* codec) const;
 
     struct Data {
         void* detector;
     } d;
+
+    // the legacy encodings detected per source, least recently used evicted;
+    // the decoder is shared between threads, so the cache and the detector
+    // are guarded by the mutex
+    struct Learned {
+        QTextCodec* codec;
+        quint64 used;
+    };
+    mutable QMutex mutex;
+    mutable QHash<QByteArray, Learned> cache;
+    mutable quint64 clock = 0;
 };
 
 IRC_END_NAMESPACE
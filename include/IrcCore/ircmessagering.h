@@ -0,0 +1,99 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCMESSAGERING_H
+#define IRCMESSAGERING_H
+
+#include <IrcGlobal>
+#include <QtCore/qobject.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qscopedpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcMessage;
+class IrcConnection;
+class IrcMessageRingPrivate;
+
+class IRC_CORE_EXPORT IrcMessageRing : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString key READ key)
+    Q_PROPERTY(int capacity READ capacity)
+    Q_PROPERTY(bool attached READ isAttached)
+    Q_PROPERTY(int bytesAvailable READ bytesAvailable)
+    Q_PROPERTY(int bytesFree READ bytesFree)
+    Q_PROPERTY(int overruns READ overruns)
+    Q_PROPERTY(int pollInterval READ pollInterval WRITE setPollInterval)
+    Q_PROPERTY(IrcConnection* connection READ connection WRITE setConnection)
+
+public:
+    explicit IrcMessageRing(QObject* parent = nullptr);
+    ~IrcMessageRing() override;
+
+    QString key() const;
+    int capacity() const;
+    bool isAttached() const;
+
+    bool create(const QString& key, int capacity);
+    bool attach(const QString& key);
+    void detach();
+
+    int bytesAvailable() const;
+    int bytesFree() const;
+    int overruns() const;
+
+    int pollInterval() const;
+    void setPollInterval(int msecs);
+
+    IrcConnection* connection() const;
+    void setConnection(IrcConnection* connection);
+
+    bool write(const QByteArray& data);
+    QByteArray read();
+
+    bool writeMessage(IrcMessage* message);
+    IrcMessage* readMessage(IrcConnection* connection);
+
+Q_SIGNALS:
+    void readyRead();
+
+private:
+    QScopedPointer<IrcMessageRingPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(IrcMessageRing)
+    Q_DISABLE_COPY(IrcMessageRing)
+
+    Q_PRIVATE_SLOT(d_func(), void _irc_messageReceived(IrcMessage*))
+    Q_PRIVATE_SLOT(d_func(), void _irc_poll())
+};
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcMessageRing*))
+
+#endif // IRCMESSAGERING_H
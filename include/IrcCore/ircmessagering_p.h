@@ -0,0 +1,84 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCMESSAGERING_P_H
+#define IRCMESSAGERING_P_H
+
+#include "ircmessagering.h"
+
+#include <QTimer>
+#include <QPointer>
+#include <QtCore/qatomic.h>
+#include <QSharedMemory>
+
+IRC_BEGIN_NAMESPACE
+
+// Lives at the start of the shared memory segment, followed by the data.
+// The producer only moves head and the consumer only moves tail, so the
+// counters are never written by both processes. Each counter has its own
+// cache line to keep the processes from invalidating each other's line.
+struct IrcMessageRingHeader
+{
+    QBasicAtomicInteger<quint32> magic;
+    quint32 version;
+    quint32 capacity;
+    alignas(64) QBasicAtomicInteger<quint32> head;
+    alignas(64) QBasicAtomicInteger<quint32> tail;
+    alignas(64) QBasicAtomicInteger<quint32> overruns;
+};
+
+class IrcConnection;
+
+class IrcMessageRingPrivate
+{
+    Q_DECLARE_PUBLIC(IrcMessageRing)
+
+public:
+    IrcMessageRingHeader* header() const;
+    char* data() const;
+
+    void copyIn(quint32 pos, const void* src, quint32 size);
+    void copyOut(quint32 pos, void* dst, quint32 size) const;
+
+    void updateTimer();
+
+    void _irc_messageReceived(IrcMessage* message);
+    void _irc_poll();
+
+    IrcMessageRing* q_ptr = nullptr;
+#ifndef QT_NO_SHAREDMEMORY
+    QSharedMemory memory;
+#endif
+    QTimer timer;
+    int pollInterval = 0;
+    QPointer<IrcConnection> connection;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCMESSAGERING_P_H
@@ -126,6 +126,10 @@ Q_SIGNALS:
     void availableCapabilitiesChanged(const QStringList& capabilities);
     void requestedCapabilitiesChanged(const QStringList& capabilities);
     void activeCapabilitiesChanged(const QStringList& capabilities);
+    void availableCapabilitiesAdded(const QStringList& capabilities);
+    void availableCapabilitiesRemoved(const QStringList& capabilities);
+    void activeCapabilitiesAdded(const QStringList& capabilities);
+    void activeCapabilitiesRemoved(const QStringList& capabilities);
     void skipCapabilityValidationChanged(bool skip);
     void requestingCapabilities();
 
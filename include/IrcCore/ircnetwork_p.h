@@ -30,6 +30,7 @@
 #define IRCNETWORK_P_H
 
 #include "ircnetwork.h"
+#include "irccore_p.h"
 
 #include <QSet>
 #include <QHash>
@@ -68,10 +69,16 @@ public:
         return network->d_ptr.data();
     }
 
+    static QString casemap(const IrcNetwork* network, const QString& str)
+    {
+        return IrcPrivate::casemap(str, network ? get(network)->caseMapping : QString());
+    }
+
     IrcNetwork* q_ptr = nullptr;
     QPointer<IrcConnection> connection;
     bool initialized = false;
     QString name;
+    QString caseMapping;
     QStringList modes, prefixes, channelTypes, channelModes, statusPrefixes;
     QHash<QString, int> numericLimits, modeLimits, channelLimits, targetLimits;
     QSet<QString> availableCaps, requestedCaps, activeCaps;
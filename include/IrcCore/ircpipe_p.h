@@ -0,0 +1,94 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCPIPE_P_H
+#define IRCPIPE_P_H
+
+#include "ircpipe.h"
+
+#include <QPointer>
+#include <QByteArray>
+#include <QAbstractSocket>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcPipeSocket : public QAbstractSocket
+{
+    Q_OBJECT
+
+public:
+    explicit IrcPipeSocket(IrcPipe* pipe);
+
+    void connectToHost(const QString& hostName, quint16 port, OpenMode mode = ReadWrite, NetworkLayerProtocol protocol = AnyIPProtocol) override;
+    void connectToHost(const QHostAddress& address, quint16 port, OpenMode mode = ReadWrite) override;
+    void disconnectFromHost() override;
+    void close() override;
+
+    qint64 bytesAvailable() const override;
+    qint64 bytesToWrite() const override;
+    bool canReadLine() const override;
+
+    bool waitForConnected(int msecs = 30000) override;
+    bool waitForReadyRead(int msecs = 30000) override;
+    bool waitForBytesWritten(int msecs = 30000) override;
+    bool waitForDisconnected(int msecs = 30000) override;
+
+    IrcPipe* pipe = nullptr;
+    QPointer<IrcPipeSocket> peer;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+private Q_SLOTS:
+    void establish();
+    void deliver();
+    void remoteClosed();
+
+private:
+    void setState(SocketState state);
+    void setError(SocketError error, const QString& message);
+    void shutdown(bool remote);
+
+    QByteArray buffer;
+    bool delivering = false;
+};
+
+class IrcPipePrivate
+{
+    Q_DECLARE_PUBLIC(IrcPipe)
+
+public:
+    IrcPipe* q_ptr = nullptr;
+    IrcPipeSocket* client = nullptr;
+    IrcPipeSocket* server = nullptr;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCPIPE_P_H
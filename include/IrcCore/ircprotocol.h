@@ -78,6 +78,7 @@ private:
 
     Q_PRIVATE_SLOT(d_func(), void _irc_pauseHandshake())
     Q_PRIVATE_SLOT(d_func(), void _irc_resumeHandshake())
+    Q_PRIVATE_SLOT(d_func(), void _irc_clearBatches())
 };
 
 IRC_END_NAMESPACE
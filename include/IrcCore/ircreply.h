@@ -0,0 +1,101 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCREPLY_H
+#define IRCREPLY_H
+
+#include <IrcGlobal>
+#include <IrcCommand>
+#include <QtCore/qobject.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qscopedpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcMessage;
+class IrcConnection;
+class IrcReplyPrivate;
+
+class IRC_CORE_EXPORT IrcReply : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(IrcConnection* connection READ connection CONSTANT)
+    Q_PROPERTY(IrcCommand::Type commandType READ commandType CONSTANT)
+    Q_PROPERTY(QString target READ target CONSTANT)
+    Q_PROPERTY(bool finished READ isFinished NOTIFY finished)
+    Q_PROPERTY(Error error READ error NOTIFY finished)
+    Q_PROPERTY(QList<IrcMessage*> messages READ messages NOTIFY finished)
+    Q_ENUMS(Error)
+
+public:
+    enum Error {
+        NoError,
+        TimeoutError,
+        CanceledError,
+        ConnectionError,
+        ServerError
+    };
+
+    ~IrcReply() override;
+
+    IrcConnection* connection() const;
+    IrcCommand::Type commandType() const;
+    QString target() const;
+
+    bool isFinished() const;
+    Error error() const;
+
+    QList<IrcMessage*> messages() const;
+
+public Q_SLOTS:
+    void abort();
+
+Q_SIGNALS:
+    void finished();
+
+private:
+    explicit IrcReply(IrcConnection* connection);
+
+    QScopedPointer<IrcReplyPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(IrcReply)
+    Q_DISABLE_COPY(IrcReply)
+
+    Q_PRIVATE_SLOT(d_func(), void _irc_timeout())
+};
+
+#ifndef QT_NO_DEBUG_STREAM
+IRC_CORE_EXPORT QDebug operator<<(QDebug debug, IrcReply::Error error);
+IRC_CORE_EXPORT QDebug operator<<(QDebug debug, const IrcReply* reply);
+#endif // QT_NO_DEBUG_STREAM
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcReply*))
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcReply::Error))
+
+#endif // IRCREPLY_H
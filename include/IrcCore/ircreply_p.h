@@ -0,0 +1,69 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCREPLY_P_H
+#define IRCREPLY_P_H
+
+#include "ircreply.h"
+
+#include <QList>
+#include <QTimer>
+#include <QString>
+#include <QPointer>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcReplyPrivate
+{
+    Q_DECLARE_PUBLIC(IrcReply)
+
+public:
+    void _irc_timeout();
+
+    void finish(IrcReply::Error error, const QList<IrcMessage*>& messages = QList<IrcMessage*>());
+
+    static IrcReply* create(IrcConnection* connection, IrcCommand::Type type, const QString& target, int timeout);
+
+    static IrcReplyPrivate* get(const IrcReply* reply)
+    {
+        return reply->d_ptr.data();
+    }
+
+    IrcReply* q_ptr = nullptr;
+    QPointer<IrcConnection> connection;
+    IrcCommand::Type type = IrcCommand::Custom;
+    QString target;
+    bool finished = false;
+    IrcReply::Error error = IrcReply::NoError;
+    QList<IrcMessage*> messages;
+    QTimer timer;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCREPLY_P_H
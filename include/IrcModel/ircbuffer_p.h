@@ -86,6 +86,8 @@ public:
     IrcBufferModel* model = nullptr;
     QString name;
     QString prefix;
+    mutable QString title;
+    mutable bool titleDirty = true;
     bool persistent = false;
     bool sticky = false;
     QVariantMap userData;
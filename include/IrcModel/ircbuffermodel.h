@@ -31,6 +31,7 @@
 
 #include <Irc>
 #include <IrcGlobal>
+#include <IrcSnapshot>
 #include <QtCore/qmetatype.h>
 #include <QtCore/qstringlist.h>
 #include <QtCore/qabstractitemmodel.h>
@@ -61,6 +62,10 @@ class IRC_MODEL_EXPORT IrcBufferModel : public QAbstractListModel
     Q_PROPERTY(IrcChannel* channelPrototype READ channelPrototype WRITE setChannelPrototype NOTIFY channelPrototypeChanged)
     Q_PROPERTY(int joinDelay READ joinDelay WRITE setJoinDelay NOTIFY joinDelayChanged)
     Q_PROPERTY(bool monitorEnabled READ isMonitorEnabled WRITE setMonitorEnabled NOTIFY monitorEnabledChanged)
+    Q_PROPERTY(bool lazyUsersEnabled READ isLazyUsersEnabled WRITE setLazyUsersEnabled NOTIFY lazyUsersEnabledChanged)
+    Q_PROPERTY(int hibernateDelay READ hibernateDelay WRITE setHibernateDelay NOTIFY hibernateDelayChanged)
+    Q_PROPERTY(bool snapshotsEnabled READ isSnapshotsEnabled WRITE setSnapshotsEnabled NOTIFY snapshotsEnabledChanged)
+    Q_PROPERTY(bool splitDetectionEnabled READ isSplitDetectionEnabled WRITE setSplitDetectionEnabled NOTIFY splitDetectionEnabledChanged)
 
 public:
     explicit IrcBufferModel(QObject* parent = nullptr);
@@ -119,6 +124,20 @@ public:
     bool isMonitorEnabled() const;
     void setMonitorEnabled(bool enabled);
 
+    bool isLazyUsersEnabled() const;
+    void setLazyUsersEnabled(bool enabled);
+
+    int hibernateDelay() const;
+    void setHibernateDelay(int delay);
+
+    bool isSnapshotsEnabled() const;
+    void setSnapshotsEnabled(bool enabled);
+
+    IrcSnapshot snapshot() const;
+
+    bool isSplitDetectionEnabled() const;
+    void setSplitDetectionEnabled(bool enabled);
+
     Q_INVOKABLE QByteArray saveState(int version = 0) const;
     Q_INVOKABLE bool restoreState(const QByteArray& state, int version = 0);
 
@@ -138,6 +157,8 @@ Q_SIGNALS:
     void persistentChanged(bool persistent);
     void buffersChanged(const QList<IrcBuffer*>& buffers);
     void channelsChanged(const QStringList& channels);
+    void channelsAdded(const QStringList& channels);
+    void channelsRemoved(const QStringList& channels);
     void connectionChanged(IrcConnection* connection);
     void networkChanged(IrcNetwork* network);
     void messageIgnored(IrcMessage* message);
@@ -146,6 +167,13 @@ Q_SIGNALS:
     void destroyed(IrcBufferModel* model);
     void joinDelayChanged(int delay);
     void monitorEnabledChanged(bool enabled);
+    void lazyUsersEnabledChanged(bool enabled);
+    void hibernateDelayChanged(int delay);
+    void snapshotsEnabledChanged(bool enabled);
+    void snapshotPublished(const IrcSnapshot& snapshot);
+    void splitDetectionEnabledChanged(bool enabled);
+    void netsplit(const QString& servers, const QStringList& nicks);
+    void netjoin(const QString& servers, const QStringList& nicks);
 
 protected Q_SLOTS:
     virtual IrcBuffer* createBuffer(const QString& title);
@@ -166,7 +194,10 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _irc_disconnected())
     Q_PRIVATE_SLOT(d_func(), void _irc_bufferDestroyed(IrcBuffer*))
     Q_PRIVATE_SLOT(d_func(), void _irc_restoreBuffers())
-    Q_PRIVATE_SLOT(d_func(), void _irc_monitorStatus())
+    Q_PRIVATE_SLOT(d_func(), void _irc_syncMonitor())
+    Q_PRIVATE_SLOT(d_func(), void _irc_flushSplit())
+    Q_PRIVATE_SLOT(d_func(), void _irc_hibernateBuffers())
+    Q_PRIVATE_SLOT(d_func(), void _irc_publishSnapshot())
 };
 
 IRC_END_NAMESPACE
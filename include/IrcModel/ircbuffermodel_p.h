@@ -31,22 +31,30 @@
 
 #include "ircbuffer.h"
 #include "ircfilter.h"
+#include "irccommand.h"
 #include "ircbuffermodel.h"
+#include "ircmessage.h"
+#include "ircmonitor_p.h"
 #include <qpointer.h>
+#include <qtimer.h>
+#include <qelapsedtimer.h>
+#include <memory>
 
 IRC_BEGIN_NAMESPACE
 
-class IrcBufferModelPrivate : public QObject, public IrcMessageFilter, public IrcCommandFilter
+class IrcBufferModelPrivate : public QObject, public IrcMessageFilter, public IrcCommandFilter, public IrcCommandValueFilter
 {
     Q_OBJECT
     Q_DECLARE_PUBLIC(IrcBufferModel)
-    Q_INTERFACES(IrcMessageFilter IrcCommandFilter)
+    Q_INTERFACES(IrcMessageFilter IrcCommandFilter IrcCommandValueFilter)
 
 public:
     IrcBufferModelPrivate();
 
     bool messageFilter(IrcMessage* message) override;
     bool commandFilter(IrcCommand* command) override;
+    bool commandValueFilter(IrcCommandValue* command) override;
+    void processCommand(IrcCommand::Type type, const QStringList& parameters);
 
     IrcBuffer* createBufferHelper(const QString& title);
     IrcChannel* createChannelHelper(const QString& title);
@@ -64,6 +72,17 @@ public:
     QVariantMap saveBuffer(IrcBuffer* buffer) const;
 
     bool processMessage(const QString& title, IrcMessage* message, bool create = false);
+    bool routeMessage(IrcMessage* message);
+
+    void processBatch(IrcBatchMessage* batch);
+    bool deferSplit(IrcQuitMessage* quit);
+    void processSplit(const QString& servers, const QList<IrcQuitMessage*>& quits);
+    void processJoin(const QString& servers, const QList<IrcJoinMessage*>& joins);
+
+    void scheduleSnapshot();
+    void setHibernateInterval(int msecs);
+    void scheduleMonitor();
+    QStringList monitorTargets() const;
 
     void _irc_connected();
     void _irc_initialized();
@@ -71,7 +90,10 @@ public:
     void _irc_bufferDestroyed(IrcBuffer* buffer);
 
     void _irc_restoreBuffers();
-    void _irc_monitorStatus();
+    void _irc_syncMonitor();
+    void _irc_flushSplit();
+    void _irc_hibernateBuffers();
+    void _irc_publishSnapshot();
 
     static IrcBufferModelPrivate* get(IrcBufferModel* model)
     {
@@ -94,6 +116,19 @@ public:
     int joinDelay = 0;
     bool monitorEnabled = false;
     bool monitorPending = false;
+    IrcMonitor monitor;
+    bool lazyUsersEnabled = false;
+    int hibernateDelay = 0;
+    int hibernateInterval = 0; // msecs, shorter than a second in tests
+    QTimer hibernateTimer;
+    QElapsedTimer clock;
+    bool splitDetectionEnabled = false;
+    bool snapshotsEnabled = false;
+    bool snapshotPending = false;
+    quint64 snapshotRevision = 0;
+    std::shared_ptr<const IrcSnapshot> publishedSnapshot; // swapped atomically
+    QString splitServers;
+    QList<IrcQuitMessage*> pendingSplit;
 };
 
 IRC_END_NAMESPACE
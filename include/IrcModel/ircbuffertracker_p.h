@@ -0,0 +1,88 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef IRCBUFFERTRACKER_P_H
+#define IRCBUFFERTRACKER_P_H
+
+#include "ircbuffermodel.h"
+#include "ircbuffer.h"
+#include "ircnetwork_p.h"
+#include <qpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+// keeps the private slots of a receiver connected to the buffers of a
+// model: _irc_bufferAdded(IrcBuffer*), _irc_bufferRemoved(IrcBuffer*)
+// and _irc_messageReceived(IrcMessage*), sent by the buffer.
+// header only, because it is shared by the model and util libraries
+class IrcBufferTracker
+{
+public:
+    IrcBufferModel* model() const { return bufferModel; }
+
+    void setModel(IrcBufferModel* model, QObject* receiver)
+    {
+        if (bufferModel == model)
+            return;
+        if (bufferModel) {
+            QObject::disconnect(bufferModel, SIGNAL(added(IrcBuffer*)), receiver, SLOT(_irc_bufferAdded(IrcBuffer*)));
+            QObject::disconnect(bufferModel, SIGNAL(removed(IrcBuffer*)), receiver, SLOT(_irc_bufferRemoved(IrcBuffer*)));
+            foreach (IrcBuffer* buffer, bufferModel->buffers())
+                untrack(buffer, receiver);
+        }
+        bufferModel = model;
+        if (model) {
+            QObject::connect(model, SIGNAL(added(IrcBuffer*)), receiver, SLOT(_irc_bufferAdded(IrcBuffer*)));
+            QObject::connect(model, SIGNAL(removed(IrcBuffer*)), receiver, SLOT(_irc_bufferRemoved(IrcBuffer*)));
+            foreach (IrcBuffer* buffer, model->buffers())
+                track(buffer, receiver);
+        }
+    }
+
+    static void track(IrcBuffer* buffer, QObject* receiver)
+    {
+        QObject::connect(buffer, SIGNAL(messageReceived(IrcMessage*)), receiver, SLOT(_irc_messageReceived(IrcMessage*)));
+    }
+
+    static void untrack(IrcBuffer* buffer, QObject* receiver)
+    {
+        QObject::disconnect(buffer, SIGNAL(messageReceived(IrcMessage*)), receiver, SLOT(_irc_messageReceived(IrcMessage*)));
+    }
+
+    // folds a buffer title or nick as the CASEMAPPING of the network of the model
+    QString casemap(const QString& str) const
+    {
+        return IrcNetworkPrivate::casemap(bufferModel ? bufferModel->network() : nullptr, str);
+    }
+
+private:
+    QPointer<IrcBufferModel> bufferModel;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCBUFFERTRACKER_P_H
@@ -32,12 +32,20 @@
 #include "ircchannel.h"
 #include "ircnetwork.h"
 #include "ircbuffer_p.h"
+#include "ircsnapshot.h"
 #include <qstringlist.h>
 #include <qlist.h>
 #include <qmap.h>
 
 IRC_BEGIN_NAMESPACE
 
+struct IrcLazyUser
+{
+    QString prefix;
+    bool away = false;
+    bool servOp = false;
+};
+
 class IrcChannelPrivate : public IrcBufferPrivate
 {
     Q_DECLARE_PUBLIC(IrcChannel)
@@ -57,8 +65,11 @@ public:
     void setTopic(const QString& value);
     void setKey(const QString& value);
 
+    IrcUser* createUser(const QString& name, const QStringList& prefixes);
     void addUser(const QString& user);
     bool removeUser(const QString& user);
+    void addUsers(const QStringList& users);
+    QStringList removeUsers(const QStringList& users);
     void setUsers(const QStringList& users);
     bool renameUser(const QString& from, const QString& to);
     void setUserMode(const QString& user, const QString& mode);
@@ -66,6 +77,14 @@ public:
     bool setUserAway(const QString &name, bool away);
     void setUserServOp(const QString &name, bool servOp);
 
+    bool isLazy() const;
+    QStringList nameList() const;
+    bool hasUser(const QString& name) const;
+    void materialize();
+    bool hibernate();
+    void touch();
+    void changed();
+
     bool processAwayMessage(IrcAwayMessage* message) override;
     bool processJoinMessage(IrcJoinMessage* message) override;
     bool processKickMessage(IrcKickMessage* message) override;
@@ -86,14 +105,24 @@ public:
     }
 
     QMap<QString, QString> modes;
+    mutable QString modeString;
+    mutable bool modeDirty = true;
     QString topic;
     bool active = false;
     bool enabled = true;
-    QStringList names;
+    mutable QStringList names;
+    mutable bool namesDirty = false;
     QList<IrcUser*> userList;
     QList<IrcUser*> activeUsers;
     QMap<QString, IrcUser*> userMap;
     QList<IrcUserModel*> userModels;
+    bool lazy = false;
+    bool namesReceived = false;
+    QMap<QString, IrcLazyUser> lazyUsers;
+    QStringList lazyActive;
+    qint64 lastSeen = 0;
+    bool snapshotDirty = true;
+    IrcChannelSnapshot snapshot;
 };
 
 IRC_END_NAMESPACE
@@ -0,0 +1,106 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCFILTERMODEL_H
+#define IRCFILTERMODEL_H
+
+#include <Irc>
+#include <IrcGlobal>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qscopedpointer.h>
+#include <QtCore/qabstractitemmodel.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcFilterModelPrivate;
+
+class IRC_MODEL_EXPORT IrcFilterModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged)
+    Q_PROPERTY(Irc::DataRole filterRole READ filterRole WRITE setFilterRole)
+    Q_PROPERTY(Qt::MatchFlags matchFlags READ matchFlags WRITE setMatchFlags)
+    Q_PROPERTY(QAbstractItemModel* sourceModel READ sourceModel WRITE setSourceModel NOTIFY sourceModelChanged)
+
+public:
+    explicit IrcFilterModel(QObject* parent = nullptr);
+    ~IrcFilterModel() override;
+
+    QAbstractItemModel* sourceModel() const;
+    void setSourceModel(QAbstractItemModel* model);
+
+    QString filter() const;
+
+    Irc::DataRole filterRole() const;
+    void setFilterRole(Irc::DataRole role);
+
+    Qt::MatchFlags matchFlags() const;
+    void setMatchFlags(Qt::MatchFlags flags);
+
+    int count() const;
+
+    QModelIndex mapToSource(const QModelIndex& index) const;
+    QModelIndex mapFromSource(const QModelIndex& index) const;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QHash<int, QByteArray> roleNames() const override;
+#endif
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+public Q_SLOTS:
+    void setFilter(const QString& filter);
+
+Q_SIGNALS:
+    void countChanged(int count);
+    void filterChanged(const QString& filter);
+    void sourceModelChanged(QAbstractItemModel* model);
+
+private:
+    QScopedPointer<IrcFilterModelPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(IrcFilterModel)
+    Q_DISABLE_COPY(IrcFilterModel)
+
+    Q_PRIVATE_SLOT(d_func(), void _irc_rowsInserted(QModelIndex, int, int))
+    Q_PRIVATE_SLOT(d_func(), void _irc_rowsAboutToBeRemoved(QModelIndex, int, int))
+    Q_PRIVATE_SLOT(d_func(), void _irc_rowsRemoved(QModelIndex, int, int))
+    Q_PRIVATE_SLOT(d_func(), void _irc_dataChanged(QModelIndex, QModelIndex))
+    Q_PRIVATE_SLOT(d_func(), void _irc_layoutAboutToBeChanged())
+    Q_PRIVATE_SLOT(d_func(), void _irc_layoutChanged())
+    Q_PRIVATE_SLOT(d_func(), void _irc_modelAboutToBeReset())
+    Q_PRIVATE_SLOT(d_func(), void _irc_modelReset())
+    Q_PRIVATE_SLOT(d_func(), void _irc_sourceDestroyed())
+    Q_PRIVATE_SLOT(d_func(), void _irc_networkInitialized())
+};
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcFilterModel*))
+
+#endif // IRCFILTERMODEL_H
@@ -0,0 +1,92 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCFILTERMODEL_P_H
+#define IRCFILTERMODEL_P_H
+
+#include "ircfiltermodel.h"
+#include <qvector.h>
+#include <qstringlist.h>
+#include <qpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcNetwork;
+
+class IrcFilterModelPrivate
+{
+    Q_DECLARE_PUBLIC(IrcFilterModel)
+
+public:
+    QString casemap(const QString& str) const;
+    void updateNetwork();
+
+    QString key(int sourceRow) const;
+    bool matches(const QString& key, const QString& query) const;
+    int rowOf(int sourceRow) const;
+    int lowerBound(const QString& key) const;
+    int sortedIndexOf(int sourceRow) const;
+    void insertSorted(int sourceRow);
+
+    void rebuild();
+    QVector<int> lookup(const QString& query) const;
+    QVector<int> refine(const QString& query) const;
+    void setRows(const QVector<int>& next);
+    void insertRows(int row, const QVector<int>& sourceRows);
+    void removeRows(int row, int count);
+    void notifyCount(int previous);
+
+    void _irc_rowsInserted(const QModelIndex& parent, int first, int last);
+    void _irc_rowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+    void _irc_rowsRemoved(const QModelIndex& parent, int first, int last);
+    void _irc_dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    void _irc_layoutAboutToBeChanged();
+    void _irc_layoutChanged();
+    void _irc_modelAboutToBeReset();
+    void _irc_modelReset();
+    void _irc_sourceDestroyed();
+    void _irc_networkInitialized();
+
+    IrcFilterModel* q_ptr = nullptr;
+    QAbstractItemModel* source = nullptr;
+    QPointer<IrcNetwork> network; // of the source model, for CASEMAPPING
+    QString filter;
+    QString query; // casemapped
+    Irc::DataRole role = Irc::NameRole;
+    Qt::MatchFlags flags = Qt::MatchStartsWith;
+    QStringList keys; // casemapped, per source row
+    QVector<int> sorted; // source rows in key order
+    QVector<int> rows; // matching source rows, ascending
+    int removed = 0; // rows being removed along with the source rows
+    QModelIndexList layoutIndexes;
+    QList<QPersistentModelIndex> layoutSources;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCFILTERMODEL_P_H
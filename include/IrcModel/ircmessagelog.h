@@ -0,0 +1,102 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCMESSAGELOG_H
+#define IRCMESSAGELOG_H
+
+#include <IrcGlobal>
+#include <IrcMessage>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qdatetime.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qscopedpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcConnection;
+class IrcBuffer;
+class IrcBufferModel;
+class IrcMessageLogPrivate;
+
+class IRC_MODEL_EXPORT IrcMessageLog : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString directory READ directory WRITE setDirectory)
+    Q_PROPERTY(IrcBufferModel* model READ model WRITE setModel)
+    Q_PROPERTY(qint64 segmentSize READ segmentSize WRITE setSegmentSize)
+    Q_PROPERTY(int indexInterval READ indexInterval WRITE setIndexInterval)
+    Q_PROPERTY(QStringList buffers READ buffers)
+
+public:
+    explicit IrcMessageLog(QObject* parent = nullptr);
+    ~IrcMessageLog() override;
+
+    QString directory() const;
+    void setDirectory(const QString& directory);
+
+    IrcBufferModel* model() const;
+    void setModel(IrcBufferModel* model);
+
+    qint64 segmentSize() const;
+    void setSegmentSize(qint64 size);
+
+    int indexInterval() const;
+    void setIndexInterval(int bytes);
+
+    QStringList buffers() const;
+    int segmentCount(const QString& buffer) const;
+
+    bool append(const QString& buffer, IrcMessage* message);
+    bool append(const QString& buffer, const QByteArray& data, const QDateTime& timeStamp, IrcMessage::Flags flags = IrcMessage::None);
+
+    QList<IrcMessage*> lastMessages(const QString& buffer, int count, IrcConnection* connection) const;
+    QList<IrcMessage*> messages(const QString& buffer, const QDateTime& from, const QDateTime& to, IrcConnection* connection) const;
+    IrcMessage* findMessage(const QString& buffer, const QString& msgid, IrcConnection* connection) const;
+
+    int compact(const QString& buffer, const QDateTime& before = QDateTime());
+
+public Q_SLOTS:
+    void flush();
+
+private:
+    QScopedPointer<IrcMessageLogPrivate> d_ptr;
+    Q_DECLARE_PRIVATE(IrcMessageLog)
+    Q_DISABLE_COPY(IrcMessageLog)
+
+    Q_PRIVATE_SLOT(d_func(), void _irc_bufferAdded(IrcBuffer*))
+    Q_PRIVATE_SLOT(d_func(), void _irc_bufferRemoved(IrcBuffer*))
+    Q_PRIVATE_SLOT(d_func(), void _irc_messageReceived(IrcMessage*))
+};
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcMessageLog*))
+
+#endif // IRCMESSAGELOG_H
@@ -0,0 +1,105 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCMESSAGELOG_P_H
+#define IRCMESSAGELOG_P_H
+
+#include "ircmessagelog.h"
+#include "ircbuffertracker_p.h"
+
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QTimer>
+
+IRC_BEGIN_NAMESPACE
+
+// a sparse index entry: the time and file offset of a record
+struct IrcMessageLogEntry
+{
+    qint64 time;
+    qint64 offset;
+};
+
+// a parsed record: "<msecs> <flags> <line>\n"
+struct IrcMessageLogRecord
+{
+    qint64 time = 0;
+    int flags = 0;
+    QByteArray line;
+};
+
+// the segment that is being appended to
+class IrcMessageLogWriter
+{
+public:
+    QFile log;
+    QFile index;
+    qint64 size = 0;
+    qint64 indexed = -1;
+    qint64 lastTime = 0;
+    quint64 used = 0;
+};
+
+class IrcMessageLogPrivate
+{
+    Q_DECLARE_PUBLIC(IrcMessageLog)
+
+public:
+    ~IrcMessageLogPrivate() override;
+
+    QString key(const QString& buffer) const;
+    QString bufferPath(const QString& buffer) const;
+    QStringList segments(const QString& buffer) const;
+
+    IrcMessageLogWriter* writer(const QString& buffer);
+    void closeWriter(const QString& buffer);
+    void scheduleFlush();
+
+    static bool parseRecord(const char* data, int length, IrcMessageLogRecord* record);
+    static QVector<IrcMessageLogEntry> readIndex(const QString& path);
+    static bool writeIndex(QFile* file, qint64 time, qint64 offset);
+    IrcMessage* createMessage(const IrcMessageLogRecord& record, IrcConnection* connection) const;
+
+    void _irc_bufferAdded(IrcBuffer* buffer);
+    void _irc_bufferRemoved(IrcBuffer* buffer);
+    void _irc_messageReceived(IrcMessage* message);
+
+    IrcMessageLog* q_ptr = nullptr;
+    QString directory;
+    IrcBufferTracker tracker;
+    qint64 segmentSize;
+    int indexInterval;
+    QHash<QString, IrcMessageLogWriter*> writers; // casemapped
+    quint64 clock = 0;
+    QTimer flushTimer;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCMESSAGELOG_P_H
@@ -32,6 +32,9 @@
 #include "ircbuffer.h"
 #include "ircbuffermodel.h"
 #include "ircchannel.h"
+#include "ircfiltermodel.h"
+#include "ircmessagelog.h"
+#include "ircsnapshot.h"
 #include "ircuser.h"
 #include "ircusermodel.h"
 
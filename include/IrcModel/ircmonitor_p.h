@@ -0,0 +1,75 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCMONITOR_P_H
+#define IRCMONITOR_P_H
+
+#include <IrcGlobal>
+#include "ircnetwork.h"
+#include <qset.h>
+#include <qlist.h>
+#include <qstringlist.h>
+#include <qpointer.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcCommand;
+
+class IrcMonitor
+{
+public:
+    int limit() const { return monitorLimit; }
+    void setLimit(int limit);
+
+    int targetLimit() const { return lineTargets; }
+    void setTargetLimit(int limit);
+
+    void setNetwork(IrcNetwork* network);
+
+    QStringList targets() const;
+    bool contains(const QString& target) const;
+
+    QList<IrcCommand*> update(const QStringList& desired);
+    void reject(const QStringList& targets, int limit);
+    void reset();
+
+    static QList<QStringList> pack(const QStringList& targets, int length, int count);
+
+private:
+    QString casemap(const QString& target) const;
+
+    int monitorLimit = 0;
+    int lineTargets = 0;
+    QPointer<IrcNetwork> network; // for CASEMAPPING
+    QStringList monitored;
+    QSet<QString> mappedMonitored;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCMONITOR_P_H
@@ -0,0 +1,145 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCSNAPSHOT_H
+#define IRCSNAPSHOT_H
+
+#include <IrcGlobal>
+#include <QtCore/qlist.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qshareddata.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcUserSnapshotData;
+class IrcChannelSnapshotData;
+class IrcNetworkSnapshotData;
+class IrcSnapshotData;
+
+class IRC_MODEL_EXPORT IrcUserSnapshot
+{
+public:
+    IrcUserSnapshot();
+    IrcUserSnapshot(const IrcUserSnapshot& other);
+    IrcUserSnapshot& operator=(const IrcUserSnapshot& other);
+    ~IrcUserSnapshot();
+
+    bool isValid() const;
+
+    QString title() const;
+    QString name() const;
+    QString prefix() const;
+    QString mode() const;
+    bool isServOp() const;
+    bool isAway() const;
+
+private:
+    friend class IrcSnapshotBuilder;
+    QSharedDataPointer<IrcUserSnapshotData> d;
+};
+
+class IRC_MODEL_EXPORT IrcChannelSnapshot
+{
+public:
+    IrcChannelSnapshot();
+    IrcChannelSnapshot(const IrcChannelSnapshot& other);
+    IrcChannelSnapshot& operator=(const IrcChannelSnapshot& other);
+    ~IrcChannelSnapshot();
+
+    bool isValid() const;
+
+    QString title() const;
+    QString name() const;
+    QString prefix() const;
+    QString mode() const;
+    QString key() const;
+    QString topic() const;
+    bool isActive() const;
+
+    QStringList names() const;
+    QList<IrcUserSnapshot> users() const;
+    IrcUserSnapshot user(const QString& name) const;
+    bool contains(const QString& name) const;
+
+private:
+    friend class IrcSnapshotBuilder;
+    QSharedDataPointer<IrcChannelSnapshotData> d;
+};
+
+class IRC_MODEL_EXPORT IrcNetworkSnapshot
+{
+public:
+    IrcNetworkSnapshot();
+    IrcNetworkSnapshot(const IrcNetworkSnapshot& other);
+    IrcNetworkSnapshot& operator=(const IrcNetworkSnapshot& other);
+    ~IrcNetworkSnapshot();
+
+    bool isValid() const;
+
+    QString name() const;
+    QStringList modes() const;
+    QStringList prefixes() const;
+    QStringList channelTypes() const;
+    QStringList statusPrefixes() const;
+    QStringList activeCapabilities() const;
+
+    QString modeToPrefix(const QString& mode) const;
+    QString prefixToMode(const QString& prefix) const;
+    bool isChannel(const QString& name) const;
+
+private:
+    friend class IrcSnapshotBuilder;
+    QSharedDataPointer<IrcNetworkSnapshotData> d;
+};
+
+class IRC_MODEL_EXPORT IrcSnapshot
+{
+public:
+    IrcSnapshot();
+    IrcSnapshot(const IrcSnapshot& other);
+    IrcSnapshot& operator=(const IrcSnapshot& other);
+    ~IrcSnapshot();
+
+    bool isValid() const;
+    quint64 revision() const;
+
+    IrcNetworkSnapshot network() const;
+    QList<IrcChannelSnapshot> channels() const;
+    IrcChannelSnapshot channel(const QString& title) const;
+
+private:
+    friend class IrcSnapshotBuilder;
+    QSharedDataPointer<IrcSnapshotData> d;
+};
+
+IRC_END_NAMESPACE
+
+Q_DECLARE_METATYPE(IRC_PREPEND_NAMESPACE(IrcSnapshot))
+
+#endif // IRCSNAPSHOT_H
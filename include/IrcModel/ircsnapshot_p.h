@@ -0,0 +1,95 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCSNAPSHOT_P_H
+#define IRCSNAPSHOT_P_H
+
+#include "ircsnapshot.h"
+#include <qhash.h>
+
+IRC_BEGIN_NAMESPACE
+
+class IrcChannel;
+class IrcNetwork;
+
+class IrcUserSnapshotData : public QSharedData
+{
+public:
+    QString name;
+    QString prefix;
+    QString mode;
+    bool servOp = false;
+    bool away = false;
+};
+
+class IrcChannelSnapshotData : public QSharedData
+{
+public:
+    QString title;
+    QString name;
+    QString prefix;
+    QString mode;
+    QString key;
+    QString topic;
+    bool active = false;
+    QStringList names;
+    QList<IrcUserSnapshot> users;
+};
+
+class IrcNetworkSnapshotData : public QSharedData
+{
+public:
+    QString name;
+    QStringList modes;
+    QStringList prefixes;
+    QStringList channelTypes;
+    QStringList statusPrefixes;
+    QStringList activeCapabilities;
+};
+
+class IrcSnapshotData : public QSharedData
+{
+public:
+    quint64 revision = 0;
+    IrcNetworkSnapshot network;
+    QList<IrcChannelSnapshot> channels;
+    QHash<QString, int> index;
+};
+
+class IrcSnapshotBuilder
+{
+public:
+    static IrcUserSnapshot user(const QString& name, const QString& prefix, const QString& mode, bool servOp, bool away);
+    static IrcChannelSnapshot channel(IrcChannel* channel, const IrcChannelSnapshot& previous = IrcChannelSnapshot());
+    static IrcNetworkSnapshot network(IrcNetwork* network);
+    static IrcSnapshot snapshot(quint64 revision, const IrcNetworkSnapshot& network, const QList<IrcChannelSnapshot>& channels);
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCSNAPSHOT_P_H
@@ -0,0 +1,76 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCSORT_P_H
+#define IRCSORT_P_H
+
+#include <IrcGlobal>
+#include <qlist.h>
+#include <qvector.h>
+#include <qabstractitemmodel.h>
+#include <algorithm>
+
+IRC_BEGIN_NAMESPACE
+
+// sorts the list and returns the new row of each old row, so that
+// persistent indexes can be remapped without searching the list
+template <typename T, typename LessThan>
+inline QVector<int> irc_sort_rows(QList<T>& list, LessThan lessThan)
+{
+    const int count = list.count();
+    QVector<int> order(count);
+    for (int i = 0; i < count; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&list, &lessThan](int a, int b) {
+        return lessThan(list.at(a), list.at(b));
+    });
+
+    QList<T> sorted;
+    sorted.reserve(count);
+    QVector<int> rows(count);
+    for (int i = 0; i < count; ++i) {
+        sorted += list.at(order.at(i));
+        rows[order.at(i)] = i;
+    }
+    list = sorted;
+    return rows;
+}
+
+template <typename Model>
+inline QModelIndexList irc_remap_rows(Model* model, const QModelIndexList& indexes, const QVector<int>& rows)
+{
+    QModelIndexList remapped;
+    remapped.reserve(indexes.count());
+    foreach (const QModelIndex& index, indexes)
+        remapped += model->index(rows.value(index.row(), -1), index.column());
+    return remapped;
+}
+
+IRC_END_NAMESPACE
+
+#endif // IRCSORT_P_H
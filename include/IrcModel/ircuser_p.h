@@ -54,6 +54,8 @@ public:
     QString name;
     QString prefix;
     QString mode;
+    mutable QString title;
+    mutable bool titleDirty;
     bool servOp;
     bool away;
 };
@@ -106,6 +106,8 @@ Q_SIGNALS:
     void namesChanged(const QStringList& names);
     void titlesChanged(const QStringList& titles);
     void usersChanged(const QList<IrcUser*>& users);
+    void namesAdded(const QStringList& names);
+    void namesRemoved(const QStringList& names);
     void channelChanged(IrcChannel* channel);
 
 protected:
@@ -33,6 +33,8 @@
 #include "ircchannel_p.h"
 #include "ircusermodel.h"
 #include <qpointer.h>
+#include <qhash.h>
+#include <qmetaobject.h>
 
 IRC_BEGIN_NAMESPACE
 
@@ -46,12 +48,26 @@ public:
     void addUser(IrcUser* user, bool notify = true);
     void insertUser(int index, IrcUser* user, bool notify = true);
     void removeUser(IrcUser* user, bool notify = true);
-    void setUsers(const QList<IrcUser*>& users, bool reset = true);
-    void renameUser(IrcUser* user);
+    void addUsers(const QList<IrcUser*>& users);
+    void removeUsers(const QList<IrcUser*>& users);
+    void setUsers(const QList<IrcUser*>& users, const QStringList& previous, bool reset = true);
+    void renameUser(IrcUser* user, const QString& from);
     void setUserMode(IrcUser* user);
     void promoteUser(IrcUser* user);
     bool updateUser(IrcUser* user);
     bool updateTitles();
+    void rankUsers(Irc::SortMethod method);
+    void clearRanks();
+
+    QStringList titleList() const;
+    QStringList nameList() const;
+    void notifyLists();
+
+    template <typename Signal>
+    bool isConnected(Signal signal) const
+    {
+        return q_func()->isSignalConnected(QMetaMethod::fromSignal(signal));
+    }
 
     static IrcUserModelPrivate* get(IrcUserModel* model)
     {
@@ -60,11 +76,14 @@ public:
 
     IrcUserModel* q_ptr = nullptr;
     Irc::DataRole role = Irc::TitleRole;
-    QStringList titles;
+    mutable QStringList titles;
+    mutable bool titlesDirty = false;
     QList<IrcUser*> userList;
     QPointer<IrcChannel> channel;
     Irc::SortMethod sortMethod = Irc::SortByHand;
     Qt::SortOrder sortOrder = Qt::AscendingOrder;
+    Irc::SortMethod rankMethod = Irc::SortByHand;
+    QHash<IrcUser*, int> ranks; // activity or prefix rank, while sorting
 };
 
 IRC_END_NAMESPACE
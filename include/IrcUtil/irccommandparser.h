@@ -88,6 +88,8 @@ public Q_SLOTS:
 
     void setTriggers(const QStringList& triggers);
     void setChannels(const QStringList& channels);
+    void addChannels(const QStringList& channels);
+    void removeChannels(const QStringList& channels);
     void setTarget(const QString& target);
 
 Q_SIGNALS:
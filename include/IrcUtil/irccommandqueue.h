@@ -45,6 +45,9 @@ class IRC_UTIL_EXPORT IrcCommandQueue : public QObject
     Q_PROPERTY(int batch READ batch WRITE setBatch)
     Q_PROPERTY(int interval READ interval WRITE setInterval)
     Q_PROPERTY(int size READ size NOTIFY sizeChanged)
+    Q_PROPERTY(int highWatermark READ highWatermark WRITE setHighWatermark)
+    Q_PROPERTY(int lowWatermark READ lowWatermark WRITE setLowWatermark)
+    Q_PROPERTY(bool congested READ isCongested NOTIFY congestedChanged)
     Q_PROPERTY(IrcConnection* connection READ connection WRITE setConnection)
 
 public:
@@ -59,6 +62,14 @@ public:
 
     int size() const;
 
+    int highWatermark() const;
+    void setHighWatermark(int bytes);
+
+    int lowWatermark() const;
+    void setLowWatermark(int bytes);
+
+    bool isCongested() const;
+
     IrcConnection* connection() const;
     void setConnection(IrcConnection* connection);
 
@@ -68,6 +79,7 @@ public Q_SLOTS:
 
 Q_SIGNALS:
     void sizeChanged(int size);
+    void congestedChanged(bool congested);
 
 private:
     QScopedPointer<IrcCommandQueuePrivate> d_ptr;
@@ -76,6 +88,8 @@ private:
 
     Q_PRIVATE_SLOT(d_func(), void _irc_updateTimer())
     Q_PRIVATE_SLOT(d_func(), void _irc_sendBatch())
+    Q_PRIVATE_SLOT(d_func(), void _irc_updateSocket())
+    Q_PRIVATE_SLOT(d_func(), void _irc_bytesWritten())
 };
 
 IRC_END_NAMESPACE
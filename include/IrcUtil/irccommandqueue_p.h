@@ -31,31 +31,42 @@
 
 #include "irccommandqueue.h"
 #include "ircfilter.h"
+#include <QAbstractSocket>
 #include <QPointer>
 #include <QQueue>
 #include <QTimer>
 
 IRC_BEGIN_NAMESPACE
 
-class IrcCommandQueuePrivate : public QObject,  public IrcCommandFilter
+class IrcCommandQueuePrivate : public QObject,  public IrcCommandFilter, public IrcCommandValueFilter
 {
     Q_OBJECT
-    Q_INTERFACES(IrcCommandFilter)
+    Q_INTERFACES(IrcCommandFilter IrcCommandValueFilter)
     Q_DECLARE_PUBLIC(IrcCommandQueue)
 
 public:
     IrcCommandQueuePrivate();
 
     bool commandFilter(IrcCommand* cmd) override;
+    bool commandValueFilter(IrcCommandValue* cmd) override;
 
     void _irc_updateTimer();
     void _irc_sendBatch(bool force = false);
+    void _irc_updateSocket();
+    void _irc_bytesWritten();
+
+    bool updateCongestion();
+    void setCongested(bool congested);
 
     IrcCommandQueue* q_ptr = nullptr;
     IrcConnection* connection = nullptr;
+    QPointer<QAbstractSocket> socket;
     QTimer timer;
     int batch;
     int interval;
+    int highWatermark = 0;
+    int lowWatermark = 0;
+    bool congested = false;
     QQueue<QPointer<IrcCommand> > commands;
 };
 
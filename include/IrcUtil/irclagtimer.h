@@ -44,6 +44,8 @@ class IRC_UTIL_EXPORT IrcLagTimer : public QObject
     Q_OBJECT
     Q_PROPERTY(qint64 lag READ lag NOTIFY lagChanged)
     Q_PROPERTY(int interval READ interval WRITE setInterval)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout)
+    Q_PROPERTY(bool adaptive READ isAdaptive WRITE setAdaptive)
     Q_PROPERTY(IrcConnection* connection READ connection WRITE setConnection)
 
 public:
@@ -58,6 +60,12 @@ public:
     int interval() const;
     void setInterval(int seconds);
 
+    int timeout() const;
+    void setTimeout(int seconds);
+
+    bool isAdaptive() const;
+    void setAdaptive(bool adaptive);
+
 Q_SIGNALS:
     void lagChanged(qint64 lag);
 
@@ -69,6 +77,9 @@ private:
     Q_PRIVATE_SLOT(d_func(), void _irc_connected())
     Q_PRIVATE_SLOT(d_func(), void _irc_pingServer())
     Q_PRIVATE_SLOT(d_func(), void _irc_disconnected())
+    Q_PRIVATE_SLOT(d_func(), void _irc_timeout())
+    Q_PRIVATE_SLOT(d_func(), void _irc_updateSocket())
+    Q_PRIVATE_SLOT(d_func(), void _irc_dataReceived())
 };
 
 IRC_END_NAMESPACE
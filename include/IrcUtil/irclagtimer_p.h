@@ -32,6 +32,9 @@
 #include "irclagtimer.h"
 #include "ircfilter.h"
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QAbstractSocket>
 
 IRC_BEGIN_NAMESPACE
 
@@ -46,22 +49,40 @@ class IrcLagTimerPrivate : public QObject,  public IrcMessageFilter
 public:
     IrcLagTimerPrivate();
 
+    static IrcLagTimerPrivate* get(IrcLagTimer* timer)
+    {
+        return timer->d_func();
+    }
+
     bool messageFilter(IrcMessage* msg) override;
     bool processPongReply(IrcPongMessage* msg);
 
     void _irc_connected();
     void _irc_pingServer();
     void _irc_disconnected();
+    void _irc_timeout();
+    void _irc_updateSocket();
+    void _irc_dataReceived();
 
     void updateTimer();
     void updateLag(qint64 value);
+    void updatePeriod(qint64 value);
+    int baseInterval() const;
 
     IrcLagTimer* q_ptr = nullptr;
     IrcConnection* connection = nullptr;
+    QPointer<QAbstractSocket> socket;
     QTimer timer;
+    QTimer deadline;
     int interval;
+    int timeout = 0;
     int pendingPings = 0;
     qint64 lag = -1;
+    bool adaptive = false;
+    int period = 0;
+    QElapsedTimer clock;
+    qint64 received = 0;
+    qint64 pinged = 0;
 };
 
 IRC_END_NAMESPACE
@@ -0,0 +1,104 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef IRCSEARCHINDEX_P_H
+#define IRCSEARCHINDEX_P_H
+
+#include "ircsearchindex.h"
+#include "irctextformat.h"
+#include "ircbuffertracker_p.h"
+
+#include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QTimer>
+#include <QStringList>
+
+IRC_BEGIN_NAMESPACE
+
+// an indexed message: the id of a document is its position in the index
+struct IrcSearchDocument
+{
+    qint64 time;
+    int buffer;
+    int nick;
+    QString msgid; // locates the message in the log
+};
+
+// a parsed query: all clauses must match
+struct IrcSearchQuery
+{
+    QList<QStringList> phrases; // a single word is a phrase of one
+    QStringList prefixes;
+    QStringList nicks;
+    QStringList buffers;
+};
+
+class IrcSearchIndexPrivate
+{
+    Q_DECLARE_PUBLIC(IrcSearchIndex)
+
+public:
+    static QStringList tokenize(const QString& text);
+    static IrcSearchQuery parseQuery(const QString& query);
+
+    QVector<int> findStrings(const QString& str) const;
+    int addString(const QString& str);
+    int addTerm(const QString& term);
+    void addDocument(qint64 time, int buffer, int nick, const QString& msgid, const QVector<int>& tokens);
+
+    QVector<quint32> phraseDocuments(const QStringList& phrase) const;
+    QVector<quint32> prefixDocuments(const QString& prefix) const;
+
+    bool open();
+    void close();
+    bool load(const QByteArray& data, qint64* valid);
+    void reset();
+    void scheduleFlush();
+
+    void _irc_bufferAdded(IrcBuffer* buffer);
+    void _irc_bufferRemoved(IrcBuffer* buffer);
+    void _irc_messageReceived(IrcMessage* message);
+
+    IrcSearchIndex* q_ptr = nullptr;
+    QString directory;
+    IrcBufferTracker tracker;
+    IrcTextFormat format;
+    QVector<IrcSearchDocument> documents;
+    QMap<QString, int> terms; // sorted for prefix queries
+    QVector<QVector<quint64> > postings; // per term: (document << 32 | position), ascending
+    QStringList strings;
+    QHash<QString, int> stringIds; // as is, casemapped at lookup
+    QFile file;
+    QTimer flushTimer;
+};
+
+IRC_END_NAMESPACE
+
+#endif // IRCSEARCHINDEX_P_H
@@ -34,6 +34,7 @@
 #include "irccompleter.h"
 #include "irclagtimer.h"
 #include "ircpalette.h"
+#include "ircsearchindex.h"
 #include "irctextformat.h"
 
 IRC_BEGIN_NAMESPACE
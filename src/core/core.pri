@@ -12,13 +12,20 @@ INCLUDEPATH += $$PWD $$INCDIR
 CONV_HEADERS  = $$INCDIR/Irc
 CONV_HEADERS += $$INCDIR/IrcCommand
 CONV_HEADERS += $$INCDIR/IrcCommandFilter
+CONV_HEADERS += $$INCDIR/IrcCommandValue
+CONV_HEADERS += $$INCDIR/IrcCommandValueFilter
 CONV_HEADERS += $$INCDIR/IrcConnection
 CONV_HEADERS += $$INCDIR/IrcCore
 CONV_HEADERS += $$INCDIR/IrcGlobal
+CONV_HEADERS += $$INCDIR/IrcLine
+CONV_HEADERS += $$INCDIR/IrcLineHandler
 CONV_HEADERS += $$INCDIR/IrcMessage
 CONV_HEADERS += $$INCDIR/IrcMessageFilter
+CONV_HEADERS += $$INCDIR/IrcMessageRing
 CONV_HEADERS += $$INCDIR/IrcNetwork
+CONV_HEADERS += $$INCDIR/IrcPipe
 CONV_HEADERS += $$INCDIR/IrcProtocol
+CONV_HEADERS += $$INCDIR/IrcReply
 
 PUB_HEADERS  = $$INCDIR/irc.h
 PUB_HEADERS += $$INCDIR/irccommand.h
@@ -26,9 +33,13 @@ PUB_HEADERS += $$INCDIR/ircconnection.h
 PUB_HEADERS += $$INCDIR/irccore.h
 PUB_HEADERS += $$INCDIR/ircfilter.h
 PUB_HEADERS += $$INCDIR/ircglobal.h
+PUB_HEADERS += $$INCDIR/ircline.h
 PUB_HEADERS += $$INCDIR/ircmessage.h
+PUB_HEADERS += $$INCDIR/ircmessagering.h
 PUB_HEADERS += $$INCDIR/ircnetwork.h
+PUB_HEADERS += $$INCDIR/ircpipe.h
 PUB_HEADERS += $$INCDIR/ircprotocol.h
+PUB_HEADERS += $$INCDIR/ircreply.h
 
 PRIV_HEADERS  = $$INCDIR/irccommand_p.h
 PRIV_HEADERS += $$INCDIR/ircconnection_p.h
@@ -37,7 +48,10 @@ PRIV_HEADERS += $$INCDIR/ircdebug_p.h
 PRIV_HEADERS += $$INCDIR/ircmessage_p.h
 PRIV_HEADERS += $$INCDIR/ircmessagecomposer_p.h
 PRIV_HEADERS += $$INCDIR/ircmessagedecoder_p.h
+PRIV_HEADERS += $$INCDIR/ircmessagering_p.h
 PRIV_HEADERS += $$INCDIR/ircnetwork_p.h
+PRIV_HEADERS += $$INCDIR/ircpipe_p.h
+PRIV_HEADERS += $$INCDIR/ircreply_p.h
 
 HEADERS += $$PUB_HEADERS
 HEADERS += $$PRIV_HEADERS
@@ -47,12 +61,16 @@ SOURCES += $$PWD/irccommand.cpp
 SOURCES += $$PWD/ircconnection.cpp
 SOURCES += $$PWD/irccore.cpp
 SOURCES += $$PWD/ircfilter.cpp
+SOURCES += $$PWD/ircline.cpp
 SOURCES += $$PWD/ircmessage.cpp
 SOURCES += $$PWD/ircmessage_p.cpp
 SOURCES += $$PWD/ircmessagecomposer.cpp
 SOURCES += $$PWD/ircmessagedecoder.cpp
+SOURCES += $$PWD/ircmessagering.cpp
 SOURCES += $$PWD/ircnetwork.cpp
+SOURCES += $$PWD/ircpipe.cpp
 SOURCES += $$PWD/ircprotocol.cpp
+SOURCES += $$PWD/ircreply.cpp
 
 include(pkg.pri)
 
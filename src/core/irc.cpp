@@ -113,6 +113,7 @@ QStringList Irc::supportedCapabilities()
                          << QLatin1String("echo-message")
                          << QLatin1String("extended-join")
                          << QLatin1String("invite-notify")
+                         << QLatin1String("labeled-response")
                          << QLatin1String("multi-prefix")
                          << QLatin1String("sasl")
                          << QLatin1String("server-time")
@@ -268,11 +268,58 @@ IrcCommandPrivate::IrcCommandPrivate() :  encoding("UTF-8")
 {
 }
 
-QString IrcCommandPrivate::params(int index) const
+QString IrcCommandPrivate::params(const QStringList& parameters, int index)
 {
     return QStringList(parameters.mid(index)).join(QLatin1String(" "));
 }
 
+QString IrcCommandPrivate::toString(IrcCommand::Type type, const QStringList& parameters)
+{
+    const QString p0 = parameters.value(0);
+    const QString p1 = parameters.value(1);
+    const QString p2 = parameters.value(2);
+
+    switch (type) {
+        case IrcCommand::Admin:          return QString("ADMIN %1").arg(p0); // server
+        case IrcCommand::Away:           return QString("AWAY :%1").arg(params(parameters, 0)); // reason
+        case IrcCommand::Capability:     return QString("CAP %1 :%2").arg(p0, params(parameters, 1)); // subcmd, caps
+        case IrcCommand::CtcpAction:     return QString("PRIVMSG %1 :\1ACTION %2\1").arg(p0, params(parameters, 1)); // target, msg
+        case IrcCommand::CtcpRequest:    return QString("PRIVMSG %1 :\1%2\1").arg(p0, params(parameters, 1)); // target, msg
+        case IrcCommand::CtcpReply:      return QString("NOTICE %1 :\1%2\1").arg(p0, params(parameters, 1)); // target, msg
+        case IrcCommand::Info:           return QString("INFO %1").arg(p0); // server
+        case IrcCommand::Invite:         return QString("INVITE %1 %2").arg(p0, p1); // user, chan
+        case IrcCommand::Join:           return p1.isNull() ? QString("JOIN %1").arg(p0) : QString("JOIN %1 %2").arg(p0, p1); // chan, key
+        case IrcCommand::Kick:           return p2.isNull() ? QString("KICK %1 %2").arg(p0, p1) : QString("KICK %1 %2 :%3").arg(p0, p1, params(parameters, 2)); // chan, user, reason
+        case IrcCommand::Knock:          return QString("KNOCK %1 %2").arg(p0, p1); // chan, msg
+        case IrcCommand::List:           return p1.isNull() ? QString("LIST %1").arg(p0) : QString("LIST %1 %2").arg(p0, p1); // chan, server
+        case IrcCommand::Message:        return QString("PRIVMSG %1 :%2").arg(p0, params(parameters, 1)); // target, msg
+        case IrcCommand::Mode:           return QString("MODE ") + parameters.join(" "); // target, mode, arg
+        case IrcCommand::Monitor:        return QString("MONITOR %1 %2").arg(p0, p1); // cmd, target
+        case IrcCommand::Motd:           return QString("MOTD %1").arg(p0); // server
+        case IrcCommand::Names:          return QString("NAMES %1").arg(p0); // chan
+        case IrcCommand::Nick:           return QString("NICK %1").arg(p0); // nick
+        case IrcCommand::Notice:         return QString("NOTICE %1 :%2").arg(p0, params(parameters, 1)); // target, msg
+        case IrcCommand::Part:           return p1.isNull() ? QString("PART %1").arg(p0) : QString("PART %1 :%2").arg(p0, params(parameters, 1)); // chan, reason
+        case IrcCommand::Ping:           return QString("PING %1").arg(p0); // argument
+        case IrcCommand::Pong:           return QString("PONG %1").arg(p0); // argument
+        case IrcCommand::Quit:           return QString("QUIT :%1").arg(params(parameters, 0)); // reason
+        case IrcCommand::Quote:          return parameters.join(" ");
+        case IrcCommand::Stats:          return QString("STATS %1 %2").arg(p0, p1); // query, server
+        case IrcCommand::Time:           return QString("TIME %1").arg(p0); // server
+        case IrcCommand::Topic:          return p1.isNull() ? QString("TOPIC %1").arg(p0) : QString("TOPIC %1 :%2").arg(p0, params(parameters, 1)); // chan, topic
+        case IrcCommand::Trace:          return QString("TRACE %1").arg(p0); // target
+        case IrcCommand::Users:          return QString("USERS %1").arg(p0); // server
+        case IrcCommand::Version:        return p0.isNull() ? QString("VERSION") : QString("PRIVMSG %1 :\1VERSION\1").arg(p0); // user
+        case IrcCommand::Who:            return QString("WHO %1").arg(p0); // user
+        case IrcCommand::Whois:          return QString("WHOIS %1 %1").arg(p0); // user
+        case IrcCommand::Whowas:         return QString("WHOWAS %1 %1").arg(p0); // user
+
+        case IrcCommand::Custom:         qWarning("Reimplement IrcCommand::toString() for IrcCommand::Custom");
+        Q_FALLTHROUGH();
+        default:                         return QString();
+    }
+}
+
 IrcCommand* IrcCommandPrivate::createCommand(IrcCommand::Type type, const QStringList& parameters)
 {
     IrcCommand* command = new IrcCommand;
@@ -405,49 +452,7 @@ void IrcCommand::setEncoding(const QByteArray& encoding)
 QString IrcCommand::toString() const
 {
     Q_D(const IrcCommand);
-    const QString p0 = d->parameters.value(0);
-    const QString p1 = d->parameters.value(1);
-    const QString p2 = d->parameters.value(2);
-
-    switch (d->type) {
-        case Admin:         return QString("ADMIN %1").arg(p0); // server
-        case Away:          return QString("AWAY :%1").arg(d->params(0)); // reason
-        case Capability:    return QString("CAP %1 :%2").arg(p0, d->params(1)); // subcmd, caps
-        case CtcpAction:    return QString("PRIVMSG %1 :\1ACTION %2\1").arg(p0, d->params(1)); // target, msg
-        case CtcpRequest:   return QString("PRIVMSG %1 :\1%2\1").arg(p0, d->params(1)); // target, msg
-        case CtcpReply:     return QString("NOTICE %1 :\1%2\1").arg(p0, d->params(1)); // target, msg
-        case Info:          return QString("INFO %1").arg(p0); // server
-        case Invite:        return QString("INVITE %1 %2").arg(p0, p1); // user, chan
-        case Join:          return p1.isNull() ? QString("JOIN %1").arg(p0) : QString("JOIN %1 %2").arg(p0, p1); // chan, key
-        case Kick:          return p2.isNull() ? QString("KICK %1 %2").arg(p0, p1) : QString("KICK %1 %2 :%3").arg(p0, p1, d->params(2)); // chan, user, reason
-        case Knock:         return QString("KNOCK %1 %2").arg(p0, p1); // chan, msg
-        case List:          return p1.isNull() ? QString("LIST %1").arg(p0) : QString("LIST %1 %2").arg(p0, p1); // chan, server
-        case Message:       return QString("PRIVMSG %1 :%2").arg(p0, d->params(1)); // target, msg
-        case Mode:          return QString("MODE ") + d->parameters.join(" "); // target, mode, arg
-        case Monitor:       return QString("MONITOR %1 %2").arg(p0, p1); // cmd, target
-        case Motd:          return QString("MOTD %1").arg(p0); // server
-        case Names:         return QString("NAMES %1").arg(p0); // chan
-        case Nick:          return QString("NICK %1").arg(p0); // nick
-        case Notice:        return QString("NOTICE %1 :%2").arg(p0, d->params(1)); // target, msg
-        case Part:          return p1.isNull() ? QString("PART %1").arg(p0) : QString("PART %1 :%2").arg(p0, d->params(1)); // chan, reason
-        case Ping:          return QString("PING %1").arg(p0); // argument
-        case Pong:          return QString("PONG %1").arg(p0); // argument
-        case Quit:          return QString("QUIT :%1").arg(d->params(0)); // reason
-        case Quote:         return d->parameters.join(" ");
-        case Stats:         return QString("STATS %1 %2").arg(p0, p1); // query, server
-        case Time:          return QString("TIME %1").arg(p0); // server
-        case Topic:         return p1.isNull() ? QString("TOPIC %1").arg(p0) : QString("TOPIC %1 :%2").arg(p0, d->params(1)); // chan, topic
-        case Trace:         return QString("TRACE %1").arg(p0); // target
-        case Users:         return QString("USERS %1").arg(p0); // server
-        case Version:       return p0.isNull() ? QString("VERSION") : QString("PRIVMSG %1 :\1VERSION\1").arg(p0); // user
-        case Who:           return QString("WHO %1").arg(p0); // user
-        case Whois:         return QString("WHOIS %1 %1").arg(p0); // user
-        case Whowas:        return QString("WHOWAS %1 %1").arg(p0); // user
-
-        case Custom:        qWarning("Reimplement IrcCommand::toString() for IrcCommand::Custom");
-        Q_FALLTHROUGH();
-        default:            return QString();
-    }
+    return IrcCommandPrivate::toString(d->type, d->parameters);
 }
 
 /*!
@@ -899,6 +904,196 @@ IrcCommand* IrcCommand::createWhowas(const QString& user, int count)
     return IrcCommandPrivate::createCommand(Whowas, QStringList() << user << QString::number(count));
 }
 
+/*!
+    \since 3.7
+    \class IrcCommandValue irccommand.h <IrcCommandValue>
+    \ingroup core
+    \brief Provides a lightweight value type for commands.
+
+    IrcCommandValue holds the type, parameters and encoding of a command
+    without allocating a QObject. It is meant for the hot send path, for
+    example bots that send large amounts of replies:
+
+    \code
+    connection->sendCommand(IrcCommandValue::createMessage(target, reply));
+    \endcode
+
+    Command values pass through filters that implement IrcCommandValueFilter
+    as is. An IrcCommand instance is created on demand only if a legacy
+    IrcCommandFilter has been installed on the connection.
+
+    \note Command values always format the built-in command types. Custom
+    commands that reimplement IrcCommand::toString() must be sent as
+    IrcCommand instances.
+
+    \sa IrcConnection::sendCommand(), IrcCommandValueFilter
+ */
+
+/*!
+    Constructs an empty command value of type IrcCommand::Custom.
+ */
+IrcCommandValue::IrcCommandValue() : m_type(IrcCommand::Custom), m_encoding("UTF-8")
+{
+}
+
+/*!
+    Constructs a command value with \a type and \a parameters.
+ */
+IrcCommandValue::IrcCommandValue(IrcCommand::Type type, const QStringList& parameters) :
+    m_type(type), m_parameters(parameters), m_encoding("UTF-8")
+{
+}
+
+/*!
+    This property holds the command type.
+
+    \par Access functions:
+    \li IrcCommand::Type <b>type</b>() const
+    \li void <b>setType</b>(IrcCommand::Type type)
+ */
+IrcCommand::Type IrcCommandValue::type() const
+{
+    return m_type;
+}
+
+void IrcCommandValue::setType(IrcCommand::Type type)
+{
+    m_type = type;
+}
+
+/*!
+    This property holds the command parameters.
+
+    \par Access functions:
+    \li QStringList <b>parameters</b>() const
+    \li void <b>setParameters</b>(const QStringList& parameters)
+ */
+QStringList IrcCommandValue::parameters() const
+{
+    return m_parameters;
+}
+
+void IrcCommandValue::setParameters(const QStringList& parameters)
+{
+    m_parameters = parameters;
+}
+
+/*!
+    This property holds the encoding that is used when
+    sending the command via IrcConnection::sendCommand().
+
+    The default value is \c "UTF-8".
+
+    \par Access functions:
+    \li QByteArray <b>encoding</b>() const
+    \li void <b>setEncoding</b>(const QByteArray& encoding)
+
+    \sa IrcCommand::encoding
+ */
+QByteArray IrcCommandValue::encoding() const
+{
+    return m_encoding;
+}
+
+void IrcCommandValue::setEncoding(const QByteArray& encoding)
+{
+    if (!irc_is_supported_encoding(encoding)) {
+        qWarning() << "IrcCommandValue::setEncoding(): unsupported encoding" << encoding;
+        return;
+    }
+    m_encoding = encoding;
+}
+
+/*!
+    Returns the command as a string.
+ */
+QString IrcCommandValue::toString() const
+{
+    return IrcCommandPrivate::toString(m_type, m_parameters);
+}
+
+/*!
+    Creates a new IrcCommand instance with \a parent from this value.
+
+    \sa fromCommand()
+ */
+IrcCommand* IrcCommandValue::toCommand(QObject* parent) const
+{
+    IrcCommand* command = new IrcCommand(parent);
+    IrcCommandPrivate* priv = IrcCommandPrivate::get(command);
+    priv->type = m_type;
+    priv->parameters = m_parameters;
+    priv->encoding = m_encoding;
+    return command;
+}
+
+/*!
+    Returns a command value that holds the type, parameters and encoding of \a command.
+
+    \sa toCommand()
+ */
+IrcCommandValue IrcCommandValue::fromCommand(const IrcCommand* command)
+{
+    IrcCommandValue value;
+    if (command) {
+        const IrcCommandPrivate* priv = IrcCommandPrivate::get(command);
+        value.m_type = priv->type;
+        value.m_parameters = priv->parameters;
+        value.m_encoding = priv->encoding;
+    }
+    return value;
+}
+
+/*!
+    Returns a command value of type IrcCommand::CtcpAction with parameters \a target and \a action.
+
+    \sa IrcCommand::createCtcpAction()
+ */
+IrcCommandValue IrcCommandValue::createCtcpAction(const QString& target, const QString& action)
+{
+    return IrcCommandValue(IrcCommand::CtcpAction, QStringList() << target << action);
+}
+
+/*!
+    Returns a command value of type IrcCommand::CtcpReply with parameters \a target and \a reply.
+
+    \sa IrcCommand::createCtcpReply()
+ */
+IrcCommandValue IrcCommandValue::createCtcpReply(const QString& target, const QString& reply)
+{
+    return IrcCommandValue(IrcCommand::CtcpReply, QStringList() << target << reply);
+}
+
+/*!
+    Returns a command value of type IrcCommand::Message with parameters \a target and \a message.
+
+    \sa IrcCommand::createMessage()
+ */
+IrcCommandValue IrcCommandValue::createMessage(const QString& target, const QString& message)
+{
+    return IrcCommandValue(IrcCommand::Message, QStringList() << target << message);
+}
+
+/*!
+    Returns a command value of type IrcCommand::Notice with parameters \a target and \a notice.
+
+    \sa IrcCommand::createNotice()
+ */
+IrcCommandValue IrcCommandValue::createNotice(const QString& target, const QString& notice)
+{
+    return IrcCommandValue(IrcCommand::Notice, QStringList() << target << notice);
+}
+
+/*!
+    Returns a command value of type IrcCommand::Quote with parameter \a raw.
+
+    \sa IrcCommand::createQuote()
+ */
+IrcCommandValue IrcCommandValue::createQuote(const QString& raw)
+{
+    return IrcCommandValue(IrcCommand::Quote, QStringList() << raw);
+}
+
 #ifndef QT_NO_DEBUG_STREAM
 QDebug operator<<(QDebug debug, IrcCommand::Type type)
 {
@@ -923,6 +1118,16 @@ QDebug operator<<(QDebug debug, const IrcCommand* command)
     debug.nospace() << ')';
     return debug.space();
 }
+
+QDebug operator<<(QDebug debug, const IrcCommandValue& command)
+{
+    debug.nospace() << "IrcCommandValue(type=" << command.type();
+    QString str = command.toString();
+    if (!str.isEmpty())
+        debug.nospace() << ", " << str.left(20);
+    debug.nospace() << ')';
+    return debug.space();
+}
 #endif // QT_NO_DEBUG_STREAM
 
 #include "moc_irccommand.cpp"
@@ -30,6 +30,8 @@
 #include "ircconnection_p.h"
 #include "ircnetwork_p.h"
 #include "irccommand_p.h"
+#include "ircmessagecomposer_p.h"
+#include "ircreply_p.h"
 #include "ircprotocol.h"
 #include "ircnetwork.h"
 #include "irccommand.h"
@@ -52,6 +54,11 @@
 #endif // QT_NO_SSL
 #include <QDataStream>
 #include <QVariantMap>
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif // Q_OS_UNIX
 
 IRC_BEGIN_NAMESPACE
 
@@ -266,6 +273,8 @@ void IrcConnectionPrivate::init(IrcConnection* connection)
     connection->setSocket(new QTcpSocket(connection));
     connection->setProtocol(new IrcProtocol(connection));
     QObject::connect(&reconnecter, SIGNAL(timeout()), connection, SLOT(_irc_reconnect()));
+    requestTimer.setSingleShot(true);
+    QObject::connect(&requestTimer, SIGNAL(timeout()), connection, SLOT(_irc_finishRequests()));
 }
 
 void IrcConnectionPrivate::_irc_connected()
@@ -274,8 +283,11 @@ void IrcConnectionPrivate::_irc_connected()
     closed = false;
     pendingOpen = false;
     emit q->connecting();
-    if (q->isSecure())
+    applySocketOptions();
+    if (q->isSecure()) {
+        prepareSession();
         QMetaObject::invokeMethod(socket, "startClientEncryption");
+    }
     protocol->open();
 }
 
@@ -291,6 +303,8 @@ void IrcConnectionPrivate::_irc_error(QAbstractSocket::SocketError error)
 {
     Q_Q(IrcConnection);
     if (error == QAbstractSocket::SslHandshakeFailedError) {
+        // don't offer a session that the server may have choked on
+        sslSessions.remove(sessionKey());
         ircDebug(q, IrcDebug::Error) << error;
         setStatus(IrcConnection::Error);
         emit q->secureError();
@@ -321,6 +335,33 @@ void IrcConnectionPrivate::_irc_sslErrors()
     emit q->secureError();
 }
 
+void IrcConnectionPrivate::_irc_encrypted()
+{
+#ifndef QT_NO_SSL
+    Q_Q(IrcConnection);
+    QSslSocket* ssl = qobject_cast<QSslSocket*>(socket);
+    if (ssl) {
+        // whether the server accepted the offered session is not exposed
+        emit q->handshakeCountChanged(++handshakeCount);
+        if (!offeredSession.isEmpty())
+            emit q->sessionOfferCountChanged(++sessionOfferCount);
+        _irc_sessionTicket();
+    }
+#endif // !QT_NO_SSL
+}
+
+void IrcConnectionPrivate::_irc_sessionTicket()
+{
+#ifndef QT_NO_SSL
+    QSslSocket* ssl = qobject_cast<QSslSocket*>(socket);
+    if (ssl && sessionResumption) {
+        const QByteArray session = ssl->sslConfiguration().sessionTicket();
+        if (!session.isEmpty())
+            sslSessions.insert(sessionKey(), session);
+    }
+#endif // !QT_NO_SSL
+}
+
 void IrcConnectionPrivate::_irc_state(QAbstractSocket::SocketState state)
 {
     Q_Q(IrcConnection);
@@ -436,11 +477,69 @@ void IrcConnectionPrivate::setStatus(IrcConnection::Status value)
             foreach (const QByteArray& data, pendingData)
                 q->sendRaw(data);
             pendingData.clear();
+        } else if (wasConnected && !q->isConnected()) {
+            abortRequests(IrcReply::ConnectionError);
         }
         ircDebug(q, IrcDebug::Status) << status << qPrintable(host) << port;
     }
 }
 
+void IrcConnectionPrivate::prepareSession()
+{
+#ifndef QT_NO_SSL
+    QSslSocket* ssl = qobject_cast<QSslSocket*>(socket);
+    if (ssl) {
+        QSslConfiguration config = ssl->sslConfiguration();
+        config.setSslOption(QSsl::SslOptionDisableSessionPersistence, !sessionResumption);
+        offeredSession = sessionResumption ? sslSessions.value(sessionKey()) : QByteArray();
+        config.setSessionTicket(offeredSession);
+        ssl->setSslConfiguration(config);
+    }
+#endif // !QT_NO_SSL
+}
+
+void IrcConnectionPrivate::applySocketOptions()
+{
+    // options are reset with every new socket descriptor, so apply on each connect
+    if (lowDelay)
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    if (keepAliveInterval > 0)
+        socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+    if (sendBufferSize > 0)
+        socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, sendBufferSize);
+    if (receiveBufferSize > 0)
+        socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receiveBufferSize);
+
+#ifdef Q_OS_UNIX
+    const int fd = static_cast<int>(socket->socketDescriptor());
+    if (fd != -1 && keepAliveInterval > 0) {
+        // probe after an idle interval, and give up after three unanswered probes
+        const int idle = keepAliveInterval;
+        const int interval = qMax(1, keepAliveInterval / 3);
+        const int count = 3;
+#if defined(TCP_KEEPIDLE)
+        ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+#elif defined(TCP_KEEPALIVE)
+        ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, &idle, sizeof(idle));
+#endif
+#ifdef TCP_KEEPINTVL
+        ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+#endif
+#ifdef TCP_KEEPCNT
+        ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+#endif
+        Q_UNUSED(idle);
+        Q_UNUSED(interval);
+        Q_UNUSED(count);
+    }
+#endif // Q_OS_UNIX
+}
+
+QString IrcConnectionPrivate::sessionKey() const
+{
+    return host.toLower() + QLatin1Char(':') + QString::number(port);
+}
+
 void IrcConnectionPrivate::setInfo(const QHash<QString, QString>& info)
 {
     Q_Q(IrcConnection);
@@ -455,6 +554,9 @@ void IrcConnectionPrivate::setInfo(const QHash<QString, QString>& info)
 bool IrcConnectionPrivate::receiveMessage(IrcMessage* msg)
 {
     Q_Q(IrcConnection);
+    if (!requests.isEmpty())
+        collectReply(msg);
+
     if (msg->type() == IrcMessage::Join && msg->isOwn()) {
         replies.clear();
     } else if (msg->type() == IrcMessage::Numeric) {
@@ -564,6 +666,286 @@ bool IrcConnectionPrivate::receiveMessage(IrcMessage* msg)
     return !filtered;
 }
 
+IrcPendingRequest* IrcConnectionPrivate::findRequest(IrcCommand::Type type, const QString& target) const
+{
+    foreach (IrcPendingRequest* request, requests) {
+        if (request->type == type && !request->ended && request->label.isEmpty() && request->target == target)
+            return request;
+    }
+    return nullptr;
+}
+
+void IrcConnectionPrivate::collectReply(IrcMessage* msg)
+{
+    const QString label = msg->tag(QStringLiteral("label")).toString();
+    if (!label.isEmpty()) {
+        foreach (IrcPendingRequest* request, requests) {
+            if (request->label == label && !request->ended) {
+                collectLabeledReply(request, msg);
+                request->ended = true;
+                break;
+            }
+        }
+        return;
+    }
+
+    IrcPendingRequest* request = nullptr;
+    switch (msg->type()) {
+    case IrcMessage::Whois:
+        request = findRequest(IrcCommand::Whois, msg->nick().toLower());
+        if (request)
+            request->messages += msg->clone();
+        break;
+    case IrcMessage::WhoReply:
+        request = findRequest(IrcCommand::Who, static_cast<IrcWhoReplyMessage*>(msg)->mask().toLower());
+        if (!request)
+            request = findRequest(IrcCommand::Who, msg->nick().toLower());
+        if (!request) {
+            // replies to wildcard masks carry no trace of the mask, but
+            // servers answer queries in order
+            foreach (IrcPendingRequest* pending, requests) {
+                if (pending->type == IrcCommand::Who && !pending->ended && pending->label.isEmpty()
+                        && (pending->target.contains(QLatin1Char('*')) || pending->target.contains(QLatin1Char('?')))) {
+                    request = pending;
+                    break;
+                }
+            }
+        }
+        if (request)
+            request->messages += msg->clone();
+        break;
+    case IrcMessage::Mode:
+        if (msg->command() == QString::number(Irc::RPL_CHANNELMODEIS)) {
+            request = findRequest(IrcCommand::Mode, static_cast<IrcModeMessage*>(msg)->target().toLower());
+            if (request) {
+                request->messages += msg->clone();
+                request->ended = true;
+            }
+        }
+        break;
+    case IrcMessage::Numeric: {
+        const QString param = msg->parameters().value(1).toLower();
+        switch (static_cast<IrcNumericMessage*>(msg)->code()) {
+        case Irc::RPL_ENDOFWHOIS:
+            // the composed IrcWhoisMessage is delivered after the raw
+            // end of whois, so the request ends once it has been received
+            request = findRequest(IrcCommand::Whois, param);
+            if (request)
+                request->closing = true;
+            break;
+        case Irc::RPL_ENDOFWHO:
+            request = findRequest(IrcCommand::Who, param);
+            if (request)
+                request->ended = true;
+            break;
+        case Irc::RPL_UMODEIS:
+            request = findRequest(IrcCommand::Mode, nickName.toLower());
+            if (request) {
+                request->messages += msg->clone();
+                request->ended = true;
+            }
+            break;
+        case Irc::ERR_NOSUCHNICK:
+            request = findRequest(IrcCommand::Whois, param);
+            if (request) {
+                // RPL_ENDOFWHOIS follows
+                request->messages += msg->clone();
+                request->error = IrcReply::ServerError;
+                break;
+            }
+            Q_FALLTHROUGH();
+        case Irc::ERR_NOSUCHCHANNEL:
+            request = findRequest(IrcCommand::Mode, param);
+            if (request) {
+                request->messages += msg->clone();
+                request->error = IrcReply::ServerError;
+                request->ended = true;
+            }
+            break;
+        case Irc::ERR_NOSUCHSERVER:
+            request = findRequest(IrcCommand::Whois, param);
+            if (request) {
+                request->messages += msg->clone();
+                request->error = IrcReply::ServerError;
+                request->ended = true;
+            }
+            break;
+        case Irc::ERR_USERSDONTMATCH:
+            foreach (IrcPendingRequest* pending, requests) {
+                if (pending->type == IrcCommand::Mode && !pending->ended && pending->label.isEmpty() && !network->isChannel(pending->target)) {
+                    pending->messages += msg->clone();
+                    pending->error = IrcReply::ServerError;
+                    pending->ended = true;
+                    break;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void IrcConnectionPrivate::collectLabeledReply(IrcPendingRequest* request, IrcMessage* msg)
+{
+    Q_Q(IrcConnection);
+    QList<IrcMessage*> messages;
+    if (msg->type() == IrcMessage::Batch)
+        messages = static_cast<IrcBatchMessage*>(msg)->messages();
+    else
+        messages += msg;
+
+    // batched numerics bypass the protocol's composer, so compose them
+    // here to deliver the same messages as unlabeled replies
+    IrcMessageComposer composer(q);
+    QObject::connect(&composer, &IrcMessageComposer::messageComposed, [=](IrcMessage* composed) {
+        composed->setParent(nullptr);
+        request->messages += composed;
+    });
+
+    foreach (IrcMessage* message, messages) {
+        if (message->type() == IrcMessage::Numeric) {
+            IrcNumericMessage* numeric = static_cast<IrcNumericMessage*>(message);
+            if (IrcMessageComposer::isComposed(numeric->code())) {
+                composer.composeMessage(numeric);
+                continue;
+            }
+            if (numeric->code() >= 400 && numeric->code() < 600)
+                request->error = IrcReply::ServerError;
+        } else if (message->command() == QLatin1String("ACK")) {
+            continue;
+        }
+        request->messages += message->clone();
+    }
+}
+
+void IrcConnectionPrivate::finishRequests()
+{
+    QList<IrcPendingRequest*> finished;
+    QMutableListIterator<IrcPendingRequest*> it(requests);
+    while (it.hasNext()) {
+        IrcPendingRequest* request = it.next();
+        if (request->closing)
+            request->ended = true;
+        if (request->ended || request->isOrphaned() || request->started.hasExpired(request->deadline())) {
+            if (!request->ended)
+                request->error = IrcReply::TimeoutError;
+            finished += request;
+            it.remove();
+        }
+    }
+
+    foreach (IrcPendingRequest* request, finished) {
+        foreach (const QPointer<IrcReply>& reply, request->replies) {
+            if (reply)
+                IrcReplyPrivate::get(reply)->finish(request->error, request->messages);
+        }
+        delete request;
+    }
+    scheduleRequests();
+}
+
+void IrcConnectionPrivate::scheduleRequests()
+{
+    // wake up for the request that expires first
+    qint64 next = -1;
+    foreach (IrcPendingRequest* request, requests) {
+        const qint64 left = qMax<qint64>(0, request->deadline() - request->started.elapsed());
+        if (next == -1 || left < next)
+            next = left;
+    }
+    if (next == -1)
+        requestTimer.stop();
+    else
+        requestTimer.start(static_cast<int>(next));
+}
+
+void IrcConnectionPrivate::_irc_finishRequests()
+{
+    finishRequests();
+}
+
+void IrcConnectionPrivate::abortRequests(IrcReply::Error error)
+{
+    const QList<IrcPendingRequest*> aborted = requests;
+    requests.clear();
+    requestTimer.stop();
+    foreach (IrcPendingRequest* request, aborted) {
+        foreach (const QPointer<IrcReply>& reply, request->replies) {
+            if (reply)
+                IrcReplyPrivate::get(reply)->finish(error);
+        }
+        delete request;
+    }
+}
+
+static const int MAX_CTCP_USER_BUCKETS = 256;
+
+static void refillCtcpBucket(IrcCtcpBucket* bucket, int limit, int interval, qint64 now)
+{
+    // token bucket: refills at the rate of limit tokens per interval
+    if (bucket->stamp < 0)
+        bucket->tokens = limit;
+    else
+        bucket->tokens = qMin<qreal>(limit, bucket->tokens + (now - bucket->stamp) * limit / (interval * 1000.0));
+    bucket->stamp = now;
+}
+
+bool IrcConnectionPrivate::hasDefaultCtcpReply(IrcPrivateMessage* request) const
+{
+    const QString type = request->content().section(QLatin1Char(' '), 0, 0, QString::SectionSkipEmpty).toUpper();
+    return ctcpReplies.contains(type) || type == QLatin1String("PING") || type == QLatin1String("TIME")
+            || type == QLatin1String("VERSION") || type == QLatin1String("SOURCE") || type == QLatin1String("CLIENTINFO");
+}
+
+bool IrcConnectionPrivate::acceptCtcpRequest(const QString& nick)
+{
+    if (ctcpReplyLimit <= 0 && ctcpReplyUserLimit <= 0)
+        return true;
+
+    if (!ctcpClock.isValid())
+        ctcpClock.start();
+    const qint64 now = ctcpClock.elapsed();
+
+    IrcCtcpBucket* userBucket = nullptr;
+    if (ctcpReplyUserLimit > 0) {
+        const QString key = IrcNetworkPrivate::casemap(network, nick);
+        if (!ctcpUserBuckets.contains(key) && ctcpUserBuckets.count() >= MAX_CTCP_USER_BUCKETS) {
+            // forget senders whose buckets have been refilled
+            QHash<QString, IrcCtcpBucket>::iterator it = ctcpUserBuckets.begin();
+            while (it != ctcpUserBuckets.end()) {
+                if (now - it.value().stamp >= ctcpReplyInterval * 1000)
+                    it = ctcpUserBuckets.erase(it);
+                else
+                    ++it;
+            }
+            if (ctcpUserBuckets.count() >= MAX_CTCP_USER_BUCKETS) {
+                ++droppedCtcpRequests;
+                return false;
+            }
+        }
+        userBucket = &ctcpUserBuckets[key];
+        refillCtcpBucket(userBucket, ctcpReplyUserLimit, ctcpReplyInterval, now);
+    }
+    if (ctcpReplyLimit > 0)
+        refillCtcpBucket(&ctcpBucket, ctcpReplyLimit, ctcpReplyInterval, now);
+
+    if ((userBucket && userBucket->tokens < 1) || (ctcpReplyLimit > 0 && ctcpBucket.tokens < 1)) {
+        ++droppedCtcpRequests;
+        return false;
+    }
+
+    if (userBucket)
+        userBucket->tokens -= 1;
+    if (ctcpReplyLimit > 0)
+        ctcpBucket.tokens -= 1;
+    return true;
+}
+
 IrcCommand* IrcConnectionPrivate::createCtcpReply(IrcPrivateMessage* request)
 {
     Q_Q(IrcConnection);
@@ -610,6 +992,9 @@ IrcConnection::IrcConnection(const QString& host, QObject* parent) : QObject(par
  */
 IrcConnection::~IrcConnection()
 {
+    Q_D(IrcConnection);
+    qDeleteAll(d->requests);
+    d->requests.clear();
     close();
     emit destroyed(this);
 }
@@ -633,10 +1018,19 @@ IrcConnection* IrcConnection::clone(QObject *parent) const
     connection->setDisplayName(displayName());
     connection->setUserData(userData());
     connection->setEncoding(encoding());
+    connection->setEncodingDetectionEnabled(isEncodingDetectionEnabled());
     connection->setEnabled(isEnabled());
     connection->setReconnectDelay(reconnectDelay());
     connection->setSecure(isSecure());
     connection->setSaslMechanism(saslMechanism());
+    connection->setCtcpReplyLimit(ctcpReplyLimit());
+    connection->setCtcpReplyUserLimit(ctcpReplyUserLimit());
+    connection->setCtcpReplyInterval(ctcpReplyInterval());
+    connection->setSessionResumptionEnabled(isSessionResumptionEnabled());
+    connection->setLowDelay(isLowDelay());
+    connection->setKeepAliveInterval(keepAliveInterval());
+    connection->setSendBufferSize(sendBufferSize());
+    connection->setReceiveBufferSize(receiveBufferSize());
     return connection;
 }
 
@@ -672,6 +1066,41 @@ void IrcConnection::setEncoding(const QByteArray& encoding)
     d->encoding = encoding;
 }
 
+/*!
+    \since 3.7
+
+    This property holds whether the encoding of legacy text is detected
+    and remembered per sender.
+
+    When enabled, text that is not valid \c UTF-8 is decoded with the
+    encoding last detected for its sender, and charset detection runs
+    again only when that fails. Detection is only available when the
+    library is built with ICU or uchardet.
+
+    When disabled, such text is always decoded with the fallback
+    \ref encoding. Single-byte encodings accept any input, so detection
+    would otherwise override a configured fallback encoding.
+
+    The default value is \c false.
+
+    \par Access functions:
+    \li bool <b>isEncodingDetectionEnabled</b>() const
+    \li void <b>setEncodingDetectionEnabled</b>(bool enabled)
+
+    \sa encoding
+ */
+bool IrcConnection::isEncodingDetectionEnabled() const
+{
+    Q_D(const IrcConnection);
+    return d->encodingDetection;
+}
+
+void IrcConnection::setEncodingDetectionEnabled(bool enabled)
+{
+    Q_D(IrcConnection);
+    d->encodingDetection = enabled;
+}
+
 /*!
     This property holds the server host.
 
@@ -1164,8 +1593,17 @@ void IrcConnection::setSocket(QAbstractSocket* socket)
             connect(socket, SIGNAL(readyRead()), this, SLOT(_irc_readData()));
             connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(_irc_error(QAbstractSocket::SocketError)));
             connect(socket, SIGNAL(stateChanged(QAbstractSocket::SocketState)), this, SLOT(_irc_state(QAbstractSocket::SocketState)));
-            if (isSecure())
+#ifndef QT_NO_SSL
+            // any SSL socket, whether set here or through setSecure()
+            if (qobject_cast<QSslSocket*>(socket)) {
                 connect(socket, SIGNAL(sslErrors(QList<QSslError>)), this, SLOT(_irc_sslErrors()));
+                connect(socket, SIGNAL(encrypted()), this, SLOT(_irc_encrypted()));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+                // TLS 1.3 servers send session tickets after the handshake
+                connect(socket, SIGNAL(newSessionTicketReceived()), this, SLOT(_irc_sessionTicket()));
+#endif
+            }
+#endif // !QT_NO_SSL
         }
     }
 }
@@ -1294,6 +1732,8 @@ QStringList IrcConnection::supportedSaslMechanisms()
 
     \note Set an empty reply to omit the automatic reply.
 
+    \note Automatic replies are subject to \ref ctcpReplyLimit and \ref ctcpReplyUserLimit.
+
     \par Access functions:
     \li QVariantMap <b>ctcpReplies</b>() const
     \li void <b>setCtcpReplies</b>(const QVariantMap& replies)
@@ -1318,6 +1758,380 @@ void IrcConnection::setCtcpReplies(const QVariantMap& replies)
     }
 }
 
+/*!
+    \since 3.7
+
+    This property holds the maximum amount of automatic CTCP replies
+    per \ref ctcpReplyInterval "interval".
+
+    Replies exceeding the limit are dropped, which protects the connection
+    from being flooded off the server by a CTCP flood. Requests that have
+    a \ref ctcpReplies "user-supplied" or a default reply are dropped
+    before createCtcpReply() is called, so a flood allocates no reply
+    commands. Other requests only count against the limit when a
+    reimplemented createCtcpReply() answers them, so a flood of unknown
+    CTCP requests does not starve the replies to known ones.
+
+    The limit is implemented as a token bucket, which allows short bursts
+    up to the limit and is replenished at the rate of ctcpReplyLimit
+    replies per interval.
+
+    The default value is \c 0 (unlimited).
+
+    \par Access functions:
+    \li int <b>ctcpReplyLimit</b>() const
+    \li void <b>setCtcpReplyLimit</b>(int limit)
+
+    \sa ctcpReplyUserLimit, droppedCtcpRequests
+ */
+int IrcConnection::ctcpReplyLimit() const
+{
+    Q_D(const IrcConnection);
+    return d->ctcpReplyLimit;
+}
+
+void IrcConnection::setCtcpReplyLimit(int limit)
+{
+    Q_D(IrcConnection);
+    if (d->ctcpReplyLimit != limit) {
+        d->ctcpReplyLimit = limit;
+        d->ctcpBucket = IrcCtcpBucket();
+    }
+}
+
+/*!
+    \since 3.7
+
+    This property holds the maximum amount of automatic CTCP replies
+    per sender per \ref ctcpReplyInterval "interval".
+
+    The default value is \c 0 (unlimited).
+
+    \par Access functions:
+    \li int <b>ctcpReplyUserLimit</b>() const
+    \li void <b>setCtcpReplyUserLimit</b>(int limit)
+
+    \sa ctcpReplyLimit, droppedCtcpRequests
+ */
+int IrcConnection::ctcpReplyUserLimit() const
+{
+    Q_D(const IrcConnection);
+    return d->ctcpReplyUserLimit;
+}
+
+void IrcConnection::setCtcpReplyUserLimit(int limit)
+{
+    Q_D(IrcConnection);
+    if (d->ctcpReplyUserLimit != limit) {
+        d->ctcpReplyUserLimit = limit;
+        d->ctcpUserBuckets.clear();
+    }
+}
+
+/*!
+    \since 3.7
+
+    This property holds the CTCP reply limit interval in seconds.
+
+    The default value is \c 10 seconds.
+
+    \par Access functions:
+    \li int <b>ctcpReplyInterval</b>() const
+    \li void <b>setCtcpReplyInterval</b>(int seconds)
+
+    \sa ctcpReplyLimit, ctcpReplyUserLimit
+ */
+int IrcConnection::ctcpReplyInterval() const
+{
+    Q_D(const IrcConnection);
+    return d->ctcpReplyInterval;
+}
+
+void IrcConnection::setCtcpReplyInterval(int seconds)
+{
+    Q_D(IrcConnection);
+    d->ctcpReplyInterval = qMax(1, seconds);
+}
+
+/*!
+    \since 3.7
+
+    This property holds the amount of CTCP requests that were
+    left unanswered due to the CTCP reply limits.
+
+    \par Access function:
+    \li int <b>droppedCtcpRequests</b>() const
+
+    \sa ctcpReplyLimit, ctcpReplyUserLimit
+ */
+int IrcConnection::droppedCtcpRequests() const
+{
+    Q_D(const IrcConnection);
+    return d->droppedCtcpRequests;
+}
+
+/*!
+    \since 3.7
+
+    This property holds whether TLS sessions are resumed across reconnects.
+
+    When enabled, the TLS session negotiated with a server is cached per
+    host and port, and offered to the server on the next secure connection.
+    A server that accepts the session skips the full handshake, which saves
+    CPU time and round trips when many connections reconnect at once. A
+    server that rejects the session simply negotiates a new one.
+
+    \note Qt does not tell whether the server accepted an offered session,
+    so sessionOfferCount counts the offers, not the resumed handshakes.
+
+    Sessions are cached per connection, so they are never shared between
+    connections that may authenticate with different client certificates.
+
+    The default value is \c true.
+
+    \par Access functions:
+    \li bool <b>isSessionResumptionEnabled</b>() const
+    \li void <b>setSessionResumptionEnabled</b>(bool enabled)
+
+    \sa handshakeCount, sessionOfferCount, secure
+ */
+bool IrcConnection::isSessionResumptionEnabled() const
+{
+    Q_D(const IrcConnection);
+    return d->sessionResumption;
+}
+
+void IrcConnection::setSessionResumptionEnabled(bool enabled)
+{
+    Q_D(IrcConnection);
+    d->sessionResumption = enabled;
+    if (!enabled)
+        d->sslSessions.clear();
+}
+
+/*!
+    \since 3.7
+
+    This property holds the amount of completed TLS handshakes.
+
+    \par Access function:
+    \li int <b>handshakeCount</b>() const
+
+    \par Notifier signal:
+    \li void <b>handshakeCountChanged</b>(int count)
+
+    \sa sessionOfferCount, sessionResumptionEnabled
+ */
+int IrcConnection::handshakeCount() const
+{
+    Q_D(const IrcConnection);
+    return d->handshakeCount;
+}
+
+/*!
+    \since 3.7
+
+    This property holds the amount of completed TLS handshakes
+    that offered a cached session to the server.
+
+    \par Access function:
+    \li int <b>sessionOfferCount</b>() const
+
+    \par Notifier signal:
+    \li void <b>sessionOfferCountChanged</b>(int count)
+
+    \sa handshakeCount, sessionResumptionEnabled
+ */
+int IrcConnection::sessionOfferCount() const
+{
+    Q_D(const IrcConnection);
+    return d->sessionOfferCount;
+}
+
+/*!
+    \since 3.7
+
+    This property holds whether Nagle's algorithm is disabled (TCP_NODELAY).
+
+    Socket options are applied every time the connection is established,
+    so changes take effect on the next (re)connect.
+
+    The default value is \c false.
+
+    \par Access functions:
+    \li bool <b>isLowDelay</b>() const
+    \li void <b>setLowDelay</b>(bool enabled)
+
+    \sa keepAliveInterval, sendBufferSize, receiveBufferSize
+ */
+bool IrcConnection::isLowDelay() const
+{
+    Q_D(const IrcConnection);
+    return d->lowDelay;
+}
+
+void IrcConnection::setLowDelay(bool enabled)
+{
+    Q_D(IrcConnection);
+    d->lowDelay = enabled;
+}
+
+/*!
+    \since 3.7
+
+    This property holds the TCP keepalive interval in seconds.
+
+    When positive, TCP keepalive is enabled and, where the platform allows
+    tuning it, the first probe is sent after the connection has been idle
+    for the interval. The connection is considered dead after three more
+    unanswered probes a third of the interval apart, which lets the socket
+    fail over to a reconnect on links that drop silently.
+
+    For faster detection on the application level, combine it with
+    IrcLagTimer::timeout.
+
+    The default value is \c 0, which disables TCP keepalive.
+
+    \par Access functions:
+    \li int <b>keepAliveInterval</b>() const
+    \li void <b>setKeepAliveInterval</b>(int seconds)
+
+    \sa lowDelay, reconnectDelay
+ */
+int IrcConnection::keepAliveInterval() const
+{
+    Q_D(const IrcConnection);
+    return d->keepAliveInterval;
+}
+
+void IrcConnection::setKeepAliveInterval(int seconds)
+{
+    Q_D(IrcConnection);
+    d->keepAliveInterval = qMax(0, seconds);
+}
+
+/*!
+    \since 3.7
+
+    This property holds the socket send buffer size in bytes (SO_SNDBUF).
+
+    The default value is \c 0, which leaves the system default untouched.
+
+    \par Access functions:
+    \li int <b>sendBufferSize</b>() const
+    \li void <b>setSendBufferSize</b>(int size)
+
+    \sa receiveBufferSize, lowDelay
+ */
+int IrcConnection::sendBufferSize() const
+{
+    Q_D(const IrcConnection);
+    return d->sendBufferSize;
+}
+
+void IrcConnection::setSendBufferSize(int size)
+{
+    Q_D(IrcConnection);
+    d->sendBufferSize = qMax(0, size);
+}
+
+/*!
+    \since 3.7
+
+    This property holds the socket receive buffer size in bytes (SO_RCVBUF).
+
+    The default value is \c 0, which leaves the system default untouched.
+
+    \par Access functions:
+    \li int <b>receiveBufferSize</b>() const
+    \li void <b>setReceiveBufferSize</b>(int size)
+
+    \sa sendBufferSize, lowDelay
+ */
+int IrcConnection::receiveBufferSize() const
+{
+    Q_D(const IrcConnection);
+    return d->receiveBufferSize;
+}
+
+void IrcConnection::setReceiveBufferSize(int size)
+{
+    Q_D(IrcConnection);
+    d->receiveBufferSize = qMax(0, size);
+}
+
+/*!
+    \since 3.7
+
+    Returns the line handler of the firehose mode, or \c nullptr
+    when the connection is not in firehose mode.
+
+    \sa setFirehose()
+ */
+IrcLineHandler* IrcConnection::firehose() const
+{
+    Q_D(const IrcConnection);
+    return d->firehose;
+}
+
+/*!
+    \since 3.7
+
+    Puts the connection in firehose mode, delivering the received lines
+    to \a handler. Passing \c nullptr returns to the normal mode.
+
+    Firehose mode is meant for clients that only record traffic, such as
+    analytics bots on a large number of busy channels. Once the connection
+    is \ref connected "connected", received lines are handed to
+    IrcLineHandler::lineReceived() as raw IrcLine views. No IrcMessage
+    objects are created for them, nothing is decoded, and neither message
+    filters, messageReceived() nor the typed message signals see them, so
+    models such as IrcBufferModel are not updated either. Components that
+    rely on message filters to tell that the connection is alive must
+    watch the \ref socket "socket" instead, as an \ref IrcLagTimer::adaptive
+    "adaptive" IrcLagTimer does.
+
+    The protocol essentials are still processed as usual, and are not
+    delivered to the handler:
+    \li the registration, up to and including the \c RPL_WELCOME reply,
+    \li the connection registration replies (\c 001 - \c 099),
+        such as \c RPL_ISUPPORT that initializes the \ref network "network",
+    \li \c PING, \c PONG, \c CAP, \c AUTHENTICATE and \c ERROR, and
+    \li \c NICK changes of the connection itself.
+
+    Batches that are open when the mode changes are dropped, because
+    their ends are delivered elsewhere.
+
+    The connection does not take ownership of the handler, which must
+    outlive the firehose mode.
+
+    \code
+    class Recorder : public QObject, public IrcLineHandler
+    {
+    public:
+        void lineReceived(const IrcLine& line) override
+        {
+            if (line.command() == "PRIVMSG")
+                record(line.parameter(0), line.nick(), line.parameter(1));
+        }
+    };
+
+    connection->setFirehose(recorder);
+    \endcode
+
+    \sa IrcLine, IrcLineHandler
+ */
+void IrcConnection::setFirehose(IrcLineHandler* handler)
+{
+    Q_D(IrcConnection);
+    if (d->firehose != handler) {
+        // batch ends are delivered to either the handler or the protocol
+        if ((!d->firehose || !handler) && d->protocol)
+            QMetaObject::invokeMethod(d->protocol, "_irc_clearBatches");
+        d->firehose = handler;
+    }
+}
+
 /*!
     This property holds the network information.
 
@@ -1446,11 +2260,23 @@ bool IrcConnection::sendCommand(IrcCommand* command)
         IrcCommandPrivate::get(command)->connection = this;
         for (int i = d->commandFilters.count() - 1; !filtered && i >= 0; --i) {
             QObject* filter = d->commandFilters.at(i);
+            if (d->activeCommandFilters.contains(filter))
+                continue;
             IrcCommandFilter* commandFilter = qobject_cast<IrcCommandFilter*>(filter);
-            if (commandFilter && !d->activeCommandFilters.contains(filter)) {
+            IrcCommandValueFilter* valueFilter = commandFilter ? nullptr : qobject_cast<IrcCommandValueFilter*>(filter);
+            if (commandFilter) {
                 d->activeCommandFilters.push(filter);
                 filtered |= commandFilter->commandFilter(command);
                 d->activeCommandFilters.pop();
+            } else if (valueFilter) {
+                IrcCommandValue value = IrcCommandValue::fromCommand(command);
+                d->activeCommandFilters.push(filter);
+                filtered |= valueFilter->commandValueFilter(&value);
+                d->activeCommandFilters.pop();
+                IrcCommandPrivate* priv = IrcCommandPrivate::get(command);
+                priv->type = value.type();
+                priv->parameters = value.parameters();
+                priv->encoding = value.encoding();
             }
         }
         if (filtered) {
@@ -1466,6 +2292,64 @@ bool IrcConnection::sendCommand(IrcCommand* command)
     return res;
 }
 
+/*!
+    \since 3.7
+    \overload
+
+    Sends a \a command value to the server.
+
+    Unlike sendCommand(IrcCommand*), this does not allocate a QObject for
+    the command. Installed command filters that implement IrcCommandValueFilter
+    receive the value as is. If any legacy IrcCommandFilter is installed, a
+    temporary IrcCommand is created for it on demand.
+
+    \code
+    connection->sendCommand(IrcCommandValue::createMessage(target, reply));
+    \endcode
+
+    \sa IrcCommandValue, installCommandFilter()
+ */
+bool IrcConnection::sendCommand(const IrcCommandValue& command)
+{
+    Q_D(IrcConnection);
+    IrcCommandValue value(command);
+    IrcCommand* legacy = nullptr;
+    bool filtered = false;
+    for (int i = d->commandFilters.count() - 1; !filtered && i >= 0; --i) {
+        QObject* filter = d->commandFilters.at(i);
+        if (d->activeCommandFilters.contains(filter))
+            continue;
+        IrcCommandValueFilter* valueFilter = qobject_cast<IrcCommandValueFilter*>(filter);
+        IrcCommandFilter* commandFilter = valueFilter ? nullptr : qobject_cast<IrcCommandFilter*>(filter);
+        if (valueFilter) {
+            d->activeCommandFilters.push(filter);
+            filtered |= valueFilter->commandValueFilter(&value);
+            d->activeCommandFilters.pop();
+        } else if (commandFilter) {
+            // materialize the command only for legacy filters
+            if (!legacy)
+                legacy = value.toCommand();
+            IrcCommandPrivate* priv = IrcCommandPrivate::get(legacy);
+            priv->type = value.type();
+            priv->parameters = value.parameters();
+            priv->encoding = value.encoding();
+            priv->connection = this;
+            d->activeCommandFilters.push(filter);
+            filtered |= commandFilter->commandFilter(legacy);
+            d->activeCommandFilters.pop();
+            value = IrcCommandValue::fromCommand(legacy);
+        }
+    }
+    // a legacy filter may have taken ownership (e.g. IrcCommandQueue)
+    if (legacy && !legacy->parent())
+        legacy->deleteLater();
+    if (filtered)
+        return false;
+    QTextCodec* codec = QTextCodec::codecForName(value.encoding());
+    Q_ASSERT(codec);
+    return sendData(codec->fromUnicode(value.toString()));
+}
+
 /*!
     Sends raw \a data to the server.
 
@@ -1505,6 +2389,98 @@ bool IrcConnection::sendRaw(const QString& message)
     return sendData(message.toUtf8());
 }
 
+/*!
+    \since 3.7
+
+    Sends a query \a command to the server and returns an IrcReply
+    that collects the response and emits \ref IrcReply::finished()
+    "finished()" once the response is complete.
+
+    The supported queries are WHOIS, WHO and MODE queries, that is,
+    commands created with IrcCommand::createWhois(), IrcCommand::createWho()
+    and IrcCommand::createMode() without a mode argument. For other commands,
+    this method returns \c 0.
+
+    When the \c labeled-response capability is active, the response is
+    correlated by a label tag. Otherwise, the numeric end marker of each
+    query is used. An identical query that is still in flight is not sent
+    again; the returned reply receives the response of the earlier one.
+
+    The reply finishes with IrcReply::TimeoutError if no response has arrived
+    within \a timeout milliseconds. A \a timeout of \c 0, or one longer than
+    two minutes, waits for two minutes. A query is forgotten once all of its
+    replies have finished, been \ref IrcReply::abort() "aborted" or deleted.
+
+    \note The connection takes ownership of a \a command without a parent,
+    just like sendCommand() does. The returned reply is a child of the
+    connection and must be deleted by the caller once it has finished.
+
+    \sa IrcReply, sendCommand()
+ */
+IrcReply* IrcConnection::sendRequest(IrcCommand* command, int timeout)
+{
+    Q_D(IrcConnection);
+    if (!command)
+        return nullptr;
+
+    const IrcCommand::Type type = command->type();
+    const QStringList params = command->parameters();
+    const QString target = params.value(0);
+    const bool query = type == IrcCommand::Whois || type == IrcCommand::Who || (type == IrcCommand::Mode && params.value(1).isEmpty());
+    if (!query || target.isEmpty()) {
+        qWarning() << "IrcConnection::sendRequest(): unsupported query:" << command;
+        if (!command->parent())
+            command->deleteLater();
+        return nullptr;
+    }
+
+    IrcReply* reply = IrcReplyPrivate::create(this, type, target, timeout);
+    if (!isActive()) {
+        IrcReplyPrivate* priv = IrcReplyPrivate::get(reply);
+        priv->finished = true;
+        priv->error = IrcReply::ConnectionError;
+        priv->timer.stop();
+        QMetaObject::invokeMethod(reply, "finished", Qt::QueuedConnection);
+        if (!command->parent())
+            command->deleteLater();
+        return reply;
+    }
+
+    const QString key = target.toLower();
+    foreach (IrcPendingRequest* request, d->requests) {
+        if (request->type == type && request->target == key && !request->ended) {
+            if (timeout <= 0 || request->timeout <= 0)
+                request->timeout = 0;
+            else
+                request->timeout = qMax(request->timeout, int(request->started.elapsed()) + timeout);
+            request->replies += reply;
+            d->scheduleRequests();
+            if (!command->parent())
+                command->deleteLater();
+            return reply;
+        }
+    }
+
+    IrcPendingRequest* request = new IrcPendingRequest;
+    request->type = type;
+    request->target = key;
+    request->timeout = timeout;
+    request->started.start();
+    request->replies += reply;
+    if (d->network->isCapable(QStringLiteral("labeled-response"))) {
+        request->label = QString::number(++d->requestLabel);
+        IrcCommand* labeled = IrcCommand::createQuote(QLatin1String("@label=") + request->label + QLatin1Char(' ') + command->toString());
+        labeled->setEncoding(command->encoding());
+        if (!command->parent())
+            command->deleteLater();
+        command = labeled;
+    }
+    d->requests += request;
+    d->scheduleRequests();
+    sendCommand(command);
+    return reply;
+}
+
 /*!
     Installs a message \a filter on the connection. The \a filter must implement the IrcMessageFilter interface.
 
@@ -1548,10 +2524,12 @@ void IrcConnection::removeMessageFilter(QObject* filter)
 }
 
 /*!
-    Installs a command \a filter on the connection. The \a filter must implement the IrcCommandFilter interface.
+    Installs a command \a filter on the connection. The \a filter must implement the
+    IrcCommandFilter or the IrcCommandValueFilter interface.
 
     A command filter receives all commands that are sent from the connection. The filter
     receives commands via the \ref IrcCommandFilter::commandFilter() "commandFilter()"
+    or the \ref IrcCommandValueFilter::commandValueFilter() "commandValueFilter()"
     function. The function must return \c true if the command should be filtered,
     (i.e. stopped); otherwise it must return \c false.
 
@@ -1564,7 +2542,8 @@ void IrcConnection::installCommandFilter(QObject* filter)
 {
     Q_D(IrcConnection);
     IrcCommandFilter* cmdFilter = qobject_cast<IrcCommandFilter*>(filter);
-    if (cmdFilter) {
+    IrcCommandValueFilter* valueFilter = qobject_cast<IrcCommandValueFilter*>(filter);
+    if (cmdFilter || valueFilter) {
         d->commandFilters += filter;
         connect(filter, SIGNAL(destroyed(QObject*)), this, SLOT(_irc_filterDestroyed(QObject*)), Qt::UniqueConnection);
     }
@@ -1583,7 +2562,8 @@ void IrcConnection::removeCommandFilter(QObject* filter)
 {
     Q_D(IrcConnection);
     IrcCommandFilter* cmdFilter = qobject_cast<IrcCommandFilter*>(filter);
-    if (cmdFilter) {
+    IrcCommandValueFilter* valueFilter = qobject_cast<IrcCommandValueFilter*>(filter);
+    if (cmdFilter || valueFilter) {
         d->commandFilters.removeAll(filter);
         disconnect(filter, SIGNAL(destroyed(QObject*)), this, SLOT(_irc_filterDestroyed(QObject*)));
     }
@@ -1612,10 +2592,18 @@ QByteArray IrcConnection::saveState(int version) const
     args.insert("displayName", displayName());
     args.insert("userData", d->userData);
     args.insert("encoding", d->encoding);
+    args.insert("encodingDetection", d->encodingDetection);
     args.insert("enabled", d->enabled);
     args.insert("reconnectDelay", reconnectDelay());
     args.insert("secure", isSecure());
     args.insert("saslMechanism", d->saslMechanism);
+    args.insert("ctcpReplyLimit", d->ctcpReplyLimit);
+    args.insert("ctcpReplyUserLimit", d->ctcpReplyUserLimit);
+    args.insert("ctcpReplyInterval", d->ctcpReplyInterval);
+    args.insert("lowDelay", d->lowDelay);
+    args.insert("keepAliveInterval", d->keepAliveInterval);
+    args.insert("sendBufferSize", d->sendBufferSize);
+    args.insert("receiveBufferSize", d->receiveBufferSize);
 
     QByteArray state;
     QDataStream out(&state, QIODevice::WriteOnly);
@@ -1657,10 +2645,18 @@ bool IrcConnection::restoreState(const QByteArray& state, int version)
     setDisplayName(args.value("displayName").toString());
     setUserData(args.value("userData", d->userData).toMap());
     setEncoding(args.value("encoding", d->encoding).toByteArray());
+    setEncodingDetectionEnabled(args.value("encodingDetection", d->encodingDetection).toBool());
     setEnabled(args.value("enabled", d->enabled).toBool());
     setReconnectDelay(args.value("reconnectDelay", reconnectDelay()).toInt());
     setSecure(args.value("secure", isSecure()).toBool());
     setSaslMechanism(args.value("saslMechanism", d->saslMechanism).toString());
+    setCtcpReplyLimit(args.value("ctcpReplyLimit", d->ctcpReplyLimit).toInt());
+    setCtcpReplyUserLimit(args.value("ctcpReplyUserLimit", d->ctcpReplyUserLimit).toInt());
+    setCtcpReplyInterval(args.value("ctcpReplyInterval", d->ctcpReplyInterval).toInt());
+    setLowDelay(args.value("lowDelay", d->lowDelay).toBool());
+    setKeepAliveInterval(args.value("keepAliveInterval", d->keepAliveInterval).toInt());
+    setSendBufferSize(args.value("sendBufferSize", d->sendBufferSize).toInt());
+    setReceiveBufferSize(args.value("receiveBufferSize", d->receiveBufferSize).toInt());
     return true;
 }
 
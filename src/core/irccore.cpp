@@ -58,10 +58,17 @@ namespace IrcCore {
         qRegisterMetaType<IrcConnection*>("IrcConnection*");
         qRegisterMetaType<IrcConnection::Status>("IrcConnection::Status");
 
+        qRegisterMetaType<IrcLine>("IrcLine");
+
+        qRegisterMetaType<IrcMessageRing*>("IrcMessageRing*");
+
         qRegisterMetaType<IrcNetwork*>("IrcNetwork*");
 
+        qRegisterMetaType<IrcPipe*>("IrcPipe*");
+
         qRegisterMetaType<IrcCommand*>("IrcCommand*");
         qRegisterMetaType<IrcCommand::Type>("IrcCommand::Type");
+        qRegisterMetaType<IrcCommandValue>("IrcCommandValue");
 
         qRegisterMetaType<IrcMessage*>("IrcMessage*");
         qRegisterMetaType<IrcMessage::Type>("IrcMessage::Type");
@@ -90,6 +97,9 @@ namespace IrcCore {
         qRegisterMetaType<IrcWhoisMessage*>("IrcWhoisMessage*");
         qRegisterMetaType<IrcWhowasMessage*>("IrcWhowasMessage*");
         qRegisterMetaType<IrcWhoReplyMessage*>("IrcWhoReplyMessage*");
+
+        qRegisterMetaType<IrcReply*>("IrcReply*");
+        qRegisterMetaType<IrcReply::Error>("IrcReply::Error");
     }
 }
 
@@ -245,4 +245,59 @@ IRC_BEGIN_NAMESPACE
     \sa IrcConnection::installCommandFilter()
  */
 
+/*!
+    \since 3.7
+    \class IrcCommandValueFilter ircfilter.h <IrcCommandValueFilter>
+    \ingroup core
+    \brief Provides an interface for filtering command values
+
+    IrcCommandValueFilter is the allocation free counterpart of
+    IrcCommandFilter. Commands sent via IrcConnection::sendCommand(const IrcCommandValue&)
+    are delivered to such filters as is, whereas an IrcCommandFilter forces
+    the connection to create a temporary IrcCommand instance. Commands sent as
+    IrcCommand instances are delivered to value filters as well.
+
+    A filter may implement both interfaces. In that case, command values are
+    delivered to \ref IrcCommandValueFilter::commandValueFilter() "commandValueFilter()"
+    and IrcCommand instances to \ref IrcCommandFilter::commandFilter() "commandFilter()".
+
+    \code
+    class Censor : public QObject, public IrcCommandValueFilter
+    {
+        Q_OBJECT
+        Q_INTERFACES(IrcCommandValueFilter)
+
+    public:
+        bool commandValueFilter(IrcCommandValue* cmd) override
+        {
+            if (cmd->type() == IrcCommand::Message) {
+                QStringList params = cmd->parameters();
+                params[1].replace("darn", "****");
+                cmd->setParameters(params);
+            }
+            return false;
+        }
+    };
+    \endcode
+
+    \sa IrcConnection::installCommandFilter(), IrcCommandFilter
+ */
+
+/*!
+    \fn IrcCommandValueFilter::~IrcCommandValueFilter()
+    Destructs the command value filter.
+ */
+
+/*!
+    \fn virtual bool IrcCommandValueFilter::commandValueFilter(IrcCommandValue* command) = 0
+
+    Reimplement this function to filter commands to installed connections.
+    The \a command may be modified in place.
+
+    Return \c true to filter the command out, i.e. stop it being handled further;
+    otherwise return \c false.
+
+    \sa IrcConnection::installCommandFilter()
+ */
+
 IRC_END_NAMESPACE
@@ -0,0 +1,298 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircline.h"
+#ifndef QT_NO_DEBUG_STREAM
+#include <QDebug>
+#endif // QT_NO_DEBUG_STREAM
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircline.h
+    \brief \#include &lt;IrcLine&gt;
+ */
+
+/*!
+    \class IrcLine ircline.h <IrcLine>
+    \ingroup core
+    \brief Provides a lightweight view of a raw IRC line.
+    \since 3.7
+
+    IrcLine locates the tags, prefix, command and parameters of a raw
+    line without decoding or copying them. The fields are returned as
+    raw bytes, in the encoding they were received in, and only the
+    fields that are asked for are copied out of the line.
+
+    IrcLine is what IrcLineHandler receives when the connection is in
+    \ref IrcConnection::firehose() "firehose mode".
+
+    \code
+    void Recorder::lineReceived(const IrcLine& line)
+    {
+        if (line.command() == "PRIVMSG")
+            record(line.parameter(0), line.nick(), line.parameter(1));
+    }
+    \endcode
+
+    \sa IrcLineHandler, IrcMessage
+ */
+
+/*!
+    \class IrcLineHandler ircline.h <IrcLineHandler>
+    \ingroup core
+    \brief Receives raw lines of a connection in firehose mode.
+    \since 3.7
+
+    \sa IrcConnection::setFirehose()
+ */
+
+/*!
+    \fn IrcLineHandler::~IrcLineHandler()
+
+    Destructs the line handler.
+ */
+
+/*!
+    \fn void IrcLineHandler::lineReceived(const IrcLine& line)
+
+    Reimplement to handle a \a line received by a connection in
+    firehose mode.
+ */
+
+/*!
+    Constructs an invalid line.
+ */
+IrcLine::IrcLine()
+{
+    m_tags[0] = m_prefix[0] = m_command[0] = 0;
+    m_tags[1] = m_prefix[1] = m_command[1] = 0;
+}
+
+/*!
+    Constructs a line from raw \a data, without the trailing \c "\r\n".
+ */
+IrcLine::IrcLine(const QByteArray& data) : m_data(data)
+{
+    m_tags[0] = m_prefix[0] = m_command[0] = 0;
+    m_tags[1] = m_prefix[1] = m_command[1] = 0;
+
+    const char* str = data.constData();
+    const int size = data.size();
+    int pos = 0;
+
+    // ['@' <tags> <SPACE>]
+    if (pos < size && str[pos] == '@') {
+        int end = data.indexOf(' ', pos);
+        if (end == -1)
+            end = size;
+        m_tags[0] = pos + 1;
+        m_tags[1] = end - pos - 1;
+        pos = end;
+    }
+    while (pos < size && str[pos] == ' ')
+        ++pos;
+
+    // [':' <prefix> <SPACE>]
+    if (pos < size && str[pos] == ':') {
+        int end = data.indexOf(' ', pos);
+        if (end == -1)
+            end = size;
+        m_prefix[0] = pos + 1;
+        m_prefix[1] = end - pos - 1;
+        pos = end;
+    }
+    while (pos < size && str[pos] == ' ')
+        ++pos;
+
+    // <command>
+    int end = data.indexOf(' ', pos);
+    if (end == -1)
+        end = size;
+    m_command[0] = pos;
+    m_command[1] = end - pos;
+    pos = end;
+
+    // <params>
+    while (pos < size) {
+        while (pos < size && str[pos] == ' ')
+            ++pos;
+        if (pos >= size)
+            break;
+        if (str[pos] == ':') {
+            m_params.append(pos + 1);
+            m_params.append(size - pos - 1);
+            break;
+        }
+        end = data.indexOf(' ', pos);
+        if (end == -1)
+            end = size;
+        m_params.append(pos);
+        m_params.append(end - pos);
+        pos = end;
+    }
+}
+
+/*!
+    Returns \c true if the line has a command.
+ */
+bool IrcLine::isValid() const
+{
+    return m_command[1] > 0;
+}
+
+/*!
+    Returns the raw data of the line.
+ */
+QByteArray IrcLine::data() const
+{
+    return m_data;
+}
+
+/*!
+    Returns the raw message tags, without the leading \c '@',
+    or an empty byte array if the line has no tags.
+ */
+QByteArray IrcLine::tags() const
+{
+    return m_data.mid(m_tags[0], m_tags[1]);
+}
+
+/*!
+    Returns the raw value of the tag with \a name,
+    or a null byte array if the line has no such tag.
+
+    \note The value is not unescaped.
+ */
+QByteArray IrcLine::tag(const QByteArray& name) const
+{
+    const char* str = m_data.constData();
+    const int end = m_tags[0] + m_tags[1];
+    int pos = m_tags[0];
+    while (pos < end) {
+        int next = m_data.indexOf(';', pos);
+        if (next == -1 || next > end)
+            next = end;
+        const int len = next - pos;
+        if (len >= name.size() && !qstrncmp(str + pos, name.constData(), name.size())) {
+            if (len == name.size())
+                return QByteArray("");
+            if (str[pos + name.size()] == '=')
+                return m_data.mid(pos + name.size() + 1, len - name.size() - 1);
+        }
+        pos = next + 1;
+    }
+    return QByteArray();
+}
+
+/*!
+    Returns the prefix, without the leading \c ':',
+    or an empty byte array if the line has no prefix.
+ */
+QByteArray IrcLine::prefix() const
+{
+    return m_data.mid(m_prefix[0], m_prefix[1]);
+}
+
+/*!
+    Returns the nick, or the server name, of the prefix.
+ */
+QByteArray IrcLine::nick() const
+{
+    const char* str = m_data.constData();
+    int len = 0;
+    while (len < m_prefix[1] && str[m_prefix[0] + len] != '!' && str[m_prefix[0] + len] != '@')
+        ++len;
+    return m_data.mid(m_prefix[0], len);
+}
+
+/*!
+    Returns the command.
+ */
+QByteArray IrcLine::command() const
+{
+    return m_data.mid(m_command[0], m_command[1]);
+}
+
+/*!
+    Returns the numeric code of the command,
+    or \c -1 if the command is not numeric.
+ */
+int IrcLine::code() const
+{
+    if (m_command[1] != 3)
+        return -1;
+    const char* str = m_data.constData() + m_command[0];
+    for (int i = 0; i < 3; ++i) {
+        if (str[i] < '0' || str[i] > '9')
+            return -1;
+    }
+    return (str[0] - '0') * 100 + (str[1] - '0') * 10 + (str[2] - '0');
+}
+
+/*!
+    Returns the number of parameters, including the trailing one.
+ */
+int IrcLine::parameterCount() const
+{
+    return m_params.count() / 2;
+}
+
+/*!
+    Returns the parameter at \a index, or a null byte array
+    if the index is out of range. The trailing parameter
+    is returned without the leading \c ':'.
+ */
+QByteArray IrcLine::parameter(int index) const
+{
+    if (index < 0 || index >= parameterCount())
+        return QByteArray();
+    return m_data.mid(m_params.at(2 * index), m_params.at(2 * index + 1));
+}
+
+/*!
+    Returns all parameters.
+ */
+QList<QByteArray> IrcLine::parameters() const
+{
+    QList<QByteArray> params;
+    params.reserve(parameterCount());
+    for (int i = 0; i < parameterCount(); ++i)
+        params += parameter(i);
+    return params;
+}
+
+#ifndef QT_NO_DEBUG_STREAM
+QDebug operator<<(QDebug debug, const IrcLine& line)
+{
+    debug.nospace() << "IrcLine(" << line.data().left(20) << ')';
+    return debug.space();
+}
+#endif // QT_NO_DEBUG_STREAM
+
+IRC_END_NAMESPACE
@@ -281,6 +281,312 @@ static IrcMessage* irc_create_message(const QString& command, IrcConnection* con
     return new IrcMessage(connection);
 }
 
+static IrcMessage* irc_create_message(IrcMessage::Type type, const QString& command, IrcConnection* connection)
+{
+    // composed messages (names, motd, whois...) don't map to their command
+    switch (type) {
+    case IrcMessage::Capability: return new IrcCapabilityMessage(connection);
+    case IrcMessage::Error: return new IrcErrorMessage(connection);
+    case IrcMessage::Invite: return new IrcInviteMessage(connection);
+    case IrcMessage::Join: return new IrcJoinMessage(connection);
+    case IrcMessage::Kick: return new IrcKickMessage(connection);
+    case IrcMessage::Mode: return new IrcModeMessage(connection);
+    case IrcMessage::Motd: return new IrcMotdMessage(connection);
+    case IrcMessage::Names: return new IrcNamesMessage(connection);
+    case IrcMessage::Nick: return new IrcNickMessage(connection);
+    case IrcMessage::Notice: return new IrcNoticeMessage(connection);
+    case IrcMessage::Numeric: return new IrcNumericMessage(connection);
+    case IrcMessage::Part: return new IrcPartMessage(connection);
+    case IrcMessage::Ping: return new IrcPingMessage(connection);
+    case IrcMessage::Pong: return new IrcPongMessage(connection);
+    case IrcMessage::Private: return new IrcPrivateMessage(connection);
+    case IrcMessage::Quit: return new IrcQuitMessage(connection);
+    case IrcMessage::Topic: return new IrcTopicMessage(connection);
+    case IrcMessage::WhoReply: return new IrcWhoReplyMessage(connection);
+    case IrcMessage::Account: return new IrcAccountMessage(connection);
+    case IrcMessage::Away: return new IrcAwayMessage(connection);
+    case IrcMessage::Whois: return new IrcWhoisMessage(connection);
+    case IrcMessage::Whowas: return new IrcWhowasMessage(connection);
+    case IrcMessage::HostChange: return new IrcHostChangeMessage(connection);
+    case IrcMessage::Batch: return new IrcBatchMessage(connection);
+    default: return irc_create_message(command, connection);
+    }
+}
+
+#ifndef IRC_DOXYGEN
+// Binary format, all numbers are LEB128 varints (signed ones zigzag encoded):
+//  <blob>    ::= "IRC" <version> <count> { <length> <bytes> } <message>
+//  <message> ::= <type> <flags> <fields> [<timestamp>] <encoding> <prefix> <command>
+//                <count> { <param> } <count> { <key> <value> } <count> { <message> }
+// Strings refer to the string table, 0 being a null string and n the
+// (n-1)th entry, so repeated prefixes, commands and tags are stored once.
+static const char IRC_BINARY_MAGIC[] = "IRC";
+static const quint8 IRC_BINARY_VERSION = 1;
+static const int IRC_BINARY_MAX_DEPTH = 8;
+
+enum IrcBinaryField {
+    BinaryTimeStamp = 0x01,
+    BinaryPrefix = 0x02,
+    BinaryCommand = 0x04,
+    BinaryParams = 0x08,
+    BinaryTags = 0x10
+};
+
+void IrcBinaryWriter::writeMessage(const IrcMessagePrivate* msg)
+{
+    // explicitly set values are stored as UTF-8 in place of the raw data
+    int fields = 0;
+    if (msg->timeStamp.isValid())
+        fields |= BinaryTimeStamp;
+    if (msg->m_prefix.isExplicit())
+        fields |= BinaryPrefix;
+    if (msg->m_command.isExplicit())
+        fields |= BinaryCommand;
+    if (msg->m_params.isExplicit())
+        fields |= BinaryParams;
+    if (msg->m_tags.isExplicit())
+        fields |= BinaryTags;
+
+    writeNumber(msg->type);
+    writeSigned(msg->flags);
+    writeNumber(fields);
+    if (fields & BinaryTimeStamp)
+        writeSigned(msg->timeStamp.toMSecsSinceEpoch());
+    writeString(msg->encoding);
+
+    if (fields & BinaryPrefix)
+        writeString(msg->m_prefix.value().toUtf8());
+    else
+        writeString(msg->data.prefix);
+
+    if (fields & BinaryCommand)
+        writeString(msg->m_command.value().toUtf8());
+    else
+        writeString(msg->data.command);
+
+    if (fields & BinaryParams) {
+        const QStringList params = msg->m_params.value();
+        writeNumber(params.count());
+        foreach (const QString& param, params)
+            writeString(param.toUtf8());
+    } else {
+        writeNumber(msg->data.params.count());
+        foreach (const QByteArray& param, msg->data.params)
+            writeString(param);
+    }
+
+    if (fields & BinaryTags) {
+        const QVariantMap tags = msg->m_tags.value();
+        writeNumber(tags.count());
+        for (QVariantMap::const_iterator it = tags.constBegin(); it != tags.constEnd(); ++it) {
+            writeString(it.key().toUtf8());
+            writeString(it.value().toString().toUtf8());
+        }
+    } else {
+        writeNumber(msg->data.tags.count());
+        QMap<QByteArray, QByteArray>::const_iterator it;
+        for (it = msg->data.tags.constBegin(); it != msg->data.tags.constEnd(); ++it) {
+            writeString(it.key());
+            writeString(it.value());
+        }
+    }
+
+    writeNumber(msg->batch.count());
+    foreach (IrcMessage* child, msg->batch)
+        writeMessage(IrcMessagePrivate::get(child));
+}
+
+QByteArray IrcBinaryWriter::finish() const
+{
+    QByteArray header(IRC_BINARY_MAGIC);
+    header += static_cast<char>(IRC_BINARY_VERSION);
+
+    IrcBinaryWriter table;
+    table.writeNumber(strings.count());
+    foreach (const QByteArray& str, strings) {
+        table.writeNumber(str.length());
+        table.body += str;
+    }
+    return header + table.body + body;
+}
+
+int IrcBinaryWriter::intern(const QByteArray& str)
+{
+    if (str.isNull())
+        return 0;
+    int idx = index.value(str);
+    if (!idx) {
+        strings += str;
+        idx = strings.count();
+        index.insert(str, idx);
+    }
+    return idx;
+}
+
+void IrcBinaryWriter::writeString(const QByteArray& str)
+{
+    writeNumber(intern(str));
+}
+
+void IrcBinaryWriter::writeNumber(quint64 value)
+{
+    while (value >= 0x80) {
+        body += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    body += static_cast<char>(value);
+}
+
+void IrcBinaryWriter::writeSigned(qint64 value)
+{
+    writeNumber((static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+IrcBinaryReader::IrcBinaryReader(const QByteArray& data) : buffer(data)
+{
+}
+
+bool IrcBinaryReader::readHeader()
+{
+    const int magic = sizeof(IRC_BINARY_MAGIC) - 1;
+    if (buffer.length() <= magic || !buffer.startsWith(IRC_BINARY_MAGIC))
+        return false;
+    if (static_cast<quint8>(buffer.at(magic)) != IRC_BINARY_VERSION)
+        return false;
+    pos = magic + 1;
+
+    quint64 count = 0;
+    if (!readNumber(&count) || count > static_cast<quint64>(buffer.length() - pos))
+        return false;
+    strings.reserve(static_cast<int>(count));
+    for (quint64 i = 0; i < count; ++i) {
+        quint64 len = 0;
+        if (!readNumber(&len) || len > static_cast<quint64>(buffer.length() - pos))
+            return false;
+        // slices share the buffer instead of copying it
+        strings += QByteArray::fromRawData(buffer.constData() + pos, static_cast<int>(len));
+        pos += static_cast<int>(len);
+    }
+    return true;
+}
+
+IrcMessage* IrcBinaryReader::readMessage(IrcConnection* connection, int depth)
+{
+    quint64 type = 0, fields = 0, count = 0;
+    qint64 flags = -1, timeStamp = 0;
+    QByteArray encoding, prefix, command;
+    if (depth > IRC_BINARY_MAX_DEPTH || !readNumber(&type) || type > static_cast<quint64>(IrcMessage::Batch) || !readSigned(&flags) || !readNumber(&fields))
+        return nullptr;
+    if ((fields & BinaryTimeStamp) && !readSigned(&timeStamp))
+        return nullptr;
+    if (!readString(&encoding) || !readString(&prefix) || !readString(&command))
+        return nullptr;
+
+    const QString cmd = (fields & BinaryCommand) ? QString::fromUtf8(command) : QString::fromLatin1(command);
+    QScopedPointer<IrcMessage> message(irc_create_message(static_cast<IrcMessage::Type>(type), cmd, connection));
+    IrcMessagePrivate* d = IrcMessagePrivate::get(message.data());
+    d->data.buffer = buffer;
+    d->flags = static_cast<int>(flags);
+    if (fields & BinaryTimeStamp)
+        d->timeStamp = QDateTime::fromMSecsSinceEpoch(timeStamp);
+    d->encoding = encoding;
+
+    if (fields & BinaryPrefix)
+        d->setPrefix(QString::fromUtf8(prefix));
+    else
+        d->data.prefix = prefix;
+
+    if (fields & BinaryCommand)
+        d->setCommand(cmd);
+    else
+        d->data.command = command;
+
+    if (!readNumber(&count) || count > static_cast<quint64>(buffer.length() - pos))
+        return nullptr;
+    QList<QByteArray> params;
+    params.reserve(static_cast<int>(count));
+    for (quint64 i = 0; i < count; ++i) {
+        QByteArray param;
+        if (!readString(&param))
+            return nullptr;
+        params += param;
+    }
+    if (fields & BinaryParams) {
+        QStringList strs;
+        foreach (const QByteArray& param, params)
+            strs += QString::fromUtf8(param);
+        d->setParams(strs);
+    } else {
+        d->data.params = params;
+    }
+
+    if (!readNumber(&count) || count > static_cast<quint64>(buffer.length() - pos))
+        return nullptr;
+    QVariantMap tags;
+    for (quint64 i = 0; i < count; ++i) {
+        QByteArray key, value;
+        if (!readString(&key) || !readString(&value))
+            return nullptr;
+        if (fields & BinaryTags)
+            tags.insert(QString::fromUtf8(key), QString::fromUtf8(value));
+        else
+            d->data.tags.insert(key, value);
+    }
+    if (fields & BinaryTags)
+        d->setTags(tags);
+
+    if (!readNumber(&count) || count > static_cast<quint64>(buffer.length() - pos))
+        return nullptr;
+    for (quint64 i = 0; i < count; ++i) {
+        IrcMessage* child = readMessage(connection, depth + 1);
+        if (!child)
+            return nullptr;
+        child->setParent(message.data());
+        d->batch += child;
+    }
+    return message.take();
+}
+
+bool IrcBinaryReader::atEnd() const
+{
+    return pos == buffer.length();
+}
+
+bool IrcBinaryReader::readString(QByteArray* str)
+{
+    quint64 idx = 0;
+    if (!readNumber(&idx) || idx > static_cast<quint64>(strings.count()))
+        return false;
+    *str = idx ? strings.at(static_cast<int>(idx - 1)) : QByteArray();
+    return true;
+}
+
+bool IrcBinaryReader::readNumber(quint64* value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= buffer.length())
+            return false;
+        const quint8 byte = static_cast<quint8>(buffer.at(pos++));
+        result |= static_cast<quint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IrcBinaryReader::readSigned(qint64* value)
+{
+    quint64 result = 0;
+    if (!readNumber(&result))
+        return false;
+    *value = static_cast<qint64>(result >> 1) ^ -static_cast<qint64>(result & 1);
+    return true;
+}
+#endif // IRC_DOXYGEN
+
 /*!
     Constructs a new IrcMessage with \a connection.
  */
@@ -579,6 +885,29 @@ void IrcMessage::setParameter(int index, const QString& parameter)
     d->setParams(params);
 }
 
+/*!
+    \since 3.7
+
+    This property holds the routing target of the message.
+
+    The routing target is the lower case name of the channel
+    that a channel-specific message, such as a join, part, kick,
+    mode, names, topic or numeric reply, is about. It is an empty
+    string for other messages.
+
+    The target is determined once and cached, decoding only the
+    parameter in question. IrcBufferModel uses it to dispatch
+    messages to their buffers.
+
+    \par Access function:
+    \li QString <b>route</b>() const
+ */
+QString IrcMessage::route() const
+{
+    Q_D(const IrcMessage);
+    return d->route();
+}
+
 /*!
     This property holds the message time stamp.
 
@@ -747,6 +1076,56 @@ IrcMessage* IrcMessage::clone(QObject* parent) const
     return msg;
 }
 
+/*!
+    \since 3.7
+
+    Returns the message in a compact, versioned binary format.
+
+    The binary format carries the parsed message as is: the type, flags,
+    time stamp, encoding, prefix, command, parameters, tags and batched
+    messages. Strings that repeat within the message and its batched
+    messages, such as prefixes and tags, are stored only once.
+
+    Use it to pass messages between processes without formatting
+    and re-parsing them as text.
+
+    \sa fromBinary(), toData()
+ */
+QByteArray IrcMessage::toBinary() const
+{
+    Q_D(const IrcMessage);
+    IrcBinaryWriter writer;
+    writer.writeMessage(d);
+    return writer.finish();
+}
+
+/*!
+    \since 3.7
+
+    Creates a new message from binary \a data with \a connection.
+
+    Returns \c nullptr if the data is not a valid message in a supported
+    version of the binary format.
+
+    The message refers to \a data instead of copying the parsed strings
+    out of it. \a data is implicitly shared, so this is safe unless it
+    was created with QByteArray::fromRawData().
+
+    \sa toBinary(), fromData()
+ */
+IrcMessage* IrcMessage::fromBinary(const QByteArray& data, IrcConnection* connection)
+{
+    IrcBinaryReader reader(data);
+    if (!reader.readHeader())
+        return nullptr;
+    IrcMessage* message = reader.readMessage(connection);
+    if (message && !reader.atEnd()) {
+        delete message;
+        return nullptr;
+    }
+    return message;
+}
+
 /*!
     \property bool IrcMessage::valid
     This property is \c true if the message is valid; otherwise \c false.
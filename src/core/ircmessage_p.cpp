@@ -28,10 +28,20 @@
 
 #include "ircmessage_p.h"
 #include "ircmessagedecoder_p.h"
+#include "ircconnection.h"
+#include "irc.h"
 
 IRC_BEGIN_NAMESPACE
 
 #ifndef IRC_DOXYGEN
+// the amount of UTF-16 code units a UTF-8 byte contributes to
+static inline int irc_utf16_units(uchar byte)
+{
+    if ((byte & 0xc0) == 0x80)
+        return 0; // continuation
+    return byte >= 0xf0 ? 2 : 1; // a surrogate pair for 4-byte sequences
+}
+
 IrcMessagePrivate::IrcMessagePrivate() :
      timeStamp(QDateTime::currentDateTime()), encoding("ISO-8859-15")
 {
@@ -42,7 +52,7 @@ QString IrcMessagePrivate::prefix() const
     if (!m_prefix.isExplicit() && m_prefix.isNull() && !data.prefix.isNull()) {
         if (data.prefix.startsWith(':')) {
             if (data.prefix.length() > 1)
-                m_prefix = decode(data.prefix.mid(1), encoding);
+                m_prefix = decodeLine() ? field(0) : decode(data.prefix.mid(1), encoding, source());
         } else {
             // empty (not null)
             m_prefix = QString("");
@@ -83,21 +93,28 @@ QString IrcMessagePrivate::host() const
 QString IrcMessagePrivate::command() const
 {
     if (!m_command.isExplicit() && m_command.isNull() && !data.command.isNull())
-        m_command = decode(data.command, encoding);
+        m_command = decodeLine() ? field(1) : decode(data.command, encoding, source());
     return m_command.value();
 }
 
 void IrcMessagePrivate::setCommand(const QString& command)
 {
     m_command.setValue(command);
+    m_route.clear();
 }
 
 QStringList IrcMessagePrivate::params() const
 {
     if (!m_params.isExplicit() && m_params.isNull() && !data.params.isEmpty()) {
         QStringList params;
-        foreach (const QByteArray& param, data.params)
-            params += decode(param, encoding);
+        if (decodeLine()) {
+            for (int i = 0; i < data.params.count(); ++i)
+                params += field(i + 2);
+        } else {
+            const QByteArray from = source();
+            foreach (const QByteArray& param, data.params)
+                params += decode(param, encoding, from);
+        }
         m_params = params;
     }
     return m_params.value();
@@ -105,21 +122,123 @@ QStringList IrcMessagePrivate::params() const
 
 QString IrcMessagePrivate::param(int index) const
 {
+    // a slice of the decoded line, without materializing the other parameters
+    if (!m_params.isExplicit() && m_params.isNull() && decodeLine())
+        return index >= 0 && index < data.params.count() ? field(index + 2) : QString();
     return params().value(index);
 }
 
 void IrcMessagePrivate::setParams(const QStringList& params)
 {
     m_params.setValue(params);
+    m_route.clear();
+}
+
+QString IrcMessagePrivate::route() const
+{
+    if (m_route.isNull()) {
+        const bool decoded = m_params.isExplicit() || !m_params.isNull();
+        const int count = decoded ? m_params.value().count() : data.params.count();
+        const bool sliced = !decoded && decodeLine();
+
+        int index = -1;
+        switch (type) {
+        case IrcMessage::Join:
+        case IrcMessage::Kick:
+        case IrcMessage::Mode:
+        case IrcMessage::Names:
+        case IrcMessage::Part:
+        case IrcMessage::Topic:
+            index = 0;
+            break;
+        case IrcMessage::Numeric:
+            // <nick> <channel> ... or <nick> <type> <channel> :<names>
+            index = command().toInt() == Irc::RPL_NAMREPLY ? count - 2 : 1;
+            break;
+        default:
+            break;
+        }
+
+        // decode the one parameter, unless they all are already
+        QString target;
+        if (index >= 0 && index < count) {
+            if (decoded)
+                target = m_params.value().at(index);
+            else
+                target = sliced ? field(index + 2) : decode(data.params.at(index), encoding, source());
+        }
+        m_route = target.toLower();
+    }
+    return m_route.value();
+}
+
+bool IrcMessagePrivate::decodeLine() const
+{
+    if (m_lineState == -1) {
+        m_lineState = 0;
+        if (data.body < 0 || data.slices.isEmpty())
+            return false;
+
+        // a line that is valid UTF-8 as a whole is valid UTF-8 in every
+        // field, because the fields are split at ASCII spaces and colons
+        const char* bytes = data.content.constData() + data.body;
+        const int size = data.content.size() - data.body;
+
+        bool ascii = true;
+        for (int i = 0; ascii && i < size; ++i)
+            ascii = static_cast<uchar>(bytes[i]) < 0x80;
+
+        if (ascii) {
+            m_line = QString::fromLatin1(bytes, size);
+            m_slices = data.slices;
+            for (int i = 0; i < m_slices.count(); ++i)
+                m_slices[i].pos -= data.body;
+        } else {
+            static QTextCodec* utf8 = QTextCodec::codecForName("UTF-8");
+            QTextCodec::ConverterState state(QTextCodec::IgnoreHeader);
+            const QString line = utf8 ? utf8->toUnicode(bytes, size, &state) : QString();
+            if (!utf8 || state.invalidChars != 0 || state.remainingChars != 0)
+                return false;
+
+            // map the byte offsets to UTF-16 offsets in a single pass
+            m_slices = data.slices;
+            int byte = 0;
+            int unit = 0;
+            for (int i = 0; i < m_slices.count(); ++i) {
+                IrcMessageSlice& slice = m_slices[i];
+                const int begin = slice.pos - data.body;
+                const int end = begin + slice.len;
+                for (; byte < begin; ++byte)
+                    unit += irc_utf16_units(static_cast<uchar>(bytes[byte]));
+                slice.pos = unit;
+                int len = 0;
+                for (int b = byte; b < end; ++b)
+                    len += irc_utf16_units(static_cast<uchar>(bytes[b]));
+                slice.len = len;
+            }
+            m_line = line;
+        }
+        m_lineState = 1;
+    }
+    return m_lineState == 1;
+}
+
+QString IrcMessagePrivate::field(int index) const
+{
+    const IrcMessageSlice& slice = m_slices.at(index);
+    if (slice.len == 0)
+        return QString();
+    return m_line.mid(slice.pos, slice.len);
 }
 
 QVariantMap IrcMessagePrivate::tags() const
 {
     if (!m_tags.isExplicit() && m_tags.isNull() && !data.tags.isEmpty()) {
         QVariantMap tags;
+        const QByteArray from = source();
         QMap<QByteArray, QByteArray>::const_iterator it;
         for (it = data.tags.constBegin(); it != data.tags.constEnd(); ++it)
-            tags.insert(decode(it.key(), encoding), decode(it.value(), encoding));
+            tags.insert(decode(it.key(), encoding, from), decode(it.value(), encoding, from));
         m_tags = tags;
     }
     return m_tags.value();
@@ -161,6 +280,10 @@ QByteArray IrcMessagePrivate::content() const
         return data;
     }
 
+    // decoded from the binary format, which does not carry the raw line
+    if (data.content.isNull() && !data.command.isNull())
+        return data.toData();
+
     return data.content;
 }
 
@@ -174,6 +297,7 @@ void IrcMessagePrivate::invalidate()
     m_command.clear();
     m_params.clear();
     m_tags.clear();
+    m_route.clear();
 }
 
 IrcMessageData IrcMessageData::fromData(const QByteArray& data)
@@ -200,12 +324,15 @@ IrcMessageData IrcMessageData::fromData(const QByteArray& data)
     //  <value>   ::= <sequence of any characters except NUL, BELL, CR, LF, semicolon (`;`) and SPACE>
     //  <vendor>  ::= <host>
 
-    QByteArray process = data;
+    const int size = data.size();
+    int pos = 0;
 
     // parse <tags>
-    if (process.startsWith('@')) {
-        process.remove(0, 1);
-        QByteArray tags = process.left(process.indexOf(' '));
+    if (data.startsWith('@')) {
+        int end = data.indexOf(' ', 1);
+        if (end == -1)
+            end = size;
+        const QByteArray tags = data.mid(1, end - 1);
         foreach (const QByteArray& tag, tags.split(';')) {
             const int idx = tag.indexOf('=');
             if (idx != -1)
@@ -213,43 +340,118 @@ IrcMessageData IrcMessageData::fromData(const QByteArray& data)
             else
                 message.tags.insert(tag, QByteArray());
         }
-        process.remove(0, tags.length() + 1);
+        pos = qMin(end + 1, size);
     }
 
+    message.body = pos;
+    IrcMessageSlice slice;
+
     // parse <prefix>
-    if (process.startsWith(':')) {
-        message.prefix = process.left(process.indexOf(' '));
-        process.remove(0, message.prefix.length() + 1);
+    if (pos < size && data.at(pos) == ':') {
+        int end = data.indexOf(' ', pos);
+        if (end == -1)
+            end = size;
+        message.prefix = data.mid(pos, end - pos);
+        slice.pos = pos + 1;
+        slice.len = end - pos - 1;
+        pos = qMin(end + 1, size);
     } else {
         // empty (not null)
         message.prefix = QByteArray("");
+        slice.pos = pos;
+        slice.len = 0;
     }
+    message.slices += slice;
 
     // parse <command>
-    message.command = process.mid(0, process.indexOf(' '));
-    process.remove(0, message.command.length() + 1);
+    int end = data.indexOf(' ', pos);
+    if (end == -1)
+        end = size;
+    message.command = data.mid(pos, end - pos);
+    slice.pos = pos;
+    slice.len = end - pos;
+    message.slices += slice;
+    pos = qMin(end + 1, size);
 
     // parse <params>
-    while (!process.isEmpty()) {
-        if (process.startsWith(':')) {
-            process.remove(0, 1);
-            message.params += process;
-            process.clear();
+    while (pos < size) {
+        if (data.at(pos) == ':') {
+            slice.pos = pos + 1;
+            slice.len = size - pos - 1;
+            pos = size;
         } else {
-            QByteArray param = process.mid(0, process.indexOf(' '));
-            process.remove(0, param.length() + 1);
-            message.params += param;
+            end = data.indexOf(' ', pos);
+            if (end == -1)
+                end = size;
+            slice.pos = pos;
+            slice.len = end - pos;
+            pos = qMin(end + 1, size);
         }
+        message.params += data.mid(slice.pos, slice.len);
+        message.slices += slice;
     }
 
     return message;
 }
 
-QString IrcMessagePrivate::decode(const QByteArray& data, const QByteArray& encoding)
+QByteArray IrcMessageData::toData() const
+{
+    QByteArray data;
+
+    // format <tags>
+    if (!tags.isEmpty()) {
+        data += '@';
+        QMap<QByteArray, QByteArray>::const_iterator it;
+        for (it = tags.constBegin(); it != tags.constEnd(); ++it) {
+            if (it != tags.constBegin())
+                data += ';';
+            data += it.key();
+            if (!it.value().isEmpty()) {
+                data += '=';
+                data += it.value();
+            }
+        }
+        data += ' ';
+    }
+
+    // format <prefix>, including the leading colon
+    if (!prefix.isEmpty()) {
+        data += prefix;
+        data += ' ';
+    }
+
+    // format <command> <params>
+    data += command;
+    for (int i = 0; i < params.count(); ++i) {
+        const QByteArray& param = params.at(i);
+        data += ' ';
+        if (i == params.count() - 1 && (param.isEmpty() || param.startsWith(':') || param.contains(' ')))
+            data += ':';
+        data += param;
+    }
+    return data;
+}
+
+QByteArray IrcMessagePrivate::source() const
+{
+    // the nick or server name, as a slice of the raw prefix
+    if (!connection || !connection->isEncodingDetectionEnabled())
+        return QByteArray();
+    if (data.prefix.length() < 2 || !data.prefix.startsWith(':'))
+        return QByteArray();
+    int end = data.prefix.indexOf('!');
+    if (end == -1)
+        end = data.prefix.indexOf('@');
+    if (end == -1)
+        end = data.prefix.length();
+    return QByteArray::fromRawData(data.prefix.constData() + 1, end - 1);
+}
+
+QString IrcMessagePrivate::decode(const QByteArray& data, const QByteArray& encoding, const QByteArray& source)
 {
-    // TODO: not thread safe
+    // shared by all connections, whichever thread they live in
     static IrcMessageDecoder decoder;
-    return decoder.decode(data, encoding);
+    return decoder.decode(data, encoding, source);
 }
 
 bool IrcMessagePrivate::parsePrefix(const QString& prefix, QString* nick, QString* ident, QString* host)
@@ -35,6 +35,8 @@
 
 IRC_BEGIN_NAMESPACE
 
+static const int MAX_LEARNED_SOURCES = 256;
+
 IRC_CORE_EXPORT bool irc_is_supported_encoding(const QByteArray& encoding)
 {
     static QSet<QByteArray> codecs = IrcPrivate::listToSet(QTextCodec::availableCodecs());
@@ -51,7 +53,7 @@ IrcMessageDecoder::~IrcMessageDecoder()
     uninitialize();
 }
 
-QString IrcMessageDecoder::decode(const QByteArray& data, const QByteArray& encoding) const
+QString IrcMessageDecoder::decode(const QByteArray& data, const QByteArray& encoding, const QByteArray& source) const
 {
     if (data.isEmpty())
         return QString();
@@ -68,10 +70,75 @@ QString IrcMessageDecoder::decode(const QByteArray& data, const QByteArray& enco
     if (!defaultCodec)
         defaultCodec = QTextCodec::codecForName("UTF-8");
 
-    QTextCodec* codec = QTextCodec::codecForUtfText(data, defaultCodec);
+    // a byte order mark beats anything learned
+    QTextCodec* codec = QTextCodec::codecForUtfText(data, nullptr);
+    if (!codec && !source.isEmpty()) {
+        QMutexLocker locker(&mutex);
+
+        // try what the source is known to send before detecting again
+        QHash<QByteArray, Learned>::iterator it = cache.find(source);
+        if (it != cache.end()) {
+            QTextCodec::ConverterState state;
+            QString text = it->codec->toUnicode(data, data.length(), &state);
+            if (state.invalidChars == 0) {
+                it->used = ++clock;
+                return text;
+            }
+            cache.erase(it);
+        }
+
+        QTextCodec* detected = QTextCodec::codecForName(codecForData(data));
+        if (detected) {
+            QTextCodec::ConverterState state;
+            QString text = detected->toUnicode(data, data.length(), &state);
+            if (state.invalidChars == 0) {
+                learn(source, detected);
+                return text;
+            }
+        }
+    }
+    if (!codec)
+        codec = defaultCodec;
     Q_ASSERT(codec);
     return codec->toUnicode(data);
 }
+
+QByteArray IrcMessageDecoder::learned(const QByteArray& source) const
+{
+    QMutexLocker locker(&mutex);
+    QHash<QByteArray, Learned>::const_iterator it = cache.constFind(source);
+    if (it != cache.constEnd())
+        return it->codec->name();
+    return QByteArray();
+}
+
+void IrcMessageDecoder::learn(const QByteArray& source, const QByteArray& encoding) const
+{
+    QMutexLocker locker(&mutex);
+    if (QTextCodec* codec = QTextCodec::codecForName(encoding))
+        learn(source, codec);
+    else
+        cache.remove(source);
+}
+
+// called with the mutex locked
+void IrcMessageDecoder::learn(const QByteArray& source, QTextCodec* codec) const
+{
+    if (!cache.contains(source) && cache.count() >= MAX_LEARNED_SOURCES) {
+        QHash<QByteArray, Learned>::iterator lru = cache.begin();
+        for (QHash<QByteArray, Learned>::iterator it = cache.begin(); it != cache.end(); ++it) {
+            if (it->used < lru->used)
+                lru = it;
+        }
+        cache.erase(lru);
+    }
+
+    Learned entry;
+    entry.codec = codec;
+    entry.used = ++clock;
+    // the source may be a raw slice of a message
+    cache.insert(QByteArray(source.constData(), source.size()), entry);
+}
 #endif // IRC_DOXYGEN
 
 IRC_END_NAMESPACE
@@ -42,7 +42,9 @@ void IrcMessageDecoder::uninitialize()
 
 QByteArray IrcMessageDecoder::codecForData(const QByteArray &data) const
 {
-    return data;
+    // no detection
+    Q_UNUSED(data);
+    return QByteArray();
 }
 #endif // IRC_DOXYGEN
 
@@ -0,0 +1,529 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircmessagering.h"
+#include "ircmessagering_p.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include <QtEndian>
+#include <cstring>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircmessagering.h
+    \brief \#include &lt;IrcMessageRing&gt;
+ */
+
+/*!
+    \class IrcMessageRing ircmessagering.h IrcMessageRing
+    \ingroup core
+    \brief Provides a shared memory message ring between processes.
+    \since 3.7
+
+    IrcMessageRing is a single-producer/single-consumer ring buffer in
+    shared memory. It passes messages from one process to another, such
+    as from a bouncer process that owns the IRC connection to a user
+    interface process, without sockets or locks. Messages go through the
+    ring in the binary format of IrcMessage::toBinary(), so the consumer
+    does not need to parse text.
+
+    One process creates the ring and the other attaches to it with the
+    same key. Exactly one of them writes and the other reads.
+
+    \code
+    // producer
+    IrcMessageRing* ring = new IrcMessageRing(this);
+    ring->create("bouncer", 1024 * 1024);
+    ring->setConnection(connection); // publishes every received message
+
+    // consumer
+    IrcMessageRing* ring = new IrcMessageRing(this);
+    ring->attach("bouncer");
+    ring->setPollInterval(10);
+    connect(ring, &IrcMessageRing::readyRead, [=]() {
+        while (IrcMessage* message = ring->readMessage(connection))
+            handle(message);
+    });
+    \endcode
+
+    \section backpressure Backpressure
+
+    A write fails when the ring does not have room for the record. The
+    producer can retry later, or drop the record. Every failed write is
+    counted as an \ref overruns "overrun", which is visible to both
+    processes. Messages published from the \ref connection "connection"
+    are dropped when the ring is full, so that a stalled consumer can
+    never stall the IRC connection.
+
+    \note The consumer has no way to be woken up by another process, so
+    it either calls read() when convenient or polls with a
+    \ref pollInterval "poll interval".
+ */
+
+/*!
+    \fn void IrcMessageRing::readyRead()
+
+    This signal is emitted when the ring has data to read.
+
+    The signal is only emitted when the \ref pollInterval "poll interval" is positive.
+ */
+
+#ifndef IRC_DOXYGEN
+static const quint32 IRC_RING_MAGIC = 0x49524352; // "IRCR"
+static const quint32 IRC_RING_VERSION = 1;
+static const quint32 IRC_RING_MIN_CAPACITY = 64;
+static const quint32 IRC_RING_MAX_CAPACITY = 1u << 30;
+static const quint32 IRC_RING_RECORD_HEADER = sizeof(quint32);
+
+static_assert(sizeof(IrcMessageRingHeader) % 64 == 0, "IrcMessageRingHeader must fill whole cache lines");
+
+IrcMessageRingHeader* IrcMessageRingPrivate::header() const
+{
+#ifndef QT_NO_SHAREDMEMORY
+    if (memory.isAttached())
+        return static_cast<IrcMessageRingHeader*>(const_cast<void*>(memory.constData()));
+#endif
+    return nullptr;
+}
+
+char* IrcMessageRingPrivate::data() const
+{
+    return reinterpret_cast<char*>(header()) + sizeof(IrcMessageRingHeader);
+}
+
+// positions are free-running counters, the capacity is a power of two
+void IrcMessageRingPrivate::copyIn(quint32 pos, const void* src, quint32 size)
+{
+    const quint32 capacity = header()->capacity;
+    const quint32 offset = pos & (capacity - 1);
+    const quint32 first = qMin(size, capacity - offset);
+    std::memcpy(data() + offset, src, first);
+    std::memcpy(data(), static_cast<const char*>(src) + first, size - first);
+}
+
+void IrcMessageRingPrivate::copyOut(quint32 pos, void* dst, quint32 size) const
+{
+    const quint32 capacity = header()->capacity;
+    const quint32 offset = pos & (capacity - 1);
+    const quint32 first = qMin(size, capacity - offset);
+    std::memcpy(dst, data() + offset, first);
+    std::memcpy(static_cast<char*>(dst) + first, data(), size - first);
+}
+
+void IrcMessageRingPrivate::updateTimer()
+{
+    if (pollInterval > 0 && header()) {
+        timer.start(pollInterval);
+    } else if (timer.isActive()) {
+        timer.stop();
+    }
+}
+
+void IrcMessageRingPrivate::_irc_messageReceived(IrcMessage* message)
+{
+    Q_Q(IrcMessageRing);
+    q->writeMessage(message);
+}
+
+void IrcMessageRingPrivate::_irc_poll()
+{
+    Q_Q(IrcMessageRing);
+    if (q->bytesAvailable() > 0)
+        emit q->readyRead();
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    Constructs a new message ring with \a parent.
+ */
+IrcMessageRing::IrcMessageRing(QObject* parent) : QObject(parent), d_ptr(new IrcMessageRingPrivate)
+{
+    Q_D(IrcMessageRing);
+    d->q_ptr = this;
+    connect(&d->timer, SIGNAL(timeout()), this, SLOT(_irc_poll()));
+}
+
+/*!
+    Destructs the message ring.
+
+    The shared memory is released when the last process detaches from it.
+ */
+IrcMessageRing::~IrcMessageRing()
+{
+}
+
+/*!
+    This property holds the key of the shared memory.
+
+    \par Access function:
+    \li QString <b>key</b>() const
+
+    \sa create(), attach()
+ */
+QString IrcMessageRing::key() const
+{
+#ifndef QT_NO_SHAREDMEMORY
+    Q_D(const IrcMessageRing);
+    return d->memory.key();
+#else
+    return QString();
+#endif
+}
+
+/*!
+    This property holds the capacity of the ring in bytes.
+
+    The value is \c 0 when the ring is not attached.
+
+    \par Access function:
+    \li int <b>capacity</b>() const
+ */
+int IrcMessageRing::capacity() const
+{
+    Q_D(const IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    return header ? static_cast<int>(header->capacity) : 0;
+}
+
+/*!
+    This property holds whether the ring is attached to shared memory.
+
+    \par Access function:
+    \li bool <b>isAttached</b>() const
+
+    \sa create(), attach(), detach()
+ */
+bool IrcMessageRing::isAttached() const
+{
+    Q_D(const IrcMessageRing);
+    return d->header();
+}
+
+/*!
+    Creates a ring of at least \a capacity bytes in shared memory identified
+    by \a key, and attaches to it.
+
+    The capacity is rounded up to a power of two. Each record takes four
+    bytes in addition to its data.
+
+    Returns \c true on success; otherwise \c false, for example when
+    shared memory with the same key already exists.
+
+    \sa attach(), detach()
+ */
+bool IrcMessageRing::create(const QString& key, int capacity)
+{
+    Q_D(IrcMessageRing);
+    detach();
+#ifndef QT_NO_SHAREDMEMORY
+    if (capacity <= 0 || static_cast<quint32>(capacity) > IRC_RING_MAX_CAPACITY)
+        return false;
+    quint32 size = IRC_RING_MIN_CAPACITY;
+    while (size < static_cast<quint32>(capacity))
+        size <<= 1;
+
+    d->memory.setKey(key);
+    if (!d->memory.create(static_cast<int>(sizeof(IrcMessageRingHeader) + size)))
+        return false;
+
+    IrcMessageRingHeader* header = d->header();
+    std::memset(static_cast<void*>(header), 0, sizeof(IrcMessageRingHeader));
+    header->version = IRC_RING_VERSION;
+    header->capacity = size;
+    // publish last, so that a consumer never sees a half initialized ring
+    header->magic.storeRelease(IRC_RING_MAGIC);
+    d->updateTimer();
+    return true;
+#else
+    Q_UNUSED(key);
+    Q_UNUSED(capacity);
+    return false;
+#endif
+}
+
+/*!
+    Attaches to an existing ring in shared memory identified by \a key.
+
+    Returns \c true on success; otherwise \c false, for example when the
+    shared memory does not exist or does not contain a compatible ring.
+
+    \sa create(), detach()
+ */
+bool IrcMessageRing::attach(const QString& key)
+{
+    Q_D(IrcMessageRing);
+    detach();
+#ifndef QT_NO_SHAREDMEMORY
+    d->memory.setKey(key);
+    if (!d->memory.attach(QSharedMemory::ReadWrite))
+        return false;
+
+    if (static_cast<quint32>(d->memory.size()) < sizeof(IrcMessageRingHeader)) {
+        d->memory.detach();
+        return false;
+    }
+
+    const IrcMessageRingHeader* header = d->header();
+    const quint32 capacity = header->capacity;
+    if (header->magic.loadAcquire() != IRC_RING_MAGIC || header->version != IRC_RING_VERSION
+            || capacity < IRC_RING_MIN_CAPACITY || capacity > IRC_RING_MAX_CAPACITY || (capacity & (capacity - 1))
+            || static_cast<quint32>(d->memory.size()) < sizeof(IrcMessageRingHeader) + capacity) {
+        d->memory.detach();
+        return false;
+    }
+    d->updateTimer();
+    return true;
+#else
+    Q_UNUSED(key);
+    return false;
+#endif
+}
+
+/*!
+    Detaches from the shared memory.
+
+    \sa create(), attach()
+ */
+void IrcMessageRing::detach()
+{
+    Q_D(IrcMessageRing);
+#ifndef QT_NO_SHAREDMEMORY
+    if (d->memory.isAttached())
+        d->memory.detach();
+#endif
+    d->updateTimer();
+}
+
+/*!
+    This property holds the amount of bytes waiting to be read, including record headers.
+
+    \par Access function:
+    \li int <b>bytesAvailable</b>() const
+
+    \sa bytesFree
+ */
+int IrcMessageRing::bytesAvailable() const
+{
+    Q_D(const IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    if (!header)
+        return 0;
+    return static_cast<int>(header->head.loadAcquire() - header->tail.loadAcquire());
+}
+
+/*!
+    This property holds the amount of free bytes, including record headers.
+
+    \par Access function:
+    \li int <b>bytesFree</b>() const
+
+    \sa bytesAvailable
+ */
+int IrcMessageRing::bytesFree() const
+{
+    Q_D(const IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    if (!header)
+        return 0;
+    return static_cast<int>(header->capacity) - bytesAvailable();
+}
+
+/*!
+    This property holds the amount of writes that failed because the ring was full.
+
+    The counter lives in the shared memory, so both processes see the same value.
+
+    \par Access function:
+    \li int <b>overruns</b>() const
+ */
+int IrcMessageRing::overruns() const
+{
+    Q_D(const IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    return header ? static_cast<int>(header->overruns.loadAcquire()) : 0;
+}
+
+/*!
+    This property holds the poll interval in milliseconds.
+
+    When positive, the ring checks for data at the interval and
+    emits readyRead() when there is data to read.
+
+    The default value is \c 0, which disables polling.
+
+    \par Access functions:
+    \li int <b>pollInterval</b>() const
+    \li void <b>setPollInterval</b>(int msecs)
+ */
+int IrcMessageRing::pollInterval() const
+{
+    Q_D(const IrcMessageRing);
+    return d->pollInterval;
+}
+
+void IrcMessageRing::setPollInterval(int msecs)
+{
+    Q_D(IrcMessageRing);
+    d->pollInterval = qMax(0, msecs);
+    d->updateTimer();
+}
+
+/*!
+    This property holds the connection whose messages are published to the ring.
+
+    Every message received by the connection is written to the ring.
+    Messages that do not fit are dropped and counted as overruns.
+
+    \par Access functions:
+    \li IrcConnection* <b>connection</b>() const
+    \li void <b>setConnection</b>(IrcConnection* connection)
+ */
+IrcConnection* IrcMessageRing::connection() const
+{
+    Q_D(const IrcMessageRing);
+    return d->connection;
+}
+
+void IrcMessageRing::setConnection(IrcConnection* connection)
+{
+    Q_D(IrcMessageRing);
+    if (d->connection != connection) {
+        if (d->connection)
+            disconnect(d->connection, SIGNAL(messageReceived(IrcMessage*)), this, SLOT(_irc_messageReceived(IrcMessage*)));
+        d->connection = connection;
+        if (connection)
+            connect(connection, SIGNAL(messageReceived(IrcMessage*)), this, SLOT(_irc_messageReceived(IrcMessage*)));
+    }
+}
+
+/*!
+    Writes a record of \a data to the ring.
+
+    Returns \c true on success; otherwise \c false when the ring is not
+    attached or does not have room for the record. A failed write is
+    counted as an overrun.
+
+    \sa read(), writeMessage(), bytesFree
+ */
+bool IrcMessageRing::write(const QByteArray& data)
+{
+    Q_D(IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    if (!header)
+        return false;
+
+    const quint32 size = static_cast<quint32>(data.size());
+    const quint32 head = header->head.loadAcquire();
+    const quint32 tail = header->tail.loadAcquire();
+    const quint32 room = header->capacity - (head - tail);
+    if (size > header->capacity - IRC_RING_RECORD_HEADER || size + IRC_RING_RECORD_HEADER > room) {
+        header->overruns.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    const quint32 length = qToLittleEndian(size);
+    d->copyIn(head, &length, IRC_RING_RECORD_HEADER);
+    d->copyIn(head + IRC_RING_RECORD_HEADER, data.constData(), size);
+    // the record becomes visible to the consumer only after it is complete
+    header->head.storeRelease(head + IRC_RING_RECORD_HEADER + size);
+    return true;
+}
+
+/*!
+    Reads the next record from the ring.
+
+    Returns a null byte array if there is nothing to read.
+
+    \sa write(), readMessage(), bytesAvailable
+ */
+QByteArray IrcMessageRing::read()
+{
+    Q_D(IrcMessageRing);
+    IrcMessageRingHeader* header = d->header();
+    if (!header)
+        return QByteArray();
+
+    const quint32 tail = header->tail.loadAcquire();
+    const quint32 head = header->head.loadAcquire();
+    const quint32 available = head - tail;
+    if (available < IRC_RING_RECORD_HEADER)
+        return QByteArray();
+
+    quint32 size = 0;
+    d->copyOut(tail, &size, IRC_RING_RECORD_HEADER);
+    size = qFromLittleEndian(size);
+    if (size > available - IRC_RING_RECORD_HEADER) {
+        // a misbehaving producer, skip everything there is
+        header->tail.storeRelease(head);
+        return QByteArray();
+    }
+
+    QByteArray data(static_cast<int>(size), Qt::Uninitialized);
+    d->copyOut(tail + IRC_RING_RECORD_HEADER, data.data(), size);
+    // hand the space back to the producer only after it has been copied
+    header->tail.storeRelease(tail + IRC_RING_RECORD_HEADER + size);
+    return data;
+}
+
+/*!
+    Writes \a message to the ring in the binary message format.
+
+    \sa readMessage(), IrcMessage::toBinary()
+ */
+bool IrcMessageRing::writeMessage(IrcMessage* message)
+{
+    if (!message)
+        return false;
+    return write(message->toBinary());
+}
+
+/*!
+    Reads the next message from the ring, and creates it with \a connection.
+
+    Records that are not valid messages are skipped. Returns \c nullptr
+    if there are no messages to read. The caller takes ownership of the
+    message, unless it has \a connection as its parent.
+
+    \sa writeMessage(), IrcMessage::fromBinary()
+ */
+IrcMessage* IrcMessageRing::readMessage(IrcConnection* connection)
+{
+    QByteArray data = read();
+    while (!data.isNull()) {
+        IrcMessage* message = IrcMessage::fromBinary(data, connection);
+        if (message)
+            return message;
+        data = read();
+    }
+    return nullptr;
+}
+
+#include "moc_ircmessagering.cpp"
+
+IRC_END_NAMESPACE
@@ -34,6 +34,7 @@
 #include "irccommand.h"
 #include "irccore_p.h"
 #include <QMetaEnum>
+#include <QMetaMethod>
 #include <QPointer>
 
 IRC_BEGIN_NAMESPACE
@@ -90,6 +91,42 @@ IRC_BEGIN_NAMESPACE
     \sa requestedCapabilities, availableCapabilities
  */
 
+/*!
+    \fn void IrcNetwork::availableCapabilitiesAdded(const QStringList& capabilities)
+    \since 3.7
+
+    This signal is emitted when \a capabilities become available.
+
+    \sa availableCapabilities, availableCapabilitiesRemoved()
+ */
+
+/*!
+    \fn void IrcNetwork::availableCapabilitiesRemoved(const QStringList& capabilities)
+    \since 3.7
+
+    This signal is emitted when \a capabilities are no longer available.
+
+    \sa availableCapabilities, availableCapabilitiesAdded()
+ */
+
+/*!
+    \fn void IrcNetwork::activeCapabilitiesAdded(const QStringList& capabilities)
+    \since 3.7
+
+    This signal is emitted when \a capabilities are activated.
+
+    \sa activeCapabilities, activeCapabilitiesRemoved()
+ */
+
+/*!
+    \fn void IrcNetwork::activeCapabilitiesRemoved(const QStringList& capabilities)
+    \since 3.7
+
+    This signal is emitted when \a capabilities are deactivated.
+
+    \sa activeCapabilities, activeCapabilitiesAdded()
+ */
+
 /*!
     \enum IrcNetwork::ModeType
     This enum describes the channel mode types.
@@ -207,6 +244,8 @@ void IrcNetworkPrivate::setInfo(const QHash<QString, QString>& info)
         setModes(pfx.mid(1, pfx.indexOf(')') - 1).split("", Qt::SkipEmptyParts));
         setPrefixes(pfx.mid(pfx.indexOf(')') + 1).split("", Qt::SkipEmptyParts));
     }
+    if (info.contains("CASEMAPPING"))
+        caseMapping = info.value("CASEMAPPING").toLower();
     if (info.contains("CHANTYPES"))
         setChannelTypes(info.value("CHANTYPES").split("", Qt::SkipEmptyParts));
     if (info.contains("STATUSMSG"))
@@ -246,8 +285,16 @@ void IrcNetworkPrivate::setAvailableCapabilities(const QSet<QString>& capabiliti
 {
     Q_Q(IrcNetwork);
     if (availableCaps != capabilities) {
+        const QStringList added = IrcPrivate::setToList(QSet<QString>(capabilities).subtract(availableCaps));
+        const QStringList removed = IrcPrivate::setToList(QSet<QString>(availableCaps).subtract(capabilities));
         availableCaps = capabilities;
-        emit q->availableCapabilitiesChanged(IrcPrivate::setToList(availableCaps));
+        if (!added.isEmpty())
+            emit q->availableCapabilitiesAdded(added);
+        if (!removed.isEmpty())
+            emit q->availableCapabilitiesRemoved(removed);
+        // the full list is built only for those who listen to it
+        if (q->isSignalConnected(QMetaMethod::fromSignal(&IrcNetwork::availableCapabilitiesChanged)))
+            emit q->availableCapabilitiesChanged(IrcPrivate::setToList(availableCaps));
     }
 }
 
@@ -255,8 +302,15 @@ void IrcNetworkPrivate::setActiveCapabilities(const QSet<QString>& capabilities)
 {
     Q_Q(IrcNetwork);
     if (activeCaps != capabilities) {
+        const QStringList added = IrcPrivate::setToList(QSet<QString>(capabilities).subtract(activeCaps));
+        const QStringList removed = IrcPrivate::setToList(QSet<QString>(activeCaps).subtract(capabilities));
         activeCaps = capabilities;
-        emit q->activeCapabilitiesChanged(IrcPrivate::setToList(activeCaps));
+        if (!added.isEmpty())
+            emit q->activeCapabilitiesAdded(added);
+        if (!removed.isEmpty())
+            emit q->activeCapabilitiesRemoved(removed);
+        if (q->isSignalConnected(QMetaMethod::fromSignal(&IrcNetwork::activeCapabilitiesChanged)))
+            emit q->activeCapabilitiesChanged(IrcPrivate::setToList(activeCaps));
     }
 }
 
@@ -585,6 +639,9 @@ int IrcNetwork::targetLimit(const QString& command) const
     \par Notifier signal:
     \li void <b>availableCapabilitiesChanged</b>(const QStringList& capabilities)
 
+    Since 3.7, the availableCapabilitiesAdded() and availableCapabilitiesRemoved()
+    signals report only the capabilities that changed.
+
     \sa requestedCapabilities, activeCapabilities
  */
 QStringList IrcNetwork::availableCapabilities() const
@@ -602,6 +659,9 @@ QStringList IrcNetwork::availableCapabilities() const
     \par Notifier signal:
     \li void <b>activeCapabilitiesChanged</b>(const QStringList& capabilities)
 
+    Since 3.7, the activeCapabilitiesAdded() and activeCapabilitiesRemoved()
+    signals report only the capabilities that changed.
+
     \sa requestedCapabilities, availableCapabilities
  */
 QStringList IrcNetwork::activeCapabilities() const
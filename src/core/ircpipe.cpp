@@ -0,0 +1,338 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircpipe.h"
+#include "ircpipe_p.h"
+#include <QMetaObject>
+#include <cstring>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircpipe.h
+    \brief \#include &lt;IrcPipe&gt;
+ */
+
+/*!
+    \class IrcPipe ircpipe.h IrcPipe
+    \ingroup core
+    \brief Provides an in-process transport for IrcConnection.
+    \since 3.7
+
+    IrcPipe connects two in-process sockets back to back. Data written
+    to one end is delivered to the other end from the event loop, without
+    system calls or a TCP round trip. This is useful when an IRC client and
+    a bouncer or server live in the same process, and for tests that want to
+    drive an IrcConnection deterministically and at full speed.
+
+    The \ref clientSocket "client socket" is assigned to an IrcConnection
+    with IrcConnection::setSocket(). The host and port of the connection are
+    ignored. Once the connection is opened, the pipe emits newConnection()
+    and the \ref serverSocket "server socket" can be used to exchange IRC
+    lines with the connection.
+
+    \code
+    IrcPipe* pipe = new IrcPipe(this);
+    connect(pipe, &IrcPipe::newConnection, bouncer, &Bouncer::attach);
+
+    IrcConnection* connection = new IrcConnection(this);
+    connection->setSocket(pipe->clientSocket());
+    connection->setHost("bouncer");
+    connection->open();
+    \endcode
+
+    Both ends behave like connected TCP sockets: they emit
+    \ref QAbstractSocket::connected() "connected()",
+    \ref QIODevice::readyRead() "readyRead()" and
+    \ref QAbstractSocket::disconnected() "disconnected()", and closing
+    one end makes the other end report that the remote host has closed
+    the connection. A closed pipe can be connected again.
+
+    Data that the other end has not read yet counts as
+    \ref QIODevice::bytesToWrite() "bytes to write", and
+    \ref QIODevice::bytesWritten() "bytesWritten()" is emitted once it has
+    been read. A slow reader therefore applies backpressure, for example to
+    an IrcCommandQueue with a \ref IrcCommandQueue::highWatermark
+    "high watermark".
+
+    \note The pipe owns its sockets. IrcConnection does not delete
+    a socket it does not own, so the pipe must outlive the connection
+    or be replaced with IrcConnection::setSocket() first.
+
+    \sa IrcConnection::socket
+ */
+
+/*!
+    \fn void IrcPipe::newConnection()
+
+    This signal is emitted when the client socket connects to the server socket.
+ */
+
+#ifndef IRC_DOXYGEN
+IrcPipeSocket::IrcPipeSocket(IrcPipe* owner) : QAbstractSocket(UnknownSocketType, owner), pipe(owner)
+{
+}
+
+void IrcPipeSocket::connectToHost(const QString& hostName, quint16 port, OpenMode mode, NetworkLayerProtocol protocol)
+{
+    Q_UNUSED(mode);
+    Q_UNUSED(protocol);
+    if (state() != UnconnectedState) {
+        qWarning("IrcPipeSocket::connectToHost() called when already connecting/connected");
+        return;
+    }
+    setPeerName(hostName);
+    setPeerPort(port);
+    setState(ConnectingState);
+    QMetaObject::invokeMethod(this, "establish", Qt::QueuedConnection);
+}
+
+void IrcPipeSocket::connectToHost(const QHostAddress& address, quint16 port, OpenMode mode)
+{
+    Q_UNUSED(address);
+    connectToHost(QString(), port, mode);
+}
+
+void IrcPipeSocket::disconnectFromHost()
+{
+    shutdown(false);
+}
+
+void IrcPipeSocket::close()
+{
+    shutdown(false);
+}
+
+qint64 IrcPipeSocket::bytesAvailable() const
+{
+    return buffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 IrcPipeSocket::bytesToWrite() const
+{
+    // written, but not yet read by the peer
+    return peer && state() == ConnectedState ? peer->buffer.size() : 0;
+}
+
+bool IrcPipeSocket::canReadLine() const
+{
+    return buffer.contains('\n') || QIODevice::canReadLine();
+}
+
+bool IrcPipeSocket::waitForConnected(int msecs)
+{
+    Q_UNUSED(msecs);
+    if (state() == ConnectingState)
+        establish();
+    return state() == ConnectedState;
+}
+
+bool IrcPipeSocket::waitForReadyRead(int msecs)
+{
+    Q_UNUSED(msecs);
+    if (buffer.isEmpty())
+        return false;
+    deliver();
+    return true;
+}
+
+bool IrcPipeSocket::waitForBytesWritten(int msecs)
+{
+    Q_UNUSED(msecs);
+    return state() == ConnectedState;
+}
+
+bool IrcPipeSocket::waitForDisconnected(int msecs)
+{
+    Q_UNUSED(msecs);
+    return state() == UnconnectedState;
+}
+
+qint64 IrcPipeSocket::readData(char* data, qint64 maxSize)
+{
+    const int count = static_cast<int>(qMin<qint64>(maxSize, buffer.size()));
+    if (count > 0) {
+        memcpy(data, buffer.constData(), count);
+        if (count == buffer.size())
+            buffer.clear();
+        else
+            buffer.remove(0, count);
+        // the data has left the pipe, like a real socket that has sent it
+        if (peer)
+            QMetaObject::invokeMethod(peer, "bytesWritten", Qt::QueuedConnection, Q_ARG(qint64, count));
+    }
+    return count;
+}
+
+qint64 IrcPipeSocket::writeData(const char* data, qint64 size)
+{
+    if (state() != ConnectedState || !peer) {
+        setError(NetworkError, tr("Socket is not connected"));
+        return -1;
+    }
+    peer->buffer.append(data, static_cast<int>(size));
+    if (!peer->delivering) {
+        // deliver once per event loop pass, like a real socket
+        peer->delivering = true;
+        QMetaObject::invokeMethod(peer, "deliver", Qt::QueuedConnection);
+    }
+    return size;
+}
+
+void IrcPipeSocket::establish()
+{
+    if (state() != ConnectingState)
+        return;
+    if (!peer || peer->state() != UnconnectedState) {
+        setState(UnconnectedState);
+        setError(ConnectionRefusedError, tr("Connection refused"));
+        return;
+    }
+
+    peer->QIODevice::open(ReadWrite);
+    peer->setState(ConnectedState);
+    emit peer->connected();
+    emit pipe->newConnection();
+
+    QIODevice::open(ReadWrite);
+    setState(ConnectedState);
+    emit connected();
+}
+
+void IrcPipeSocket::deliver()
+{
+    delivering = false;
+    if (!buffer.isEmpty() && state() == ConnectedState)
+        emit readyRead();
+}
+
+void IrcPipeSocket::remoteClosed()
+{
+    if (state() == ConnectedState) {
+        deliver();
+        shutdown(true);
+    }
+}
+
+void IrcPipeSocket::setState(SocketState value)
+{
+    if (state() != value) {
+        setSocketState(value);
+        emit stateChanged(value);
+    }
+}
+
+void IrcPipeSocket::setError(SocketError error, const QString& message)
+{
+    setSocketError(error);
+    setErrorString(message);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    emit errorOccurred(error);
+#endif
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0) || QT_DEPRECATED_SINCE(5, 15)
+    emit this->error(error);
+#endif
+}
+
+void IrcPipeSocket::shutdown(bool remote)
+{
+    if (state() == UnconnectedState)
+        return;
+
+    const bool wasConnected = state() == ConnectedState;
+    if (wasConnected)
+        setState(ClosingState);
+    if (remote)
+        setError(RemoteHostClosedError, tr("The remote host closed the connection"));
+    QIODevice::close();
+    buffer.clear();
+    delivering = false;
+    setState(UnconnectedState);
+
+    if (wasConnected) {
+        emit disconnected();
+        if (!remote && peer)
+            QMetaObject::invokeMethod(peer, "remoteClosed", Qt::QueuedConnection);
+    }
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    Constructs a new pipe with \a parent.
+ */
+IrcPipe::IrcPipe(QObject* parent) : QObject(parent), d_ptr(new IrcPipePrivate)
+{
+    Q_D(IrcPipe);
+    d->q_ptr = this;
+    d->client = new IrcPipeSocket(this);
+    d->server = new IrcPipeSocket(this);
+    d->client->peer = d->server;
+    d->server->peer = d->client;
+}
+
+/*!
+    Destructs the pipe and its sockets.
+ */
+IrcPipe::~IrcPipe()
+{
+}
+
+/*!
+    This property holds the client end of the pipe.
+
+    Assign the client socket to an IrcConnection with IrcConnection::setSocket().
+
+    \par Access function:
+    \li QAbstractSocket* <b>clientSocket</b>() const
+ */
+QAbstractSocket* IrcPipe::clientSocket() const
+{
+    Q_D(const IrcPipe);
+    return d->client;
+}
+
+/*!
+    This property holds the server end of the pipe.
+
+    The server socket becomes connected when the client socket connects.
+
+    \par Access function:
+    \li QAbstractSocket* <b>serverSocket</b>() const
+
+    \sa newConnection()
+ */
+QAbstractSocket* IrcPipe::serverSocket() const
+{
+    Q_D(const IrcPipe);
+    return d->server;
+}
+
+#include "moc_ircpipe.cpp"
+#include "moc_ircpipe_p.cpp"
+
+IRC_END_NAMESPACE
@@ -32,6 +32,7 @@
 #include "ircnetwork_p.h"
 #include "ircconnection.h"
 #include "ircmessage_p.h"
+#include "ircline.h"
 #include "irccommand.h"
 #include "ircdebug_p.h"
 #include "irccore_p.h"
@@ -66,6 +67,7 @@ public:
 
     void readLines(const QByteArray& delimiter);
     void processLine(const QByteArray& line);
+    bool isEssential(const IrcLine& line) const;
 
     bool batchMessage(IrcMessage* msg);
     bool handleBatchMessage(IrcBatchMessage* msg);
@@ -76,6 +78,7 @@ public:
 
     void _irc_pauseHandshake();
     void _irc_resumeHandshake();
+    void _irc_clearBatches();
 
     IrcProtocol* q_ptr = nullptr;
     IrcConnection* connection = nullptr;
@@ -83,6 +86,7 @@ public:
     QHash<QString, IrcBatchMessage*> batches;
     QHash<QString, QString> info;
     QByteArray buffer;
+    int consumed = 0;
     int currentNick = -1;
     bool resumed = false;
     bool authed = false;
@@ -109,13 +113,17 @@ void IrcProtocolPrivate::authenticate(bool secure)
 
 void IrcProtocolPrivate::readLines(const QByteArray& delimiter)
 {
+    // drop the consumed lines at once instead of copying the rest of the
+    // buffer after each line (the offset is shared with nested reads)
     int i = -1;
-    while ((i = buffer.indexOf(delimiter)) != -1) {
-        QByteArray line = buffer.left(i).trimmed();
-        buffer = buffer.mid(i + delimiter.length());
+    while ((i = buffer.indexOf(delimiter, consumed)) != -1) {
+        QByteArray line = buffer.mid(consumed, i - consumed).trimmed();
+        consumed = i + delimiter.length();
         if (!line.isEmpty())
             processLine(line);
     }
+    buffer.remove(0, consumed);
+    consumed = 0;
 }
 
 void IrcProtocolPrivate::processLine(const QByteArray& line)
@@ -132,6 +140,15 @@ void IrcProtocolPrivate::processLine(const QByteArray& line)
         return;
     }
 
+    IrcLineHandler* firehose = IrcConnectionPrivate::get(connection)->firehose;
+    if (firehose && connection->isConnected()) {
+        const IrcLine view(line);
+        if (!isEssential(view)) {
+            firehose->lineReceived(view);
+            return;
+        }
+    }
+
     IrcMessage* msg = IrcMessage::fromData(line, connection);
     if (msg) {
         msg->setEncoding(connection->encoding());
@@ -169,6 +186,20 @@ void IrcProtocolPrivate::processLine(const QByteArray& line)
     }
 }
 
+bool IrcProtocolPrivate::isEssential(const IrcLine& line) const
+{
+    const int code = line.code();
+    if (code != -1)
+        return code < 100;
+
+    const QByteArray command = line.command();
+    if (command == "PING" || command == "PONG" || command == "CAP" || command == "AUTHENTICATE" || command == "ERROR")
+        return true;
+    if (command == "NICK")
+        return QString::fromUtf8(line.nick()) == connection->nickName();
+    return false;
+}
+
 bool IrcProtocolPrivate::batchMessage(IrcMessage* msg)
 {
     QString tag = msg->tags().value("batch").toString();
@@ -259,7 +290,18 @@ void IrcProtocolPrivate::handleNumericMessage(IrcNumericMessage* msg)
 void IrcProtocolPrivate::handlePrivateMessage(IrcPrivateMessage* msg)
 {
     if (msg->isRequest()) {
-        IrcCommand* reply = IrcConnectionPrivate::get(connection)->createCtcpReply(msg);
+        IrcConnectionPrivate* priv = IrcConnectionPrivate::get(connection);
+        // only requests that are answered count against the limits: drop
+        // floods of known requests before any reply is created, and charge
+        // the replies of a reimplemented createCtcpReply() afterwards
+        const bool known = priv->hasDefaultCtcpReply(msg);
+        if (known && !priv->acceptCtcpRequest(msg->nick()))
+            return;
+        IrcCommand* reply = priv->createCtcpReply(msg);
+        if (reply && !known && !priv->acceptCtcpRequest(msg->nick())) {
+            delete reply;
+            return;
+        }
         if (reply)
             connection->sendCommand(reply);
     }
@@ -392,6 +434,13 @@ void IrcProtocolPrivate::_irc_resumeHandshake()
     }
     resumed = true;
 }
+
+void IrcProtocolPrivate::_irc_clearBatches()
+{
+    // the ends of the open batches go elsewhere after a firehose switch
+    qDeleteAll(batches);
+    batches.clear();
+}
 #endif // IRC_DOXYGEN
 
 /*!
@@ -516,6 +565,8 @@ void IrcProtocol::receiveMessage(IrcMessage* message)
     IrcConnectionPrivate* priv = IrcConnectionPrivate::get(d->connection);
     if (priv->receiveMessage(message) && message->type() == IrcMessage::Numeric)
         d->composer->composeMessage(static_cast<IrcNumericMessage*>(message));
+    if (!priv->requests.isEmpty())
+        priv->finishRequests();
 }
 
 /*!
@@ -0,0 +1,309 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircreply.h"
+#include "ircreply_p.h"
+#include "ircconnection_p.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include <QMetaEnum>
+#include <QDebug>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircreply.h
+    \brief \#include &lt;IrcReply&gt;
+ */
+
+/*!
+    \class IrcReply ircreply.h IrcReply
+    \ingroup core
+    \brief Tracks the reply to a query sent via IrcConnection::sendRequest().
+    \since 3.7
+
+    IrcReply is returned by IrcConnection::sendRequest(). It collects
+    the messages the server sends in response to a single WHOIS, WHO or
+    MODE query, and emits finished() once the reply is complete, the
+    request has timed out, it has been \ref abort() "aborted" or the
+    connection was lost.
+
+    Replies are correlated with \c labeled-response when the capability
+    is active, and with the numeric end markers of each query otherwise.
+    Identical queries that are still in flight are coalesced, so that
+    only one command is sent to the server and every reply receives its
+    own copy of the resulting messages.
+
+    \code
+    IrcReply* reply = connection->sendRequest(IrcCommand::createWhois("jpnurmi"));
+    connect(reply, &IrcReply::finished, [=]() {
+        foreach (IrcMessage* message, reply->messages()) {
+            if (message->type() == IrcMessage::Whois)
+                qDebug() << static_cast<IrcWhoisMessage*>(message)->account();
+        }
+        reply->deleteLater();
+    });
+    \endcode
+
+    \note The reply is a child of the connection. The caller is
+    responsible for deleting it, preferably with QObject::deleteLater()
+    from a slot connected to finished().
+
+    \sa IrcConnection::sendRequest()
+ */
+
+/*!
+    \enum IrcReply::Error
+    This enum describes the outcome of a reply.
+ */
+
+/*!
+    \var IrcReply::NoError
+    \brief The server replied to the query.
+ */
+
+/*!
+    \var IrcReply::TimeoutError
+    \brief The server did not reply in time.
+ */
+
+/*!
+    \var IrcReply::CanceledError
+    \brief The reply was \ref abort() "aborted".
+ */
+
+/*!
+    \var IrcReply::ConnectionError
+    \brief The connection was lost before the server replied.
+ */
+
+/*!
+    \var IrcReply::ServerError
+    \brief The server replied with an error numeric, which is available in messages().
+ */
+
+/*!
+    \fn void IrcReply::finished()
+
+    This signal is emitted once the reply has finished.
+
+    \sa error, messages
+ */
+
+#ifndef IRC_DOXYGEN
+void IrcReplyPrivate::_irc_timeout()
+{
+    finish(IrcReply::TimeoutError);
+}
+
+void IrcReplyPrivate::finish(IrcReply::Error value, const QList<IrcMessage*>& replies)
+{
+    Q_Q(IrcReply);
+    if (finished)
+        return;
+    finished = true;
+    error = value;
+    timer.stop();
+    foreach (IrcMessage* message, replies)
+        messages += message->clone(q);
+    // let the connection forget a query nobody waits for
+    if (connection)
+        IrcConnectionPrivate::get(connection)->requestTimer.start(0);
+    emit q->finished();
+}
+
+IrcReply* IrcReplyPrivate::create(IrcConnection* connection, IrcCommand::Type type, const QString& target, int timeout)
+{
+    IrcReply* reply = new IrcReply(connection);
+    IrcReplyPrivate* d = reply->d_func();
+    d->type = type;
+    d->target = target;
+    if (timeout > 0)
+        d->timer.start(timeout);
+    return reply;
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    \internal
+    Constructs a new reply for \a connection.
+ */
+IrcReply::IrcReply(IrcConnection* connection) : QObject(connection), d_ptr(new IrcReplyPrivate)
+{
+    Q_D(IrcReply);
+    d->q_ptr = this;
+    d->connection = connection;
+    d->timer.setSingleShot(true);
+    connect(&d->timer, SIGNAL(timeout()), this, SLOT(_irc_timeout()));
+}
+
+/*!
+    Destructs the reply.
+ */
+IrcReply::~IrcReply()
+{
+    Q_D(IrcReply);
+    if (d->connection && !d->finished)
+        IrcConnectionPrivate::get(d->connection)->requestTimer.start(0);
+}
+
+/*!
+    This property holds the connection the request was sent to.
+
+    \par Access function:
+    \li \ref IrcConnection* <b>connection</b>() const
+ */
+IrcConnection* IrcReply::connection() const
+{
+    Q_D(const IrcReply);
+    return d->connection;
+}
+
+/*!
+    This property holds the type of the command that was sent.
+
+    \par Access function:
+    \li \ref IrcCommand::Type <b>commandType</b>() const
+ */
+IrcCommand::Type IrcReply::commandType() const
+{
+    Q_D(const IrcReply);
+    return d->type;
+}
+
+/*!
+    This property holds the target of the query.
+
+    The target is the nick of a WHOIS query, the mask of a WHO
+    query, or the channel or nick of a MODE query.
+
+    \par Access function:
+    \li QString <b>target</b>() const
+ */
+QString IrcReply::target() const
+{
+    Q_D(const IrcReply);
+    return d->target;
+}
+
+/*!
+    \property bool IrcReply::finished
+    This property holds whether the reply has finished.
+
+    \par Access function:
+    \li bool <b>isFinished</b>() const
+
+    \par Notifier signal:
+    \li void <b>finished</b>()
+ */
+bool IrcReply::isFinished() const
+{
+    Q_D(const IrcReply);
+    return d->finished;
+}
+
+/*!
+    This property holds the outcome of the reply.
+
+    \par Access function:
+    \li \ref IrcReply::Error <b>error</b>() const
+
+    \par Notifier signal:
+    \li void <b>finished</b>()
+ */
+IrcReply::Error IrcReply::error() const
+{
+    Q_D(const IrcReply);
+    return d->error;
+}
+
+/*!
+    This property holds the messages the server replied with.
+
+    WHOIS replies are delivered as a composed IrcWhoisMessage, WHO
+    replies as one IrcWhoReplyMessage per user, and channel MODE
+    replies as an IrcModeMessage. Error numerics are delivered as
+    IrcNumericMessage. The messages are owned by the reply.
+
+    \par Access function:
+    \li QList<\ref IrcMessage*> <b>messages</b>() const
+
+    \par Notifier signal:
+    \li void <b>finished</b>()
+ */
+QList<IrcMessage*> IrcReply::messages() const
+{
+    Q_D(const IrcReply);
+    return d->messages;
+}
+
+/*!
+    Aborts the reply. The reply finishes immediately with
+    IrcReply::CanceledError. Does nothing if the reply has
+    already finished.
+
+    \note The query itself cannot be recalled from the server. Once
+    no other reply waits for the same query, the response is delivered
+    as a regular message when it arrives.
+ */
+void IrcReply::abort()
+{
+    Q_D(IrcReply);
+    d->finish(CanceledError);
+}
+
+#ifndef QT_NO_DEBUG_STREAM
+QDebug operator<<(QDebug debug, IrcReply::Error error)
+{
+    const int index = IrcReply::staticMetaObject.indexOfEnumerator("Error");
+    QMetaEnum enumerator = IrcReply::staticMetaObject.enumerator(index);
+    const char* key = enumerator.valueToKey(error);
+    debug << (key ? key : "Unknown");
+    return debug;
+}
+
+QDebug operator<<(QDebug debug, const IrcReply* reply)
+{
+    if (!reply)
+        return debug << "IrcReply(0x0) ";
+    debug.nospace() << reply->metaObject()->className() << '(' << (void*) reply;
+    if (!reply->objectName().isEmpty())
+        debug.nospace() << ", name=" << qPrintable(reply->objectName());
+    debug.nospace() << ", type=" << reply->commandType();
+    if (!reply->target().isEmpty())
+        debug.nospace() << ", target=" << qPrintable(reply->target());
+    if (reply->isFinished())
+        debug.nospace() << ", error=" << reply->error();
+    debug.nospace() << ')';
+    return debug.space();
+}
+#endif // QT_NO_DEBUG_STREAM
+
+#include "moc_ircreply.cpp"
+
+IRC_END_NAMESPACE
@@ -124,6 +124,7 @@ public:
         qmlRegisterType<IrcChannel>(uri, 3, 0, "IrcChannel");
         qmlRegisterType<IrcUser>(uri, 3, 0, "IrcUser");
         qmlRegisterType<IrcUserModel>(uri, 3, 0, "IrcUserModel");
+        qmlRegisterType<IrcFilterModel>(uri, 3, 7, "IrcFilterModel");
 
         // IrcUtil
         qmlRegisterType<IrcCommandParser>(uri, 3, 0, "IrcCommandParser");
@@ -85,6 +85,7 @@ IrcBufferPrivate::~IrcBufferPrivate()
 void IrcBufferPrivate::init(const QString& title, IrcBufferModel* m)
 {
     name = title;
+    titleDirty = true;
     setModel(m);
 }
 
@@ -106,6 +107,7 @@ void IrcBufferPrivate::setName(const QString& value)
     if (name != value) {
         const QString oldTitle = q->title();
         name = value;
+        titleDirty = true;
         emit q->nameChanged(name);
         emit q->titleChanged(q->title());
         if (model)
@@ -119,6 +121,7 @@ void IrcBufferPrivate::setPrefix(const QString& value)
     if (prefix != value) {
         const QString oldTitle = q->title();
         prefix = value;
+        titleDirty = true;
         emit q->prefixChanged(prefix);
         emit q->titleChanged(q->title());
         if (model)
@@ -334,7 +337,11 @@ IrcBuffer::~IrcBuffer()
 QString IrcBuffer::title() const
 {
     Q_D(const IrcBuffer);
-    return d->prefix + d->name;
+    if (d->titleDirty) {
+        d->title = d->prefix + d->name;
+        d->titleDirty = false;
+    }
+    return d->title;
 }
 
 /*!
@@ -498,6 +505,8 @@ void IrcBuffer::setSticky(bool sticky)
     Q_D(IrcBuffer);
     if (d->sticky != sticky) {
         d->sticky = sticky;
+        if (d->model)
+            IrcBufferModelPrivate::get(d->model)->scheduleMonitor();
         emit stickyChanged(sticky);
     }
 }
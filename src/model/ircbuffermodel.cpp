@@ -28,6 +28,7 @@
 
 #include "ircbuffermodel.h"
 #include "ircbuffermodel_p.h"
+#include "ircsort_p.h"
 #include "ircchannel_p.h"
 #include "ircbuffer_p.h"
 #include "ircnetwork.h"
@@ -35,11 +36,14 @@
 #include "ircmessage.h"
 #include "irccommand.h"
 #include "ircconnection.h"
+#include "ircsnapshot_p.h"
+#include "irccore_p.h"
 #include <qmetatype.h>
 #include <qmetaobject.h>
 #include <qdatastream.h>
 #include <qvariant.h>
 #include <qtimer.h>
+#include <qset.h>
 #include <algorithm>
 
 IRC_BEGIN_NAMESPACE
@@ -93,6 +97,27 @@ IRC_BEGIN_NAMESPACE
     This signal is emitted just before a \a buffer is removed from the list of buffers.
  */
 
+/*!
+    \fn void IrcBufferModel::channelsAdded(const QStringList& channels)
+    \since 3.7
+
+    This signal is emitted when \a channels are added to the list of channels.
+
+    Unlike \ref channels "channelsChanged()", this signal carries only
+    the changed channels.
+
+    \sa channelsRemoved()
+ */
+
+/*!
+    \fn void IrcBufferModel::channelsRemoved(const QStringList& channels)
+    \since 3.7
+
+    This signal is emitted when \a channels are removed from the list of channels.
+
+    \sa channelsAdded()
+ */
+
 /*!
     \fn void IrcBufferModel::messageIgnored(IrcMessage* message)
 
@@ -106,6 +131,46 @@ IRC_BEGIN_NAMESPACE
     \sa IrcConnection::messageReceived(), IrcBuffer::messageReceived()
  */
 
+/*!
+    \fn void IrcBufferModel::netsplit(const QString& servers, const QStringList& nicks)
+    \since 3.7
+
+    This signal is emitted when \a nicks were lost in a netsplit between \a servers.
+
+    The users are removed from all channels in one go and each channel
+    receives a single change notification, instead of one per quit.
+    IrcBuffer::messageReceived() is still emitted for each quit message.
+
+    IRCv3 \c netsplit batches are always aggregated. Plain quit messages
+    are aggregated only when \ref splitDetectionEnabled "split detection"
+    is enabled.
+
+    \sa netjoin(), splitDetectionEnabled
+ */
+
+/*!
+    \fn void IrcBufferModel::netjoin(const QString& servers, const QStringList& nicks)
+    \since 3.7
+
+    This signal is emitted when \a nicks returned after a netsplit between \a servers.
+
+    \note Netjoins are aggregated for IRCv3 \c netjoin batches only.
+
+    \sa netsplit()
+ */
+
+/*!
+    \fn void IrcBufferModel::snapshotPublished(const IrcSnapshot& snapshot)
+    \since 3.7
+
+    This signal is emitted when a new \a snapshot has been published.
+
+    The signal is emitted in the thread of the model. Connect to it with
+    a queued connection to hand snapshots over to worker threads.
+
+    \sa snapshot(), snapshotsEnabled
+ */
+
 #ifndef IRC_DOXYGEN
 class IrcBufferLessThan
 {
@@ -141,19 +206,46 @@ static QHash<int, QByteArray> irc_buffer_model_roles()
 
 IrcBufferModelPrivate::IrcBufferModelPrivate()
 {
+    qRegisterMetaType<IrcSnapshot>();
+    clock.start();
+}
+
+static bool looksLikeSplit(const QString& reason)
+{
+    // "irc.hub.net irc.leaf.net" - anything else is a regular quit
+    const QStringList servers = reason.split(QLatin1Char(' '));
+    if (servers.count() != 2 || servers.at(0) == servers.at(1))
+        return false;
+    foreach (const QString& server, servers) {
+        if (!server.contains(QLatin1Char('.')) || server.startsWith(QLatin1Char('.')) || server.endsWith(QLatin1Char('.')))
+            return false;
+        foreach (const QChar& c, server) {
+            if (!c.isLetterOrNumber() && c != QLatin1Char('.') && c != QLatin1Char('-') && c != QLatin1Char('*') && c != QLatin1Char('_'))
+                return false;
+        }
+    }
+    return true;
 }
 
 bool IrcBufferModelPrivate::messageFilter(IrcMessage* msg)
 {
     Q_Q(IrcBufferModel);
+    if (!pendingSplit.isEmpty()) {
+        if (msg->type() != IrcMessage::Quit || static_cast<IrcQuitMessage*>(msg)->reason() != splitServers)
+            _irc_flushSplit();
+    }
+
     if (msg->type() == IrcMessage::Join && msg->isOwn())
         createBuffer(static_cast<IrcJoinMessage*>(msg)->channel());
 
     bool processed = false;
     switch (msg->type()) {
+        case IrcMessage::Quit:
+            if (deferSplit(static_cast<IrcQuitMessage*>(msg)))
+                return false;
+            Q_FALLTHROUGH();
         case IrcMessage::Away:
         case IrcMessage::Nick:
-        case IrcMessage::Quit:
             foreach (IrcBuffer* buffer, bufferList) {
                 if (buffer->isActive())
                     IrcBufferPrivate::get(buffer)->processMessage(msg);
@@ -167,7 +259,8 @@ bool IrcBufferModelPrivate::messageFilter(IrcMessage* msg)
         case IrcMessage::Kick:
         case IrcMessage::Names:
         case IrcMessage::Topic:
-            processed = processMessage(msg->property("channel").toString(), msg);
+        case IrcMessage::Mode:
+            processed = routeMessage(msg);
             break;
 
         case IrcMessage::WhoReply:
@@ -184,25 +277,25 @@ bool IrcBufferModelPrivate::messageFilter(IrcMessage* msg)
                 processed = !no->isReply() && processMessage(no->isPrivate() ? no->nick() : no->target(), no, no->host() != QLatin1String("services."));
             break;
 
-        case IrcMessage::Mode:
-            processed = processMessage(static_cast<IrcModeMessage*>(msg)->target(), msg);
-            break;
-
-        case IrcMessage::Numeric:
+        case IrcMessage::Numeric: {
             // TODO: any other special cases besides RPL_NAMREPLY?
-            if (static_cast<IrcNumericMessage*>(msg)->code() == Irc::RPL_NAMREPLY) {
-                const int count = msg->parameters().count();
-                const QString channel = msg->parameters().value(count - 2);
-                processed = processMessage(channel, msg);
-            } else if (static_cast<IrcNumericMessage*>(msg)->code() == Irc::RPL_MONONLINE ||
-                       static_cast<IrcNumericMessage*>(msg)->code() == Irc::RPL_MONOFFLINE) {
+            const int code = static_cast<IrcNumericMessage*>(msg)->code();
+            if (code == Irc::ERR_MONLISTFULL) {
+                monitor.reject(msg->parameter(2).split(QLatin1Char(','), Qt::SkipEmptyParts), msg->parameter(1).toInt());
+            } else if (code == Irc::RPL_MONONLINE || code == Irc::RPL_MONOFFLINE) {
                 msg->setFlag(IrcMessage::Implicit);
-                foreach (const QString& target, msg->parameters().value(1).split(QLatin1String(",")))
+                foreach (const QString& target, msg->parameter(1).split(QLatin1String(",")))
                     processed |= processMessage(Irc::nickFromPrefix(target), msg);
             } else {
-                processed = processMessage(msg->parameters().value(1), msg);
+                // the channel of RPL_NAMREPLY, or the second parameter
+                processed = routeMessage(msg);
             }
             break;
+        }
+
+        case IrcMessage::Batch:
+            processBatch(static_cast<IrcBatchMessage*>(msg));
+            return false;
 
         default:
             break;
@@ -225,15 +318,139 @@ bool IrcBufferModelPrivate::messageFilter(IrcMessage* msg)
 
 bool IrcBufferModelPrivate::commandFilter(IrcCommand* cmd)
 {
-    if (cmd->type() == IrcCommand::Join) {
-        const QString channel = cmd->parameters().value(0).toLower();
-        const QString key = cmd->parameters().value(1);
+    processCommand(cmd->type(), cmd->parameters());
+    return false;
+}
+
+bool IrcBufferModelPrivate::commandValueFilter(IrcCommandValue* cmd)
+{
+    processCommand(cmd->type(), cmd->parameters());
+    return false;
+}
+
+void IrcBufferModelPrivate::processCommand(IrcCommand::Type type, const QStringList& parameters)
+{
+    if (type == IrcCommand::Join) {
+        const QString channel = parameters.value(0).toLower();
+        const QString key = parameters.value(1);
         if (!key.isEmpty())
             keys.insert(channel, key);
         else
             keys.remove(channel);
+    } else if (type == IrcCommand::Monitor && !parameters.value(0).compare(QLatin1String("C"), Qt::CaseInsensitive)) {
+        // the list was cleared behind our back
+        monitor.reset();
+        if (monitorEnabled)
+            scheduleMonitor();
     }
-    return false;
+}
+
+void IrcBufferModelPrivate::processBatch(IrcBatchMessage* batch)
+{
+    Q_Q(IrcBufferModel);
+    const QString type = batch->batch().toLower();
+    const QString servers = batch->parameters().mid(2).join(QLatin1String(" "));
+
+    QList<IrcQuitMessage*> quits;
+    QList<IrcJoinMessage*> joins;
+    foreach (IrcMessage* msg, batch->messages()) {
+        const bool bulk = !msg->isOwn() && !msg->testFlag(IrcMessage::Playback);
+        if (bulk && type == QLatin1String("netsplit") && msg->type() == IrcMessage::Quit)
+            quits += static_cast<IrcQuitMessage*>(msg);
+        else if (bulk && type == QLatin1String("netjoin") && msg->type() == IrcMessage::Join)
+            joins += static_cast<IrcJoinMessage*>(msg);
+        else if (type == QLatin1String("netsplit") || type == QLatin1String("netjoin"))
+            messageFilter(msg);
+    }
+
+    if (!quits.isEmpty())
+        processSplit(servers, quits);
+    if (!joins.isEmpty())
+        processJoin(servers, joins);
+    if (quits.isEmpty() && joins.isEmpty())
+        emit q->messageIgnored(batch);
+}
+
+bool IrcBufferModelPrivate::deferSplit(IrcQuitMessage* quit)
+{
+    if (!splitDetectionEnabled || quit->isOwn() || quit->testFlag(IrcMessage::Playback))
+        return false;
+    if (quit->parent() && quit->parent() != connection)
+        return false;
+    if (!looksLikeSplit(quit->reason()))
+        return false;
+
+    // keep the message alive until the split is flushed
+    quit->setParent(this);
+    if (pendingSplit.isEmpty()) {
+        Q_Q(IrcBufferModel);
+        splitServers = quit->reason();
+        QTimer::singleShot(0, q, SLOT(_irc_flushSplit()));
+    }
+    pendingSplit += quit;
+    return true;
+}
+
+void IrcBufferModelPrivate::processSplit(const QString& servers, const QList<IrcQuitMessage*>& quits)
+{
+    Q_Q(IrcBufferModel);
+    QStringList nicks;
+    QHash<QString, IrcQuitMessage*> queries;
+    foreach (IrcQuitMessage* quit, quits) {
+        nicks += quit->nick();
+        queries.insert(quit->nick().toLower(), quit);
+    }
+
+    foreach (IrcBuffer* buffer, bufferList) {
+        if (!buffer->isActive())
+            continue;
+        if (IrcChannel* channel = buffer->toChannel()) {
+            QSet<QString> removed;
+            foreach (const QString& nick, IrcChannelPrivate::get(channel)->removeUsers(nicks))
+                removed.insert(nick);
+            foreach (IrcQuitMessage* quit, quits) {
+                if (removed.contains(quit->nick()))
+                    emit buffer->messageReceived(quit);
+            }
+        } else if (IrcQuitMessage* quit = queries.value(buffer->title().toLower())) {
+            emit buffer->messageReceived(quit);
+        }
+    }
+    emit q->netsplit(servers, nicks);
+}
+
+void IrcBufferModelPrivate::processJoin(const QString& servers, const QList<IrcJoinMessage*>& joins)
+{
+    Q_Q(IrcBufferModel);
+    QStringList nicks;
+    QStringList channels;
+    QMultiHash<QString, IrcJoinMessage*> channelJoins;
+    foreach (IrcJoinMessage* join, joins) {
+        if (!nicks.contains(join->nick()))
+            nicks += join->nick();
+        const QString channel = join->channel().toLower();
+        if (!channelJoins.contains(channel))
+            channels += channel;
+        channelJoins.insert(channel, join);
+    }
+
+    foreach (const QString& title, channels) {
+        IrcChannel* channel = bufferMap.value(title) ? bufferMap.value(title)->toChannel() : nullptr;
+        QList<IrcJoinMessage*> messages = channelJoins.values(title);
+        std::reverse(messages.begin(), messages.end());
+        if (!channel) {
+            foreach (IrcJoinMessage* join, messages)
+                emit q->messageIgnored(join);
+            continue;
+        }
+        QStringList names;
+        foreach (IrcJoinMessage* join, messages)
+            names += join->nick();
+        IrcChannelPrivate::get(channel)->addUsers(names);
+        foreach (IrcJoinMessage* join, messages)
+            emit channel->messageReceived(join);
+    }
+    emit q->netjoin(servers, nicks);
 }
 
 IrcBuffer* IrcBufferModelPrivate::createBufferHelper(const QString& title)
@@ -342,25 +559,23 @@ void IrcBufferModelPrivate::insertBuffer(int index, IrcBuffer* buffer, bool noti
             IrcChannel* channel = buffer->toChannel();
             if (keys.contains(lower) && channel->key().isEmpty())
                 IrcChannelPrivate::get(channel)->setKey(keys.take(lower));
+            IrcChannelPrivate::get(channel)->changed();
         }
         q->connect(buffer, SIGNAL(destroyed(IrcBuffer*)), SLOT(_irc_bufferDestroyed(IrcBuffer*)));
         q->endInsertRows();
         if (notify) {
             emit q->added(buffer);
-            if (isChannel)
+            if (isChannel) {
+                emit q->channelsAdded(QStringList(title));
                 emit q->channelsChanged(channels);
+            }
             emit q->buffersChanged(bufferList);
             emit q->countChanged(bufferList.count());
             if (bufferList.count() == 1)
                 emit q->emptyChanged(false);
         }
-        if (monitorEnabled && IrcBufferPrivate::get(buffer)->isMonitorable()) {
-            connection->sendCommand(IrcCommand::createMonitor("+", buffer->title()));
-            if (!monitorPending) {
-                monitorPending = true;
-                QTimer::singleShot(1000, q, SLOT(_irc_monitorStatus()));
-            }
-        }
+        if (monitorEnabled && IrcBufferPrivate::get(buffer)->isMonitorable())
+            scheduleMonitor();
     }
 }
 
@@ -378,20 +593,24 @@ void IrcBufferModelPrivate::removeBuffer(IrcBuffer* buffer, bool notify)
         bufferList.removeAt(idx);
         bufferMap.remove(lower);
         bufferStates.remove(lower);
-        if (isChannel)
+        if (isChannel) {
             channels.removeOne(title);
+            scheduleSnapshot();
+        }
         q->endRemoveRows();
         if (notify) {
             emit q->removed(buffer);
-            if (isChannel)
+            if (isChannel) {
+                emit q->channelsRemoved(QStringList(title));
                 emit q->channelsChanged(channels);
+            }
             emit q->buffersChanged(bufferList);
             emit q->countChanged(bufferList.count());
             if (bufferList.isEmpty())
                 emit q->emptyChanged(true);
         }
-        if (monitorEnabled && IrcBufferPrivate::get(buffer)->isMonitorable())
-            connection->sendCommand(IrcCommand::createMonitor("-", title));
+        if (monitor.contains(title))
+            scheduleMonitor();
     }
 }
 
@@ -405,6 +624,8 @@ bool IrcBufferModelPrivate::renameBuffer(const QString& from, const QString& to)
     if (bufferMap.contains(fromLower)) {
         IrcBuffer* buffer = bufferMap.take(fromLower);
         bufferMap.insert(toLower, buffer);
+        if (monitorEnabled)
+            scheduleMonitor();
 
         const int idx = bufferList.indexOf(buffer);
         QModelIndex index = q->index(idx);
@@ -426,6 +647,9 @@ bool IrcBufferModelPrivate::renameBuffer(const QString& from, const QString& to)
 void IrcBufferModelPrivate::promoteBuffer(IrcBuffer* buffer)
 {
     Q_Q(IrcBufferModel);
+    // an active buffer may outrank a monitored one once the list is full
+    if (monitorEnabled && monitor.limit() > 0 && !monitor.contains(buffer->title()) && IrcBufferPrivate::get(buffer)->isMonitorable())
+        scheduleMonitor();
     if (sortMethod == Irc::SortByActivity) {
         const bool notify = false;
         removeBuffer(buffer, notify);
@@ -448,6 +672,7 @@ void IrcBufferModelPrivate::restoreBuffer(IrcBuffer* buffer)
             const QStringList args = b.value("args").toStringList();
             for (int i = 0; i < modes.count(); ++i)
                 p->modes.insert(modes.at(i), args.value(i));
+            p->modeDirty = true;
             p->enabled = b.value("enabled", true).toBool();
         }
     }
@@ -473,6 +698,14 @@ QVariantMap IrcBufferModelPrivate::saveBuffer(IrcBuffer* buffer) const
     return b;
 }
 
+bool IrcBufferModelPrivate::routeMessage(IrcMessage* message)
+{
+    IrcBuffer* buffer = bufferMap.value(message->route());
+    if (buffer)
+        return IrcBufferPrivate::get(buffer)->processMessage(message);
+    return false;
+}
+
 bool IrcBufferModelPrivate::processMessage(const QString& title, IrcMessage* message, bool create)
 {
     IrcBuffer* buffer = bufferMap.value(title.toLower());
@@ -494,23 +727,19 @@ void IrcBufferModelPrivate::_irc_initialized()
     Q_Q(IrcBufferModel);
     if (joinDelay >= 0)
         QTimer::singleShot(joinDelay * 1000, q, SLOT(_irc_restoreBuffers()));
+    scheduleSnapshot();
 
-    bool monitored = false;
-    foreach (IrcBuffer* buffer, bufferList) {
-        if (monitorEnabled && IrcBufferPrivate::get(buffer)->isMonitorable()) {
-            connection->sendCommand(IrcCommand::createMonitor("+", buffer->title()));
-            monitored = true;
-        }
-    }
-
-    if (monitored && !monitorPending) {
-        monitorPending = true;
-        QTimer::singleShot(1000, q, SLOT(_irc_monitorStatus()));
-    }
+    IrcNetwork* network = connection->network();
+    monitor.setNetwork(network);
+    monitor.setLimit(network->numericLimit(IrcNetwork::MonitorCount));
+    monitor.setTargetLimit(network->targetLimit(QStringLiteral("MONITOR")));
+    _irc_syncMonitor();
 }
 
 void IrcBufferModelPrivate::_irc_disconnected()
 {
+    _irc_flushSplit();
+    monitor.reset();
     foreach (IrcBuffer* buffer, bufferList)
         IrcBufferPrivate::get(buffer)->disconnected();
 }
@@ -635,11 +864,135 @@ void IrcBufferModelPrivate::_irc_restoreBuffers()
     }
 }
 
-void IrcBufferModelPrivate::_irc_monitorStatus()
+void IrcBufferModelPrivate::scheduleMonitor()
+{
+    Q_Q(IrcBufferModel);
+    if (!monitorPending) {
+        monitorPending = true;
+        QTimer::singleShot(0, q, SLOT(_irc_syncMonitor()));
+    }
+}
+
+QStringList IrcBufferModelPrivate::monitorTargets() const
+{
+    QList<IrcBuffer*> buffers;
+    foreach (IrcBuffer* buffer, bufferList) {
+        if (IrcBufferPrivate::get(buffer)->isMonitorable())
+            buffers += buffer;
+    }
+
+    // persistent buffers take precedence, then the most recently active
+    const int limit = monitor.limit();
+    if (limit > 0 && buffers.count() > limit) {
+        std::stable_sort(buffers.begin(), buffers.end(), [](IrcBuffer* one, IrcBuffer* another) {
+            if (one->isPersistent() != another->isPersistent())
+                return one->isPersistent();
+            const QDateTime& a = IrcBufferPrivate::get(one)->activity;
+            const QDateTime& b = IrcBufferPrivate::get(another)->activity;
+            if (a.isValid() != b.isValid())
+                return a.isValid();
+            return a > b;
+        });
+    }
+
+    QStringList targets;
+    foreach (IrcBuffer* buffer, buffers)
+        targets += buffer->title();
+    return targets;
+}
+
+void IrcBufferModelPrivate::_irc_syncMonitor()
 {
-    if (monitorEnabled && connection)
-        connection->sendCommand(IrcCommand::createMonitor("S"));
     monitorPending = false;
+    if (!connection || !connection->isConnected())
+        return;
+
+    QStringList targets;
+    if (monitorEnabled)
+        targets = monitorTargets();
+    foreach (IrcCommand* command, monitor.update(targets))
+        connection->sendCommand(command);
+}
+
+void IrcBufferModelPrivate::scheduleSnapshot()
+{
+    Q_Q(IrcBufferModel);
+    if (snapshotsEnabled && !snapshotPending) {
+        snapshotPending = true;
+        QTimer::singleShot(0, q, SLOT(_irc_publishSnapshot()));
+    }
+}
+
+void IrcBufferModelPrivate::_irc_publishSnapshot()
+{
+    Q_Q(IrcBufferModel);
+    snapshotPending = false;
+    if (!snapshotsEnabled)
+        return;
+
+    // unchanged channels share their previous snapshot
+    QList<IrcChannelSnapshot> channelSnapshots;
+    foreach (IrcBuffer* buffer, bufferList) {
+        if (IrcChannel* channel = buffer->toChannel()) {
+            IrcChannelPrivate* priv = IrcChannelPrivate::get(channel);
+            if (priv->snapshotDirty) {
+                priv->snapshot = IrcSnapshotBuilder::channel(channel, priv->snapshot);
+                priv->snapshotDirty = false;
+            }
+            channelSnapshots += priv->snapshot;
+        }
+    }
+
+    const IrcNetworkSnapshot network = IrcSnapshotBuilder::network(q->network());
+    const IrcSnapshot snapshot = IrcSnapshotBuilder::snapshot(++snapshotRevision, network, channelSnapshots);
+    std::atomic_store(&publishedSnapshot, std::make_shared<const IrcSnapshot>(snapshot));
+    emit q->snapshotPublished(snapshot);
+}
+
+void IrcBufferModelPrivate::setHibernateInterval(int msecs)
+{
+    hibernateInterval = msecs;
+    if (msecs > 0)
+        hibernateTimer.start(msecs);
+    else
+        hibernateTimer.stop();
+}
+
+void IrcBufferModelPrivate::_irc_hibernateBuffers()
+{
+    if (hibernateInterval <= 0)
+        return;
+
+    // wake up when the channel that was seen the longest ago is due,
+    // or after a full interval when no channel can hibernate yet
+    const qint64 now = clock.elapsed();
+    qint64 next = hibernateInterval;
+    foreach (IrcBuffer* buffer, bufferList) {
+        if (IrcChannel* channel = buffer->toChannel()) {
+            IrcChannelPrivate* priv = IrcChannelPrivate::get(channel);
+            if (priv->lazy || !priv->userModels.isEmpty())
+                continue;
+            const qint64 idle = now - priv->lastSeen;
+            if (idle >= hibernateInterval)
+                priv->hibernate();
+            else
+                next = qMin(next, hibernateInterval - idle);
+        }
+    }
+    hibernateTimer.start(static_cast<int>(next));
+}
+
+void IrcBufferModelPrivate::_irc_flushSplit()
+{
+    if (pendingSplit.isEmpty())
+        return;
+
+    const QList<IrcQuitMessage*> quits = pendingSplit;
+    pendingSplit.clear();
+    processSplit(splitServers, quits);
+    splitServers.clear();
+    foreach (IrcQuitMessage* quit, quits)
+        quit->deleteLater();
 }
 #endif // IRC_DOXYGEN
 
@@ -657,6 +1010,8 @@ IrcBufferModel::IrcBufferModel(QObject* parent)
     setBufferPrototype(new IrcBuffer(this));
     setChannelPrototype(new IrcChannel(this));
     setConnection(qobject_cast<IrcConnection*>(parent));
+    d->hibernateTimer.setSingleShot(true);
+    connect(&d->hibernateTimer, SIGNAL(timeout()), this, SLOT(_irc_hibernateBuffers()));
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
     setRoleNames(irc_buffer_model_roles());
@@ -1012,14 +1367,15 @@ void IrcBufferModel::clear()
     Q_D(IrcBufferModel);
     if (!d->bufferList.isEmpty()) {
         bool bufferRemoved = false;
-        bool channelRemoved = false;
+        QStringList removedChannels;
         foreach (IrcBuffer* buffer, d->bufferList) {
             if (!buffer->isPersistent()) {
                 if (!bufferRemoved) {
                     beginResetModel();
                     bufferRemoved = true;
                 }
-                channelRemoved |= buffer->isChannel();
+                if (buffer->isChannel())
+                    removedChannels += buffer->title();
                 buffer->disconnect(this);
                 d->bufferList.removeOne(buffer);
                 d->channels.removeOne(buffer->title());
@@ -1029,8 +1385,10 @@ void IrcBufferModel::clear()
         }
         if (bufferRemoved) {
             endResetModel();
-            if (channelRemoved)
+            if (!removedChannels.isEmpty()) {
+                emit channelsRemoved(removedChannels);
                 emit channelsChanged(d->channels);
+            }
             emit buffersChanged(d->bufferList);
             emit countChanged(d->bufferList.count());
             if (d->bufferList.isEmpty())
@@ -1071,20 +1429,15 @@ void IrcBufferModel::sort(Irc::SortMethod method, Qt::SortOrder order)
 
     emit layoutAboutToBeChanged();
 
-    QList<IrcBuffer*> persistentBuffers;
-    QModelIndexList oldPersistentIndexes = persistentIndexList();
-    foreach (const QModelIndex& index, oldPersistentIndexes)
-        persistentBuffers += static_cast<IrcBuffer*>(index.internalPointer());
+    const QModelIndexList oldPersistentIndexes = persistentIndexList();
 
+    QVector<int> rows;
     if (order == Qt::AscendingOrder)
-        std::sort(d->bufferList.begin(), d->bufferList.end(), IrcBufferLessThan(this, method));
+        rows = irc_sort_rows(d->bufferList, IrcBufferLessThan(this, method));
     else
-        std::sort(d->bufferList.begin(), d->bufferList.end(), IrcBufferGreaterThan(this, method));
+        rows = irc_sort_rows(d->bufferList, IrcBufferGreaterThan(this, method));
 
-    QModelIndexList newPersistentIndexes;
-    foreach (IrcBuffer* buffer, persistentBuffers)
-        newPersistentIndexes += index(d->bufferList.indexOf(buffer));
-    changePersistentIndexList(oldPersistentIndexes, newPersistentIndexes);
+    changePersistentIndexList(oldPersistentIndexes, irc_remap_rows(this, oldPersistentIndexes, rows));
 
     emit layoutChanged();
 }
@@ -1214,9 +1567,7 @@ QVariant IrcBufferModel::data(const QModelIndex& index, int role) const
     IrcBuffer* buffer = static_cast<IrcBuffer*>(index.internalPointer());
     Q_ASSERT(buffer);
 
-    switch (role) {
-    case Qt::DisplayRole:
-        return data(index, d->role);
+    switch (role == Qt::DisplayRole ? d->role : role) {
     case Irc::BufferRole:
         return QVariant::fromValue(buffer);
     case Irc::ChannelRole:
@@ -1337,6 +1688,12 @@ void IrcBufferModel::setJoinDelay(int delay)
 
     This property holds whether automatic monitor is enabled.
 
+    When enabled, the model keeps the server-side MONITOR list in sync
+    with its query buffers. Changes are collected during an event loop
+    pass and sent as minimal \c + and \c - updates, packed into as few
+    lines as possible. If the server limits the size of the list, persistent
+    buffers and the most recently active buffers are monitored first.
+
     The default value is \c false.
 
     \par Access function:
@@ -1359,10 +1716,217 @@ void IrcBufferModel::setMonitorEnabled(bool enabled)
     Q_D(IrcBufferModel);
     if (d->monitorEnabled != enabled) {
         d->monitorEnabled = enabled;
+        d->scheduleMonitor();
         emit monitorEnabledChanged(enabled);
     }
 }
 
+/*!
+    \since 3.7
+    \property bool IrcBufferModel::lazyUsersEnabled
+
+    This property holds whether channel users are created lazily.
+
+    By default, every channel creates an IrcUser object for each of its
+    members as soon as the names list arrives. When lazy users are enabled,
+    channels that have no IrcUserModel attached keep only the nicks, prefixes
+    and away states. The IrcUser objects are created when the first
+    IrcUserModel is attached to the channel.
+
+    If the server has the \c draft/no-implicit-names capability enabled,
+    the names list is requested when the first IrcUserModel is attached.
+
+    \note Lazily created users are initially ordered by name, because the
+    original order of the names list is not stored.
+
+    The default value is \c false.
+
+    \par Access function:
+    \li bool <b>isLazyUsersEnabled</b>() const
+    \li void <b>setLazyUsersEnabled</b>(bool enabled)
+
+    \par Notifier signal:
+    \li void <b>lazyUsersEnabledChanged</b>(bool enabled)
+
+    \sa IrcUserModel::channel
+ */
+bool IrcBufferModel::isLazyUsersEnabled() const
+{
+    Q_D(const IrcBufferModel);
+    return d->lazyUsersEnabled;
+}
+
+void IrcBufferModel::setLazyUsersEnabled(bool enabled)
+{
+    Q_D(IrcBufferModel);
+    if (d->lazyUsersEnabled != enabled) {
+        d->lazyUsersEnabled = enabled;
+        if (!enabled) {
+            foreach (IrcBuffer* buffer, d->bufferList) {
+                if (IrcChannel* channel = buffer->toChannel())
+                    IrcChannelPrivate::get(channel)->materialize();
+            }
+        }
+        emit lazyUsersEnabledChanged(enabled);
+    }
+}
+
+/*!
+    \since 3.7
+    \property int IrcBufferModel::hibernateDelay
+
+    This property holds the delay in seconds after which idle channels hibernate.
+
+    A channel is idle while no IrcUserModel is attached to it and no
+    messages or notices arrive in it. After the delay, its IrcUser objects
+    are released and replaced by the same compact snapshot that
+    \ref lazyUsersEnabled "lazy users" use. Joins, parts, nick and mode
+    changes keep updating the snapshot while the channel hibernates.
+    Attaching an IrcUserModel restores the users from the snapshot,
+    without asking the server for a new names list.
+
+    Topics, modes, keys and \ref IrcBuffer::userData "user data" are kept.
+
+    \note The IrcUser objects of a channel are deleted when it hibernates,
+    and new ones are created when it wakes up. Pointers to them, such as
+    those returned by IrcUserModel::get() or IrcUserModel::find(), must not
+    be kept beyond the lifetime of the IrcUserModel they were obtained from.
+    Use QPointer to hold on to a user in a channel that may hibernate.
+
+    The default value is \c 0 which means that channels never hibernate.
+
+    \par Access function:
+    \li int <b>hibernateDelay</b>() const
+    \li void <b>setHibernateDelay</b>(int delay)
+
+    \par Notifier signal:
+    \li void <b>hibernateDelayChanged</b>(int delay)
+
+    \sa lazyUsersEnabled
+ */
+int IrcBufferModel::hibernateDelay() const
+{
+    Q_D(const IrcBufferModel);
+    return d->hibernateDelay;
+}
+
+void IrcBufferModel::setHibernateDelay(int delay)
+{
+    Q_D(IrcBufferModel);
+    if (d->hibernateDelay != delay) {
+        d->hibernateDelay = delay;
+        d->setHibernateInterval(qMax(0, delay) * 1000);
+        emit hibernateDelayChanged(delay);
+    }
+}
+
+/*!
+    \since 3.7
+    \property bool IrcBufferModel::snapshotsEnabled
+
+    This property holds whether the model publishes snapshots.
+
+    When enabled, the model publishes an immutable IrcSnapshot of the
+    network information and the channels, including their users and
+    modes. A new snapshot is published once per event loop pass after
+    any channel has changed, so a burst of messages produces a single
+    snapshot. Only the changed channels are copied again, and their
+    unchanged users share the data of the previous snapshot.
+
+    The default value is \c false.
+
+    \par Access function:
+    \li bool <b>isSnapshotsEnabled</b>() const
+    \li void <b>setSnapshotsEnabled</b>(bool enabled)
+
+    \par Notifier signal:
+    \li void <b>snapshotsEnabledChanged</b>(bool enabled)
+
+    \sa snapshot(), snapshotPublished()
+ */
+bool IrcBufferModel::isSnapshotsEnabled() const
+{
+    Q_D(const IrcBufferModel);
+    return d->snapshotsEnabled;
+}
+
+void IrcBufferModel::setSnapshotsEnabled(bool enabled)
+{
+    Q_D(IrcBufferModel);
+    if (d->snapshotsEnabled != enabled) {
+        d->snapshotsEnabled = enabled;
+        if (enabled) {
+            foreach (IrcBuffer* buffer, d->bufferList) {
+                if (IrcChannel* channel = buffer->toChannel())
+                    IrcChannelPrivate::get(channel)->snapshotDirty = true;
+            }
+            d->scheduleSnapshot();
+        }
+        emit snapshotsEnabledChanged(enabled);
+    }
+}
+
+/*!
+    \since 3.7
+
+    Returns the latest published snapshot, or an invalid snapshot if none
+    has been published yet.
+
+    \note Unlike the rest of the model, this function is thread-safe. It
+    may be called from any thread while the model keeps publishing new
+    snapshots. The latest snapshot is swapped atomically once it has been
+    built, so readers never wait for the model.
+
+    \sa snapshotsEnabled, snapshotPublished()
+ */
+IrcSnapshot IrcBufferModel::snapshot() const
+{
+    Q_D(const IrcBufferModel);
+    const std::shared_ptr<const IrcSnapshot> snapshot = std::atomic_load(&d->publishedSnapshot);
+    return snapshot ? *snapshot : IrcSnapshot();
+}
+
+/*!
+    \since 3.7
+    \property bool IrcBufferModel::splitDetectionEnabled
+
+    This property holds whether netsplits are detected from plain quit messages.
+
+    When enabled, consecutive quit messages whose reason looks like a pair
+    of server names (for example \c "irc.hub.net irc.leaf.net") are held
+    back until the next different message arrives, and then applied to the
+    channels in one go. See netsplit().
+
+    IRCv3 \c netsplit batches are aggregated regardless of this property.
+
+    The default value is \c false.
+
+    \par Access function:
+    \li bool <b>isSplitDetectionEnabled</b>() const
+    \li void <b>setSplitDetectionEnabled</b>(bool enabled)
+
+    \par Notifier signal:
+    \li void <b>splitDetectionEnabledChanged</b>(bool enabled)
+
+    \sa netsplit()
+ */
+bool IrcBufferModel::isSplitDetectionEnabled() const
+{
+    Q_D(const IrcBufferModel);
+    return d->splitDetectionEnabled;
+}
+
+void IrcBufferModel::setSplitDetectionEnabled(bool enabled)
+{
+    Q_D(IrcBufferModel);
+    if (d->splitDetectionEnabled != enabled) {
+        d->splitDetectionEnabled = enabled;
+        if (!enabled)
+            d->_irc_flushSplit();
+        emit splitDetectionEnabledChanged(enabled);
+    }
+}
+
 /*!
     \since 3.1
 
@@ -37,6 +37,7 @@
 #include "irccommand.h"
 #include "ircuser_p.h"
 #include "irc.h"
+#include <qset.h>
 
 IRC_BEGIN_NAMESPACE
 
@@ -86,6 +87,43 @@ static QString userName(const QString& name, const QStringList& prefixes)
     return Irc::nickFromPrefix(copy);
 }
 
+static void applyUserMode(const IrcNetwork* network, const QString& command, QString& mode, QString& prefix)
+{
+    bool add = true;
+    for (int i = 0; i < command.size(); ++i) {
+        QChar c = command.at(i);
+        if (c == QLatin1Char('+')) {
+            add = true;
+        } else if (c == QLatin1Char('-')) {
+            add = false;
+        } else {
+            QString p = network->modeToPrefix(c);
+            if (add) {
+                if (!mode.contains(c))
+                    mode += c;
+                if (!prefix.contains(p))
+                    prefix += p;
+            } else {
+                mode.remove(c);
+                prefix.remove(p);
+            }
+        }
+    }
+
+    QString sortedMode;
+    foreach (const QString& m, network->modes())
+        if (mode.contains(m))
+            sortedMode += m;
+
+    QString sortedPrefix;
+    foreach (const QString& p, network->prefixes())
+        if (prefix.contains(p))
+            sortedPrefix += p;
+
+    mode = sortedMode;
+    prefix = sortedPrefix;
+}
+
 IrcChannelPrivate::IrcChannelPrivate()
 {
     qRegisterMetaType<IrcChannel*>();
@@ -103,6 +141,8 @@ void IrcChannelPrivate::init(const QString& title, IrcBufferModel* m)
     const QStringList chanTypes = m->network()->channelTypes();
     prefix = getPrefix(title, chanTypes);
     name = channelName(title, chanTypes);
+    titleDirty = true;
+    touch();
 }
 
 void IrcChannelPrivate::connected()
@@ -122,6 +162,7 @@ void IrcChannelPrivate::setActive(bool value)
     if (active != value) {
         active = value;
         emit q->activeChanged(active);
+        changed();
     }
 }
 
@@ -155,7 +196,9 @@ void IrcChannelPrivate::changeModes(const QString& value, const QStringList& arg
     if (modes != ms) {
         setKey(ms.value(QLatin1String("k")));
         modes = ms;
+        modeDirty = true;
         emit q->modeChanged(q->mode());
+        changed();
     }
 }
 
@@ -180,7 +223,9 @@ void IrcChannelPrivate::setModes(const QString& value, const QStringList& argume
     if (modes != ms) {
         setKey(ms.value(QLatin1String("k")));
         modes = ms;
+        modeDirty = true;
         emit q->modeChanged(q->mode());
+        changed();
     }
 }
 
@@ -190,6 +235,7 @@ void IrcChannelPrivate::setTopic(const QString& value)
     if (topic != value) {
         topic = value;
         emit q->topicChanged(topic);
+        changed();
     }
 }
 
@@ -198,25 +244,46 @@ void IrcChannelPrivate::setKey(const QString& value)
     Q_Q(IrcChannel);
     if (modes.value(QLatin1String("k")) != value) {
         modes.insert(QLatin1String("k"), value);
+        modeDirty = true;
         emit q->keyChanged(value);
+        changed();
     }
 }
 
-void IrcChannelPrivate::addUser(const QString& name)
+IrcUser* IrcChannelPrivate::createUser(const QString& name, const QStringList& prefixes)
 {
     Q_Q(IrcChannel);
-    const QStringList prefixes = q->network()->prefixes();
-
     IrcUser* user = new IrcUser(q);
     IrcUserPrivate* priv = IrcUserPrivate::get(user);
     priv->channel = q;
     priv->setName(userName(name, prefixes));
     priv->setPrefix(getPrefix(name, prefixes));
     priv->setMode(getMode(q->network(), user->prefix()));
+    return user;
+}
+
+void IrcChannelPrivate::addUser(const QString& name)
+{
+    Q_Q(IrcChannel);
+    changed();
+    if (lazy) {
+        const QStringList prefixes = q->network()->prefixes();
+        const QString nick = userName(name, prefixes);
+        if (!lazyUsers.contains(nick)) {
+            IrcLazyUser user;
+            user.prefix = getPrefix(name, prefixes);
+            lazyUsers.insert(nick, user);
+            lazyActive.prepend(nick);
+            namesDirty = true;
+        }
+        return;
+    }
+
+    IrcUser* user = createUser(name, q->network()->prefixes());
     activeUsers.prepend(user);
     userList.append(user);
     userMap.insert(user->name(), user);
-    names = userMap.keys();
+    namesDirty = true;
 
     foreach (IrcUserModel* model, userModels)
         IrcUserModelPrivate::get(model)->addUser(user);
@@ -224,57 +291,188 @@ void IrcChannelPrivate::addUser(const QString& name)
 
 bool IrcChannelPrivate::removeUser(const QString& name)
 {
+    if (lazy) {
+        if (!lazyUsers.remove(name))
+            return false;
+        lazyActive.removeOne(name);
+        changed();
+        namesDirty = true;
+        return true;
+    }
+
     if (IrcUser* user = userMap.value(name)) {
         userMap.remove(name);
-        names = userMap.keys();
+        namesDirty = true;
         userList.removeOne(user);
         activeUsers.removeOne(user);
         foreach (IrcUserModel* model, userModels)
             IrcUserModelPrivate::get(model)->removeUser(user);
         user->deleteLater();
+        changed();
         return true;
     }
     return false;
 }
 
+void IrcChannelPrivate::addUsers(const QStringList& users)
+{
+    Q_Q(IrcChannel);
+    changed();
+    const QStringList prefixes = q->network()->prefixes();
+
+    if (lazy) {
+        foreach (const QString& name, users) {
+            const QString nick = userName(name, prefixes);
+            if (lazyUsers.contains(nick))
+                continue;
+            IrcLazyUser user;
+            user.prefix = getPrefix(name, prefixes);
+            lazyUsers.insert(nick, user);
+            lazyActive.prepend(nick);
+        }
+        namesDirty = true;
+        return;
+    }
+
+    QList<IrcUser*> added;
+    foreach (const QString& name, users) {
+        if (userMap.contains(userName(name, prefixes)))
+            continue;
+        IrcUser* user = createUser(name, prefixes);
+        activeUsers.prepend(user);
+        userList.append(user);
+        userMap.insert(user->name(), user);
+        added += user;
+    }
+
+    if (!added.isEmpty()) {
+        namesDirty = true;
+        foreach (IrcUserModel* model, userModels)
+            IrcUserModelPrivate::get(model)->addUsers(added);
+    }
+}
+
+QStringList IrcChannelPrivate::removeUsers(const QStringList& users)
+{
+    QStringList removed;
+    if (lazy) {
+        QSet<QString> gone;
+        foreach (const QString& name, users) {
+            if (lazyUsers.remove(name)) {
+                removed += name;
+                gone.insert(name);
+            }
+        }
+        if (!removed.isEmpty()) {
+            namesDirty = true;
+            changed();
+            QStringList remaining;
+            foreach (const QString& name, lazyActive) {
+                if (!gone.contains(name))
+                    remaining += name;
+            }
+            lazyActive = remaining;
+        }
+        return removed;
+    }
+
+    QSet<IrcUser*> gone;
+    foreach (const QString& name, users) {
+        if (IrcUser* user = userMap.take(name)) {
+            removed += name;
+            gone.insert(user);
+        }
+    }
+
+    // filter the lists in one pass instead of removing one user at a time
+    if (!gone.isEmpty()) {
+        namesDirty = true;
+        changed();
+        QList<IrcUser*> list;
+        QList<IrcUser*> remaining;
+        foreach (IrcUser* user, userList) {
+            if (gone.contains(user))
+                list += user;
+            else
+                remaining += user;
+        }
+        userList = remaining;
+        remaining.clear();
+        foreach (IrcUser* user, activeUsers) {
+            if (!gone.contains(user))
+                remaining += user;
+        }
+        activeUsers = remaining;
+        foreach (IrcUserModel* model, userModels)
+            IrcUserModelPrivate::get(model)->removeUsers(list);
+        foreach (IrcUser* user, list)
+            user->deleteLater();
+    }
+    return removed;
+}
+
 void IrcChannelPrivate::setUsers(const QStringList& users)
 {
     Q_Q(IrcChannel);
+    changed();
     const QStringList prefixes = q->network()->prefixes();
+    const QStringList previous = userModels.isEmpty() ? QStringList() : nameList();
 
     qDeleteAll(userList);
     userMap.clear();
     userList.clear();
     activeUsers.clear();
+    lazyUsers.clear();
+    lazyActive.clear();
+    namesReceived = true;
+
+    lazy = lazy || isLazy();
+    if (lazy) {
+        foreach (const QString& name, users) {
+            const QString nick = userName(name, prefixes);
+            IrcLazyUser user;
+            user.prefix = getPrefix(name, prefixes);
+            lazyUsers.insert(nick, user);
+            lazyActive.append(nick);
+        }
+        namesDirty = true;
+        return;
+    }
 
     foreach (const QString& name, users) {
-        IrcUser* user = new IrcUser(q);
-        IrcUserPrivate* priv = IrcUserPrivate::get(user);
-        priv->channel = q;
-        priv->setName(userName(name, prefixes));
-        priv->setPrefix(getPrefix(name, prefixes));
-        priv->setMode(getMode(q->network(), user->prefix()));
+        IrcUser* user = createUser(name, prefixes);
         activeUsers.append(user);
         userList.append(user);
         userMap.insert(user->name(), user);
     }
-    names = userMap.keys();
+    namesDirty = true;
 
     foreach (IrcUserModel* model, userModels)
-        IrcUserModelPrivate::get(model)->setUsers(userList);
+        IrcUserModelPrivate::get(model)->setUsers(userList, previous);
 }
 
 bool IrcChannelPrivate::renameUser(const QString& from, const QString& to)
 {
+    if (lazy) {
+        if (!lazyUsers.contains(from))
+            return false;
+        lazyUsers.insert(to, lazyUsers.take(from));
+        const int idx = lazyActive.indexOf(from);
+        if (idx != -1)
+            lazyActive[idx] = to;
+        namesDirty = true;
+        changed();
+        return true;
+    }
+
     if (IrcUser* user = userMap.take(from)) {
         IrcUserPrivate::get(user)->setName(to);
         userMap.insert(to, user);
-        names = userMap.keys();
+        namesDirty = true;
 
-        foreach (IrcUserModel* model, userModels) {
-            IrcUserModelPrivate::get(model)->renameUser(user);
-            emit model->namesChanged(names);
-        }
+        foreach (IrcUserModel* model, userModels)
+            IrcUserModelPrivate::get(model)->renameUser(user, from);
+        changed();
         return true;
     }
     return false;
@@ -282,44 +480,24 @@ bool IrcChannelPrivate::renameUser(const QString& from, const QString& to)
 
 void IrcChannelPrivate::setUserMode(const QString& name, const QString& command)
 {
+    changed();
+    if (lazy) {
+        QMap<QString, IrcLazyUser>::iterator it = lazyUsers.find(name);
+        if (it != lazyUsers.end()) {
+            QString mode = getMode(model->network(), it->prefix);
+            applyUserMode(model->network(), command, mode, it->prefix);
+        }
+        return;
+    }
+
     if (IrcUser* user = userMap.value(name)) {
-        bool add = true;
         QString mode = user->mode();
         QString prefix = user->prefix();
-        const IrcNetwork* network = model->network();
-        for (int i = 0; i < command.size(); ++i) {
-            QChar c = command.at(i);
-            if (c == QLatin1Char('+')) {
-                add = true;
-            } else if (c == QLatin1Char('-')) {
-                add = false;
-            } else {
-                QString p = network->modeToPrefix(c);
-                if (add) {
-                    if (!mode.contains(c))
-                        mode += c;
-                    if (!prefix.contains(p))
-                        prefix += p;
-                } else {
-                    mode.remove(c);
-                    prefix.remove(p);
-                }
-            }
-        }
-
-        QString sortedMode;
-        foreach (const QString& m, network->modes())
-            if (mode.contains(m))
-                sortedMode += m;
-
-        QString sortedPrefix;
-        foreach (const QString& p, network->prefixes())
-            if (prefix.contains(p))
-                sortedPrefix += p;
+        applyUserMode(model->network(), command, mode, prefix);
 
         IrcUserPrivate* priv = IrcUserPrivate::get(user);
-        priv->setPrefix(sortedPrefix);
-        priv->setMode(sortedMode);
+        priv->setPrefix(prefix);
+        priv->setMode(mode);
 
         foreach (IrcUserModel* model, userModels)
             IrcUserModelPrivate::get(model)->setUserMode(user);
@@ -328,6 +506,13 @@ void IrcChannelPrivate::setUserMode(const QString& name, const QString& command)
 
 void IrcChannelPrivate::promoteUser(const QString& name)
 {
+    if (lazy) {
+        const int idx = lazyActive.indexOf(name);
+        if (idx > 0)
+            lazyActive.move(idx, 0);
+        return;
+    }
+
     if (IrcUser* user = userMap.value(name)) {
         const int idx = activeUsers.indexOf(user);
         Q_ASSERT(idx != -1);
@@ -339,11 +524,21 @@ void IrcChannelPrivate::promoteUser(const QString& name)
 
 bool IrcChannelPrivate::setUserAway(const QString& name, bool away)
 {
+    if (lazy) {
+        QMap<QString, IrcLazyUser>::iterator it = lazyUsers.find(name);
+        if (it == lazyUsers.end())
+            return false;
+        it->away = away;
+        changed();
+        return true;
+    }
+
     if (IrcUser* user = userMap.value(name)) {
         IrcUserPrivate* priv = IrcUserPrivate::get(user);
         priv->setAway(away);
         foreach (IrcUserModel* model, userModels)
             IrcUserModelPrivate::get(model)->updateUser(user);
+        changed();
         return true;
     }
     return false;
@@ -351,14 +546,107 @@ bool IrcChannelPrivate::setUserAway(const QString& name, bool away)
 
 void IrcChannelPrivate::setUserServOp(const QString& name, bool servOp)
 {
+    if (lazy) {
+        QMap<QString, IrcLazyUser>::iterator it = lazyUsers.find(name);
+        if (it != lazyUsers.end()) {
+            it->servOp = servOp;
+            changed();
+        }
+        return;
+    }
+
     if (IrcUser* user = userMap.value(name)) {
         IrcUserPrivate* priv = IrcUserPrivate::get(user);
         priv->setServOp(servOp);
         foreach (IrcUserModel* model, userModels)
             IrcUserModelPrivate::get(model)->updateUser(user);
+        changed();
     }
 }
 
+bool IrcChannelPrivate::isLazy() const
+{
+    return model && model->isLazyUsersEnabled() && userModels.isEmpty();
+}
+
+QStringList IrcChannelPrivate::nameList() const
+{
+    // rebuilt on demand instead of on every join, part and nick change
+    if (namesDirty) {
+        names = lazy ? lazyUsers.keys() : userMap.keys();
+        namesDirty = false;
+    }
+    return names;
+}
+
+bool IrcChannelPrivate::hasUser(const QString& name) const
+{
+    return lazy ? lazyUsers.contains(name) : userMap.contains(name);
+}
+
+void IrcChannelPrivate::materialize()
+{
+    Q_Q(IrcChannel);
+    if (!lazy)
+        return;
+
+    lazy = false;
+    foreach (const QString& name, lazyActive) {
+        const IrcLazyUser lazyUser = lazyUsers.value(name);
+        IrcUser* user = new IrcUser(q);
+        IrcUserPrivate* priv = IrcUserPrivate::get(user);
+        priv->channel = q;
+        priv->setName(name);
+        priv->setPrefix(lazyUser.prefix);
+        priv->setMode(getMode(q->network(), lazyUser.prefix));
+        priv->setAway(lazyUser.away);
+        priv->setServOp(lazyUser.servOp);
+        activeUsers.append(user);
+        userMap.insert(name, user);
+    }
+    userList = userMap.values();
+    lazyUsers.clear();
+    lazyActive.clear();
+
+    // with no-implicit-names, the list is fetched when somebody looks at it
+    if (!namesReceived && active && q->network()->isCapable(QLatin1String("draft/no-implicit-names")))
+        q->sendCommand(IrcCommand::createNames(q->title()));
+}
+
+bool IrcChannelPrivate::hibernate()
+{
+    if (lazy || !userModels.isEmpty())
+        return false;
+
+    foreach (IrcUser* user, activeUsers) {
+        IrcLazyUser lazyUser;
+        lazyUser.prefix = user->prefix();
+        lazyUser.away = user->isAway();
+        lazyUser.servOp = user->isServOp();
+        lazyUsers.insert(user->name(), lazyUser);
+        lazyActive.append(user->name());
+        user->deleteLater();
+    }
+    userList.clear();
+    activeUsers.clear();
+    userMap.clear();
+    lazy = true;
+    return true;
+}
+
+void IrcChannelPrivate::changed()
+{
+    snapshotDirty = true;
+    if (model)
+        IrcBufferModelPrivate::get(model)->scheduleSnapshot();
+}
+
+void IrcChannelPrivate::touch()
+{
+    if (model)
+        lastSeen = IrcBufferModelPrivate::get(model)->clock.elapsed();
+}
+
 bool IrcChannelPrivate::processAwayMessage(IrcAwayMessage* message)
 {
     setUserAway(message->nick(), message->isAway());
@@ -371,6 +659,11 @@ bool IrcChannelPrivate::processJoinMessage(IrcJoinMessage* message)
         if (message->isOwn()) {
             setActive(true);
             enabled = true;
+            namesReceived = false;
+            // no names list will arrive to make the channel lazy, so
+            // start lazy right away and fetch the list on attach
+            if (!lazy && isLazy() && message->network()->isCapable(QLatin1String("draft/no-implicit-names")))
+                hibernate();
         } else {
             addUser(message->nick());
         }
@@ -388,7 +681,7 @@ bool IrcChannelPrivate::processKickMessage(IrcKickMessage* message)
         }
         return removeUser(message->user());
     }
-    return userMap.contains(message->user());
+    return hasUser(message->user());
 }
 
 bool IrcChannelPrivate::processModeMessage(IrcModeMessage* message)
@@ -424,6 +717,8 @@ bool IrcChannelPrivate::processNickMessage(IrcNickMessage* message)
 
 bool IrcChannelPrivate::processNoticeMessage(IrcNoticeMessage* message)
 {
+    if (!message->testFlag(IrcMessage::Playback))
+        touch();
     promoteUser(message->nick());
     return true;
 }
@@ -449,8 +744,21 @@ bool IrcChannelPrivate::processPartMessage(IrcPartMessage* message)
 
 bool IrcChannelPrivate::processPrivateMessage(IrcPrivateMessage* message)
 {
+    if (!message->testFlag(IrcMessage::Playback))
+        touch();
     const QString content = message->content();
     const bool prefixed = !content.isEmpty() && message->network()->prefixes().contains(content.at(0));
+    if (lazy) {
+        foreach (const QString& name, lazyActive) {
+            const QString str = prefixed ? lazyUsers.value(name).prefix.left(1) + name : name;
+            if (content.startsWith(str)) {
+                promoteUser(name);
+                break;
+            }
+        }
+        promoteUser(message->nick());
+        return true;
+    }
     foreach (IrcUser* user, activeUsers) {
         const QString str = prefixed ? user->title() : user->name();
         if (content.startsWith(str)) {
@@ -471,7 +779,7 @@ bool IrcChannelPrivate::processQuitMessage(IrcQuitMessage* message)
         }
         return removeUser(message->nick()) || IrcBufferPrivate::processQuitMessage(message);
     }
-    return userMap.contains(message->nick()) || IrcBufferPrivate::processQuitMessage(message);
+    return hasUser(message->nick()) || IrcBufferPrivate::processQuitMessage(message);
 }
 
 bool IrcChannelPrivate::processTopicMessage(IrcTopicMessage* message)
@@ -511,6 +819,7 @@ IrcChannel::~IrcChannel()
     d->userList.clear();
     d->userMap.clear();
     d->names.clear();
+    d->namesDirty = false;
     d->userModels.clear();
     emit destroyed(this);
 }
@@ -544,14 +853,18 @@ QString IrcChannel::key() const
 QString IrcChannel::mode() const
 {
     Q_D(const IrcChannel);
-    QString m = QStringList(d->modes.keys()).join(QString());
-    QStringList a = d->modes.values();
-    a.removeAll(QString());
-    if (!a.isEmpty())
-        m += QLatin1String(" ") + a.join(QLatin1String(" "));
-    if (!m.isEmpty())
-        m.prepend(QLatin1String("+"));
-    return m;
+    if (d->modeDirty) {
+        QString m = QStringList(d->modes.keys()).join(QString());
+        QStringList a = d->modes.values();
+        a.removeAll(QString());
+        if (!a.isEmpty())
+            m += QLatin1String(" ") + a.join(QLatin1String(" "));
+        if (!m.isEmpty())
+            m.prepend(QLatin1String("+"));
+        d->modeString = m;
+        d->modeDirty = false;
+    }
+    return d->modeString;
 }
 
 /*!
@@ -0,0 +1,652 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircfiltermodel.h"
+#include "ircfiltermodel_p.h"
+#include "ircbuffermodel.h"
+#include "ircusermodel.h"
+#include "ircchannel.h"
+#include "ircnetwork_p.h"
+#include <algorithm>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircfiltermodel.h
+    \brief \#include &lt;IrcFilterModel&gt;
+ */
+
+/*!
+    \class IrcFilterModel ircfiltermodel.h <IrcFilterModel>
+    \ingroup models
+    \brief Provides a filtered view of a buffer or user model.
+    \since 3.7
+
+    IrcFilterModel presents the rows of a \ref sourceModel "source model",
+    typically an IrcBufferModel or an IrcUserModel, whose
+    \ref filterRole "filter role" matches the \ref filter "filter".
+    The rows keep their source order.
+
+    \code
+    IrcFilterModel* filterModel = new IrcFilterModel(this);
+    filterModel->setSourceModel(userModel);
+    connect(searchEdit, SIGNAL(textChanged(QString)), filterModel, SLOT(setFilter(QString)));
+    listView->setModel(filterModel);
+    \endcode
+
+    Unlike QSortFilterProxyModel, IrcFilterModel does not re-evaluate every
+    row whenever the filter or the source model changes. It keeps the filter
+    role values case-mapped and sorted, so that a prefix filter is a binary
+    search. A filter that extends the previous one only re-checks the rows
+    that matched the previous one, and the source model changes are applied
+    to the affected rows only. The matching is case insensitive, according
+    to the CASEMAPPING of the network of the source model, or the IRC
+    (\c rfc1459) case mapping when the source model has no network.
+
+    \sa IrcBufferModel, IrcUserModel
+ */
+
+#ifndef IRC_DOXYGEN
+QString IrcFilterModelPrivate::casemap(const QString& str) const
+{
+    return IrcNetworkPrivate::casemap(network, str);
+}
+
+void IrcFilterModelPrivate::updateNetwork()
+{
+    Q_Q(IrcFilterModel);
+    IrcNetwork* current = nullptr;
+    if (IrcBufferModel* bufferModel = qobject_cast<IrcBufferModel*>(source)) {
+        current = bufferModel->network();
+    } else if (IrcUserModel* userModel = qobject_cast<IrcUserModel*>(source)) {
+        if (IrcChannel* channel = userModel->channel())
+            current = channel->network();
+    }
+    if (network != current) {
+        if (network)
+            QObject::disconnect(network, SIGNAL(initialized()), q, SLOT(_irc_networkInitialized()));
+        network = current;
+        if (network)
+            QObject::connect(network, SIGNAL(initialized()), q, SLOT(_irc_networkInitialized()));
+    }
+    query = casemap(filter);
+}
+
+QString IrcFilterModelPrivate::key(int sourceRow) const
+{
+    return casemap(source->data(source->index(sourceRow, 0), role).toString());
+}
+
+bool IrcFilterModelPrivate::matches(const QString& key, const QString& query) const
+{
+    if (query.isEmpty())
+        return true;
+    switch (flags & 0x0f) {
+    case Qt::MatchExactly:
+        return key == query;
+    case Qt::MatchContains:
+        return key.contains(query);
+    case Qt::MatchEndsWith:
+        return key.endsWith(query);
+    case Qt::MatchStartsWith:
+    default:
+        return key.startsWith(query);
+    }
+}
+
+int IrcFilterModelPrivate::rowOf(int sourceRow) const
+{
+    return std::lower_bound(rows.constBegin(), rows.constEnd(), sourceRow) - rows.constBegin();
+}
+
+int IrcFilterModelPrivate::lowerBound(const QString& key) const
+{
+    const QStringList& k = keys;
+    return std::lower_bound(sorted.constBegin(), sorted.constEnd(), key, [&k](int row, const QString& value) {
+        return k.at(row) < value;
+    }) - sorted.constBegin();
+}
+
+int IrcFilterModelPrivate::sortedIndexOf(int sourceRow) const
+{
+    for (int i = lowerBound(keys.at(sourceRow)); i < sorted.count(); ++i) {
+        if (sorted.at(i) == sourceRow)
+            return i;
+    }
+    return -1;
+}
+
+void IrcFilterModelPrivate::insertSorted(int sourceRow)
+{
+    sorted.insert(lowerBound(keys.at(sourceRow)), sourceRow);
+}
+
+void IrcFilterModelPrivate::rebuild()
+{
+    updateNetwork();
+    keys.clear();
+    sorted.clear();
+    const int count = source ? source->rowCount() : 0;
+    keys.reserve(count);
+    sorted.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        keys += key(i);
+        sorted += i;
+    }
+    const QStringList& k = keys;
+    std::stable_sort(sorted.begin(), sorted.end(), [&k](int a, int b) {
+        return k.at(a) < k.at(b);
+    });
+}
+
+QVector<int> IrcFilterModelPrivate::lookup(const QString& query) const
+{
+    QVector<int> result;
+    const int match = flags & 0x0f;
+    if (query.isEmpty()) {
+        result.reserve(keys.count());
+        for (int i = 0; i < keys.count(); ++i)
+            result += i;
+    } else if (match == Qt::MatchStartsWith || match == Qt::MatchExactly) {
+        // the matching keys are adjacent in the sorted index
+        for (int i = lowerBound(query); i < sorted.count() && matches(keys.at(sorted.at(i)), query); ++i)
+            result += sorted.at(i);
+        std::sort(result.begin(), result.end());
+    } else {
+        for (int i = 0; i < keys.count(); ++i) {
+            if (matches(keys.at(i), query))
+                result += i;
+        }
+    }
+    return result;
+}
+
+QVector<int> IrcFilterModelPrivate::refine(const QString& query) const
+{
+    QVector<int> result;
+    foreach (int row, rows) {
+        if (matches(keys.at(row), query))
+            result += row;
+    }
+    return result;
+}
+
+void IrcFilterModelPrivate::setRows(const QVector<int>& next)
+{
+    const int previous = rows.count();
+
+    // both are ascending: remove and insert the differing runs
+    int i = 0;
+    int j = 0;
+    while (i < rows.count() || j < next.count()) {
+        if (j >= next.count() || (i < rows.count() && rows.at(i) < next.at(j))) {
+            int end = i;
+            while (end < rows.count() && (j >= next.count() || rows.at(end) < next.at(j)))
+                ++end;
+            removeRows(i, end - i);
+        } else if (i >= rows.count() || next.at(j) < rows.at(i)) {
+            int end = j;
+            while (end < next.count() && (i >= rows.count() || next.at(end) < rows.at(i)))
+                ++end;
+            insertRows(i, next.mid(j, end - j));
+            i += end - j;
+            j = end;
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+
+    notifyCount(previous);
+}
+
+void IrcFilterModelPrivate::insertRows(int row, const QVector<int>& sourceRows)
+{
+    Q_Q(IrcFilterModel);
+    if (sourceRows.isEmpty())
+        return;
+    q->beginInsertRows(QModelIndex(), row, row + sourceRows.count() - 1);
+    rows.insert(row, sourceRows.count(), 0);
+    std::copy(sourceRows.constBegin(), sourceRows.constEnd(), rows.begin() + row);
+    q->endInsertRows();
+}
+
+void IrcFilterModelPrivate::removeRows(int row, int count)
+{
+    Q_Q(IrcFilterModel);
+    if (count <= 0)
+        return;
+    q->beginRemoveRows(QModelIndex(), row, row + count - 1);
+    rows.remove(row, count);
+    q->endRemoveRows();
+}
+
+void IrcFilterModelPrivate::notifyCount(int previous)
+{
+    Q_Q(IrcFilterModel);
+    if (rows.count() != previous)
+        emit q->countChanged(rows.count());
+}
+
+void IrcFilterModelPrivate::_irc_rowsInserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+        return;
+
+    const int previous = rows.count();
+    const int count = last - first + 1;
+    for (int i = 0; i < rows.count(); ++i) {
+        if (rows.at(i) >= first)
+            rows[i] += count;
+    }
+    for (int i = 0; i < sorted.count(); ++i) {
+        if (sorted.at(i) >= first)
+            sorted[i] += count;
+    }
+
+    // the shifted rows in the sorted index refer to keys past the new ones
+    for (int r = first; r <= last; ++r)
+        keys.insert(r, key(r));
+
+    QVector<int> inserted;
+    for (int r = first; r <= last; ++r) {
+        insertSorted(r);
+        if (matches(keys.at(r), query))
+            inserted += r;
+    }
+    insertRows(rowOf(first), inserted);
+
+    notifyCount(previous);
+}
+
+void IrcFilterModelPrivate::_irc_rowsAboutToBeRemoved(const QModelIndex& parent, int first, int last)
+{
+    Q_Q(IrcFilterModel);
+    if (parent.isValid())
+        return;
+
+    // the rest of the rows are shifted once the source rows are gone
+    const int from = rowOf(first);
+    removed = rowOf(last + 1) - from;
+    if (removed > 0) {
+        q->beginRemoveRows(QModelIndex(), from, from + removed - 1);
+        rows.remove(from, removed);
+    }
+}
+
+void IrcFilterModelPrivate::_irc_rowsRemoved(const QModelIndex& parent, int first, int last)
+{
+    Q_Q(IrcFilterModel);
+    if (parent.isValid())
+        return;
+
+    const int count = last - first + 1;
+    for (int i = 0; i < rows.count(); ++i) {
+        if (rows.at(i) > last)
+            rows[i] -= count;
+    }
+    for (int i = sorted.count() - 1; i >= 0; --i) {
+        if (sorted.at(i) > last)
+            sorted[i] -= count;
+        else if (sorted.at(i) >= first)
+            sorted.remove(i);
+    }
+    for (int r = last; r >= first; --r)
+        keys.removeAt(r);
+
+    if (removed > 0) {
+        const int previous = rows.count() + removed;
+        removed = 0;
+        q->endRemoveRows();
+        notifyCount(previous);
+    }
+}
+
+void IrcFilterModelPrivate::_irc_dataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    Q_Q(IrcFilterModel);
+    if (topLeft.parent().isValid())
+        return;
+
+    const int previous = rows.count();
+    for (int r = topLeft.row(); r <= bottomRight.row(); ++r) {
+        const QString k = key(r);
+        if (k != keys.at(r)) {
+            sorted.remove(sortedIndexOf(r));
+            keys[r] = k;
+            insertSorted(r);
+        }
+
+        const int row = rowOf(r);
+        const bool contains = row < rows.count() && rows.at(row) == r;
+        if (matches(k, query)) {
+            if (contains)
+                emit q->dataChanged(q->index(row), q->index(row));
+            else
+                insertRows(row, QVector<int>() << r);
+        } else if (contains) {
+            removeRows(row, 1);
+        }
+    }
+    notifyCount(previous);
+}
+
+void IrcFilterModelPrivate::_irc_layoutAboutToBeChanged()
+{
+    Q_Q(IrcFilterModel);
+    emit q->layoutAboutToBeChanged();
+
+    layoutIndexes = q->persistentIndexList();
+    foreach (const QModelIndex& index, layoutIndexes)
+        layoutSources += QPersistentModelIndex(q->mapToSource(index));
+}
+
+void IrcFilterModelPrivate::_irc_layoutChanged()
+{
+    Q_Q(IrcFilterModel);
+    const int previous = rows.count();
+    rebuild();
+    rows = lookup(query);
+
+    QModelIndexList remapped;
+    remapped.reserve(layoutSources.count());
+    for (int i = 0; i < layoutSources.count(); ++i)
+        remapped += q->mapFromSource(layoutSources.at(i));
+    q->changePersistentIndexList(layoutIndexes, remapped);
+    layoutIndexes.clear();
+    layoutSources.clear();
+
+    emit q->layoutChanged();
+    notifyCount(previous);
+}
+
+void IrcFilterModelPrivate::_irc_modelAboutToBeReset()
+{
+    Q_Q(IrcFilterModel);
+    q->beginResetModel();
+}
+
+void IrcFilterModelPrivate::_irc_modelReset()
+{
+    Q_Q(IrcFilterModel);
+    const int previous = rows.count();
+    rebuild();
+    rows = lookup(query);
+    q->endResetModel();
+    notifyCount(previous);
+}
+
+void IrcFilterModelPrivate::_irc_sourceDestroyed()
+{
+    Q_Q(IrcFilterModel);
+    q->setSourceModel(nullptr);
+}
+
+void IrcFilterModelPrivate::_irc_networkInitialized()
+{
+    // the keys depend on the CASEMAPPING
+    rebuild();
+    setRows(lookup(query));
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    Constructs a new filter model with \a parent.
+ */
+IrcFilterModel::IrcFilterModel(QObject* parent)
+    : QAbstractListModel(parent), d_ptr(new IrcFilterModelPrivate)
+{
+    Q_D(IrcFilterModel);
+    d->q_ptr = this;
+    qRegisterMetaType<IrcFilterModel*>();
+}
+
+/*!
+    Destructs the filter model.
+ */
+IrcFilterModel::~IrcFilterModel()
+{
+}
+
+/*!
+    This property holds the source model.
+
+    \par Access functions:
+    \li QAbstractItemModel* <b>sourceModel</b>() const
+    \li void <b>setSourceModel</b>(QAbstractItemModel* model)
+
+    \par Notifier signal:
+    \li void <b>sourceModelChanged</b>(QAbstractItemModel* model)
+ */
+QAbstractItemModel* IrcFilterModel::sourceModel() const
+{
+    Q_D(const IrcFilterModel);
+    return d->source;
+}
+
+void IrcFilterModel::setSourceModel(QAbstractItemModel* model)
+{
+    Q_D(IrcFilterModel);
+    if (d->source == model)
+        return;
+
+    const int previous = d->rows.count();
+    beginResetModel();
+    if (d->source)
+        disconnect(d->source, nullptr, this, nullptr);
+
+    d->source = model;
+
+    if (model) {
+        connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(_irc_rowsInserted(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(_irc_rowsAboutToBeRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(_irc_rowsRemoved(QModelIndex,int,int)));
+        connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(_irc_dataChanged(QModelIndex,QModelIndex)));
+        connect(model, SIGNAL(layoutAboutToBeChanged()), this, SLOT(_irc_layoutAboutToBeChanged()));
+        connect(model, SIGNAL(layoutChanged()), this, SLOT(_irc_layoutChanged()));
+        connect(model, SIGNAL(modelAboutToBeReset()), this, SLOT(_irc_modelAboutToBeReset()));
+        connect(model, SIGNAL(modelReset()), this, SLOT(_irc_modelReset()));
+        connect(model, SIGNAL(destroyed()), this, SLOT(_irc_sourceDestroyed()));
+    }
+
+    d->rebuild();
+    d->rows = d->lookup(d->query);
+    endResetModel();
+
+    emit sourceModelChanged(model);
+    d->notifyCount(previous);
+}
+
+/*!
+    This property holds the filter.
+
+    An empty filter matches all rows. The filter is matched case
+    insensitively against the \ref filterRole "filter role" of the
+    source rows, as specified by \ref matchFlags "the match flags".
+
+    \par Access functions:
+    \li QString <b>filter</b>() const
+    \li void <b>setFilter</b>(const QString& filter) [slot]
+
+    \par Notifier signal:
+    \li void <b>filterChanged</b>(const QString& filter)
+ */
+QString IrcFilterModel::filter() const
+{
+    Q_D(const IrcFilterModel);
+    return d->filter;
+}
+
+void IrcFilterModel::setFilter(const QString& filter)
+{
+    Q_D(IrcFilterModel);
+    if (d->filter == filter)
+        return;
+
+    const QString query = d->casemap(filter);
+    if (query != d->query) {
+        // a narrower filter only needs to re-check the current rows
+        const bool narrower = !d->query.isEmpty() && d->matches(query, d->query);
+        const QVector<int> next = narrower ? d->refine(query) : d->lookup(query);
+        d->query = query;
+        d->setRows(next);
+    }
+    d->filter = filter;
+    emit filterChanged(filter);
+}
+
+/*!
+    This property holds the role that is matched against the filter.
+
+    The default value is \c Irc::NameRole.
+
+    \par Access functions:
+    \li \ref Irc::DataRole <b>filterRole</b>() const
+    \li void <b>setFilterRole</b>(\ref Irc::DataRole role)
+ */
+Irc::DataRole IrcFilterModel::filterRole() const
+{
+    Q_D(const IrcFilterModel);
+    return d->role;
+}
+
+void IrcFilterModel::setFilterRole(Irc::DataRole role)
+{
+    Q_D(IrcFilterModel);
+    if (d->role != role) {
+        d->role = role;
+        d->rebuild();
+        d->setRows(d->lookup(d->query));
+    }
+}
+
+/*!
+    This property holds how the filter is matched.
+
+    Qt::MatchStartsWith, Qt::MatchContains, Qt::MatchEndsWith and
+    Qt::MatchExactly are supported. The matching is always case
+    insensitive. The default value is Qt::MatchStartsWith, which
+    is answered from the sorted index without visiting every row.
+
+    \par Access functions:
+    \li Qt::MatchFlags <b>matchFlags</b>() const
+    \li void <b>setMatchFlags</b>(Qt::MatchFlags flags)
+ */
+Qt::MatchFlags IrcFilterModel::matchFlags() const
+{
+    Q_D(const IrcFilterModel);
+    return d->flags;
+}
+
+void IrcFilterModel::setMatchFlags(Qt::MatchFlags flags)
+{
+    Q_D(IrcFilterModel);
+    if (d->flags != flags) {
+        d->flags = flags;
+        d->setRows(d->lookup(d->query));
+    }
+}
+
+/*!
+    This property holds the number of rows.
+
+    \par Access function:
+    \li int <b>count</b>() const
+
+    \par Notifier signal:
+    \li void <b>countChanged</b>(int count)
+ */
+int IrcFilterModel::count() const
+{
+    return rowCount();
+}
+
+/*!
+    Returns the source model index that corresponds to \a index.
+ */
+QModelIndex IrcFilterModel::mapToSource(const QModelIndex& index) const
+{
+    Q_D(const IrcFilterModel);
+    if (!d->source || !hasIndex(index.row(), index.column(), index.parent()))
+        return QModelIndex();
+    return d->source->index(d->rows.at(index.row()), index.column());
+}
+
+/*!
+    Returns the index that corresponds to the source model \a index,
+    or an invalid index if the source row does not match the filter.
+ */
+QModelIndex IrcFilterModel::mapFromSource(const QModelIndex& index) const
+{
+    Q_D(const IrcFilterModel);
+    if (!index.isValid() || index.model() != d->source || index.parent().isValid())
+        return QModelIndex();
+    const int row = d->rowOf(index.row());
+    if (row >= d->rows.count() || d->rows.at(row) != index.row())
+        return QModelIndex();
+    return this->index(row, index.column());
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+/*!
+    Returns the role names of the \ref sourceModel "source model".
+ */
+QHash<int, QByteArray> IrcFilterModel::roleNames() const
+{
+    Q_D(const IrcFilterModel);
+    if (d->source)
+        return d->source->roleNames();
+    return QAbstractListModel::roleNames();
+}
+#endif
+
+/*!
+    Returns the number of rows that match the filter.
+ */
+int IrcFilterModel::rowCount(const QModelIndex& parent) const
+{
+    Q_D(const IrcFilterModel);
+    if (parent.isValid())
+        return 0;
+    return d->rows.count();
+}
+
+/*!
+    Returns the data of the source model for specified \a role and \a index.
+ */
+QVariant IrcFilterModel::data(const QModelIndex& index, int role) const
+{
+    Q_D(const IrcFilterModel);
+    if (!d->source || !hasIndex(index.row(), index.column(), index.parent()))
+        return QVariant();
+    return d->source->data(d->source->index(d->rows.at(index.row()), index.column()), role);
+}
+
+IRC_END_NAMESPACE
+
+#include "moc_ircfiltermodel.cpp"
@@ -0,0 +1,799 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircmessagelog.h"
+#include "ircmessagelog_p.h"
+#include "ircbuffermodel.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include "ircbuffer.h"
+#include <QByteArrayMatcher>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDir>
+#include <QUrl>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircmessagelog.h
+    \brief \#include &lt;IrcMessageLog&gt;
+ */
+
+/*!
+    \class IrcMessageLog ircmessagelog.h <IrcMessageLog>
+    \ingroup models
+    \brief Provides an append-only on-disk message log.
+    \since 3.7
+
+    IrcMessageLog stores the messages of each buffer in its own directory
+    under \ref directory "directory". When assigned a \ref model "model",
+    it logs every message that the buffers of the model receive.
+
+    \code
+    IrcMessageLog* log = new IrcMessageLog(this);
+    log->setDirectory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/logs/" + network);
+    log->setModel(bufferModel);
+
+    // the backlog of a channel
+    QList<IrcMessage*> backlog = log->lastMessages("#communi", 100, connection);
+    \endcode
+
+    \section format Format
+
+    Messages are appended to segment files as raw IRC lines prefixed with
+    the message time stamp and flags, one record per line:
+    \code
+    1571404849000 0 @time=2019-10-18T13:20:49.000Z :nick!ident@host PRIVMSG #communi :hello
+    \endcode
+    The logs can therefore be read with any text tool. The time stamps
+    within a buffer never decrease: a message that is older than the
+    previous one, such as a playback message, is logged at the time of
+    the previous one. The original time stamp is still in the \c time tag
+    of the line when the server provides it.
+
+    A segment is closed once it grows over the \ref segmentSize "segment size"
+    and a new one is started. Next to each segment, a sparse index records the
+    time and position of a record every \ref indexInterval "index interval" bytes,
+    so that messages() finds a time range without reading the whole log.
+
+    Segments are memory-mapped for reading, so loading a backlog only touches
+    the pages that contain the requested messages. Writes are buffered and
+    flushed when the event loop returns, or explicitly with flush().
+
+    compact() drops segments that are older than a given time, and merges
+    small segments left behind by restarts.
+
+    \sa IrcBufferModel, IrcBuffer::messageReceived()
+ */
+
+#ifndef IRC_DOXYGEN
+static const qint64 DEFAULT_SEGMENT_SIZE = 32 * 1024 * 1024;
+static const qint64 MAX_SEGMENT_SIZE = 1024 * 1024 * 1024;
+static const int DEFAULT_INDEX_INTERVAL = 64 * 1024;
+static const int MAX_OPEN_WRITERS = 32;
+static const int INDEX_ENTRY_SIZE = 2 * sizeof(qint64);
+
+static QString irc_segment_name(int number)
+{
+    return QString("%1").arg(number, 8, 10, QLatin1Char('0'));
+}
+
+// finds the value of the tag with key in the tag section of an IRC line
+static bool irc_find_tag(const QByteArray& line, const QByteArray& key, QByteArray* value)
+{
+    if (!line.startsWith('@'))
+        return false;
+    const int end = line.indexOf(' ');
+    if (end == -1)
+        return false;
+    foreach (const QByteArray& tag, line.mid(1, end - 1).split(';')) {
+        const int idx = tag.indexOf('=');
+        if ((idx == -1 ? tag : tag.left(idx)) == key) {
+            *value = idx == -1 ? QByteArray() : tag.mid(idx + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// the IRCv3 message tag value escaping
+static QByteArray irc_unescape_tag(const QByteArray& value)
+{
+    QByteArray unescaped;
+    unescaped.reserve(value.size());
+    for (int i = 0; i < value.size(); ++i) {
+        char c = value.at(i);
+        if (c == '\\') {
+            if (++i >= value.size())
+                break;
+            c = value.at(i);
+            switch (c) {
+            case ':': c = ';'; break;
+            case 's': c = ' '; break;
+            case 'r': c = '\r'; break;
+            case 'n': c = '\n'; break;
+            default: break;
+            }
+        }
+        unescaped += c;
+    }
+    return unescaped;
+}
+
+// a segment mapped for reading, falling back to reading it all
+class IrcMessageLogSegment
+{
+public:
+    explicit IrcMessageLogSegment(const QString& base) : file(base + ".log")
+    {
+        if (file.open(QIODevice::ReadOnly)) {
+            size = file.size();
+            if (size > 0) {
+                data = reinterpret_cast<const char*>(file.map(0, size));
+                if (!data) {
+                    buffer = file.readAll();
+                    data = buffer.constData();
+                    size = buffer.size();
+                }
+            }
+        }
+    }
+
+    // finds the line that ends before pos, returning its start
+    qint64 previousLine(qint64 pos, qint64* end) const
+    {
+        *end = (pos > 0 && data[pos - 1] == '\n') ? pos - 1 : pos;
+        qint64 start = *end;
+        while (start > 0 && data[start - 1] != '\n')
+            --start;
+        return start;
+    }
+
+    // finds the end of the line that starts at pos
+    qint64 nextLine(qint64 pos) const
+    {
+        const void* nl = std::memchr(data + pos, '\n', static_cast<size_t>(size - pos));
+        return nl ? static_cast<const char*>(nl) - data : size;
+    }
+
+    bool lastRecord(IrcMessageLogRecord* record) const
+    {
+        qint64 pos = size;
+        while (pos > 0) {
+            qint64 end = 0;
+            const qint64 start = previousLine(pos, &end);
+            if (IrcMessageLogPrivate::parseRecord(data + start, static_cast<int>(end - start), record))
+                return true;
+            pos = start;
+        }
+        return false;
+    }
+
+    QFile file;
+    QByteArray buffer;
+    const char* data = nullptr;
+    qint64 size = 0;
+};
+
+IrcMessageLogPrivate::~IrcMessageLogPrivate()
+{
+    // closing flushes
+    qDeleteAll(writers);
+}
+
+QString IrcMessageLogPrivate::key(const QString& buffer) const
+{
+    return tracker.casemap(buffer);
+}
+
+QString IrcMessageLogPrivate::bufferPath(const QString& buffer) const
+{
+    // escape everything that might not be valid in a file name, including dots
+    const QByteArray name = QUrl::toPercentEncoding(key(buffer), QByteArray(), ".");
+    return directory + QLatin1Char('/') + QString::fromLatin1(name);
+}
+
+QStringList IrcMessageLogPrivate::segments(const QString& buffer) const
+{
+    QStringList segments;
+    if (directory.isEmpty())
+        return segments;
+    const QString path = bufferPath(buffer);
+    const QStringList files = QDir(path).entryList(QStringList("*.log"), QDir::Files, QDir::Name);
+    foreach (const QString& file, files)
+        segments += path + QLatin1Char('/') + QFileInfo(file).completeBaseName();
+    return segments;
+}
+
+IrcMessageLogWriter* IrcMessageLogPrivate::writer(const QString& buffer)
+{
+    const QString key = this->key(buffer);
+    IrcMessageLogWriter* writer = writers.value(key);
+    if (!writer) {
+        if (directory.isEmpty() || !QDir().mkpath(bufferPath(buffer)))
+            return nullptr;
+
+        // keep the amount of open files at bay
+        if (writers.count() >= MAX_OPEN_WRITERS) {
+            QHash<QString, IrcMessageLogWriter*>::const_iterator lru = writers.constBegin();
+            for (QHash<QString, IrcMessageLogWriter*>::const_iterator it = writers.constBegin(); it != writers.constEnd(); ++it) {
+                if (it.value()->used < lru.value()->used)
+                    lru = it;
+            }
+            closeWriter(lru.key());
+        }
+
+        writer = new IrcMessageLogWriter;
+        const QStringList segs = segments(buffer);
+        QString base;
+        if (!segs.isEmpty()) {
+            // continue the time line of the previous segment
+            IrcMessageLogSegment last(segs.last());
+            IrcMessageLogRecord record;
+            if (last.lastRecord(&record))
+                writer->lastTime = record.time;
+            if (last.size < segmentSize) {
+                base = segs.last();
+                writer->size = last.size;
+                const QVector<IrcMessageLogEntry> index = readIndex(base + ".idx");
+                if (!index.isEmpty())
+                    writer->indexed = index.last().offset;
+                // a partial record left behind by a crash must not swallow the next one
+                if (last.size > 0 && last.data[last.size - 1] != '\n')
+                    writer->size = -1;
+            }
+        }
+        if (base.isEmpty()) {
+            const int number = segs.isEmpty() ? 0 : QFileInfo(segs.last()).fileName().toInt() + 1;
+            base = bufferPath(buffer) + QLatin1Char('/') + irc_segment_name(number);
+        }
+
+        writer->log.setFileName(base + ".log");
+        writer->index.setFileName(base + ".idx");
+        if (!writer->log.open(QIODevice::WriteOnly | QIODevice::Append) || !writer->index.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            delete writer;
+            return nullptr;
+        }
+        if (writer->size == -1) {
+            writer->log.write("\n", 1);
+            writer->size = writer->log.size();
+        }
+        writers.insert(key, writer);
+    }
+    writer->used = ++clock;
+    return writer;
+}
+
+void IrcMessageLogPrivate::closeWriter(const QString& buffer)
+{
+    delete writers.take(key(buffer));
+}
+
+void IrcMessageLogPrivate::scheduleFlush()
+{
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+bool IrcMessageLogPrivate::parseRecord(const char* data, int length, IrcMessageLogRecord* record)
+{
+    // <msecs> <flags> <line>
+    const char* end = data + length;
+    const char* sp1 = static_cast<const char*>(std::memchr(data, ' ', static_cast<size_t>(length)));
+    if (!sp1 || sp1 == data)
+        return false;
+    const char* sp2 = static_cast<const char*>(std::memchr(sp1 + 1, ' ', static_cast<size_t>(end - sp1 - 1)));
+    if (!sp2 || sp2 == sp1 + 1 || sp2 + 1 >= end)
+        return false;
+
+    bool ok = false;
+    record->time = QByteArray::fromRawData(data, static_cast<int>(sp1 - data)).toLongLong(&ok);
+    if (!ok)
+        return false;
+    record->flags = QByteArray::fromRawData(sp1 + 1, static_cast<int>(sp2 - sp1 - 1)).toInt(&ok);
+    if (!ok)
+        return false;
+    record->line = QByteArray(sp2 + 1, static_cast<int>(end - sp2 - 1));
+    return true;
+}
+
+QVector<IrcMessageLogEntry> IrcMessageLogPrivate::readIndex(const QString& path)
+{
+    QVector<IrcMessageLogEntry> entries;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        const QByteArray data = file.readAll();
+        const int count = data.size() / INDEX_ENTRY_SIZE;
+        entries.reserve(count);
+        const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+        for (int i = 0; i < count; ++i, p += INDEX_ENTRY_SIZE) {
+            IrcMessageLogEntry entry;
+            entry.time = qFromLittleEndian<qint64>(p);
+            entry.offset = qFromLittleEndian<qint64>(p + sizeof(qint64));
+            entries += entry;
+        }
+    }
+    return entries;
+}
+
+bool IrcMessageLogPrivate::writeIndex(QFile* file, qint64 time, qint64 offset)
+{
+    uchar entry[INDEX_ENTRY_SIZE];
+    qToLittleEndian<qint64>(time, entry);
+    qToLittleEndian<qint64>(offset, entry + sizeof(qint64));
+    return file->write(reinterpret_cast<const char*>(entry), INDEX_ENTRY_SIZE) == INDEX_ENTRY_SIZE;
+}
+
+IrcMessage* IrcMessageLogPrivate::createMessage(const IrcMessageLogRecord& record, IrcConnection* connection) const
+{
+    IrcMessage* message = IrcMessage::fromData(record.line, connection);
+    // the time tag carries the original time stamp, if any
+    if (!message->tags().contains("time"))
+        message->setTimeStamp(QDateTime::fromMSecsSinceEpoch(record.time));
+    message->setFlags(IrcMessage::Flags(record.flags));
+    return message;
+}
+
+void IrcMessageLogPrivate::_irc_bufferAdded(IrcBuffer* buffer)
+{
+    Q_Q(IrcMessageLog);
+    IrcBufferTracker::track(buffer, q);
+}
+
+void IrcMessageLogPrivate::_irc_bufferRemoved(IrcBuffer* buffer)
+{
+    Q_Q(IrcMessageLog);
+    IrcBufferTracker::untrack(buffer, q);
+    closeWriter(buffer->title());
+}
+
+void IrcMessageLogPrivate::_irc_messageReceived(IrcMessage* message)
+{
+    Q_Q(IrcMessageLog);
+    IrcBuffer* buffer = qobject_cast<IrcBuffer*>(q->sender());
+    if (buffer)
+        q->append(buffer->title(), message);
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    Constructs a new message log with \a parent.
+ */
+IrcMessageLog::IrcMessageLog(QObject* parent) : QObject(parent), d_ptr(new IrcMessageLogPrivate)
+{
+    Q_D(IrcMessageLog);
+    d->q_ptr = this;
+    d->segmentSize = DEFAULT_SEGMENT_SIZE;
+    d->indexInterval = DEFAULT_INDEX_INTERVAL;
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(0);
+    connect(&d->flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+/*!
+    Destructs the message log, and flushes pending writes.
+ */
+IrcMessageLog::~IrcMessageLog()
+{
+}
+
+/*!
+    This property holds the directory of the log.
+
+    Each buffer is logged in a sub-directory, named after the buffer
+    title folded as the CASEMAPPING of the network of the model, with
+    file name unsafe characters escaped.
+
+    \par Access functions:
+    \li QString <b>directory</b>() const
+    \li void <b>setDirectory</b>(const QString& directory)
+ */
+QString IrcMessageLog::directory() const
+{
+    Q_D(const IrcMessageLog);
+    return d->directory;
+}
+
+void IrcMessageLog::setDirectory(const QString& directory)
+{
+    Q_D(IrcMessageLog);
+    if (d->directory != directory) {
+        qDeleteAll(d->writers);
+        d->writers.clear();
+        d->directory = directory;
+    }
+}
+
+/*!
+    This property holds the buffer model whose messages are logged.
+
+    \par Access functions:
+    \li \ref IrcBufferModel* <b>model</b>() const
+    \li void <b>setModel</b>(\ref IrcBufferModel* model)
+ */
+IrcBufferModel* IrcMessageLog::model() const
+{
+    Q_D(const IrcMessageLog);
+    return d->tracker.model();
+}
+
+void IrcMessageLog::setModel(IrcBufferModel* model)
+{
+    Q_D(IrcMessageLog);
+    d->tracker.setModel(model, this);
+}
+
+/*!
+    This property holds the size in bytes after which a segment is closed and a new one started.
+
+    The default value is \c 32 megabytes, and the maximum is \c 1 gigabyte.
+
+    \par Access functions:
+    \li qint64 <b>segmentSize</b>() const
+    \li void <b>setSegmentSize</b>(qint64 size)
+ */
+qint64 IrcMessageLog::segmentSize() const
+{
+    Q_D(const IrcMessageLog);
+    return d->segmentSize;
+}
+
+void IrcMessageLog::setSegmentSize(qint64 size)
+{
+    Q_D(IrcMessageLog);
+    d->segmentSize = qBound<qint64>(1, size, MAX_SEGMENT_SIZE);
+}
+
+/*!
+    This property holds the interval in bytes between entries of the time index.
+
+    A smaller interval makes time range lookups read less of the log,
+    at the cost of a larger index.
+
+    The default value is \c 64 kilobytes.
+
+    \par Access functions:
+    \li int <b>indexInterval</b>() const
+    \li void <b>setIndexInterval</b>(int bytes)
+ */
+int IrcMessageLog::indexInterval() const
+{
+    Q_D(const IrcMessageLog);
+    return d->indexInterval;
+}
+
+void IrcMessageLog::setIndexInterval(int bytes)
+{
+    Q_D(IrcMessageLog);
+    d->indexInterval = qMax(1, bytes);
+}
+
+/*!
+    This property holds the titles of the logged buffers, casemapped.
+
+    \par Access function:
+    \li QStringList <b>buffers</b>() const
+ */
+QStringList IrcMessageLog::buffers() const
+{
+    Q_D(const IrcMessageLog);
+    QStringList buffers;
+    if (!d->directory.isEmpty()) {
+        foreach (const QString& name, QDir(d->directory).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name))
+            buffers += QUrl::fromPercentEncoding(name.toLatin1());
+    }
+    return buffers;
+}
+
+/*!
+    Returns the amount of segments of \a buffer.
+ */
+int IrcMessageLog::segmentCount(const QString& buffer) const
+{
+    Q_D(const IrcMessageLog);
+    return d->segments(buffer).count();
+}
+
+/*!
+    Appends \a message to the log of \a buffer.
+
+    Returns \c true on success; otherwise \c false.
+ */
+bool IrcMessageLog::append(const QString& buffer, IrcMessage* message)
+{
+    if (!message)
+        return false;
+    return append(buffer, message->toData(), message->timeStamp(), message->flags());
+}
+
+/*!
+    Appends a raw IRC line of \a data, received at \a timeStamp with \a flags, to the log of \a buffer.
+
+    Returns \c true on success; otherwise \c false, for example when the
+    data is empty or spans multiple lines.
+ */
+bool IrcMessageLog::append(const QString& buffer, const QByteArray& data, const QDateTime& timeStamp, IrcMessage::Flags flags)
+{
+    Q_D(IrcMessageLog);
+    if (data.isEmpty() || data.contains('\n') || data.contains('\r'))
+        return false;
+
+    IrcMessageLogWriter* writer = d->writer(buffer);
+    if (!writer)
+        return false;
+
+    const qint64 time = qMax(timeStamp.isValid() ? timeStamp.toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch(), writer->lastTime);
+    QByteArray record;
+    record.reserve(data.size() + 32);
+    record += QByteArray::number(time);
+    record += ' ';
+    record += QByteArray::number(static_cast<int>(flags));
+    record += ' ';
+    record += data;
+    record += '\n';
+
+    if (writer->log.write(record) != record.size())
+        return false;
+    if (writer->indexed == -1 || writer->size - writer->indexed >= d->indexInterval) {
+        d->writeIndex(&writer->index, time, writer->size);
+        writer->indexed = writer->size;
+    }
+    writer->size += record.size();
+    writer->lastTime = time;
+
+    if (writer->size >= d->segmentSize)
+        d->closeWriter(buffer);
+    d->scheduleFlush();
+    return true;
+}
+
+/*!
+    Returns the last \a count messages of \a buffer, oldest first, created with \a connection.
+
+    The caller takes ownership of the messages, unless they have \a connection as their parent.
+ */
+QList<IrcMessage*> IrcMessageLog::lastMessages(const QString& buffer, int count, IrcConnection* connection) const
+{
+    Q_D(const IrcMessageLog);
+    if (IrcMessageLogWriter* writer = d->writers.value(d->key(buffer)))
+        writer->log.flush();
+
+    QList<IrcMessageLogRecord> records;
+    const QStringList segs = d->segments(buffer);
+    for (int i = segs.count() - 1; i >= 0 && records.count() < count; --i) {
+        IrcMessageLogSegment segment(segs.at(i));
+        qint64 pos = segment.size;
+        while (pos > 0 && records.count() < count) {
+            qint64 end = 0;
+            const qint64 start = segment.previousLine(pos, &end);
+            IrcMessageLogRecord record;
+            if (d->parseRecord(segment.data + start, static_cast<int>(end - start), &record))
+                records += record;
+            pos = start;
+        }
+    }
+
+    QList<IrcMessage*> messages;
+    messages.reserve(records.count());
+    for (int i = records.count() - 1; i >= 0; --i)
+        messages += d->createMessage(records.at(i), connection);
+    return messages;
+}
+
+/*!
+    Returns the messages of \a buffer logged between \a from and \a to (inclusive),
+    oldest first, created with \a connection. An invalid \a from or \a to leaves the
+    range open.
+
+    The caller takes ownership of the messages, unless they have \a connection as their parent.
+ */
+QList<IrcMessage*> IrcMessageLog::messages(const QString& buffer, const QDateTime& from, const QDateTime& to, IrcConnection* connection) const
+{
+    Q_D(const IrcMessageLog);
+    if (IrcMessageLogWriter* writer = d->writers.value(d->key(buffer)))
+        writer->log.flush();
+
+    const qint64 min = from.isValid() ? from.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+    const qint64 max = to.isValid() ? to.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+
+    QList<IrcMessage*> messages;
+    const QStringList segs = d->segments(buffer);
+    for (int i = 0; i < segs.count(); ++i) {
+        const QVector<IrcMessageLogEntry> index = d->readIndex(segs.at(i) + ".idx");
+        if (!index.isEmpty() && index.first().time > max)
+            break;
+
+        // a segment that ends before the range only costs a lookup of its last record
+        if (i + 1 < segs.count()) {
+            const QVector<IrcMessageLogEntry> next = d->readIndex(segs.at(i + 1) + ".idx");
+            if (!next.isEmpty() && next.first().time < min)
+                continue;
+        }
+
+        IrcMessageLogSegment segment(segs.at(i));
+
+        // start from the last indexed record before the range
+        qint64 pos = 0;
+        QVector<IrcMessageLogEntry>::const_iterator it = std::lower_bound(index.constBegin(), index.constEnd(), min,
+            [](const IrcMessageLogEntry& entry, qint64 time) { return entry.time < time; });
+        if (it != index.constBegin())
+            pos = qBound<qint64>(0, (it - 1)->offset, segment.size);
+
+        while (pos < segment.size) {
+            const qint64 end = segment.nextLine(pos);
+            IrcMessageLogRecord record;
+            if (d->parseRecord(segment.data + pos, static_cast<int>(end - pos), &record)) {
+                if (record.time > max)
+                    return messages;
+                if (record.time >= min)
+                    messages += d->createMessage(record, connection);
+            }
+            pos = end + 1;
+        }
+    }
+    return messages;
+}
+
+/*!
+    Returns the message of \a buffer with the \c msgid tag \a msgid, created
+    with \a connection, or \c nullptr if there is no such message.
+
+    The log is searched from the newest segment to the oldest. Only the
+    \c msgid tag of the messages is compared, after unescaping its value
+    as specified by IRCv3 message tags.
+
+    The caller takes ownership of the message, unless it has \a connection as its parent.
+ */
+IrcMessage* IrcMessageLog::findMessage(const QString& buffer, const QString& msgid, IrcConnection* connection) const
+{
+    Q_D(const IrcMessageLog);
+    if (msgid.isEmpty())
+        return nullptr;
+    if (IrcMessageLogWriter* writer = d->writers.value(d->key(buffer)))
+        writer->log.flush();
+
+    // an id that needs no escaping appears as is in the log
+    const QByteArray id = msgid.toUtf8();
+    bool plain = true;
+    for (int i = 0; plain && i < id.size(); ++i)
+        plain = !std::strchr(";\\ \r\n", id.at(i));
+    const QByteArrayMatcher matcher(plain ? id : QByteArray("msgid="));
+    const QStringList segs = d->segments(buffer);
+    for (int i = segs.count() - 1; i >= 0; --i) {
+        IrcMessageLogSegment segment(segs.at(i));
+        int pos = matcher.indexIn(segment.data, static_cast<int>(segment.size));
+        while (pos != -1) {
+            // only the msgid tag counts, and not the same text elsewhere in the line
+            qint64 end = 0;
+            const qint64 start = segment.previousLine(segment.nextLine(pos), &end);
+            IrcMessageLogRecord record;
+            QByteArray value;
+            if (d->parseRecord(segment.data + start, static_cast<int>(end - start), &record) &&
+                irc_find_tag(record.line, "msgid", &value) && (value == id || irc_unescape_tag(value) == id))
+                return d->createMessage(record, connection);
+            pos = matcher.indexIn(segment.data, static_cast<int>(segment.size), static_cast<int>(end) + 1);
+        }
+    }
+    return nullptr;
+}
+
+/*!
+    Compacts the log of \a buffer.
+
+    Segments whose messages are all older than \a before are removed.
+    Adjacent segments that fit together within the \ref segmentSize
+    "segment size" are merged. Returns the amount of segments that were
+    removed or merged away.
+ */
+int IrcMessageLog::compact(const QString& buffer, const QDateTime& before)
+{
+    Q_D(IrcMessageLog);
+    d->closeWriter(buffer);
+
+    int removed = 0;
+    QStringList segs = d->segments(buffer);
+
+    if (before.isValid()) {
+        const qint64 min = before.toMSecsSinceEpoch();
+        while (!segs.isEmpty()) {
+            IrcMessageLogRecord record;
+            {
+                IrcMessageLogSegment segment(segs.first());
+                if (segment.lastRecord(&record) && record.time >= min)
+                    break;
+            }
+            QFile::remove(segs.first() + ".log");
+            QFile::remove(segs.first() + ".idx");
+            segs.removeFirst();
+            ++removed;
+        }
+    }
+
+    int i = 0;
+    while (i + 1 < segs.count()) {
+        QFile log(segs.at(i) + ".log");
+        QFile next(segs.at(i + 1) + ".log");
+        if (log.size() + next.size() > d->segmentSize) {
+            ++i;
+            continue;
+        }
+
+        bool partial = false;
+        if (log.open(QIODevice::ReadOnly)) {
+            partial = log.size() > 0 && log.seek(log.size() - 1) && log.read(1) != "\n";
+            log.close();
+        }
+        if (!log.open(QIODevice::WriteOnly | QIODevice::Append) || !next.open(QIODevice::ReadOnly)) {
+            ++i;
+            continue;
+        }
+
+        // terminate a partial record before appending to it
+        if (partial)
+            log.write("\n", 1);
+        const qint64 offset = log.size();
+        while (!next.atEnd())
+            log.write(next.read(1024 * 1024));
+        log.close();
+        next.close();
+
+        QFile index(segs.at(i) + ".idx");
+        if (index.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            foreach (const IrcMessageLogEntry& entry, d->readIndex(segs.at(i + 1) + ".idx"))
+                d->writeIndex(&index, entry.time, entry.offset + offset);
+        }
+
+        QFile::remove(segs.at(i + 1) + ".log");
+        QFile::remove(segs.at(i + 1) + ".idx");
+        segs.removeAt(i + 1);
+        ++removed;
+    }
+    return removed;
+}
+
+/*!
+    Flushes pending writes to disk.
+
+    Writes are flushed automatically when the event loop returns.
+ */
+void IrcMessageLog::flush()
+{
+    Q_D(IrcMessageLog);
+    foreach (IrcMessageLogWriter* writer, d->writers) {
+        writer->log.flush();
+        writer->index.flush();
+    }
+}
+
+#include "moc_ircmessagelog.cpp"
+
+IRC_END_NAMESPACE
@@ -53,6 +53,9 @@ namespace IrcModel {
         qRegisterMetaType<IrcBuffer*>("IrcBuffer*");
         qRegisterMetaType<IrcBufferModel*>("IrcBufferModel*");
         qRegisterMetaType<IrcChannel*>("IrcChannel*");
+        qRegisterMetaType<IrcFilterModel*>("IrcFilterModel*");
+        qRegisterMetaType<IrcMessageLog*>("IrcMessageLog*");
+        qRegisterMetaType<IrcSnapshot>("IrcSnapshot");
         qRegisterMetaType<IrcUser*>("IrcUser*");
         qRegisterMetaType<IrcUserModel*>("IrcUserModel*");
     }
@@ -0,0 +1,150 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircmonitor_p.h"
+#include "irccommand.h"
+#include "ircnetwork_p.h"
+
+IRC_BEGIN_NAMESPACE
+
+#ifndef IRC_DOXYGEN
+static const int MAX_MONITOR_LENGTH = 510 - 10; // "MONITOR + " and CR-LF
+
+void IrcMonitor::setLimit(int limit)
+{
+    monitorLimit = limit;
+}
+
+void IrcMonitor::setTargetLimit(int limit)
+{
+    lineTargets = limit;
+}
+
+void IrcMonitor::setNetwork(IrcNetwork* network)
+{
+    this->network = network;
+}
+
+QString IrcMonitor::casemap(const QString& target) const
+{
+    return IrcNetworkPrivate::casemap(network, target);
+}
+
+QStringList IrcMonitor::targets() const
+{
+    return monitored;
+}
+
+bool IrcMonitor::contains(const QString& target) const
+{
+    return mappedMonitored.contains(casemap(target));
+}
+
+QList<IrcCommand*> IrcMonitor::update(const QStringList& desired)
+{
+    // the desired targets are in order of priority, and only
+    // the first ones are monitored when the server limit is hit
+    QStringList wanted;
+    QSet<QString> mappedWanted;
+    foreach (const QString& target, desired) {
+        if (monitorLimit > 0 && wanted.count() >= monitorLimit)
+            break;
+        const QString mapped = casemap(target);
+        if (!mappedWanted.contains(mapped)) {
+            mappedWanted.insert(mapped);
+            wanted += target;
+        }
+    }
+
+    QStringList removed;
+    foreach (const QString& target, monitored) {
+        if (!mappedWanted.contains(casemap(target)))
+            removed += target;
+    }
+    QStringList added;
+    foreach (const QString& target, wanted) {
+        if (!mappedMonitored.contains(casemap(target)))
+            added += target;
+    }
+    monitored = wanted;
+    mappedMonitored = mappedWanted;
+
+    // removals go first to make room for the additions
+    QList<IrcCommand*> commands;
+    foreach (const QStringList& targets, pack(removed, MAX_MONITOR_LENGTH, lineTargets))
+        commands += IrcCommand::createMonitor(QStringLiteral("-"), targets);
+    foreach (const QStringList& targets, pack(added, MAX_MONITOR_LENGTH, lineTargets))
+        commands += IrcCommand::createMonitor(QStringLiteral("+"), targets);
+    return commands;
+}
+
+void IrcMonitor::reject(const QStringList& targets, int limit)
+{
+    if (limit > 0)
+        monitorLimit = limit;
+    foreach (const QString& target, targets) {
+        const QString mapped = casemap(target);
+        if (mappedMonitored.remove(mapped)) {
+            for (int i = 0; i < monitored.count(); ++i) {
+                if (casemap(monitored.at(i)) == mapped) {
+                    monitored.removeAt(i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void IrcMonitor::reset()
+{
+    monitored.clear();
+    mappedMonitored.clear();
+}
+
+QList<QStringList> IrcMonitor::pack(const QStringList& targets, int length, int count)
+{
+    QList<QStringList> lines;
+    QStringList line;
+    int lineLength = 0;
+    foreach (const QString& target, targets) {
+        const int targetLength = target.toUtf8().length();
+        if (!line.isEmpty() && (lineLength + 1 + targetLength > length || (count > 0 && line.count() >= count))) {
+            lines += line;
+            line.clear();
+            lineLength = 0;
+        }
+        lineLength += line.isEmpty() ? targetLength : targetLength + 1;
+        line += target;
+    }
+    if (!line.isEmpty())
+        lines += line;
+    return lines;
+}
+#endif // IRC_DOXYGEN
+
+IRC_END_NAMESPACE
@@ -0,0 +1,631 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircsnapshot.h"
+#include "ircsnapshot_p.h"
+#include "ircchannel_p.h"
+#include "ircnetwork.h"
+#include "ircuser.h"
+#include <algorithm>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircsnapshot.h
+    \brief \#include &lt;IrcSnapshot&gt;
+ */
+
+/*!
+    \class IrcSnapshot ircsnapshot.h <IrcSnapshot>
+    \ingroup models
+    \brief An immutable copy of the channel and network state.
+    \since 3.7
+
+    IrcBuffer, IrcChannel, IrcUser and IrcNetwork live in the thread of
+    their connection and must not be touched from other threads. When
+    \ref IrcBufferModel::snapshotsEnabled "snapshots are enabled",
+    IrcBufferModel publishes an IrcSnapshot after each round of updates.
+    Any thread may fetch the latest one with IrcBufferModel::snapshot().
+
+    Snapshots are implicitly shared and never change after they have been
+    published, so they can be copied and read from any thread without
+    locking. Channels that did not change between two snapshots share the
+    same IrcChannelSnapshot data, and so do the users that did not change
+    within a changed channel.
+
+    \sa IrcBufferModel::snapshot(), IrcChannelSnapshot, IrcNetworkSnapshot
+ */
+
+/*!
+    \class IrcChannelSnapshot ircsnapshot.h <IrcSnapshot>
+    \ingroup models
+    \brief An immutable copy of the channel state.
+    \since 3.7
+
+    \sa IrcSnapshot
+ */
+
+/*!
+    \class IrcUserSnapshot ircsnapshot.h <IrcSnapshot>
+    \ingroup models
+    \brief An immutable copy of the channel user state.
+    \since 3.7
+
+    \sa IrcChannelSnapshot
+ */
+
+/*!
+    \class IrcNetworkSnapshot ircsnapshot.h <IrcSnapshot>
+    \ingroup models
+    \brief An immutable copy of the network information.
+    \since 3.7
+
+    \sa IrcSnapshot
+ */
+
+/*!
+    Constructs an invalid user snapshot.
+ */
+IrcUserSnapshot::IrcUserSnapshot()
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+ */
+IrcUserSnapshot::IrcUserSnapshot(const IrcUserSnapshot& other) : d(other.d)
+{
+}
+
+/*!
+    Assigns \a other to this user snapshot.
+ */
+IrcUserSnapshot& IrcUserSnapshot::operator=(const IrcUserSnapshot& other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Destructs the user snapshot.
+ */
+IrcUserSnapshot::~IrcUserSnapshot()
+{
+}
+
+/*!
+    Returns \c true if the snapshot holds a user.
+ */
+bool IrcUserSnapshot::isValid() const
+{
+    return d.constData() != nullptr;
+}
+
+/*!
+    Returns the title, the first prefix followed by the name.
+
+    \sa IrcUser::title
+ */
+QString IrcUserSnapshot::title() const
+{
+    return d ? d->prefix.left(1) + d->name : QString();
+}
+
+/*!
+    Returns the name.
+
+    \sa IrcUser::name
+ */
+QString IrcUserSnapshot::name() const
+{
+    return d ? d->name : QString();
+}
+
+/*!
+    Returns the prefix characters.
+
+    \sa IrcUser::prefix
+ */
+QString IrcUserSnapshot::prefix() const
+{
+    return d ? d->prefix : QString();
+}
+
+/*!
+    Returns the mode characters.
+
+    \sa IrcUser::mode
+ */
+QString IrcUserSnapshot::mode() const
+{
+    return d ? d->mode : QString();
+}
+
+/*!
+    Returns whether the user is a server operator.
+
+    \sa IrcUser::servOp
+ */
+bool IrcUserSnapshot::isServOp() const
+{
+    return d && d->servOp;
+}
+
+/*!
+    Returns whether the user is away.
+
+    \sa IrcUser::away
+ */
+bool IrcUserSnapshot::isAway() const
+{
+    return d && d->away;
+}
+
+/*!
+    Constructs an invalid channel snapshot.
+ */
+IrcChannelSnapshot::IrcChannelSnapshot()
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+ */
+IrcChannelSnapshot::IrcChannelSnapshot(const IrcChannelSnapshot& other) : d(other.d)
+{
+}
+
+/*!
+    Assigns \a other to this channel snapshot.
+ */
+IrcChannelSnapshot& IrcChannelSnapshot::operator=(const IrcChannelSnapshot& other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Destructs the channel snapshot.
+ */
+IrcChannelSnapshot::~IrcChannelSnapshot()
+{
+}
+
+/*!
+    Returns \c true if the snapshot holds a channel.
+ */
+bool IrcChannelSnapshot::isValid() const
+{
+    return d.constData() != nullptr;
+}
+
+/*!
+    Returns the title, the prefix followed by the name.
+
+    \sa IrcBuffer::title
+ */
+QString IrcChannelSnapshot::title() const
+{
+    return d ? d->title : QString();
+}
+
+/*!
+    Returns the name.
+
+    \sa IrcBuffer::name
+ */
+QString IrcChannelSnapshot::name() const
+{
+    return d ? d->name : QString();
+}
+
+/*!
+    Returns the prefix.
+
+    \sa IrcBuffer::prefix
+ */
+QString IrcChannelSnapshot::prefix() const
+{
+    return d ? d->prefix : QString();
+}
+
+/*!
+    Returns the channel mode.
+
+    \sa IrcChannel::mode
+ */
+QString IrcChannelSnapshot::mode() const
+{
+    return d ? d->mode : QString();
+}
+
+/*!
+    Returns the channel key.
+
+    \sa IrcChannel::key
+ */
+QString IrcChannelSnapshot::key() const
+{
+    return d ? d->key : QString();
+}
+
+/*!
+    Returns the channel topic.
+
+    \sa IrcChannel::topic
+ */
+QString IrcChannelSnapshot::topic() const
+{
+    return d ? d->topic : QString();
+}
+
+/*!
+    Returns whether the channel was active.
+
+    \sa IrcBuffer::active
+ */
+bool IrcChannelSnapshot::isActive() const
+{
+    return d && d->active;
+}
+
+/*!
+    Returns the sorted list of user names.
+
+    \sa IrcUserModel::names
+ */
+QStringList IrcChannelSnapshot::names() const
+{
+    return d ? d->names : QStringList();
+}
+
+/*!
+    Returns the users, in the same order as names().
+ */
+QList<IrcUserSnapshot> IrcChannelSnapshot::users() const
+{
+    return d ? d->users : QList<IrcUserSnapshot>();
+}
+
+/*!
+    Returns the user with \a name, or an invalid snapshot if there is no such user.
+ */
+IrcUserSnapshot IrcChannelSnapshot::user(const QString& name) const
+{
+    if (d) {
+        QStringList::const_iterator it = std::lower_bound(d->names.constBegin(), d->names.constEnd(), name);
+        if (it != d->names.constEnd() && *it == name)
+            return d->users.at(it - d->names.constBegin());
+    }
+    return IrcUserSnapshot();
+}
+
+/*!
+    Returns \c true if the channel has a user with \a name.
+ */
+bool IrcChannelSnapshot::contains(const QString& name) const
+{
+    return d && std::binary_search(d->names.constBegin(), d->names.constEnd(), name);
+}
+
+/*!
+    Constructs an invalid network snapshot.
+ */
+IrcNetworkSnapshot::IrcNetworkSnapshot()
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+ */
+IrcNetworkSnapshot::IrcNetworkSnapshot(const IrcNetworkSnapshot& other) : d(other.d)
+{
+}
+
+/*!
+    Assigns \a other to this network snapshot.
+ */
+IrcNetworkSnapshot& IrcNetworkSnapshot::operator=(const IrcNetworkSnapshot& other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Destructs the network snapshot.
+ */
+IrcNetworkSnapshot::~IrcNetworkSnapshot()
+{
+}
+
+/*!
+    Returns \c true if the snapshot holds network information.
+ */
+bool IrcNetworkSnapshot::isValid() const
+{
+    return d.constData() != nullptr;
+}
+
+/*!
+    Returns the network name.
+
+    \sa IrcNetwork::name
+ */
+QString IrcNetworkSnapshot::name() const
+{
+    return d ? d->name : QString();
+}
+
+/*!
+    Returns the supported channel user mode letters.
+
+    \sa IrcNetwork::modes
+ */
+QStringList IrcNetworkSnapshot::modes() const
+{
+    return d ? d->modes : QStringList();
+}
+
+/*!
+    Returns the supported channel user mode prefixes.
+
+    \sa IrcNetwork::prefixes
+ */
+QStringList IrcNetworkSnapshot::prefixes() const
+{
+    return d ? d->prefixes : QStringList();
+}
+
+/*!
+    Returns the supported channel type prefixes.
+
+    \sa IrcNetwork::channelTypes
+ */
+QStringList IrcNetworkSnapshot::channelTypes() const
+{
+    return d ? d->channelTypes : QStringList();
+}
+
+/*!
+    Returns the supported status message prefixes.
+
+    \sa IrcNetwork::statusPrefixes
+ */
+QStringList IrcNetworkSnapshot::statusPrefixes() const
+{
+    return d ? d->statusPrefixes : QStringList();
+}
+
+/*!
+    Returns the active capabilities.
+
+    \sa IrcNetwork::activeCapabilities
+ */
+QStringList IrcNetworkSnapshot::activeCapabilities() const
+{
+    return d ? d->activeCapabilities : QStringList();
+}
+
+/*!
+    Converts a \a mode to a prefix.
+
+    \sa IrcNetwork::modeToPrefix()
+ */
+QString IrcNetworkSnapshot::modeToPrefix(const QString& mode) const
+{
+    if (!d)
+        return QString();
+    return d->prefixes.value(d->modes.indexOf(mode));
+}
+
+/*!
+    Converts a \a prefix to a mode.
+
+    \sa IrcNetwork::prefixToMode()
+ */
+QString IrcNetworkSnapshot::prefixToMode(const QString& prefix) const
+{
+    if (!d)
+        return QString();
+    return d->modes.value(d->prefixes.indexOf(prefix));
+}
+
+/*!
+    Returns \c true if \a name is a channel.
+
+    \sa IrcNetwork::isChannel()
+ */
+bool IrcNetworkSnapshot::isChannel(const QString& name) const
+{
+    return d && !name.isEmpty() && d->channelTypes.contains(name.at(0));
+}
+
+/*!
+    Constructs an invalid snapshot.
+ */
+IrcSnapshot::IrcSnapshot()
+{
+}
+
+/*!
+    Constructs a copy of \a other.
+ */
+IrcSnapshot::IrcSnapshot(const IrcSnapshot& other) : d(other.d)
+{
+}
+
+/*!
+    Assigns \a other to this snapshot.
+ */
+IrcSnapshot& IrcSnapshot::operator=(const IrcSnapshot& other)
+{
+    d = other.d;
+    return *this;
+}
+
+/*!
+    Destructs the snapshot.
+ */
+IrcSnapshot::~IrcSnapshot()
+{
+}
+
+/*!
+    Returns \c true if the snapshot has been published by a model.
+ */
+bool IrcSnapshot::isValid() const
+{
+    return d.constData() != nullptr;
+}
+
+/*!
+    Returns the revision of the snapshot.
+
+    The revision grows with each snapshot published by the same model.
+ */
+quint64 IrcSnapshot::revision() const
+{
+    return d ? d->revision : 0;
+}
+
+/*!
+    Returns the network information.
+ */
+IrcNetworkSnapshot IrcSnapshot::network() const
+{
+    return d ? d->network : IrcNetworkSnapshot();
+}
+
+/*!
+    Returns the channels, in the order of the model.
+ */
+QList<IrcChannelSnapshot> IrcSnapshot::channels() const
+{
+    return d ? d->channels : QList<IrcChannelSnapshot>();
+}
+
+/*!
+    Returns the channel with \a title, or an invalid snapshot if there is no such channel.
+ */
+IrcChannelSnapshot IrcSnapshot::channel(const QString& title) const
+{
+    if (d) {
+        const int idx = d->index.value(title.toLower(), -1);
+        if (idx != -1)
+            return d->channels.at(idx);
+    }
+    return IrcChannelSnapshot();
+}
+
+#ifndef IRC_DOXYGEN
+// shares the data of an unchanged user with the previous snapshot
+static IrcUserSnapshot irc_user_snapshot(const IrcChannelSnapshot& previous, const QString& name, const QString& prefix, const QString& mode, bool servOp, bool away)
+{
+    IrcUserSnapshot user = previous.user(name);
+    if (!user.isValid() || user.prefix() != prefix || user.mode() != mode || user.isServOp() != servOp || user.isAway() != away)
+        user = IrcSnapshotBuilder::user(name, prefix, mode, servOp, away);
+    return user;
+}
+
+IrcUserSnapshot IrcSnapshotBuilder::user(const QString& name, const QString& prefix, const QString& mode, bool servOp, bool away)
+{
+    IrcUserSnapshot user;
+    user.d = new IrcUserSnapshotData;
+    user.d->name = name;
+    user.d->prefix = prefix;
+    user.d->mode = mode;
+    user.d->servOp = servOp;
+    user.d->away = away;
+    return user;
+}
+
+IrcChannelSnapshot IrcSnapshotBuilder::channel(IrcChannel* channel, const IrcChannelSnapshot& previous)
+{
+    const IrcChannelPrivate* priv = IrcChannelPrivate::get(channel);
+
+    IrcChannelSnapshot snapshot;
+    IrcChannelSnapshotData* data = new IrcChannelSnapshotData;
+    data->title = channel->title();
+    data->name = channel->name();
+    data->prefix = channel->prefix();
+    data->mode = channel->mode();
+    data->key = channel->key();
+    data->topic = channel->topic();
+    data->active = channel->isActive();
+    data->names = priv->nameList();
+
+    IrcNetwork* network = channel->network();
+    if (priv->lazy) {
+        data->users.reserve(priv->lazyUsers.count());
+        QMap<QString, IrcLazyUser>::const_iterator it;
+        for (it = priv->lazyUsers.constBegin(); it != priv->lazyUsers.constEnd(); ++it) {
+            QString mode;
+            foreach (const QString& p, it->prefix)
+                mode += network->prefixToMode(p);
+            data->users += irc_user_snapshot(previous, it.key(), it->prefix, mode, it->servOp, it->away);
+        }
+    } else {
+        data->users.reserve(priv->userMap.count());
+        foreach (IrcUser* u, priv->userMap)
+            data->users += irc_user_snapshot(previous, u->name(), u->prefix(), u->mode(), u->isServOp(), u->isAway());
+    }
+    snapshot.d = data;
+    return snapshot;
+}
+
+IrcNetworkSnapshot IrcSnapshotBuilder::network(IrcNetwork* network)
+{
+    IrcNetworkSnapshot snapshot;
+    if (network) {
+        IrcNetworkSnapshotData* data = new IrcNetworkSnapshotData;
+        data->name = network->name();
+        data->modes = network->modes();
+        data->prefixes = network->prefixes();
+        data->channelTypes = network->channelTypes();
+        data->statusPrefixes = network->statusPrefixes();
+        data->activeCapabilities = network->activeCapabilities();
+        snapshot.d = data;
+    }
+    return snapshot;
+}
+
+IrcSnapshot IrcSnapshotBuilder::snapshot(quint64 revision, const IrcNetworkSnapshot& network, const QList<IrcChannelSnapshot>& channels)
+{
+    IrcSnapshot snapshot;
+    IrcSnapshotData* data = new IrcSnapshotData;
+    data->revision = revision;
+    data->network = network;
+    data->channels = channels;
+    for (int i = 0; i < channels.count(); ++i)
+        data->index.insert(channels.at(i).title().toLower(), i);
+    snapshot.d = data;
+    return snapshot;
+}
+#endif // IRC_DOXYGEN
+
+IRC_END_NAMESPACE
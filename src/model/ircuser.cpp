@@ -51,6 +51,7 @@ void IrcUserPrivate::setName(const QString& n)
     Q_Q(IrcUser);
     if (name != n) {
         name = n;
+        titleDirty = true;
         emit q->nameChanged(name);
         emit q->titleChanged(q->title());
     }
@@ -61,6 +62,7 @@ void IrcUserPrivate::setPrefix(const QString& p)
     Q_Q(IrcUser);
     if (prefix != p) {
         prefix = p;
+        titleDirty = true;
         emit q->prefixChanged(prefix);
         emit q->titleChanged(q->title());
     }
@@ -105,6 +107,7 @@ IrcUser::IrcUser(QObject* parent)
     d->channel = nullptr;
     d->away = false;
     d->servOp = false;
+    d->titleDirty = true;
 }
 
 /*!
@@ -128,7 +131,11 @@ IrcUser::~IrcUser()
 QString IrcUser::title() const
 {
     Q_D(const IrcUser);
-    return d->prefix.left(1) + d->name;
+    if (d->titleDirty) {
+        d->title = d->prefix.left(1) + d->name;
+        d->titleDirty = false;
+    }
+    return d->title;
 }
 
 /*!
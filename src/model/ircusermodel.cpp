@@ -28,11 +28,13 @@
 
 #include "ircusermodel.h"
 #include "ircusermodel_p.h"
+#include "ircsort_p.h"
 #include "ircbuffermodel.h"
 #include "ircconnection.h"
 #include "ircchannel_p.h"
 #include "ircuser.h"
 #include <qpointer.h>
+#include <qset.h>
 #include <algorithm>
 
 IRC_BEGIN_NAMESPACE
@@ -87,6 +89,27 @@ IRC_BEGIN_NAMESPACE
     This signal is emitted just before a \a user is removed from the list of users.
  */
 
+/*!
+    \fn void IrcUserModel::namesAdded(const QStringList& names)
+    \since 3.7
+
+    This signal is emitted when \a names are added to the list of names.
+
+    Unlike \ref names "namesChanged()", this signal carries only the
+    changed names, and is therefore cheap to handle in large channels.
+
+    \sa namesRemoved()
+ */
+
+/*!
+    \fn void IrcUserModel::namesRemoved(const QStringList& names)
+    \since 3.7
+
+    This signal is emitted when \a names are removed from the list of names.
+
+    \sa namesAdded()
+ */
+
 #ifndef IRC_DOXYGEN
 class IrcUserLessThan
 {
@@ -150,9 +173,8 @@ void IrcUserModelPrivate::insertUser(int index, IrcUser* user, bool notify)
     q->endInsertRows();
     if (notify) {
         emit q->added(user);
-        emit q->namesChanged(IrcChannelPrivate::get(channel)->names);
-        emit q->titlesChanged(titles);
-        emit q->usersChanged(userList);
+        emit q->namesAdded(QStringList(user->name()));
+        notifyLists();
         emit q->countChanged(userList.count());
         if (userList.count() == 1)
             emit q->emptyChanged(false);
@@ -172,9 +194,8 @@ void IrcUserModelPrivate::removeUser(IrcUser* user, bool notify)
         q->endRemoveRows();
         if (notify) {
             emit q->removed(user);
-            emit q->namesChanged(IrcChannelPrivate::get(channel)->names);
-            emit q->titlesChanged(titles);
-            emit q->usersChanged(userList);
+            emit q->namesRemoved(QStringList(user->name()));
+            notifyLists();
             emit q->countChanged(userList.count());
             if (userList.isEmpty())
                 emit q->emptyChanged(true);
@@ -182,7 +203,80 @@ void IrcUserModelPrivate::removeUser(IrcUser* user, bool notify)
     }
 }
 
-void IrcUserModelPrivate::setUsers(const QList<IrcUser*>& users, bool reset)
+void IrcUserModelPrivate::addUsers(const QList<IrcUser*>& users)
+{
+    Q_Q(IrcUserModel);
+    if (users.count() == 1) {
+        addUser(users.first());
+        return;
+    }
+
+    const bool wasEmpty = userList.isEmpty();
+    foreach (IrcUser* user, users)
+        emit q->aboutToBeAdded(user);
+    q->beginResetModel();
+    userList += users;
+    if (sortMethod != Irc::SortByHand) {
+        rankUsers(sortMethod);
+        if (sortOrder == Qt::AscendingOrder)
+            std::stable_sort(userList.begin(), userList.end(), IrcUserLessThan(q, sortMethod));
+        else
+            std::stable_sort(userList.begin(), userList.end(), IrcUserGreaterThan(q, sortMethod));
+        clearRanks();
+    }
+    updateTitles();
+    q->endResetModel();
+    QStringList names;
+    foreach (IrcUser* user, users) {
+        emit q->added(user);
+        names += user->name();
+    }
+    emit q->namesAdded(names);
+    notifyLists();
+    emit q->countChanged(userList.count());
+    if (wasEmpty && !userList.isEmpty())
+        emit q->emptyChanged(false);
+}
+
+void IrcUserModelPrivate::removeUsers(const QList<IrcUser*>& users)
+{
+    Q_Q(IrcUserModel);
+    if (users.count() == 1) {
+        removeUser(users.first());
+        return;
+    }
+
+    QSet<IrcUser*> removed;
+    foreach (IrcUser* user, users)
+        removed.insert(user);
+
+    QList<IrcUser*> remaining;
+    foreach (IrcUser* user, userList) {
+        if (!removed.contains(user))
+            remaining += user;
+    }
+    if (remaining.count() == userList.count())
+        return;
+
+    foreach (IrcUser* user, users)
+        emit q->aboutToBeRemoved(user);
+    q->beginResetModel();
+    userList = remaining;
+    updateTitles();
+    q->endResetModel();
+    QStringList names;
+    foreach (IrcUser* user, users) {
+        emit q->removed(user);
+        names += user->name();
+    }
+    emit q->namesRemoved(names);
+    notifyLists();
+    emit q->countChanged(userList.count());
+    if (userList.isEmpty())
+        emit q->emptyChanged(true);
+}
+
+void IrcUserModelPrivate::setUsers(const QList<IrcUser*>& users, const QStringList& previous, bool reset)
 {
     Q_Q(IrcUserModel);
     bool wasEmpty = userList.isEmpty();
@@ -190,50 +284,66 @@ void IrcUserModelPrivate::setUsers(const QList<IrcUser*>& users, bool reset)
         q->beginResetModel();
     userList = users;
     if (sortMethod != Irc::SortByHand) {
+        rankUsers(sortMethod);
         if (sortOrder == Qt::AscendingOrder)
             std::sort(userList.begin(), userList.end(), IrcUserLessThan(q, sortMethod));
         else
             std::sort(userList.begin(), userList.end(), IrcUserGreaterThan(q, sortMethod));
+        clearRanks();
     }
     updateTitles();
     if (reset)
         q->endResetModel();
     QStringList names;
-    if (channel)
-        names = IrcChannelPrivate::get(channel)->names;
-    emit q->namesChanged(names);
-    emit q->titlesChanged(titles);
-    emit q->usersChanged(userList);
+    foreach (IrcUser* user, userList)
+        names += user->name();
+    if (!previous.isEmpty())
+        emit q->namesRemoved(previous);
+    if (!names.isEmpty())
+        emit q->namesAdded(names);
+    notifyLists();
     emit q->countChanged(userList.count());
     if (wasEmpty != userList.isEmpty())
         emit q->emptyChanged(userList.isEmpty());
 }
 
-void IrcUserModelPrivate::renameUser(IrcUser* user)
+void IrcUserModelPrivate::renameUser(IrcUser* user, const QString& from)
 {
     Q_Q(IrcUserModel);
-    if (updateUser(user) && sortMethod != Irc::SortByHand) {
-        QList<IrcUser*> users = userList;
-        const bool notify = false;
-        removeUser(user, notify);
-        insertUser(-1, user, notify);
-        if (updateTitles())
-            emit q->titlesChanged(titles);
-        if (users != userList)
-            emit q->usersChanged(userList);
+    if (updateUser(user)) {
+        if (sortMethod != Irc::SortByHand) {
+            QList<IrcUser*> users = userList;
+            const bool notify = false;
+            removeUser(user, notify);
+            insertUser(-1, user, notify);
+            if (updateTitles())
+                emit q->titlesChanged(titleList());
+            if (users != userList)
+                emit q->usersChanged(userList);
+        } else if (updateTitles()) {
+            emit q->titlesChanged(titleList());
+        }
     }
+    emit q->namesRemoved(QStringList(from));
+    emit q->namesAdded(QStringList(user->name()));
+    if (isConnected(&IrcUserModel::namesChanged))
+        emit q->namesChanged(nameList());
 }
 
 void IrcUserModelPrivate::setUserMode(IrcUser* user)
 {
     Q_Q(IrcUserModel);
-    if (updateUser(user) && sortMethod == Irc::SortByTitle) {
-        const bool notify = false;
-        removeUser(user, notify);
-        insertUser(0, user, notify);
-        if (updateTitles())
-            emit q->titlesChanged(titles);
-        emit q->usersChanged(userList);
+    if (updateUser(user)) {
+        if (sortMethod == Irc::SortByTitle) {
+            const bool notify = false;
+            removeUser(user, notify);
+            insertUser(0, user, notify);
+            if (updateTitles())
+                emit q->titlesChanged(titleList());
+            emit q->usersChanged(userList);
+        } else if (updateTitles()) {
+            emit q->titlesChanged(titleList());
+        }
     }
 }
 
@@ -245,11 +355,41 @@ void IrcUserModelPrivate::promoteUser(IrcUser* user)
         removeUser(user, notify);
         insertUser(0, user, notify);
         if (updateTitles())
-            emit q->titlesChanged(titles);
+            emit q->titlesChanged(titleList());
         emit q->usersChanged(userList);
     }
 }
 
+void IrcUserModelPrivate::rankUsers(Irc::SortMethod method)
+{
+    // looked up once per user instead of once per comparison
+    ranks.clear();
+    rankMethod = Irc::SortByHand;
+    if (!channel)
+        return;
+    if (method == Irc::SortByActivity) {
+        const QList<IrcUser*>& activeUsers = IrcChannelPrivate::get(channel)->activeUsers;
+        ranks.reserve(activeUsers.count());
+        for (int i = 0; i < activeUsers.count(); ++i)
+            ranks.insert(activeUsers.at(i), i);
+        rankMethod = method;
+    } else if (method == Irc::SortByTitle) {
+        const QStringList prefixes = channel->network()->prefixes();
+        ranks.reserve(userList.count());
+        foreach (IrcUser* user, userList) {
+            const QString prefix = user->prefix();
+            ranks.insert(user, !prefix.isEmpty() ? prefixes.indexOf(prefix.at(0)) : -1);
+        }
+        rankMethod = method;
+    }
+}
+
+void IrcUserModelPrivate::clearRanks()
+{
+    ranks.clear();
+    rankMethod = Irc::SortByHand;
+}
+
 bool IrcUserModelPrivate::updateUser(IrcUser* user)
 {
     Q_Q(IrcUserModel);
@@ -264,11 +404,46 @@ bool IrcUserModelPrivate::updateUser(IrcUser* user)
 
 bool IrcUserModelPrivate::updateTitles()
 {
-    QStringList prev = titles;
-    titles.clear();
-    foreach (IrcUser* user, userList)
-        titles += user->title();
-    return titles != prev;
+    // without listeners, the titles are rebuilt only when asked for
+    if (!isConnected(&IrcUserModel::titlesChanged)) {
+        titlesDirty = true;
+        return false;
+    }
+    // the previous titles are unknown, assume they changed
+    if (titlesDirty)
+        return true;
+    const QStringList prev = titles;
+    titlesDirty = true;
+    return titleList() != prev;
+}
+
+QStringList IrcUserModelPrivate::titleList() const
+{
+    if (titlesDirty) {
+        titles.clear();
+        foreach (IrcUser* user, userList)
+            titles += user->title();
+        titlesDirty = false;
+    }
+    return titles;
+}
+
+QStringList IrcUserModelPrivate::nameList() const
+{
+    if (channel)
+        return IrcChannelPrivate::get(channel)->nameList();
+    return QStringList();
+}
+
+void IrcUserModelPrivate::notifyLists()
+{
+    Q_Q(IrcUserModel);
+    // the full lists are built only for those who listen to them
+    if (isConnected(&IrcUserModel::namesChanged))
+        emit q->namesChanged(nameList());
+    if (isConnected(&IrcUserModel::titlesChanged))
+        emit q->titlesChanged(titleList());
+    emit q->usersChanged(userList);
 }
 
 #endif // IRC_DOXYGEN
@@ -299,8 +474,10 @@ IrcUserModel::IrcUserModel(QObject* parent) : QAbstractListModel(parent), d_ptr(
 IrcUserModel::~IrcUserModel()
 {
     Q_D(IrcUserModel);
-    if (d->channel)
+    if (d->channel) {
         IrcChannelPrivate::get(d->channel)->userModels.removeOne(this);
+        IrcChannelPrivate::get(d->channel)->touch();
+    }
 }
 
 /*!
@@ -323,14 +500,18 @@ void IrcUserModel::setChannel(IrcChannel* channel)
 {
     Q_D(IrcUserModel);
     if (d->channel != channel) {
+        const QStringList previous = names();
         beginResetModel();
-        if (d->channel)
+        if (d->channel) {
             IrcChannelPrivate::get(d->channel)->userModels.removeOne(this);
+            IrcChannelPrivate::get(d->channel)->touch();
+        }
 
         d->channel = channel;
 
         QList<IrcUser*> users;
         if (d->channel) {
+            IrcChannelPrivate::get(d->channel)->materialize();
             IrcChannelPrivate::get(d->channel)->userModels.append(this);
             if (d->sortMethod == Irc::SortByActivity)
                 users = IrcChannelPrivate::get(d->channel)->activeUsers;
@@ -338,7 +519,7 @@ void IrcUserModel::setChannel(IrcChannel* channel)
                 users = IrcChannelPrivate::get(d->channel)->userList;
         }
         const bool reset = false;
-        d->setUsers(users, reset);
+        d->setUsers(users, previous, reset);
         endResetModel();
 
         emit channelChanged(channel);
@@ -385,12 +566,15 @@ bool IrcUserModel::isEmpty() const
 
     \par Notifier signal:
     \li void <b>namesChanged</b>(const QStringList& names)
+
+    \note Since 3.7, the list is built on demand. Prefer namesAdded() and
+    namesRemoved() for tracking changes in large channels.
  */
 QStringList IrcUserModel::names() const
 {
     Q_D(const IrcUserModel);
     if (d->channel && !d->userList.isEmpty())
-        return IrcChannelPrivate::get(d->channel)->names;
+        return IrcChannelPrivate::get(d->channel)->nameList();
     return QStringList();
 }
 
@@ -404,11 +588,13 @@ QStringList IrcUserModel::names() const
 
     \par Notifier signal:
     \li void <b>titlesChanged</b>(const QStringList& titles)
+
+    \note Since 3.7, the list is built on demand.
  */
 QStringList IrcUserModel::titles() const
 {
     Q_D(const IrcUserModel);
-    return d->titles;
+    return d->titleList();
 }
 
 /*!
@@ -505,7 +691,7 @@ void IrcUserModel::setSortMethod(Irc::SortMethod method)
         if (method == Irc::SortByActivity && d->channel) {
             d->userList = IrcChannelPrivate::get(d->channel)->activeUsers;
             if (d->updateTitles())
-                emit titlesChanged(d->titles);
+                emit titlesChanged(d->titleList());
         }
         if (d->sortMethod != Irc::SortByHand && !d->userList.isEmpty())
             sort(d->sortMethod, d->sortOrder);
@@ -629,9 +815,7 @@ QVariant IrcUserModel::data(const QModelIndex& index, int role) const
     IrcUser* user = static_cast<IrcUser*>(index.internalPointer());
     Q_ASSERT(user);
 
-    switch (role) {
-    case Qt::DisplayRole:
-        return data(index, d->role);
+    switch (role == Qt::DisplayRole ? d->role : role) {
     case Irc::UserRole:
         return QVariant::fromValue(user);
     case Irc::NameRole:
@@ -666,9 +850,14 @@ void IrcUserModel::clear()
 {
     Q_D(IrcUserModel);
     if (!d->userList.isEmpty()) {
+        QStringList names;
+        foreach (IrcUser* user, d->userList)
+            names += user->name();
         beginResetModel();
         d->userList.clear();
+        d->titlesDirty = true;
         endResetModel();
+        emit namesRemoved(names);
         emit namesChanged(QStringList());
         emit titlesChanged(QStringList());
         emit usersChanged(QList<IrcUser*>());
@@ -700,23 +889,20 @@ void IrcUserModel::sort(Irc::SortMethod method, Qt::SortOrder order)
 
     emit layoutAboutToBeChanged();
 
-    QList<IrcUser*> persistentUsers;
-    QModelIndexList oldPersistentIndexes = persistentIndexList();
-    foreach (const QModelIndex& index, oldPersistentIndexes)
-        persistentUsers += static_cast<IrcUser*>(index.internalPointer());
+    const QModelIndexList oldPersistentIndexes = persistentIndexList();
 
+    QVector<int> rows;
+    d->rankUsers(method);
     if (order == Qt::AscendingOrder)
-        std::sort(d->userList.begin(), d->userList.end(), IrcUserLessThan(this, method));
+        rows = irc_sort_rows(d->userList, IrcUserLessThan(this, method));
     else
-        std::sort(d->userList.begin(), d->userList.end(), IrcUserGreaterThan(this, method));
+        rows = irc_sort_rows(d->userList, IrcUserGreaterThan(this, method));
+    d->clearRanks();
 
     if (d->updateTitles())
-        emit titlesChanged(d->titles);
+        emit titlesChanged(d->titleList());
 
-    QModelIndexList newPersistentIndexes;
-    foreach (IrcUser* user, persistentUsers)
-        newPersistentIndexes += index(d->userList.indexOf(user));
-    changePersistentIndexList(oldPersistentIndexes, newPersistentIndexes);
+    changePersistentIndexList(oldPersistentIndexes, irc_remap_rows(this, oldPersistentIndexes, rows));
 
     emit layoutChanged();
 }
@@ -732,20 +918,31 @@ void IrcUserModel::sort(Irc::SortMethod method, Qt::SortOrder order)
  */
 bool IrcUserModel::lessThan(IrcUser* one, IrcUser* another, Irc::SortMethod method) const
 {
+    Q_D(const IrcUserModel);
+    const bool ranked = d->rankMethod == method;
     if (method == Irc::SortByActivity) {
-        QList<IrcUser*> activeUsers = IrcChannelPrivate::get(one->channel())->activeUsers;
+        if (ranked)
+            return d->ranks.value(one, -1) < d->ranks.value(another, -1);
+        const QList<IrcUser*>& activeUsers = IrcChannelPrivate::get(one->channel())->activeUsers;
         const int i1 = activeUsers.indexOf(one);
         const int i2 = activeUsers.indexOf(another);
         return i1 < i2;
     } else if (method == Irc::SortByTitle) {
-        const IrcNetwork* network = one->channel()->network();
-        const QStringList prefixes = network->prefixes();
-
-        const QString p1 = one->prefix();
-        const QString p2 = another->prefix();
-
-        const int i1 = !p1.isEmpty() ? prefixes.indexOf(p1.at(0)) : -1;
-        const int i2 = !p2.isEmpty() ? prefixes.indexOf(p2.at(0)) : -1;
+        int i1 = -1;
+        int i2 = -1;
+        if (ranked) {
+            i1 = d->ranks.value(one, -1);
+            i2 = d->ranks.value(another, -1);
+        } else {
+            const IrcNetwork* network = one->channel()->network();
+            const QStringList prefixes = network->prefixes();
+
+            const QString p1 = one->prefix();
+            const QString p2 = another->prefix();
+
+            i1 = !p1.isEmpty() ? prefixes.indexOf(p1.at(0)) : -1;
+            i2 = !p2.isEmpty() ? prefixes.indexOf(p2.at(0)) : -1;
+        }
 
         if (i1 >= 0 && i2 < 0)
             return true;
@@ -12,20 +12,32 @@ INCLUDEPATH += $$PWD $$INCDIR
 CONV_HEADERS  = $$INCDIR/IrcBuffer
 CONV_HEADERS += $$INCDIR/IrcBufferModel
 CONV_HEADERS += $$INCDIR/IrcChannel
+CONV_HEADERS += $$INCDIR/IrcFilterModel
+CONV_HEADERS += $$INCDIR/IrcMessageLog
 CONV_HEADERS += $$INCDIR/IrcModel
+CONV_HEADERS += $$INCDIR/IrcSnapshot
 CONV_HEADERS += $$INCDIR/IrcUser
 CONV_HEADERS += $$INCDIR/IrcUserModel
 
 PUB_HEADERS  = $$INCDIR/ircbuffer.h
 PUB_HEADERS += $$INCDIR/ircbuffermodel.h
 PUB_HEADERS += $$INCDIR/ircchannel.h
+PUB_HEADERS += $$INCDIR/ircfiltermodel.h
+PUB_HEADERS += $$INCDIR/ircmessagelog.h
 PUB_HEADERS += $$INCDIR/ircmodel.h
+PUB_HEADERS += $$INCDIR/ircsnapshot.h
 PUB_HEADERS += $$INCDIR/ircuser.h
 PUB_HEADERS += $$INCDIR/ircusermodel.h
 
 PRIV_HEADERS  = $$INCDIR/ircbuffer_p.h
 PRIV_HEADERS += $$INCDIR/ircbuffermodel_p.h
+PRIV_HEADERS += $$INCDIR/ircbuffertracker_p.h
 PRIV_HEADERS += $$INCDIR/ircchannel_p.h
+PRIV_HEADERS += $$INCDIR/ircfiltermodel_p.h
+PRIV_HEADERS += $$INCDIR/ircmessagelog_p.h
+PRIV_HEADERS += $$INCDIR/ircmonitor_p.h
+PRIV_HEADERS += $$INCDIR/ircsnapshot_p.h
+PRIV_HEADERS += $$INCDIR/ircsort_p.h
 PRIV_HEADERS += $$INCDIR/ircuser_p.h
 PRIV_HEADERS += $$INCDIR/ircusermodel_p.h
 
@@ -35,6 +47,10 @@ HEADERS += $$PRIV_HEADERS
 SOURCES += $$PWD/ircbuffer.cpp
 SOURCES += $$PWD/ircbuffermodel.cpp
 SOURCES += $$PWD/ircchannel.cpp
+SOURCES += $$PWD/ircfiltermodel.cpp
+SOURCES += $$PWD/ircmessagelog.cpp
 SOURCES += $$PWD/ircmodel.cpp
+SOURCES += $$PWD/ircmonitor.cpp
+SOURCES += $$PWD/ircsnapshot.cpp
 SOURCES += $$PWD/ircuser.cpp
 SOURCES += $$PWD/ircusermodel.cpp
@@ -453,6 +453,52 @@ void IrcCommandParser::setChannels(const QStringList& channels)
     }
 }
 
+/*!
+    \since 3.7
+
+    Adds \a channels to the list of available channels.
+
+    This slot is meant to be connected to IrcBufferModel::channelsAdded(),
+    so that the whole list is not copied on every change:
+
+    \code
+    connect(model, SIGNAL(channelsAdded(QStringList)), parser, SLOT(addChannels(QStringList)));
+    connect(model, SIGNAL(channelsRemoved(QStringList)), parser, SLOT(removeChannels(QStringList)));
+    \endcode
+
+    \sa removeChannels(), channels
+ */
+void IrcCommandParser::addChannels(const QStringList& channels)
+{
+    Q_D(IrcCommandParser);
+    bool changed = false;
+    foreach (const QString& channel, channels) {
+        if (!d->channels.contains(channel)) {
+            d->channels += channel;
+            changed = true;
+        }
+    }
+    if (changed)
+        emit channelsChanged(d->channels);
+}
+
+/*!
+    \since 3.7
+
+    Removes \a channels from the list of available channels.
+
+    \sa addChannels(), channels
+ */
+void IrcCommandParser::removeChannels(const QStringList& channels)
+{
+    Q_D(IrcCommandParser);
+    bool changed = false;
+    foreach (const QString& channel, channels)
+        changed |= d->channels.removeOne(channel);
+    if (changed)
+        emit channelsChanged(d->channels);
+}
+
 /*!
     This property holds the current target.
 
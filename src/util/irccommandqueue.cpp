@@ -46,6 +46,15 @@ static const int DEFAULT_INTERVAL = 2;
     \class IrcCommandQueue irccommandqueue.h <IrcCommandQueue>
     \ingroup util
     \brief Provides a flood protection queue for commands.
+
+    \section backpressure Backpressure
+
+    In addition to flood protection, the queue can bound the amount of
+    data buffered by the underlying \ref IrcConnection::socket "socket".
+    When a \ref highWatermark "high watermark" is set and the amount of
+    unwritten bytes reaches it, the queue becomes \ref congested and holds
+    back further commands until the socket has written its buffer down to
+    the \ref lowWatermark "low watermark".
  */
 
 /*!
@@ -54,6 +63,14 @@ static const int DEFAULT_INTERVAL = 2;
     This signal is emitted when the queue \a size has changed.
  */
 
+/*!
+    \since 3.7
+    \fn void IrcCommandQueue::congestedChanged(bool congested)
+
+    This signal is emitted when the queue becomes \a congested,
+    or when it has recovered from congestion.
+ */
+
 #ifndef IRC_DOXYGEN
 IrcCommandQueuePrivate::IrcCommandQueuePrivate() :  batch(DEFAULT_BATCH), interval(DEFAULT_INTERVAL)
 {
@@ -64,7 +81,7 @@ bool IrcCommandQueuePrivate::commandFilter(IrcCommand* cmd)
     Q_Q(IrcCommandQueue);
     if (cmd->type() == IrcCommand::Quit) {
         _irc_sendBatch(true);
-    } else if (interval > 0 && !cmd->parent() && connection->isConnected()) {
+    } else if (!cmd->parent() && connection->isConnected() && (interval > 0 || updateCongestion())) {
         cmd->setParent(q);
         commands.enqueue(cmd);
         emit q->sizeChanged(commands.size());
@@ -74,9 +91,24 @@ bool IrcCommandQueuePrivate::commandFilter(IrcCommand* cmd)
     return false;
 }
 
+bool IrcCommandQueuePrivate::commandValueFilter(IrcCommandValue* cmd)
+{
+    Q_Q(IrcCommandQueue);
+    if (cmd->type() == IrcCommand::Quit) {
+        _irc_sendBatch(true);
+    } else if (connection->isConnected() && (interval > 0 || updateCongestion())) {
+        // only queued commands need to be materialized
+        commands.enqueue(cmd->toCommand(q));
+        emit q->sizeChanged(commands.size());
+        _irc_updateTimer();
+        return true;
+    }
+    return false;
+}
+
 void IrcCommandQueuePrivate::_irc_updateTimer()
 {
-    if (connection && interval > 0 && !commands.isEmpty() && connection->isConnected()) {
+    if (connection && interval > 0 && !congested && !commands.isEmpty() && connection->isConnected()) {
         timer.setInterval(interval * 1000);
         if (!timer.isActive())
             timer.start();
@@ -90,8 +122,9 @@ void IrcCommandQueuePrivate::_irc_sendBatch(bool force)
 {
     Q_Q(IrcCommandQueue);
     if (!commands.isEmpty()) {
-        int i = batch;
-        while ((force || --i >= 0) && !commands.isEmpty()) {
+        // without an interval, commands are queued only due to congestion
+        int i = interval > 0 ? batch : commands.size();
+        while ((force || --i >= 0) && !commands.isEmpty() && (force || !updateCongestion())) {
             IrcCommand* cmd = commands.dequeue();
             if (cmd) {
                 connection->sendCommand(cmd);
@@ -102,6 +135,54 @@ void IrcCommandQueuePrivate::_irc_sendBatch(bool force)
     }
     _irc_updateTimer();
 }
+
+void IrcCommandQueuePrivate::_irc_updateSocket()
+{
+    Q_Q(IrcCommandQueue);
+    QAbstractSocket* current = connection ? connection->socket() : nullptr;
+    if (socket != current) {
+        if (socket)
+            QObject::disconnect(socket, SIGNAL(bytesWritten(qint64)), q, SLOT(_irc_bytesWritten()));
+        socket = current;
+        if (socket)
+            QObject::connect(socket, SIGNAL(bytesWritten(qint64)), q, SLOT(_irc_bytesWritten()));
+    }
+    updateCongestion();
+}
+
+void IrcCommandQueuePrivate::_irc_bytesWritten()
+{
+    if (congested && !updateCongestion()) {
+        if (interval > 0)
+            _irc_updateTimer();
+        else
+            _irc_sendBatch();
+    }
+}
+
+bool IrcCommandQueuePrivate::updateCongestion()
+{
+    if (highWatermark > 0 && socket && socket->state() == QAbstractSocket::ConnectedState) {
+        const qint64 pending = socket->bytesToWrite();
+        if (!congested && pending >= highWatermark)
+            setCongested(true);
+        else if (congested && pending <= lowWatermark)
+            setCongested(false);
+    } else if (congested) {
+        setCongested(false);
+    }
+    return congested;
+}
+
+void IrcCommandQueuePrivate::setCongested(bool value)
+{
+    Q_Q(IrcCommandQueue);
+    if (congested != value) {
+        congested = value;
+        _irc_updateTimer();
+        emit q->congestedChanged(value);
+    }
+}
 #endif // IRC_DOXYGEN
 
 /*!
@@ -188,6 +269,95 @@ int IrcCommandQueue::size() const
     return d->commands.size();
 }
 
+/*!
+    \since 3.7
+
+    This property holds the high watermark in bytes.
+
+    When the amount of data buffered by the underlying socket, see
+    QAbstractSocket::bytesToWrite(), reaches the high watermark, the
+    queue becomes \ref congested and stops sending commands.
+
+    The default value is \c 0. A value equal to or less than \c 0
+    disables congestion control.
+
+    \par Access functions:
+    \li int <b>highWatermark</b>() const
+    \li void <b>setHighWatermark</b>(int bytes)
+
+    \sa lowWatermark, congested
+ */
+int IrcCommandQueue::highWatermark() const
+{
+    Q_D(const IrcCommandQueue);
+    return d->highWatermark;
+}
+
+void IrcCommandQueue::setHighWatermark(int bytes)
+{
+    Q_D(IrcCommandQueue);
+    if (d->highWatermark != bytes) {
+        d->highWatermark = bytes;
+        d->_irc_bytesWritten();
+    }
+}
+
+/*!
+    \since 3.7
+
+    This property holds the low watermark in bytes.
+
+    A \ref congested queue resumes sending commands when the amount
+    of data buffered by the underlying socket drops to the low watermark.
+
+    The default value is \c 0 i.e. the socket buffer must be fully written.
+
+    \par Access functions:
+    \li int <b>lowWatermark</b>() const
+    \li void <b>setLowWatermark</b>(int bytes)
+
+    \sa highWatermark, congested
+ */
+int IrcCommandQueue::lowWatermark() const
+{
+    Q_D(const IrcCommandQueue);
+    return d->lowWatermark;
+}
+
+void IrcCommandQueue::setLowWatermark(int bytes)
+{
+    Q_D(IrcCommandQueue);
+    if (d->lowWatermark != bytes) {
+        d->lowWatermark = bytes;
+        d->_irc_bytesWritten();
+    }
+}
+
+/*!
+    \since 3.7
+
+    This property holds whether the queue is congested.
+
+    A congested queue holds back all commands, regardless of the
+    \ref interval, until the underlying socket has written its
+    buffer down to the \ref lowWatermark "low watermark".
+
+    \note A \c QUIT command and flush() bypass congestion control.
+
+    \par Access function:
+    \li bool <b>isCongested</b>() const
+
+    \par Notifier signal:
+    \li void <b>congestedChanged</b>(bool congested)
+
+    \sa highWatermark, lowWatermark
+ */
+bool IrcCommandQueue::isCongested() const
+{
+    Q_D(const IrcCommandQueue);
+    return d->congested;
+}
+
 /*!
     This property holds the associated connection.
 
@@ -207,15 +377,18 @@ void IrcCommandQueue::setConnection(IrcConnection* connection)
     if (d->connection != connection) {
         if (d->connection) {
             d->connection->removeCommandFilter(d);
+            disconnect(d->connection, SIGNAL(connected()), this, SLOT(_irc_updateSocket()));
             disconnect(d->connection, SIGNAL(connected()), this, SLOT(_irc_sendBatch()));
             disconnect(d->connection, SIGNAL(disconnected()), this, SLOT(_irc_updateTimer()));
         }
         d->connection = connection;
         if (connection) {
             connection->installCommandFilter(d);
+            connect(connection, SIGNAL(connected()), this, SLOT(_irc_updateSocket()));
             connect(connection, SIGNAL(connected()), this, SLOT(_irc_sendBatch()));
             connect(connection, SIGNAL(disconnected()), this, SLOT(_irc_updateTimer()));
         }
+        d->_irc_updateSocket();
         d->_irc_updateTimer();
     }
 }
@@ -31,11 +31,15 @@
 #include "ircconnection.h"
 #include "ircmessage.h"
 #include "irccommand.h"
-#include <QDateTime>
+#include <QAbstractSocket>
+#include <climits>
 
 IRC_BEGIN_NAMESPACE
 
 static const int DEFAULT_INTERVAL = 60;
+static const int ADAPTIVE_FACTOR = 4;
+static const int MIN_PERIOD = 1000;
+static const qint64 DEGRADED_LAG = 500;
 
 /*!
     \file irclagtimer.h
@@ -47,6 +51,11 @@ static const int DEFAULT_INTERVAL = 60;
     \ingroup util
     \brief Provides a timer for measuring lag.
 
+    IrcLagTimer pings the server every \ref interval "interval", and measures
+    the round-trip time on a monotonic clock, so that adjusting the system
+    time does not show up as lag. When \ref adaptive "adaptive", only idle
+    connections are pinged, and the interval adapts to the link quality.
+
     \note IrcLagTimer relies on functionality introduced in Qt 4.7.0, and is
           therefore not functional when built against earlier versions of Qt.
  */
@@ -60,10 +69,14 @@ static const int DEFAULT_INTERVAL = 60;
 #ifndef IRC_DOXYGEN
 IrcLagTimerPrivate::IrcLagTimerPrivate() :  interval(DEFAULT_INTERVAL)
 {
+#if QT_VERSION >= 0x040700
+    clock.start();
+#endif // QT_VERSION
 }
 
 bool IrcLagTimerPrivate::messageFilter(IrcMessage* msg)
 {
+    _irc_dataReceived();
     if (msg->type() == IrcMessage::Pong)
         return processPongReply(static_cast<IrcPongMessage*>(msg));
     return false;
@@ -77,8 +90,11 @@ bool IrcLagTimerPrivate::processPongReply(IrcPongMessage* msg)
         bool ok = false;
         qint64 timestamp = msg->argument().mid(8).toLongLong(&ok);
         if (ok) {
-            --pendingPings;
-            updateLag(QDateTime::currentMSecsSinceEpoch() - timestamp);
+            pendingPings = qMax(0, pendingPings - 1);
+            const qint64 value = clock.elapsed() - timestamp;
+            if (adaptive)
+                updatePeriod(value);
+            updateLag(value);
             return true;
         }
     }
@@ -90,21 +106,42 @@ void IrcLagTimerPrivate::_irc_connected()
 {
 #if QT_VERSION >= 0x040700
     pendingPings = 0;
+    period = baseInterval();
+    received = clock.elapsed();
     if (interval > 0)
-        timer.start();
+        timer.start(period);
 #endif // QT_VERSION
 }
 
 void IrcLagTimerPrivate::_irc_pingServer()
 {
 #if QT_VERSION >= 0x040700
+    const qint64 now = clock.elapsed();
+    if (adaptive) {
+        if (pendingPings > 0) {
+            // an unanswered ping: probe more often until the link recovers
+            period = qMax(MIN_PERIOD, baseInterval() / ADAPTIVE_FACTOR);
+        } else if (now - received < period) {
+            // recent traffic already proves that the connection is alive;
+            // the very coarse timer rounds to whole seconds, so a shorter
+            // remainder would fire right away and re-arm in a loop
+            timer.start(qMax(MIN_PERIOD, period - static_cast<int>(now - received)));
+            return;
+        }
+        timer.start(period);
+    }
+
     // TODO: configurable format?
-    QString cmd = QString("PING communi/%1").arg(QDateTime::currentMSecsSinceEpoch());
+    QString cmd = QString("PING communi/%1").arg(now);
     connection->sendData(cmd.toUtf8());
-    qint64 pingLag = pendingPings * interval * 1000ll;
+    if (pendingPings == 0)
+        pinged = now;
+    qint64 pingLag = pendingPings > 0 ? now - pinged : 0;
     if (lag > -1 && pingLag > lag)
         updateLag(pingLag);
     ++pendingPings;
+    if (timeout > 0 && !deadline.isActive())
+        deadline.start(timeout * 1000);
 #endif // QT_VERSION
 }
 
@@ -115,14 +152,49 @@ void IrcLagTimerPrivate::_irc_disconnected()
     pendingPings = 0;
     if (timer.isActive())
         timer.stop();
+    if (deadline.isActive())
+        deadline.stop();
+#endif // QT_VERSION
+}
+
+void IrcLagTimerPrivate::_irc_updateSocket()
+{
+    Q_Q(IrcLagTimer);
+    QAbstractSocket* current = connection ? connection->socket() : nullptr;
+    if (socket != current) {
+        if (socket)
+            QObject::disconnect(socket, SIGNAL(readyRead()), q, SLOT(_irc_dataReceived()));
+        socket = current;
+        // in firehose mode, most lines bypass the message filters
+        if (socket)
+            QObject::connect(socket, SIGNAL(readyRead()), q, SLOT(_irc_dataReceived()));
+    }
+}
+
+void IrcLagTimerPrivate::_irc_dataReceived()
+{
+    // any traffic proves that the connection is alive
+    if (deadline.isActive())
+        deadline.stop();
+#if QT_VERSION >= 0x040700
+    received = clock.elapsed();
 #endif // QT_VERSION
 }
 
+void IrcLagTimerPrivate::_irc_timeout()
+{
+    // abort instead of close, so that the connection reconnects
+    if (connection && connection->socket() && connection->isActive())
+        connection->socket()->abort();
+}
+
 void IrcLagTimerPrivate::updateTimer()
 {
 #if QT_VERSION >= 0x040700
     if (connection && interval > 0) {
-        timer.setInterval(interval * 1000);
+        period = baseInterval();
+        timer.setSingleShot(adaptive);
+        timer.setInterval(period);
         if (!timer.isActive() && connection->isConnected())
             timer.start();
     } else {
@@ -142,6 +214,24 @@ void IrcLagTimerPrivate::updateLag(qint64 value)
         emit q->lagChanged(lag);
     }
 }
+
+void IrcLagTimerPrivate::updatePeriod(qint64 value)
+{
+    const int base = baseInterval();
+    if (lag > -1 && value > lag + qMax(lag / 2, DEGRADED_LAG)) {
+        // degraded: tighten to catch a dying link early
+        period = qMax(MIN_PERIOD, base / ADAPTIVE_FACTOR);
+    } else {
+        // stable: back off up to a multiple of the interval
+        const qint64 max = qMin<qint64>(INT_MAX, qint64(base) * ADAPTIVE_FACTOR);
+        period = static_cast<int>(qMin<qint64>(max, qMax(qint64(base), qint64(period) * 2)));
+    }
+}
+
+int IrcLagTimerPrivate::baseInterval() const
+{
+    return static_cast<int>(qBound<qint64>(0, interval * 1000ll, INT_MAX));
+}
 #endif // IRC_DOXYGEN
 
 /*!
@@ -154,7 +244,13 @@ IrcLagTimer::IrcLagTimer(QObject* parent) : QObject(parent), d_ptr(new IrcLagTim
 {
     Q_D(IrcLagTimer);
     d->q_ptr = this;
+#if QT_VERSION >= 0x050000
+    // second accuracy is plenty, and lets the timers of many connections coalesce
+    d->timer.setTimerType(Qt::VeryCoarseTimer);
+#endif // QT_VERSION
     connect(&d->timer, SIGNAL(timeout()), this, SLOT(_irc_pingServer()));
+    d->deadline.setSingleShot(true);
+    connect(&d->deadline, SIGNAL(timeout()), this, SLOT(_irc_timeout()));
     setConnection(qobject_cast<IrcConnection*>(parent));
 }
 
@@ -186,15 +282,19 @@ void IrcLagTimer::setConnection(IrcConnection* connection)
             d->connection->removeMessageFilter(d);
             disconnect(d->connection, SIGNAL(connected()), this, SLOT(_irc_connected()));
             disconnect(d->connection, SIGNAL(disconnected()), this, SLOT(_irc_disconnected()));
+            disconnect(d->connection, SIGNAL(connected()), this, SLOT(_irc_updateSocket()));
         }
         d->connection = connection;
         if (connection) {
             connection->installMessageFilter(d);
             connect(connection, SIGNAL(connected()), this, SLOT(_irc_connected()));
             connect(connection, SIGNAL(disconnected()), this, SLOT(_irc_disconnected()));
+            connect(connection, SIGNAL(connected()), this, SLOT(_irc_updateSocket()));
         }
+        d->_irc_updateSocket();
         d->updateLag(-1);
         d->updateTimer();
+        d->deadline.stop();
     }
 }
 
@@ -244,6 +344,82 @@ void IrcLagTimer::setInterval(int seconds)
     }
 }
 
+/*!
+    \since 3.7
+
+    This property holds the dead connection timeout in seconds.
+
+    When positive, the connection is considered dead if nothing at all
+    is received within the timeout after a lag measurement ping was sent.
+    A dead connection is aborted, so that the connection reconnects
+    according to its \ref IrcConnection::reconnectDelay "reconnect delay".
+
+    Pings are sent every \ref interval "interval", so the timeout has no
+    effect when lag measurement is disabled. Combined with
+    IrcConnection::keepAliveInterval, a silently dropped link is detected
+    both on the TCP level and on the IRC level, whichever comes first.
+
+    The default value is \c 0 seconds, which disables the timeout.
+
+    \par Access functions:
+    \li int <b>timeout</b>() const
+    \li void <b>setTimeout</b>(int seconds)
+ */
+int IrcLagTimer::timeout() const
+{
+    Q_D(const IrcLagTimer);
+    return d->timeout;
+}
+
+void IrcLagTimer::setTimeout(int seconds)
+{
+    Q_D(IrcLagTimer);
+    d->timeout = qMax(0, seconds);
+    if (d->timeout == 0)
+        d->deadline.stop();
+}
+
+/*!
+    \since 3.7
+
+    This property holds whether the ping interval is adaptive.
+
+    An adaptive lag timer treats any data received from the server as
+    proof that the connection is alive, and only pings the server once
+    the connection has been idle for the current interval. The lag is
+    therefore measured on idle connections only. The lag timer watches the
+    \ref IrcConnection::socket "socket" for received data, so this includes
+    the lines delivered in \ref IrcConnection::setFirehose() "firehose mode",
+    which bypass message filters.
+
+    The current interval starts at \ref interval "interval". While the
+    measured lag is stable, it doubles after each reply, up to four times
+    the interval. When the lag rises sharply or a ping goes unanswered, it
+    drops to a quarter of the interval, but not below one second. This
+    keeps the pings and timer wake-ups of a large number of healthy
+    connections at a minimum, and detects a degrading link early.
+
+    The default value is \c false.
+
+    \par Access functions:
+    \li bool <b>isAdaptive</b>() const
+    \li void <b>setAdaptive</b>(bool adaptive)
+ */
+bool IrcLagTimer::isAdaptive() const
+{
+    Q_D(const IrcLagTimer);
+    return d->adaptive;
+}
+
+void IrcLagTimer::setAdaptive(bool adaptive)
+{
+    Q_D(IrcLagTimer);
+    if (d->adaptive != adaptive) {
+        d->adaptive = adaptive;
+        d->updateTimer();
+    }
+}
+
 #include "moc_irclagtimer.cpp"
 #include "moc_irclagtimer_p.cpp"
 
@@ -0,0 +1,809 @@
+/*
+  Copyright (C) 2008-2020 The Communi Project
+
+  You may use this file under the terms of BSD license as follows:
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of the copyright holder nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR
+  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ircsearchindex.h"
+#include "ircsearchindex_p.h"
+#include "ircbuffermodel.h"
+#include "ircmessage.h"
+#include "ircbuffer.h"
+#include <QDir>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+IRC_BEGIN_NAMESPACE
+
+/*!
+    \file ircsearchindex.h
+    \brief \#include &lt;IrcSearchIndex&gt;
+ */
+
+/*!
+    \class IrcSearchIndex ircsearchindex.h <IrcSearchIndex>
+    \ingroup util
+    \brief Provides a full-text search index over buffer messages.
+    \since 3.7
+
+    IrcSearchIndex maintains an inverted index of the messages that are
+    added to it. When assigned a \ref model "model", it indexes every
+    message that the buffers of the model receive, as they arrive.
+    The index is typically kept in the same directory as an IrcMessageLog,
+    so that the messages found can be loaded from the log.
+
+    \code
+    IrcSearchIndex* index = new IrcSearchIndex(this);
+    index->setDirectory(logDirectory);
+    index->setModel(bufferModel);
+
+    foreach (const IrcSearchResult& result, index->search("\"release notes\" nick:jpnurmi")) {
+        IrcMessage* message = messageLog->findMessage(result.buffer(), result.msgid(), connection);
+        // ...
+    }
+    \endcode
+
+    Each result carries the \c msgid tag of the message, when the server
+    provides one, and the time stamp of the message, so that the message
+    can be loaded from the log.
+
+    The content of private messages, notices, topic changes, and the reasons
+    of parts, quits and kicks are indexed. The content is converted to plain
+    text with IrcTextFormat::toPlainText(), and split into case-folded words
+    of letters and numbers.
+
+    \section query Query syntax
+
+    A query consists of clauses separated by white space. A message
+    matches when it matches all of the clauses:
+    \li \c word - the message contains the word.
+    \li \c prefix* - the message contains a word that starts with the prefix.
+    \li \c "a phrase" - the message contains the words in this order.
+    \li \c nick:name - the message is from \c name.
+    \li \c in:buffer - the message is in \c buffer.
+
+    Words, prefixes and phrases are case insensitive, and names compare
+    as the CASEMAPPING of the network of the model. Multiple \c nick:
+    or \c in: clauses match any of the given names.
+
+    \section persistence Persistence
+
+    When a \ref directory "directory" is set, the index is persisted to the
+    \c search.idx file in the directory. The file is append-only: indexing
+    a message appends its words as term identifiers, and new words and names
+    to a string table. Writes are buffered and flushed when the event loop
+    returns, or explicitly with flush(). A record left partially written by
+    a crash is discarded when the index is loaded.
+
+    The whole index is held in memory, with the postings of each word sorted
+    by message and position, so queries are answered by merging sorted lists
+    without touching the disk.
+
+    \sa IrcMessageLog, IrcTextFormat
+ */
+
+/*!
+    \class IrcSearchResult ircsearchindex.h <IrcSearchIndex>
+    \ingroup util
+    \brief Describes a message found by IrcSearchIndex.
+    \since 3.7
+
+    \sa IrcSearchIndex::search()
+ */
+
+/*!
+    \fn QString IrcSearchResult::buffer() const
+
+    Returns the title of the buffer the message was in.
+ */
+
+/*!
+    \fn QString IrcSearchResult::nick() const
+
+    Returns the nick the message was from, if any.
+ */
+
+/*!
+    \fn QDateTime IrcSearchResult::timeStamp() const
+
+    Returns the time stamp of the message.
+
+    A message without a \ref msgid() "msgid" can be loaded from
+    the log by its time stamp.
+
+    \sa IrcMessageLog::messages()
+ */
+
+/*!
+    \fn QString IrcSearchResult::msgid() const
+
+    Returns the \c msgid tag of the message, if any.
+
+    The message can be loaded from the log with IrcMessageLog::findMessage().
+ */
+
+/*!
+    \fn bool IrcSearchResult::isValid() const
+
+    Returns \c true if the result refers to a message.
+ */
+
+#ifndef IRC_DOXYGEN
+static const char INDEX_HEADER[] = "IRCS\x01";
+static const int INDEX_HEADER_SIZE = 5;
+static const int MAX_TERM_LENGTH = 64;
+
+enum IrcSearchRecord { TermRecord = 'T', StringRecord = 'S', DocumentRecord = 'D', TaggedDocumentRecord = 'M' };
+
+static void irc_write_varint(QByteArray* out, quint64 value)
+{
+    while (value >= 0x80) {
+        out->append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out->append(static_cast<char>(value));
+}
+
+static bool irc_read_varint(const char** data, const char* end, quint64* value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 64 && *data < end; shift += 7) {
+        const uchar byte = static_cast<uchar>(*(*data)++);
+        *value |= static_cast<quint64>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void irc_write_string(QByteArray* out, char type, const QString& str)
+{
+    const QByteArray utf8 = str.toUtf8();
+    out->append(type);
+    irc_write_varint(out, static_cast<quint64>(utf8.size()));
+    out->append(utf8);
+}
+
+static bool irc_read_string(const char** data, const char* end, QString* str)
+{
+    quint64 length = 0;
+    if (!irc_read_varint(data, end, &length) || length > static_cast<quint64>(end - *data))
+        return false;
+    *str = QString::fromUtf8(*data, static_cast<int>(length));
+    *data += length;
+    return true;
+}
+
+static QVector<quint32> irc_intersect(const QVector<quint32>& a, const QVector<quint32>& b)
+{
+    QVector<quint32> result;
+    std::set_intersection(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(), std::back_inserter(result));
+    return result;
+}
+
+static bool irc_shorter(const QVector<quint32>& a, const QVector<quint32>& b)
+{
+    return a.count() < b.count();
+}
+
+QStringList IrcSearchIndexPrivate::tokenize(const QString& text)
+{
+    QStringList tokens;
+    const QString folded = text.toCaseFolded();
+    const int length = folded.length();
+    int start = -1;
+    for (int i = 0; i <= length; ++i) {
+        const QChar c = i < length ? folded.at(i) : QChar();
+        const bool word = c.isLetterOrNumber() || c.isMark() || c.isSurrogate();
+        if (word && start == -1) {
+            start = i;
+        } else if (!word && start != -1) {
+            tokens += folded.mid(start, qMin(i - start, MAX_TERM_LENGTH));
+            start = -1;
+        }
+    }
+    return tokens;
+}
+
+IrcSearchQuery IrcSearchIndexPrivate::parseQuery(const QString& query)
+{
+    IrcSearchQuery parsed;
+    const int length = query.length();
+    int i = 0;
+    while (i < length) {
+        if (query.at(i).isSpace()) {
+            ++i;
+            continue;
+        }
+        if (query.at(i) == QLatin1Char('"')) {
+            int end = query.indexOf(QLatin1Char('"'), i + 1);
+            if (end == -1)
+                end = length;
+            const QStringList phrase = tokenize(query.mid(i + 1, end - i - 1));
+            if (!phrase.isEmpty())
+                parsed.phrases += phrase;
+            i = end + 1;
+            continue;
+        }
+        int end = i;
+        while (end < length && !query.at(end).isSpace())
+            ++end;
+        const QString word = query.mid(i, end - i);
+        i = end;
+
+        if (word.startsWith(QLatin1String("nick:"), Qt::CaseInsensitive)) {
+            if (word.length() > 5)
+                parsed.nicks += word.mid(5).toLower();
+        } else if (word.startsWith(QLatin1String("in:"), Qt::CaseInsensitive)) {
+            if (word.length() > 3)
+                parsed.buffers += word.mid(3).toLower();
+        } else if (word.endsWith(QLatin1Char('*'))) {
+            QStringList tokens = tokenize(word);
+            if (!tokens.isEmpty()) {
+                parsed.prefixes += tokens.takeLast();
+                if (!tokens.isEmpty())
+                    parsed.phrases += tokens;
+            }
+        } else {
+            // punctuated words, such as "foo-bar", are phrases
+            const QStringList tokens = tokenize(word);
+            if (!tokens.isEmpty())
+                parsed.phrases += tokens;
+        }
+    }
+    return parsed;
+}
+
+QVector<int> IrcSearchIndexPrivate::findStrings(const QString& str) const
+{
+    // the casemapping may differ from the one the strings were indexed with
+    QVector<int> ids;
+    const QString key = tracker.casemap(str);
+    for (int i = 0; i < strings.count(); ++i) {
+        if (tracker.casemap(strings.at(i)) == key)
+            ids += i;
+    }
+    return ids;
+}
+
+int IrcSearchIndexPrivate::addString(const QString& str)
+{
+    int id = stringIds.value(str, -1);
+    if (id == -1) {
+        id = strings.count();
+        strings += str;
+        stringIds.insert(str, id);
+    }
+    return id;
+}
+
+int IrcSearchIndexPrivate::addTerm(const QString& term)
+{
+    int id = terms.value(term, -1);
+    if (id == -1) {
+        id = postings.count();
+        postings.resize(id + 1);
+        terms.insert(term, id);
+    }
+    return id;
+}
+
+void IrcSearchIndexPrivate::addDocument(qint64 time, int buffer, int nick, const QString& msgid, const QVector<int>& tokens)
+{
+    const quint64 id = static_cast<quint64>(documents.count());
+    IrcSearchDocument document;
+    document.time = time;
+    document.buffer = buffer;
+    document.nick = nick;
+    document.msgid = msgid;
+    documents += document;
+    for (int pos = 0; pos < tokens.count(); ++pos)
+        postings[tokens.at(pos)] += (id << 32) | static_cast<quint32>(pos);
+}
+
+QVector<quint32> IrcSearchIndexPrivate::phraseDocuments(const QStringList& phrase) const
+{
+    // keys of the following words are shifted back to the position of the first
+    QVector<quint64> keys;
+    for (int i = 0; i < phrase.count(); ++i) {
+        const int term = terms.value(phrase.at(i), -1);
+        if (term == -1)
+            return QVector<quint32>();
+        const QVector<quint64>& list = postings.at(term);
+        if (i == 0) {
+            keys = list;
+            continue;
+        }
+        QVector<quint64> shifted;
+        shifted.reserve(list.count());
+        foreach (quint64 key, list) {
+            if ((key & 0xffffffff) >= static_cast<quint64>(i))
+                shifted += key - i;
+        }
+        QVector<quint64> matches;
+        std::set_intersection(keys.constBegin(), keys.constEnd(), shifted.constBegin(), shifted.constEnd(), std::back_inserter(matches));
+        keys.swap(matches);
+        if (keys.isEmpty())
+            break;
+    }
+
+    QVector<quint32> docs;
+    foreach (quint64 key, keys) {
+        const quint32 doc = static_cast<quint32>(key >> 32);
+        if (docs.isEmpty() || docs.last() != doc)
+            docs += doc;
+    }
+    return docs;
+}
+
+QVector<quint32> IrcSearchIndexPrivate::prefixDocuments(const QString& prefix) const
+{
+    QVector<quint32> docs;
+    for (QMap<QString, int>::const_iterator it = terms.lowerBound(prefix); it != terms.constEnd() && it.key().startsWith(prefix); ++it) {
+        foreach (quint64 key, postings.at(it.value()))
+            docs += static_cast<quint32>(key >> 32);
+    }
+    std::sort(docs.begin(), docs.end());
+    docs.erase(std::unique(docs.begin(), docs.end()), docs.end());
+    return docs;
+}
+
+bool IrcSearchIndexPrivate::open()
+{
+    if (directory.isEmpty() || !QDir().mkpath(directory))
+        return false;
+
+    const QString path = directory + QLatin1String("/search.idx");
+    qint64 valid = 0;
+    QFile existing(path);
+    if (existing.open(QIODevice::ReadOnly) && !load(existing.readAll(), &valid)) {
+        qWarning("IrcSearchIndex: discarding an invalid index: %s", qPrintable(path));
+        reset();
+        valid = 0;
+    }
+    existing.close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+    // drop a partial record left behind by a crash
+    if (file.size() != valid)
+        file.resize(valid);
+    file.seek(valid);
+    if (valid == 0)
+        file.write(INDEX_HEADER, INDEX_HEADER_SIZE);
+    return true;
+}
+
+void IrcSearchIndexPrivate::close()
+{
+    flushTimer.stop();
+    file.close();
+}
+
+bool IrcSearchIndexPrivate::load(const QByteArray& data, qint64* valid)
+{
+    *valid = 0;
+    if (data.isEmpty())
+        return true;
+    if (!data.startsWith(QByteArray::fromRawData(INDEX_HEADER, INDEX_HEADER_SIZE)))
+        return false;
+
+    const char* begin = data.constData();
+    const char* end = begin + data.size();
+    const char* p = begin + INDEX_HEADER_SIZE;
+    *valid = INDEX_HEADER_SIZE;
+
+    QVector<int> tokens;
+    while (p < end) {
+        const char type = *p++;
+        if (type == TermRecord || type == StringRecord) {
+            QString str;
+            if (!irc_read_string(&p, end, &str))
+                break;
+            // the documents refer to the strings by position
+            if (type == TermRecord) {
+                addTerm(str);
+            } else {
+                if (!stringIds.contains(str))
+                    stringIds.insert(str, strings.count());
+                strings += str;
+            }
+        } else if (type == DocumentRecord || type == TaggedDocumentRecord) {
+            quint64 time = 0, buffer = 0, nick = 0, count = 0;
+            if (!irc_read_varint(&p, end, &time) || !irc_read_varint(&p, end, &buffer) ||
+                !irc_read_varint(&p, end, &nick))
+                break;
+            QString msgid;
+            if (type == TaggedDocumentRecord && !irc_read_string(&p, end, &msgid))
+                break;
+            if (!irc_read_varint(&p, end, &count))
+                break;
+            if (buffer >= static_cast<quint64>(strings.count()) || nick > static_cast<quint64>(strings.count()) || count > static_cast<quint64>(end - p))
+                break;
+            tokens.resize(static_cast<int>(count));
+            bool ok = true;
+            for (int i = 0; ok && i < tokens.count(); ++i) {
+                quint64 term = 0;
+                ok = irc_read_varint(&p, end, &term) && term < static_cast<quint64>(postings.count());
+                tokens[i] = static_cast<int>(term);
+            }
+            if (!ok)
+                break;
+            // zigzag encoded
+            const qint64 msecs = static_cast<qint64>(time >> 1) ^ -static_cast<qint64>(time & 1);
+            addDocument(msecs, static_cast<int>(buffer), static_cast<int>(nick) - 1, msgid, tokens);
+        } else {
+            break;
+        }
+        *valid = p - begin;
+    }
+    return true;
+}
+
+void IrcSearchIndexPrivate::reset()
+{
+    documents.clear();
+    terms.clear();
+    postings.clear();
+    strings.clear();
+    stringIds.clear();
+}
+
+void IrcSearchIndexPrivate::scheduleFlush()
+{
+    if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void IrcSearchIndexPrivate::_irc_bufferAdded(IrcBuffer* buffer)
+{
+    Q_Q(IrcSearchIndex);
+    IrcBufferTracker::track(buffer, q);
+}
+
+void IrcSearchIndexPrivate::_irc_bufferRemoved(IrcBuffer* buffer)
+{
+    Q_Q(IrcSearchIndex);
+    IrcBufferTracker::untrack(buffer, q);
+}
+
+void IrcSearchIndexPrivate::_irc_messageReceived(IrcMessage* message)
+{
+    Q_Q(IrcSearchIndex);
+    IrcBuffer* buffer = qobject_cast<IrcBuffer*>(q->sender());
+    if (buffer)
+        q->add(buffer->title(), message);
+}
+#endif // IRC_DOXYGEN
+
+/*!
+    Constructs a new search index with \a parent.
+ */
+IrcSearchIndex::IrcSearchIndex(QObject* parent) : QObject(parent), d_ptr(new IrcSearchIndexPrivate)
+{
+    Q_D(IrcSearchIndex);
+    d->q_ptr = this;
+    d->flushTimer.setSingleShot(true);
+    d->flushTimer.setInterval(0);
+    connect(&d->flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+/*!
+    Destructs the search index, and flushes pending writes.
+ */
+IrcSearchIndex::~IrcSearchIndex()
+{
+}
+
+/*!
+    This property holds the directory of the index.
+
+    Setting a directory loads the index persisted in it, if any.
+    Without a directory, the index is kept in memory only.
+
+    \par Access functions:
+    \li QString <b>directory</b>() const
+    \li void <b>setDirectory</b>(const QString& directory)
+ */
+QString IrcSearchIndex::directory() const
+{
+    Q_D(const IrcSearchIndex);
+    return d->directory;
+}
+
+void IrcSearchIndex::setDirectory(const QString& directory)
+{
+    Q_D(IrcSearchIndex);
+    if (d->directory != directory) {
+        d->close();
+        d->reset();
+        d->directory = directory;
+        d->open();
+    }
+}
+
+/*!
+    This property holds the buffer model whose messages are indexed.
+
+    \par Access functions:
+    \li \ref IrcBufferModel* <b>model</b>() const
+    \li void <b>setModel</b>(\ref IrcBufferModel* model)
+ */
+IrcBufferModel* IrcSearchIndex::model() const
+{
+    Q_D(const IrcSearchIndex);
+    return d->tracker.model();
+}
+
+void IrcSearchIndex::setModel(IrcBufferModel* model)
+{
+    Q_D(IrcSearchIndex);
+    d->tracker.setModel(model, this);
+}
+
+/*!
+    This property holds the number of indexed messages.
+
+    \par Access function:
+    \li int <b>documentCount</b>() const
+ */
+int IrcSearchIndex::documentCount() const
+{
+    Q_D(const IrcSearchIndex);
+    return d->documents.count();
+}
+
+/*!
+    This property holds the number of distinct indexed words.
+
+    \par Access function:
+    \li int <b>termCount</b>() const
+ */
+int IrcSearchIndex::termCount() const
+{
+    Q_D(const IrcSearchIndex);
+    return d->postings.count();
+}
+
+/*!
+    Indexes \a message in \a buffer.
+
+    Returns \c true if the message was indexed, or \c false
+    if the message type is not indexed or it contains no words.
+ */
+bool IrcSearchIndex::add(const QString& buffer, IrcMessage* message)
+{
+    if (!message)
+        return false;
+
+    QString text;
+    switch (message->type()) {
+    case IrcMessage::Private: {
+        IrcPrivateMessage* msg = static_cast<IrcPrivateMessage*>(message);
+        if (msg->isRequest())
+            return false;
+        text = msg->content();
+        break;
+    }
+    case IrcMessage::Notice: {
+        IrcNoticeMessage* msg = static_cast<IrcNoticeMessage*>(message);
+        if (msg->isReply())
+            return false;
+        text = msg->content();
+        break;
+    }
+    case IrcMessage::Topic: {
+        IrcTopicMessage* msg = static_cast<IrcTopicMessage*>(message);
+        if (msg->isReply())
+            return false;
+        text = msg->topic();
+        break;
+    }
+    case IrcMessage::Part:
+        text = static_cast<IrcPartMessage*>(message)->reason();
+        break;
+    case IrcMessage::Quit:
+        text = static_cast<IrcQuitMessage*>(message)->reason();
+        break;
+    case IrcMessage::Kick:
+        text = static_cast<IrcKickMessage*>(message)->reason();
+        break;
+    default:
+        return false;
+    }
+    return add(buffer, message->nick(), text, message->timeStamp(), message->tags().value(QStringLiteral("msgid")).toString());
+}
+
+/*!
+    Indexes \a text from \a nick in \a buffer at \a timeStamp.
+
+    The text may contain IRC formatting codes. The optional \a msgid
+    is returned with the results, to locate the message in the log.
+
+    Returns \c true if the text was indexed, or \c false if it contains no words.
+ */
+bool IrcSearchIndex::add(const QString& buffer, const QString& nick, const QString& text, const QDateTime& timeStamp, const QString& msgid)
+{
+    Q_D(IrcSearchIndex);
+    if (buffer.isEmpty())
+        return false;
+
+    const QStringList words = IrcSearchIndexPrivate::tokenize(d->format.toPlainText(text));
+    if (words.isEmpty())
+        return false;
+
+    const bool persist = d->file.isOpen();
+    QByteArray record;
+
+    const int strings = d->strings.count();
+    const int bufferId = d->addString(buffer);
+    const int nickId = nick.isEmpty() ? -1 : d->addString(nick);
+    if (persist) {
+        for (int i = strings; i < d->strings.count(); ++i)
+            irc_write_string(&record, StringRecord, d->strings.at(i));
+    }
+
+    QVector<int> tokens;
+    tokens.reserve(words.count());
+    foreach (const QString& word, words) {
+        const int terms = d->postings.count();
+        tokens += d->addTerm(word);
+        if (persist && d->postings.count() > terms)
+            irc_write_string(&record, TermRecord, word);
+    }
+
+    const qint64 time = timeStamp.isValid() ? timeStamp.toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+    d->addDocument(time, bufferId, nickId, msgid, tokens);
+
+    if (persist) {
+        record.append(static_cast<char>(msgid.isEmpty() ? DocumentRecord : TaggedDocumentRecord));
+        irc_write_varint(&record, (static_cast<quint64>(time) << 1) ^ static_cast<quint64>(time >> 63));
+        irc_write_varint(&record, static_cast<quint64>(bufferId));
+        irc_write_varint(&record, static_cast<quint64>(nickId + 1));
+        if (!msgid.isEmpty()) {
+            const QByteArray utf8 = msgid.toUtf8();
+            irc_write_varint(&record, static_cast<quint64>(utf8.size()));
+            record.append(utf8);
+        }
+        irc_write_varint(&record, static_cast<quint64>(tokens.count()));
+        foreach (int token, tokens)
+            irc_write_varint(&record, static_cast<quint64>(token));
+        d->file.write(record);
+        d->scheduleFlush();
+    }
+    return true;
+}
+
+/*!
+    Returns at most \a limit messages that match \a query,
+    most recently indexed first.
+
+    See \ref query "query syntax".
+ */
+QList<IrcSearchResult> IrcSearchIndex::search(const QString& query, int limit) const
+{
+    return search(query, QDateTime(), QDateTime(), limit);
+}
+
+/*!
+    Returns at most \a limit messages that match \a query, with a time stamp
+    between \a from and \a to (inclusive), most recently indexed first.
+
+    An invalid \a from or \a to leaves the range open at that end.
+ */
+QList<IrcSearchResult> IrcSearchIndex::search(const QString& query, const QDateTime& from, const QDateTime& to, int limit) const
+{
+    Q_D(const IrcSearchIndex);
+    QList<IrcSearchResult> results;
+    if (limit <= 0)
+        return results;
+
+    const IrcSearchQuery parsed = IrcSearchIndexPrivate::parseQuery(query);
+
+    QVector<int> nicks;
+    foreach (const QString& nick, parsed.nicks)
+        nicks += d->findStrings(nick);
+    QVector<int> buffers;
+    foreach (const QString& buffer, parsed.buffers)
+        buffers += d->findStrings(buffer);
+    if ((!parsed.nicks.isEmpty() && nicks.isEmpty()) || (!parsed.buffers.isEmpty() && buffers.isEmpty()))
+        return results;
+
+    QVector<QVector<quint32> > lists;
+    foreach (const QStringList& phrase, parsed.phrases)
+        lists += d->phraseDocuments(phrase);
+    foreach (const QString& prefix, parsed.prefixes)
+        lists += d->prefixDocuments(prefix);
+
+    // a query of filters only scans all messages
+    const bool all = lists.isEmpty();
+    if (all && nicks.isEmpty() && buffers.isEmpty() && !from.isValid() && !to.isValid())
+        return results;
+
+    // intersect the shortest lists first
+    QVector<quint32> matches;
+    if (!all) {
+        std::sort(lists.begin(), lists.end(), irc_shorter);
+        matches = lists.first();
+        for (int i = 1; i < lists.count() && !matches.isEmpty(); ++i)
+            matches = irc_intersect(matches, lists.at(i));
+    }
+
+    const qint64 min = from.isValid() ? from.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+    const qint64 max = to.isValid() ? to.toMSecsSinceEpoch() : std::numeric_limits<qint64>::max();
+
+    int i = all ? d->documents.count() : matches.count();
+    while (--i >= 0 && results.count() < limit) {
+        const IrcSearchDocument& document = d->documents.at(all ? i : static_cast<int>(matches.at(i)));
+        if (document.time < min || document.time > max)
+            continue;
+        if (!nicks.isEmpty() && !nicks.contains(document.nick))
+            continue;
+        if (!buffers.isEmpty() && !buffers.contains(document.buffer))
+            continue;
+
+        IrcSearchResult result;
+        result.m_buffer = d->strings.at(document.buffer);
+        if (document.nick != -1)
+            result.m_nick = d->strings.at(document.nick);
+        result.m_timeStamp = QDateTime::fromMSecsSinceEpoch(document.time);
+        result.m_msgid = document.msgid;
+        results += result;
+    }
+    return results;
+}
+
+/*!
+    Writes pending changes to the index file.
+ */
+void IrcSearchIndex::flush()
+{
+    Q_D(IrcSearchIndex);
+    d->flushTimer.stop();
+    if (d->file.isOpen())
+        d->file.flush();
+}
+
+/*!
+    Removes all messages from the index, including the index file.
+ */
+void IrcSearchIndex::clear()
+{
+    Q_D(IrcSearchIndex);
+    d->reset();
+    if (d->file.isOpen()) {
+        d->flushTimer.stop();
+        d->file.resize(0);
+        d->file.seek(0);
+        d->file.write(INDEX_HEADER, INDEX_HEADER_SIZE);
+        d->file.flush();
+    }
+}
+
+#include "moc_ircsearchindex.cpp"
+
+IRC_END_NAMESPACE
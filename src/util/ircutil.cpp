@@ -54,6 +54,8 @@ namespace IrcUtil {
         qRegisterMetaType<IrcCompleter*>("IrcCompleter*");
         qRegisterMetaType<IrcLagTimer*>("IrcLagTimer*");
         qRegisterMetaType<IrcPalette*>("IrcPalette*");
+        qRegisterMetaType<IrcSearchIndex*>("IrcSearchIndex*");
+        qRegisterMetaType<IrcSearchResult>("IrcSearchResult");
         qRegisterMetaType<IrcTextFormat*>("IrcTextFormat*");
     }
 }
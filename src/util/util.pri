@@ -14,6 +14,7 @@ CONV_HEADERS += $$INCDIR/IrcCommandQueue
 CONV_HEADERS += $$INCDIR/IrcCompleter
 CONV_HEADERS += $$INCDIR/IrcLagTimer
 CONV_HEADERS += $$INCDIR/IrcPalette
+CONV_HEADERS += $$INCDIR/IrcSearchIndex
 CONV_HEADERS += $$INCDIR/IrcTextFormat
 CONV_HEADERS += $$INCDIR/IrcUtil
 
@@ -22,12 +23,14 @@ PUB_HEADERS += $$INCDIR/irccommandqueue.h
 PUB_HEADERS += $$INCDIR/irccompleter.h
 PUB_HEADERS += $$INCDIR/irclagtimer.h
 PUB_HEADERS += $$INCDIR/ircpalette.h
+PUB_HEADERS += $$INCDIR/ircsearchindex.h
 PUB_HEADERS += $$INCDIR/irctextformat.h
 PUB_HEADERS += $$INCDIR/ircutil.h
 
 PRIV_HEADERS  = $$INCDIR/irccommandparser_p.h
 PRIV_HEADERS += $$INCDIR/irccommandqueue_p.h
 PRIV_HEADERS += $$INCDIR/irclagtimer_p.h
+PRIV_HEADERS += $$INCDIR/ircsearchindex_p.h
 PRIV_HEADERS += $$INCDIR/irctoken_p.h
 
 HEADERS += $$PUB_HEADERS
@@ -38,6 +41,7 @@ SOURCES += $$PWD/irccommandqueue.cpp
 SOURCES += $$PWD/irccompleter.cpp
 SOURCES += $$PWD/irclagtimer.cpp
 SOURCES += $$PWD/ircpalette.cpp
+SOURCES += $$PWD/ircsearchindex.cpp
 SOURCES += $$PWD/irctextformat.cpp
 SOURCES += $$PWD/irctoken.cpp
 SOURCES += $$PWD/ircutil.cpp
@@ -8,13 +8,18 @@ TEMPLATE = subdirs
 SUBDIRS += irc
 SUBDIRS += ircconnection
 SUBDIRS += irccommand
+SUBDIRS += ircline
 SUBDIRS += ircmessage
+SUBDIRS += ircmessagering
 SUBDIRS += ircnetwork
+SUBDIRS += ircpipe
 
 # IrcModel
 SUBDIRS += ircbuffer
 SUBDIRS += ircbuffermodel
 SUBDIRS += ircchannel
+SUBDIRS += ircfiltermodel
+SUBDIRS += ircmessagelog
 SUBDIRS += ircuser
 SUBDIRS += ircusermodel
 
@@ -24,4 +29,5 @@ SUBDIRS += irccommandqueue
 SUBDIRS += irccompleter
 SUBDIRS += irclagtimer
 SUBDIRS += ircpalette
+SUBDIRS += ircsearchindex
 SUBDIRS += irctextformat
@@ -12,10 +12,17 @@
 #include "ircchannel.h"
 #include "irccommand.h"
 #include "ircbuffer.h"
+#include "ircusermodel.h"
+#include "ircuser.h"
+#include "ircsnapshot.h"
 #include "ircfilter.h"
 #include <QtTest/QtTest>
 #include "tst_ircclientserver.h"
 #include "tst_ircdata.h"
+#ifdef Q_OS_LINUX
+#include "ircbuffermodel_p.h"
+#include "ircmonitor_p.h"
+#endif // Q_OS_LINUX
 
 class tst_IrcBufferModel : public tst_IrcClientServer
 {
@@ -39,6 +46,12 @@ private slots:
     void testQML();
     void testWarnings();
     void testMonitor();
+    void testMonitorLimit();
+    void testNetsplit();
+    void testLazyUsers();
+    void testLazyNoImplicitNames();
+    void testHibernate();
+    void testSnapshot();
 };
 
 Q_DECLARE_METATYPE(QModelIndex)
@@ -312,12 +325,14 @@ void tst_IrcBufferModel::testClear()
     QSignalSpy countSpy(&model, SIGNAL(countChanged(int)));
     QSignalSpy buffersSpy(&model, SIGNAL(buffersChanged(QList<IrcBuffer*>)));
     QSignalSpy channelsSpy(&model, SIGNAL(channelsChanged(QStringList)));
+    QSignalSpy channelsRemovedSpy(&model, SIGNAL(channelsRemoved(QStringList)));
     QSignalSpy modelAboutToBeResetSpy(&model, SIGNAL(modelAboutToBeReset()));
     QSignalSpy modelResetSpy(&model, SIGNAL(modelReset()));
 
     QVERIFY(countSpy.isValid());
     QVERIFY(buffersSpy.isValid());
     QVERIFY(channelsSpy.isValid());
+    QVERIFY(channelsRemovedSpy.isValid());
     QVERIFY(modelAboutToBeResetSpy.isValid());
     QVERIFY(modelResetSpy.isValid());
 
@@ -357,6 +372,9 @@ void tst_IrcBufferModel::testClear()
     QCOMPARE(channelsSpy.count(), 1);
     QCOMPARE(channelsSpy.last().at(0).toStringList(), QStringList() << "#b");
 
+    QCOMPARE(channelsRemovedSpy.count(), 1);
+    QCOMPARE(channelsRemovedSpy.last().at(0).toStringList(), QStringList() << "#a");
+
     QCOMPARE(modelAboutToBeResetSpy.count(), 1);
     QCOMPARE(modelResetSpy.count(), 1);
 
@@ -1489,7 +1507,7 @@ void tst_IrcBufferModel::testMonitor()
 
     IrcBuffer* buffer = model.add("jirssi");
     QVERIFY(!buffer->isActive());
-    QCOMPARE(filter.commands.count(), 1);
+    QTRY_COMPARE(filter.commands.count(), 1);
     QCOMPARE(filter.commands.last(), QString("MONITOR + jirssi"));
 
     QVERIFY(waitForWritten(":card.freenode.net 730 * :jirssi!~jpnurmi@88.95.51.136"));
@@ -1499,7 +1517,7 @@ void tst_IrcBufferModel::testMonitor()
     QVERIFY(!buffer->isActive());
 
     model.remove("jirssi");
-    QCOMPARE(filter.commands.count(), 2);
+    QTRY_COMPARE(filter.commands.count(), 2);
     QCOMPARE(filter.commands.last(), QString("MONITOR - jirssi"));
 
     filter.commands.clear();
@@ -1507,9 +1525,376 @@ void tst_IrcBufferModel::testMonitor()
     // don't monitor channels
     buffer = model.add("#channel");
     QCOMPARE(model.channels(), QStringList() << "#channel");
+    QCoreApplication::processEvents();
     QVERIFY(filter.commands.isEmpty());
     delete buffer;
+    QCoreApplication::processEvents();
     QVERIFY(filter.commands.isEmpty());
+
+    // changes are packed into minimal diffs
+    model.add("alpha");
+    model.add("beta");
+    model.add("gamma");
+    model.remove("beta");
+    QTRY_COMPARE(filter.commands.count(), 1);
+    QCOMPARE(filter.commands.last(), QString("MONITOR + alpha,gamma"));
+
+    filter.commands.clear();
+    model.remove("alpha");
+    model.add("beta");
+    model.add("alpha");
+    QTRY_COMPARE(filter.commands.count(), 1);
+    QCOMPARE(filter.commands.last(), QString("MONITOR + beta"));
+
+    // the server rejects targets beyond its limit
+    filter.commands.clear();
+    QVERIFY(waitForWritten(":card.freenode.net 734 communi 2 beta :Monitor list is full."));
+    QCoreApplication::processEvents();
+    QVERIFY(filter.commands.isEmpty());
+
+    // removals make room for the rejected targets
+    model.remove("gamma");
+    QTRY_COMPARE(filter.commands.count(), 2);
+    QCOMPARE(filter.commands, QStringList() << "MONITOR - gamma" << "MONITOR + beta");
+
+    filter.commands.clear();
+    model.remove("alpha");
+    model.add("delta");
+    QTRY_COMPARE(filter.commands.count(), 2);
+    QCOMPARE(filter.commands, QStringList() << "MONITOR - alpha" << "MONITOR + delta");
+}
+
+void tst_IrcBufferModel::testMonitorLimit()
+{
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    QList<QStringList> lines = IrcMonitor::pack(QStringList() << "aaaa" << "bbbb" << "cccc" << "dd", 9, 0);
+    QCOMPARE(lines.count(), 2);
+    QCOMPARE(lines.at(0), QStringList() << "aaaa" << "bbbb");
+    QCOMPARE(lines.at(1), QStringList() << "cccc" << "dd");
+
+    lines = IrcMonitor::pack(QStringList() << "a" << "b" << "c", 510, 2);
+    QCOMPARE(lines.count(), 2);
+
+    IrcMonitor monitor;
+    monitor.setLimit(2);
+    QList<IrcCommand*> commands = monitor.update(QStringList() << "first" << "second" << "third");
+    QCOMPARE(commands.count(), 1);
+    QCOMPARE(commands.first()->toString(), QString("MONITOR + first,second"));
+    qDeleteAll(commands);
+
+    commands = monitor.update(QStringList() << "third" << "First" << "second");
+    QCOMPARE(commands.count(), 2);
+    QCOMPARE(commands.at(0)->toString(), QString("MONITOR - second"));
+    QCOMPARE(commands.at(1)->toString(), QString("MONITOR + third"));
+    qDeleteAll(commands);
+    QCOMPARE(monitor.targets(), QStringList() << "third" << "First");
+
+    // the targets compare as the CASEMAPPING of the network
+    monitor.reset();
+    monitor.setLimit(0);
+    commands = monitor.update(QStringList() << "nick[a]" << "NICK{A}");
+    QCOMPARE(commands.count(), 1);
+    QCOMPARE(commands.first()->toString(), QString("MONITOR + nick[a]"));
+    qDeleteAll(commands);
+    QVERIFY(monitor.contains("Nick{a}"));
+#endif // Q_OS_LINUX
+}
+
+void tst_IrcBufferModel::testNetsplit()
+{
+    IrcBufferModel model(connection);
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":irc.ser.ver 353 communi = #communi :communi aji @nenolod +jilles other"));
+    QVERIFY(waitForWritten(":irc.ser.ver 366 communi #communi :End of /NAMES list."));
+    QVERIFY(waitForWritten(":aji!a@a PRIVMSG communi :hi"));
+    QCOMPARE(model.count(), 2);
+
+    IrcChannel* channel = model.find("#communi")->toChannel();
+    QVERIFY(channel);
+    IrcBuffer* query = model.find("aji");
+    QVERIFY(query);
+
+    IrcUserModel users(channel);
+    QCOMPARE(users.count(), 5);
+
+    QSignalSpy splitSpy(&model, SIGNAL(netsplit(QString,QStringList)));
+    QSignalSpy joinSpy(&model, SIGNAL(netjoin(QString,QStringList)));
+    QSignalSpy namesSpy(&users, SIGNAL(namesChanged(QStringList)));
+    QSignalSpy removedSpy(&users, SIGNAL(removed(IrcUser*)));
+    QSignalSpy channelSpy(channel, SIGNAL(messageReceived(IrcMessage*)));
+    QSignalSpy querySpy(query, SIGNAL(messageReceived(IrcMessage*)));
+    QVERIFY(splitSpy.isValid());
+    QVERIFY(joinSpy.isValid());
+    QVERIFY(namesSpy.isValid());
+    QVERIFY(removedSpy.isValid());
+    QVERIFY(channelSpy.isValid());
+    QVERIFY(querySpy.isValid());
+
+    // IRCv3 batch
+    QVERIFY(waitForWritten(":irc.host BATCH +yXNAbvnRHTRBv netsplit irc.hub other.host"));
+    QVERIFY(waitForWritten("@batch=yXNAbvnRHTRBv :aji!a@a QUIT :irc.hub other.host"));
+    QVERIFY(waitForWritten("@batch=yXNAbvnRHTRBv :nenolod!a@a QUIT :irc.hub other.host"));
+    QVERIFY(waitForWritten("@batch=yXNAbvnRHTRBv :jilles!a@a QUIT :irc.hub other.host"));
+    QVERIFY(waitForWritten(":irc.host BATCH -yXNAbvnRHTRBv"));
+
+    QCOMPARE(splitSpy.count(), 1);
+    QCOMPARE(splitSpy.last().at(0).toString(), QString("irc.hub other.host"));
+    QCOMPARE(splitSpy.last().at(1).toStringList(), QStringList() << "aji" << "nenolod" << "jilles");
+    QCOMPARE(namesSpy.count(), 1);
+    QCOMPARE(removedSpy.count(), 3);
+    QCOMPARE(channelSpy.count(), 3);
+    QCOMPARE(querySpy.count(), 1);
+    QCOMPARE(users.count(), 2);
+    QCOMPARE(users.names(), QStringList() << "communi" << "other");
+
+    QVERIFY(waitForWritten(":irc.host BATCH +4lT8M netjoin irc.hub other.host"));
+    QVERIFY(waitForWritten("@batch=4lT8M :aji!a@a JOIN :#communi"));
+    QVERIFY(waitForWritten("@batch=4lT8M :jilles!a@a JOIN :#communi"));
+    QVERIFY(waitForWritten(":irc.host BATCH -4lT8M"));
+
+    QCOMPARE(joinSpy.count(), 1);
+    QCOMPARE(joinSpy.last().at(1).toStringList(), QStringList() << "aji" << "jilles");
+    QCOMPARE(namesSpy.count(), 2);
+    QCOMPARE(channelSpy.count(), 5);
+    QCOMPARE(users.count(), 4);
+
+    // heuristic detection is opt-in
+    model.setSplitDetectionEnabled(true);
+    QVERIFY(model.isSplitDetectionEnabled());
+    namesSpy.clear();
+    channelSpy.clear();
+
+    QVERIFY(waitForWritten(":aji!a@a QUIT :irc.hub other.host\r\n"
+                           ":jilles!a@a QUIT :irc.hub other.host\r\n"
+                           ":other!a@a QUIT :Quit: bye"));
+    QTRY_COMPARE(splitSpy.count(), 2);
+    QCOMPARE(splitSpy.last().at(1).toStringList(), QStringList() << "aji" << "jilles");
+    QCOMPARE(namesSpy.count(), 2); // split + regular quit
+    QCOMPARE(channelSpy.count(), 3);
+    QCOMPARE(users.names(), QStringList() << "communi");
+
+    // a regular quit that just looks like one
+    QVERIFY(waitForWritten(":nenolod!a@a JOIN :#communi"));
+    QVERIFY(waitForWritten(":nenolod!a@a QUIT :Quit: see you.later"));
+    QCOMPARE(users.names(), QStringList() << "communi");
+    QCOMPARE(splitSpy.count(), 2);
+}
+
+void tst_IrcBufferModel::testLazyUsers()
+{
+    IrcBufferModel model(connection);
+    model.setLazyUsersEnabled(true);
+    QVERIFY(model.isLazyUsersEnabled());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":irc.ser.ver 353 communi = #communi :communi @op +voice nick"));
+    QVERIFY(waitForWritten(":irc.ser.ver 366 communi #communi :End of /NAMES list."));
+
+    IrcChannel* channel = model.find("#communi")->toChannel();
+    QVERIFY(channel);
+    QVERIFY(channel->findChildren<IrcUser*>().isEmpty());
+
+    QVERIFY(waitForWritten(":joiner!a@a JOIN :#communi"));
+    QVERIFY(waitForWritten(":op!a@a MODE #communi +v nick"));
+    QVERIFY(waitForWritten(":op!a@a MODE #communi -o op"));
+    QVERIFY(waitForWritten(":voice!a@a NICK :speaker"));
+    QVERIFY(waitForWritten(":joiner!a@a PRIVMSG #communi :hi"));
+    QVERIFY(waitForWritten(":communi!communi@hidd.en PRIVMSG #communi :nick: hello"));
+    QVERIFY(waitForWritten(":op!a@a PART #communi"));
+    QVERIFY(channel->findChildren<IrcUser*>().isEmpty());
+
+    IrcUserModel users(channel);
+    users.setSortMethod(Irc::SortByActivity);
+    QCOMPARE(channel->findChildren<IrcUser*>().count(), 4);
+    QCOMPARE(users.count(), 4);
+    QCOMPARE(users.names(), QStringList() << "communi" << "joiner" << "nick" << "speaker");
+    QCOMPARE(users.titles(), QStringList() << "communi" << "+nick" << "joiner" << "+speaker");
+    QCOMPARE(users.find("nick")->mode(), QString("v"));
+
+    // materialized channels stay materialized
+    QVERIFY(waitForWritten(":late!a@a JOIN :#communi"));
+    QCOMPARE(users.count(), 5);
+    QVERIFY(users.contains("late"));
+}
+
+void tst_IrcBufferModel::testLazyNoImplicitNames()
+{
+    IrcBufferModel model(connection);
+    model.setLazyUsersEnabled(true);
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    QVERIFY(waitForWritten(":irc.ser.ver CAP communi ACK :draft/no-implicit-names"));
+    QVERIFY(connection->network()->isCapable("draft/no-implicit-names"));
+
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":joiner!a@a JOIN :#communi"));
+
+    IrcChannel* channel = model.find("#communi")->toChannel();
+    QVERIFY(channel);
+    QVERIFY(channel->findChildren<IrcUser*>().isEmpty());
+    serverSocket->waitForReadyRead(200);
+    QVERIFY(!serverSocket->readAll().contains("NAMES"));
+
+    // the names list is requested once somebody looks at it
+    IrcUserModel users(channel);
+    QVERIFY(clientSocket->waitForBytesWritten(1000));
+    QVERIFY(serverSocket->waitForReadyRead(1000));
+    QVERIFY(serverSocket->readAll().contains("NAMES #communi"));
+    QCOMPARE(users.names(), QStringList() << "joiner");
+
+    QVERIFY(waitForWritten(":irc.ser.ver 353 communi = #communi :communi @op joiner"));
+    QVERIFY(waitForWritten(":irc.ser.ver 366 communi #communi :End of /NAMES list."));
+    QCOMPARE(users.names(), QStringList() << "communi" << "joiner" << "op");
+}
+
+void tst_IrcBufferModel::testHibernate()
+{
+    IrcBufferModel model(connection);
+    QCOMPARE(model.hibernateDelay(), 0);
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":irc.ser.ver 353 communi = #communi :communi @op +voice nick"));
+    QVERIFY(waitForWritten(":irc.ser.ver 366 communi #communi :End of /NAMES list."));
+
+    IrcChannel* channel = model.find("#communi")->toChannel();
+    QVERIFY(channel);
+    QCOMPARE(channel->findChildren<IrcUser*>().count(), 4);
+
+    QScopedPointer<IrcUserModel> viewer(new IrcUserModel(channel));
+    model.setHibernateDelay(1);
+    QCOMPARE(model.hibernateDelay(), 1);
+
+    int interval = 1000;
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    interval = 250;
+    IrcBufferModelPrivate::get(&model)->setHibernateInterval(interval);
+    QVERIFY(IrcBufferModelPrivate::get(&model)->hibernateTimer.isSingleShot());
+#endif // Q_OS_LINUX
+
+    // viewed channels stay awake
+    QTest::qWait(3 * interval);
+    QCOMPARE(channel->findChildren<IrcUser*>().count(), 4);
+
+    // so do channels with recent messages
+    viewer.reset();
+    for (int i = 0; i < 6; ++i) {
+        QTest::qWait(interval / 5);
+        QVERIFY(waitForWritten(":nick!n@n PRIVMSG #communi :still here"));
+    }
+    QCOMPARE(channel->findChildren<IrcUser*>().count(), 4);
+
+    QTRY_COMPARE(channel->findChildren<IrcUser*>().count(), 0);
+#ifdef Q_OS_LINUX
+    // nothing is left to hibernate, so the next check is a full interval away
+    QCOMPARE(IrcBufferModelPrivate::get(&model)->hibernateTimer.interval(), interval);
+#endif // Q_OS_LINUX
+
+    QVERIFY(waitForWritten(":joiner!a@a JOIN :#communi"));
+    QVERIFY(waitForWritten(":op!a@a PART #communi"));
+    QVERIFY(channel->findChildren<IrcUser*>().isEmpty());
+
+    IrcUserModel users(channel);
+    QCOMPARE(users.count(), 4);
+    QCOMPARE(users.names(), QStringList() << "communi" << "joiner" << "nick" << "voice");
+    QCOMPARE(users.find("voice")->prefix(), QString("+"));
+}
+
+class SnapshotReader : public QThread
+{
+public:
+    SnapshotReader(IrcBufferModel* model) : model(model) { }
+    void run() override
+    {
+        while (!stop.loadAcquire()) {
+            const IrcSnapshot snapshot = model->snapshot();
+            foreach (const IrcChannelSnapshot& channel, snapshot.channels()) {
+                if (channel.names().count() != channel.users().count())
+                    errors.ref();
+            }
+            if (snapshot.revision() < revision)
+                errors.ref();
+            revision = snapshot.revision();
+        }
+    }
+    IrcBufferModel* model;
+    QAtomicInt stop;
+    QAtomicInt errors;
+    quint64 revision = 0;
+};
+
+void tst_IrcBufferModel::testSnapshot()
+{
+    IrcBufferModel model(connection);
+    QVERIFY(!model.isSnapshotsEnabled());
+    QVERIFY(!model.snapshot().isValid());
+
+    QSignalSpy spy(&model, SIGNAL(snapshotPublished(IrcSnapshot)));
+    QVERIFY(spy.isValid());
+
+    model.setSnapshotsEnabled(true);
+    QVERIFY(model.isSnapshotsEnabled());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+
+    SnapshotReader reader(&model);
+    reader.start();
+
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":irc.ser.ver 332 communi #communi :Hello world"));
+    QVERIFY(waitForWritten(":irc.ser.ver 353 communi = #communi :communi @op +voice nick"));
+    QVERIFY(waitForWritten(":irc.ser.ver 366 communi #communi :End of /NAMES list."));
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#freenode"));
+
+    // one snapshot per event loop pass
+    QTRY_COMPARE(spy.count(), 1);
+    IrcSnapshot snapshot = model.snapshot();
+    QVERIFY(snapshot.isValid());
+    QVERIFY(snapshot.network().isValid());
+    QCOMPARE(snapshot.network().prefixes(), connection->network()->prefixes());
+    QCOMPARE(snapshot.channels().count(), 2);
+
+    IrcChannelSnapshot communi = snapshot.channel("#COMMUNI");
+    QVERIFY(communi.isValid());
+    QVERIFY(communi.isActive());
+    QCOMPARE(communi.topic(), QString("Hello world"));
+    QCOMPARE(communi.names(), QStringList() << "communi" << "nick" << "op" << "voice");
+    QCOMPARE(communi.user("op").mode(), QString("o"));
+    QCOMPARE(communi.user("voice").title(), QString("+voice"));
+    QVERIFY(!communi.user("none").isValid());
+
+    QVERIFY(waitForWritten(":op!a@a MODE #communi +v nick"));
+    QVERIFY(waitForWritten(":voice!a@a PART #communi"));
+    QTRY_COMPARE(spy.count(), 2);
+
+    // published snapshots never change
+    QCOMPARE(communi.names(), QStringList() << "communi" << "nick" << "op" << "voice");
+    IrcSnapshot next = model.snapshot();
+    QVERIFY(next.revision() > snapshot.revision());
+    QCOMPARE(next.channel("#communi").names(), QStringList() << "communi" << "nick" << "op");
+    QCOMPARE(next.channel("#communi").user("nick").prefix(), QString("+"));
+    QVERIFY(next.channel("#freenode").isValid());
+
+    reader.stop.storeRelease(1);
+    QVERIFY(reader.wait(5000));
+    QCOMPARE(reader.errors.loadAcquire(), 0);
 }
 
 QTEST_MAIN(tst_IrcBufferModel)
@@ -10,6 +10,7 @@
 #include "ircchannel.h"
 #include <QtTest/QtTest>
 #include <QtCore/QRegExp>
+#include "ircchannel_p.h"
 
 class tst_IrcChannel : public QObject
 {
@@ -18,6 +19,7 @@ class tst_IrcChannel : public QObject
 private slots:
     void testDefaults();
     void testSignals();
+    void testMode();
     void testDebug();
 };
 
@@ -48,6 +50,31 @@ void tst_IrcChannel::testSignals()
     QVERIFY(topicSpy.isValid());
 }
 
+void tst_IrcChannel::testMode()
+{
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    IrcChannel channel;
+    QSignalSpy modeSpy(&channel, SIGNAL(modeChanged(QString)));
+    QVERIFY(modeSpy.isValid());
+
+    IrcChannelPrivate* priv = IrcChannelPrivate::get(&channel);
+    priv->setModes("+nt", QStringList());
+    QCOMPARE(channel.mode(), QString("+nt"));
+    QCOMPARE(modeSpy.count(), 1);
+    QCOMPARE(modeSpy.last().at(0).toString(), QString("+nt"));
+
+    priv->changeModes("-t+s", QStringList());
+    QCOMPARE(channel.mode(), QString("+ns"));
+    QCOMPARE(modeSpy.count(), 2);
+    QCOMPARE(modeSpy.last().at(0).toString(), QString("+ns"));
+
+    priv->setKey("secret");
+    QCOMPARE(channel.key(), QString("secret"));
+    QCOMPARE(channel.mode(), QString("+kns secret"));
+#endif // Q_OS_LINUX
+}
+
 void tst_IrcChannel::testDebug()
 {
     QString str;
@@ -28,6 +28,7 @@ private slots:
     void testConversion();
 
     void testConnection();
+    void testValue();
 
     void testAdmin();
     void testAway();
@@ -141,6 +142,44 @@ void tst_IrcCommand::testConnection()
     QVERIFY(!command.network());
 }
 
+void tst_IrcCommand::testValue()
+{
+    IrcCommandValue value;
+    QCOMPARE(value.type(), IrcCommand::Custom);
+    QVERIFY(value.parameters().isEmpty());
+    QCOMPARE(value.encoding(), QByteArray("UTF-8"));
+
+    QTest::ignoreMessage(QtWarningMsg, "IrcCommandValue::setEncoding(): unsupported encoding \"invalid\" ");
+    value.setEncoding("invalid");
+    QCOMPARE(value.encoding(), QByteArray("UTF-8"));
+
+    value = IrcCommandValue::createMessage("target", "foo bar");
+    QCOMPARE(value.type(), IrcCommand::Message);
+    QCOMPARE(value.parameters(), QStringList() << "target" << "foo bar");
+    QCOMPARE(value.toString(), QString("PRIVMSG target :foo bar"));
+
+    QScopedPointer<IrcCommand> message(IrcCommand::createMessage("target", "foo bar"));
+    QCOMPARE(value.toString(), message->toString());
+
+    QCOMPARE(IrcCommandValue::createNotice("target", "foo bar").toString(), QString("NOTICE target :foo bar"));
+    QCOMPARE(IrcCommandValue::createCtcpAction("target", "foo bar").toString(), QString("PRIVMSG target :\1ACTION foo bar\1"));
+    QCOMPARE(IrcCommandValue::createCtcpReply("target", "foo bar").toString(), QString("NOTICE target :\1foo bar\1"));
+    QCOMPARE(IrcCommandValue::createQuote("CUSTOM foo bar").toString(), QString("CUSTOM foo bar"));
+
+    value.setEncoding("ISO-8859-15");
+    QScopedPointer<IrcCommand> command(value.toCommand(this));
+    QCOMPARE(command->parent(), this);
+    QCOMPARE(command->type(), IrcCommand::Message);
+    QCOMPARE(command->parameters(), value.parameters());
+    QCOMPARE(command->encoding(), QByteArray("ISO-8859-15"));
+
+    command->setType(IrcCommand::Notice);
+    IrcCommandValue copy = IrcCommandValue::fromCommand(command.data());
+    QCOMPARE(copy.type(), IrcCommand::Notice);
+    QCOMPARE(copy.parameters(), value.parameters());
+    QCOMPARE(copy.encoding(), QByteArray("ISO-8859-15"));
+}
+
 void tst_IrcCommand::testAdmin()
 {
     QScopedPointer<IrcCommand> cmd(IrcCommand::createAdmin("server"));
@@ -570,6 +609,10 @@ void tst_IrcCommand::testDebug()
     dbg << IrcCommand::Join;
     QCOMPARE(str.trimmed(), QString::fromLatin1("Join"));
     str.clear();
+
+    dbg << IrcCommandValue::createQuote("QUIT");
+    QCOMPARE(str.trimmed(), QString::fromLatin1("IrcCommandValue(type=Quote, \"QUIT\")"));
+    str.clear();
 }
 
 QTEST_MAIN(tst_IrcCommand)
@@ -177,6 +177,21 @@ void tst_IrcCommandParser::testChannels()
     QCOMPARE(parser.channels(), QStringList());
     QCOMPARE(channelSpy.count(), 2);
     QCOMPARE(channelSpy.last().at(0).toStringList(), QStringList());
+
+    parser.addChannels(QStringList() << "#foo" << "#bar");
+    QCOMPARE(parser.channels(), QStringList() << "#foo" << "#bar");
+    QCOMPARE(channelSpy.count(), 3);
+
+    parser.addChannels(QStringList() << "#foo");
+    QCOMPARE(channelSpy.count(), 3);
+
+    parser.removeChannels(QStringList() << "#foo" << "#baz");
+    QCOMPARE(parser.channels(), QStringList() << "#bar");
+    QCOMPARE(channelSpy.count(), 4);
+    QCOMPARE(channelSpy.last().at(0).toStringList(), QStringList() << "#bar");
+
+    parser.removeChannels(QStringList() << "#baz");
+    QCOMPARE(channelSpy.count(), 4);
 }
 
 void tst_IrcCommandParser::testCommands()
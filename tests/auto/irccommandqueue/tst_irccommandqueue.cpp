@@ -28,6 +28,7 @@ private slots:
     void testClear();
     void testFlush();
     void testQuit();
+    void testCongestion();
 };
 
 void tst_IrcCommandQueue::testBatch()
@@ -144,6 +145,54 @@ void tst_IrcCommandQueue::testQuit()
     QCOMPARE(queue.size(), 0);
 }
 
+void tst_IrcCommandQueue::testCongestion()
+{
+    IrcCommandQueue queue(connection);
+    QCOMPARE(queue.highWatermark(), 0);
+    QCOMPARE(queue.lowWatermark(), 0);
+    QVERIFY(!queue.isCongested());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    QTRY_COMPARE(clientSocket->bytesToWrite(), qint64(0));
+
+    QSignalSpy congestedSpy(&queue, SIGNAL(congestedChanged(bool)));
+    QVERIFY(congestedSpy.isValid());
+
+    queue.setInterval(0);
+    queue.setHighWatermark(1);
+    QCOMPARE(queue.highWatermark(), 1);
+
+    // the socket buffer is empty -> sent right away
+    connection->sendCommand(IrcCommand::createAway());
+    QCOMPARE(queue.size(), 0);
+    QVERIFY(!queue.isCongested());
+    QVERIFY(clientSocket->bytesToWrite() > 0);
+
+    // the socket buffer has reached the high watermark -> queued
+    for (int i = 1; i <= 3; ++i) {
+        connection->sendCommand(IrcCommand::createAway());
+        QCOMPARE(queue.size(), i);
+    }
+    QVERIFY(queue.isCongested());
+    QCOMPARE(congestedSpy.count(), 1);
+    QCOMPARE(congestedSpy.last().at(0).toBool(), true);
+
+    // the socket buffer drains -> resumed until congested again
+    QTRY_COMPARE(queue.size(), 0);
+    QTRY_VERIFY(!queue.isCongested());
+    QVERIFY(congestedSpy.count() >= 2);
+    QCOMPARE(congestedSpy.last().at(0).toBool(), false);
+
+    // disabled congestion control
+    queue.setHighWatermark(0);
+    for (int i = 0; i < 3; ++i)
+        connection->sendCommand(IrcCommand::createAway());
+    QCOMPARE(queue.size(), 0);
+    QVERIFY(!queue.isCongested());
+}
+
 QTEST_MAIN(tst_IrcCommandQueue)
 
 #include "tst_irccommandqueue.moc"
@@ -0,0 +1,7 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircfiltermodel.cpp
+
+include(../auto.pri)
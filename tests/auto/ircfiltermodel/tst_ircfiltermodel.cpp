@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircfiltermodel.h"
+#include "ircbuffermodel.h"
+#include "ircusermodel.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include "ircchannel.h"
+#include "ircuser.h"
+#include "ircnetwork.h"
+#include "irc.h"
+#include <QtTest/QtTest>
+#include <QStringListModel>
+
+#ifdef Q_OS_LINUX
+#include "ircnetwork_p.h"
+#endif // Q_OS_LINUX
+
+class tst_IrcFilterModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaults();
+    void testFilter();
+    void testChanges();
+    void testSorting();
+    void testBuffers();
+    void testInsertRows();
+
+private:
+    static void receive(IrcBufferModel* model, const QByteArray& data);
+    static void names(IrcBufferModel* model, const QString& channel, const QStringList& names);
+    static QStringList rows(const IrcFilterModel& model);
+};
+
+void tst_IrcFilterModel::receive(IrcBufferModel* model, const QByteArray& data)
+{
+    IrcMessage* msg = IrcMessage::fromData(data, model->connection());
+    model->receiveMessage(msg);
+    delete msg;
+}
+
+void tst_IrcFilterModel::names(IrcBufferModel* model, const QString& channel, const QStringList& names)
+{
+    IrcNamesMessage* msg = new IrcNamesMessage(model->connection());
+    msg->setPrefix("irc.ser.ver");
+    msg->setCommand("353");
+    msg->setParameters(QStringList() << channel << names);
+    model->receiveMessage(msg);
+    delete msg;
+}
+
+QStringList tst_IrcFilterModel::rows(const IrcFilterModel& model)
+{
+    QStringList rows;
+    for (int i = 0; i < model.count(); ++i)
+        rows += model.index(i).data(Irc::NameRole).toString();
+    return rows;
+}
+
+void tst_IrcFilterModel::testDefaults()
+{
+    IrcFilterModel model;
+    QVERIFY(!model.sourceModel());
+    QVERIFY(model.filter().isEmpty());
+    QCOMPARE(model.filterRole(), Irc::NameRole);
+    QCOMPARE(model.matchFlags(), Qt::MatchFlags(Qt::MatchStartsWith));
+    QCOMPARE(model.count(), 0);
+    QCOMPARE(model.rowCount(), 0);
+    QVERIFY(!model.mapToSource(model.index(0)).isValid());
+}
+
+void tst_IrcFilterModel::testFilter()
+{
+    IrcConnection connection;
+    connection.setNickName("communi");
+    IrcBufferModel bufferModel(&connection);
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#communi");
+    names(&bufferModel, "#communi", QStringList() << "communi" << "@alice" << "+Alicia" << "bob" << "[x]" << "malice");
+
+    IrcUserModel userModel(bufferModel.find("#communi")->toChannel());
+    QCOMPARE(userModel.count(), 6);
+
+    IrcFilterModel model;
+    QSignalSpy countSpy(&model, SIGNAL(countChanged(int)));
+    QSignalSpy filterSpy(&model, SIGNAL(filterChanged(QString)));
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QVERIFY(countSpy.isValid());
+    QVERIFY(filterSpy.isValid());
+    QVERIFY(resetSpy.isValid());
+    QVERIFY(removedSpy.isValid());
+
+    model.setSourceModel(&userModel);
+    QCOMPARE(model.sourceModel(), &userModel);
+    QStringList users;
+    for (int i = 0; i < userModel.count(); ++i)
+        users += userModel.get(i)->name();
+    QCOMPARE(rows(model), users);
+    QCOMPARE(countSpy.count(), 1);
+    QCOMPARE(resetSpy.count(), 1);
+
+    // the rows keep the source order
+    model.setFilter("A");
+    QCOMPARE(model.filter(), QString("A"));
+    QCOMPARE(filterSpy.count(), 1);
+    QCOMPARE(model.count(), 2);
+    QVERIFY(rows(model).contains("alice"));
+    QVERIFY(rows(model).contains("Alicia"));
+    for (int i = 0; i < model.count(); ++i)
+        QCOMPARE(model.mapToSource(model.index(i)).data(Irc::NameRole), model.index(i).data(Irc::NameRole));
+
+    // a narrower filter only removes rows
+    removedSpy.clear();
+    model.setFilter("alic");
+    QCOMPARE(model.count(), 2);
+    model.setFilter("alice");
+    QCOMPARE(rows(model), QStringList() << "alice");
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(resetSpy.count(), 1);
+
+    // case mapping
+    model.setFilter("{X}");
+    QCOMPARE(rows(model), QStringList() << "[x]");
+
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    IrcNetworkPrivate::get(connection.network())->caseMapping = "ascii";
+    QMetaObject::invokeMethod(&model, "_irc_networkInitialized");
+    QCOMPARE(model.count(), 0);
+    model.setFilter("[X]");
+    QCOMPARE(rows(model), QStringList() << "[x]");
+    IrcNetworkPrivate::get(connection.network())->caseMapping = QString();
+    QMetaObject::invokeMethod(&model, "_irc_networkInitialized");
+#endif // Q_OS_LINUX
+
+    model.setFilter(QString());
+    QCOMPARE(model.count(), 6);
+    QCOMPARE(resetSpy.count(), 1);
+
+    model.setMatchFlags(Qt::MatchContains);
+    model.setFilter("lic");
+    QCOMPARE(model.count(), 3);
+    model.setFilter("alic");
+    QCOMPARE(model.count(), 3);
+
+    model.setMatchFlags(Qt::MatchExactly);
+    QCOMPARE(model.count(), 0);
+    model.setFilter("malice");
+    QCOMPARE(rows(model), QStringList() << "malice");
+
+    model.setMatchFlags(Qt::MatchStartsWith);
+    model.setFilterRole(Irc::TitleRole);
+    model.setFilter("@");
+    QCOMPARE(rows(model), QStringList() << "alice");
+    model.setFilter("+");
+    QCOMPARE(rows(model), QStringList() << "Alicia");
+    QCOMPARE(resetSpy.count(), 1);
+
+    model.setSourceModel(nullptr);
+    QCOMPARE(model.count(), 0);
+    QVERIFY(!model.sourceModel());
+}
+
+void tst_IrcFilterModel::testChanges()
+{
+    IrcConnection connection;
+    connection.setNickName("communi");
+    IrcBufferModel bufferModel(&connection);
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#communi");
+    names(&bufferModel, "#communi", QStringList() << "communi" << "alice" << "bob");
+
+    IrcUserModel userModel(bufferModel.find("#communi")->toChannel());
+
+    IrcFilterModel model;
+    model.setSourceModel(&userModel);
+    model.setFilter("al");
+    QCOMPARE(rows(model), QStringList() << "alice");
+
+    QSignalSpy countSpy(&model, SIGNAL(countChanged(int)));
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QVERIFY(countSpy.isValid());
+    QVERIFY(resetSpy.isValid());
+
+    receive(&bufferModel, ":albert!albert@hidd.en JOIN :#communi");
+    QCOMPARE(model.count(), 2);
+    QVERIFY(rows(model).contains("albert"));
+    QCOMPARE(countSpy.count(), 1);
+
+    receive(&bufferModel, ":carol!carol@hidd.en JOIN :#communi");
+    QCOMPARE(model.count(), 2);
+    QCOMPARE(countSpy.count(), 1);
+
+    receive(&bufferModel, ":alice!alice@hidd.en PART #communi");
+    QCOMPARE(rows(model), QStringList() << "albert");
+    QCOMPARE(countSpy.count(), 2);
+
+    receive(&bufferModel, ":bob!bob@hidd.en NICK :alfred");
+    QCOMPARE(model.count(), 2);
+    QVERIFY(rows(model).contains("alfred"));
+
+    receive(&bufferModel, ":albert!albert@hidd.en NICK :bert");
+    QCOMPARE(rows(model), QStringList() << "alfred");
+
+    foreach (const QString& name, rows(model))
+        QVERIFY(userModel.contains(name));
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void tst_IrcFilterModel::testSorting()
+{
+    IrcConnection connection;
+    connection.setNickName("communi");
+    IrcBufferModel bufferModel(&connection);
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#communi");
+    names(&bufferModel, "#communi", QStringList() << "communi" << "charlie" << "alice" << "carol" << "bob" << "clara");
+
+    IrcUserModel userModel(bufferModel.find("#communi")->toChannel());
+
+    IrcFilterModel model;
+    model.setSourceModel(&userModel);
+    model.setFilter("c");
+    QCOMPARE(model.count(), 4);
+
+    QPersistentModelIndex carol = model.index(rows(model).indexOf("carol"));
+    QVERIFY(carol.isValid());
+
+    userModel.sort(Irc::SortByName);
+    QCOMPARE(rows(model), QStringList() << "carol" << "charlie" << "clara" << "communi");
+    QCOMPARE(carol.data(Irc::NameRole).toString(), QString("carol"));
+    QCOMPARE(carol.row(), 0);
+
+    userModel.sort(Irc::SortByName, Qt::DescendingOrder);
+    QCOMPARE(rows(model), QStringList() << "communi" << "clara" << "charlie" << "carol");
+    QCOMPARE(carol.row(), 3);
+}
+
+void tst_IrcFilterModel::testBuffers()
+{
+    IrcConnection connection;
+    connection.setNickName("communi");
+    IrcBufferModel bufferModel(&connection);
+
+    IrcFilterModel model;
+    model.setSourceModel(&bufferModel);
+    model.setFilterRole(Irc::TitleRole);
+    model.setFilter("#qt");
+
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#communi");
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#qt");
+    receive(&bufferModel, ":communi!communi@hidd.en JOIN :#qt-labs");
+    QCOMPARE(model.count(), 2);
+
+    receive(&bufferModel, ":communi!communi@hidd.en PART #qt");
+    QTRY_COMPARE(model.count(), 1);
+    QCOMPARE(model.index(0).data(Irc::TitleRole).toString(), QString("#qt-labs"));
+    QCOMPARE(model.index(0).data(Irc::BufferRole).value<IrcBuffer*>(), bufferModel.find("#qt-labs"));
+
+    bufferModel.clear();
+    QCOMPARE(model.count(), 0);
+}
+
+void tst_IrcFilterModel::testInsertRows()
+{
+    QStringListModel source(QStringList() << "alice" << "bob" << "carol" << "dave");
+
+    IrcFilterModel model;
+    model.setFilterRole(static_cast<Irc::DataRole>(Qt::DisplayRole));
+    model.setSourceModel(&source);
+    model.setFilter("a");
+    QCOMPARE(model.count(), 1);
+
+    // several rows at once, in front of the existing ones
+    QVERIFY(source.insertRows(1, 3));
+    source.setData(source.index(1), "albert");
+    source.setData(source.index(2), "bert");
+    source.setData(source.index(3), "alfred");
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(model.index(0).data().toString(), QString("alice"));
+    QCOMPARE(model.index(1).data().toString(), QString("albert"));
+    QCOMPARE(model.index(2).data().toString(), QString("alfred"));
+
+    // several matching rows at once, at the end
+    source.setStringList(QStringList() << "bob" << "carol");
+    QCOMPARE(model.count(), 0);
+    QVERIFY(source.insertRows(0, 2));
+    QVERIFY(source.insertRows(4, 2));
+    source.setData(source.index(4), "ann");
+    QCOMPARE(model.count(), 1);
+    QCOMPARE(model.index(0).data().toString(), QString("ann"));
+    QCOMPARE(model.mapToSource(model.index(0)).row(), 4);
+
+    model.setFilter("b");
+    QCOMPARE(model.count(), 1);
+    QCOMPARE(model.index(0).data().toString(), QString("bob"));
+    QCOMPARE(model.mapToSource(model.index(0)).row(), 2);
+}
+
+QTEST_MAIN(tst_IrcFilterModel)
+
+#include "tst_ircfiltermodel.moc"
@@ -9,10 +9,15 @@
 
 #include "irclagtimer.h"
 #include "ircconnection.h"
+#include "ircline.h"
 #include "tst_ircclientserver.h"
 #include "tst_ircdata.h"
 #include <QtTest/QtTest>
 
+#ifdef Q_OS_LINUX
+#include "irclagtimer_p.h"
+#endif // Q_OS_LINUX
+
 class tst_IrcLagTimer : public tst_IrcClientServer
 {
     Q_OBJECT
@@ -22,6 +27,8 @@ private slots:
     void testInterval();
     void testConnection();
     void testLag();
+    void testTimeout();
+    void testAdaptive();
 };
 
 void tst_IrcLagTimer::testDefaults()
@@ -30,6 +37,8 @@ void tst_IrcLagTimer::testDefaults()
     QCOMPARE(timer.lag(), qint64(-1));
     QVERIFY(!timer.connection());
     QCOMPARE(timer.interval(), 60);
+    QCOMPARE(timer.timeout(), 0);
+    QVERIFY(!timer.isAdaptive());
 }
 
 void tst_IrcLagTimer::testInterval()
@@ -78,7 +87,11 @@ void tst_IrcLagTimer::testLag()
     QString written = QString::fromUtf8(serverSocket->readAll());
     QVERIFY(rx.indexIn(written) != -1);
 
-    waitForWritten(QString(":irc.ser.ver PONG communi communi/%1").arg(QDateTime::currentMSecsSinceEpoch() - 1234ll).toUtf8());
+    // the time stamps are on a monotonic clock, not the wall clock
+    const qint64 sent = rx.cap(1).toLongLong();
+    QVERIFY(sent < QDateTime::currentMSecsSinceEpoch() / 2);
+
+    waitForWritten(QString(":irc.ser.ver PONG communi communi/%1").arg(sent - 1234ll).toUtf8());
     QVERIFY(timer.lag() >= 1234ll);
     QCOMPARE(lagSpy.count(), ++lagCount);
     QVERIFY(lagSpy.last().at(0).toLongLong() >= 1234ll);
@@ -92,7 +105,7 @@ void tst_IrcLagTimer::testLag()
     QCOMPARE(timer.lag(), -1ll);
     QCOMPARE(lagSpy.count(), lagCount);
 
-    waitForWritten(QString(":irc.ser.ver PONG communi communi/%1").arg(QDateTime::currentMSecsSinceEpoch() - 4321ll).toUtf8());
+    waitForWritten(QString(":irc.ser.ver PONG communi communi/%1").arg(sent - 4321ll).toUtf8());
     QVERIFY(timer.lag() >= 4321ll);
     QCOMPARE(lagSpy.count(), ++lagCount);
     QVERIFY(lagSpy.last().at(0).toLongLong() >= 4321ll);
@@ -104,6 +117,110 @@ void tst_IrcLagTimer::testLag()
 #endif // QT_VERSION >= 0x040700
 }
 
+void tst_IrcLagTimer::testTimeout()
+{
+#if QT_VERSION >= 0x040700
+    IrcLagTimer timer(connection);
+    timer.setTimeout(-1);
+    QCOMPARE(timer.timeout(), 0);
+    timer.setTimeout(1);
+    QCOMPARE(timer.timeout(), 1);
+
+    QSignalSpy disconnectedSpy(connection, SIGNAL(disconnected()));
+    QVERIFY(disconnectedSpy.isValid());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+
+    // any reply keeps the connection alive
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QVERIFY(waitForWritten(":irc.ser.ver NOTICE communi :still here"));
+    QTest::qWait(1500);
+    QVERIFY(connection->isActive());
+    QCOMPARE(disconnectedSpy.count(), 0);
+
+    // silence after a ping aborts the connection
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QTRY_COMPARE_WITH_TIMEOUT(disconnectedSpy.count(), 1, 3000);
+    QVERIFY(!connection->isConnected());
+#endif // QT_VERSION >= 0x040700
+}
+
+class FirehoseHandler : public IrcLineHandler
+{
+public:
+    void lineReceived(const IrcLine&) override { ++lines; }
+    int lines = 0;
+};
+
+void tst_IrcLagTimer::testAdaptive()
+{
+#if QT_VERSION >= 0x040700 && defined(Q_OS_LINUX)
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    IrcLagTimer timer(connection);
+    timer.setInterval(10);
+    timer.setAdaptive(true);
+    QVERIFY(timer.isAdaptive());
+
+    IrcLagTimerPrivate* d = IrcLagTimerPrivate::get(&timer);
+    QVERIFY(d->timer.isSingleShot());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    QCOMPARE(d->period, 10000);
+    QVERIFY(clientSocket->waitForBytesWritten(1000));
+    serverSocket->waitForReadyRead(200);
+    serverSocket->readAll();
+
+    // traffic keeps a busy connection from being pinged
+    QVERIFY(waitForWritten(":irc.ser.ver NOTICE communi :busy"));
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QVERIFY(!serverSocket->waitForReadyRead(200));
+    QVERIFY(d->timer.isActive());
+    QVERIFY(d->timer.interval() <= 10000);
+
+    // the remainder is never shorter than the timer accuracy
+    d->received = d->clock.elapsed() - 9900;
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QCOMPARE(d->timer.interval(), 1000);
+
+    // an idle connection is probed
+    d->received = d->clock.elapsed() - 10000;
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QVERIFY(clientSocket->waitForBytesWritten(1000));
+    QVERIFY(serverSocket->waitForReadyRead(1000));
+    QRegExp rx("PING communi/(\\d+)");
+    QVERIFY(rx.indexIn(QString::fromUtf8(serverSocket->readAll())) != -1);
+    QCOMPARE(d->timer.interval(), 10000);
+
+    // a stable link backs off
+    waitForWritten(QString(":irc.ser.ver PONG communi communi/%1").arg(rx.cap(1)).toUtf8());
+    QVERIFY(timer.lag() >= 0);
+    QCOMPARE(d->period, 20000);
+
+    // an unanswered ping tightens the interval
+    d->received = d->clock.elapsed() - 20000;
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QCOMPARE(d->pendingPings, 1);
+    d->received = d->clock.elapsed() - 20000;
+    QMetaObject::invokeMethod(&timer, "_irc_pingServer");
+    QCOMPARE(d->period, 2500);
+    QCOMPARE(d->timer.interval(), 2500);
+
+    // lines delivered to the firehose bypass the message filters,
+    // but still prove that the connection is alive
+    FirehoseHandler handler;
+    connection->setFirehose(&handler);
+    d->received = d->clock.elapsed() - 20000;
+    QVERIFY(waitForWritten(":nick!user@host PRIVMSG #channel :busy"));
+    QCOMPARE(handler.lines, 1);
+    QVERIFY(d->clock.elapsed() - d->received < 20000);
+    connection->setFirehose(nullptr);
+#endif // QT_VERSION >= 0x040700 && Q_OS_LINUX
+}
+
 QTEST_MAIN(tst_IrcLagTimer)
 
 #include "tst_irclagtimer.moc"
@@ -0,0 +1,7 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircline.cpp
+
+include(../auto.pri)
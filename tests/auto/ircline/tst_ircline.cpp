@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircline.h"
+#include <QtTest/QtTest>
+
+class tst_IrcLine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaults();
+
+    void testParse_data();
+    void testParse();
+
+    void testTags();
+    void testCode();
+};
+
+void tst_IrcLine::testDefaults()
+{
+    IrcLine line;
+    QVERIFY(!line.isValid());
+    QVERIFY(line.data().isEmpty());
+    QVERIFY(line.tags().isEmpty());
+    QVERIFY(line.prefix().isEmpty());
+    QVERIFY(line.nick().isEmpty());
+    QVERIFY(line.command().isEmpty());
+    QCOMPARE(line.code(), -1);
+    QCOMPARE(line.parameterCount(), 0);
+    QVERIFY(line.parameter(0).isNull());
+    QVERIFY(line.parameters().isEmpty());
+}
+
+void tst_IrcLine::testParse_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QByteArray>("tags");
+    QTest::addColumn<QByteArray>("prefix");
+    QTest::addColumn<QByteArray>("nick");
+    QTest::addColumn<QByteArray>("command");
+    QTest::addColumn<QList<QByteArray> >("params");
+
+    QTest::newRow("empty") << QByteArray() << false << QByteArray() << QByteArray() << QByteArray() << QByteArray() << QList<QByteArray>();
+    QTest::newRow("command") << QByteArray("PING") << true << QByteArray() << QByteArray() << QByteArray() << QByteArray("PING") << QList<QByteArray>();
+    QTest::newRow("server") << QByteArray(":irc.ser.ver PONG :irc.ser.ver") << true << QByteArray() << QByteArray("irc.ser.ver") << QByteArray("irc.ser.ver") << QByteArray("PONG") << (QList<QByteArray>() << "irc.ser.ver");
+    QTest::newRow("user") << QByteArray(":nick!ident@host PRIVMSG #chan :hello world") << true << QByteArray() << QByteArray("nick!ident@host") << QByteArray("nick") << QByteArray("PRIVMSG") << (QList<QByteArray>() << "#chan" << "hello world");
+    QTest::newRow("tags") << QByteArray("@aaa=bbb;ccc :nick!ident@host JOIN #chan") << true << QByteArray("aaa=bbb;ccc") << QByteArray("nick!ident@host") << QByteArray("nick") << QByteArray("JOIN") << (QList<QByteArray>() << "#chan");
+    QTest::newRow("spaces") << QByteArray(":nick  MODE  #chan  +o  nick") << true << QByteArray() << QByteArray("nick") << QByteArray("nick") << QByteArray("MODE") << (QList<QByteArray>() << "#chan" << "+o" << "nick");
+    QTest::newRow("empty trailing") << QByteArray(":nick TOPIC #chan :") << true << QByteArray() << QByteArray("nick") << QByteArray("nick") << QByteArray("TOPIC") << (QList<QByteArray>() << "#chan" << "");
+    QTest::newRow("colon trailing") << QByteArray(":nick PRIVMSG #chan ::)") << true << QByteArray() << QByteArray("nick") << QByteArray("nick") << QByteArray("PRIVMSG") << (QList<QByteArray>() << "#chan" << ":)");
+}
+
+void tst_IrcLine::testParse()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, valid);
+    QFETCH(QByteArray, tags);
+    QFETCH(QByteArray, prefix);
+    QFETCH(QByteArray, nick);
+    QFETCH(QByteArray, command);
+    QFETCH(QList<QByteArray>, params);
+
+    IrcLine line(data);
+    QCOMPARE(line.isValid(), valid);
+    QCOMPARE(line.data(), data);
+    QCOMPARE(line.tags(), tags);
+    QCOMPARE(line.prefix(), prefix);
+    QCOMPARE(line.nick(), nick);
+    QCOMPARE(line.command(), command);
+    QCOMPARE(line.parameterCount(), params.count());
+    QCOMPARE(line.parameters(), params);
+    for (int i = 0; i < params.count(); ++i)
+        QCOMPARE(line.parameter(i), params.at(i));
+    QVERIFY(line.parameter(-1).isNull());
+    QVERIFY(line.parameter(params.count()).isNull());
+}
+
+void tst_IrcLine::testTags()
+{
+    IrcLine line("@time=2020-01-01T00:00:00.000Z;account;batch=yXNAbvnRHTRBv :nick PRIVMSG #chan :hi");
+    QCOMPARE(line.tag("time"), QByteArray("2020-01-01T00:00:00.000Z"));
+    QCOMPARE(line.tag("batch"), QByteArray("yXNAbvnRHTRBv"));
+    QVERIFY(!line.tag("account").isNull());
+    QVERIFY(line.tag("account").isEmpty());
+    QVERIFY(line.tag("acc").isNull());
+    QVERIFY(line.tag("label").isNull());
+
+    // tags are not searched past the tag section
+    QVERIFY(IrcLine(":nick PRIVMSG #chan :time=now").tag("time").isNull());
+}
+
+void tst_IrcLine::testCode()
+{
+    QCOMPARE(IrcLine(":irc.ser.ver 001 nick :Welcome").code(), 1);
+    QCOMPARE(IrcLine(":irc.ser.ver 353 nick = #chan :nick").code(), 353);
+    QCOMPARE(IrcLine(":irc.ser.ver 999 nick").code(), 999);
+    QCOMPARE(IrcLine(":nick PRIVMSG #chan :hi").code(), -1);
+    QCOMPARE(IrcLine(":irc.ser.ver 12 nick").code(), -1);
+    QCOMPARE(IrcLine(":irc.ser.ver 1234 nick").code(), -1);
+    QCOMPARE(IrcLine(":irc.ser.ver 0x1 nick").code(), -1);
+}
+
+QTEST_MAIN(tst_IrcLine)
+
+#include "tst_ircline.moc"
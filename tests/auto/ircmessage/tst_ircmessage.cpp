@@ -17,6 +17,7 @@
 
 #ifdef Q_OS_LINUX
 #include "ircmessagedecoder_p.h"
+#include "ircmessage_p.h"
 #endif // Q_OS_LINUX
 
 class tst_IrcMessage : public QObject
@@ -34,6 +35,9 @@ private slots:
     void testParameters_data();
     void testParameters();
 
+    void testRoute_data();
+    void testRoute();
+
     void testFlags();
 
     void testEncoding_data();
@@ -41,6 +45,12 @@ private slots:
 
     void testDecoder_data();
     void testDecoder();
+    void testLearnedEncoding();
+    void testLearnedEncodingThreads();
+    void testEncodingDetection();
+
+    void testLineDecode_data();
+    void testLineDecode();
 
     void testTags();
     void testServerTime();
@@ -88,6 +98,10 @@ private slots:
     void testWhoReplyMessage();
 
     void testClone();
+    void testBinary_data();
+    void testBinary();
+    void testBinaryBatch();
+    void testInvalidBinary();
     void testNullConnection();
 
     void testDebug();
@@ -198,6 +212,39 @@ void tst_IrcMessage::testParameters()
     QCOMPARE(message->parameter(5), QString("foo"));
 }
 
+void tst_IrcMessage::testRoute_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QString>("route");
+
+    QTest::newRow("join") << QByteArray(":nick!user@host JOIN #Communi") << QString("#communi");
+    QTest::newRow("part") << QByteArray(":nick!user@host PART #Communi :reason") << QString("#communi");
+    QTest::newRow("kick") << QByteArray(":nick!user@host KICK #Communi other :reason") << QString("#communi");
+    QTest::newRow("mode") << QByteArray(":nick!user@host MODE #Communi +o other") << QString("#communi");
+    QTest::newRow("topic") << QByteArray(":nick!user@host TOPIC #Communi :topic") << QString("#communi");
+    QTest::newRow("names") << QByteArray(":irc.ser.ver 353 communi = #Communi :a b c") << QString("#communi");
+    QTest::newRow("numeric") << QByteArray(":irc.ser.ver 332 communi #Communi :topic") << QString("#communi");
+    QTest::newRow("short numeric") << QByteArray(":irc.ser.ver 001 communi") << QString();
+    QTest::newRow("privmsg") << QByteArray(":nick!user@host PRIVMSG #Communi :hi") << QString();
+    QTest::newRow("quit") << QByteArray(":nick!user@host QUIT :bye") << QString();
+}
+
+void tst_IrcMessage::testRoute()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QString, route);
+
+    IrcConnection connection;
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData(data, &connection));
+    QCOMPARE(message->route(), route);
+    QCOMPARE(message->property("route").toString(), route);
+
+    // follows explicit changes
+    message->setParameters(QStringList() << "#Changed" << "#Changed" << "#Changed");
+    if (!route.isEmpty())
+        QCOMPARE(message->route(), QString("#changed"));
+}
+
 void tst_IrcMessage::testFlags()
 {
     IrcMessage msg(nullptr);
@@ -277,6 +324,150 @@ void tst_IrcMessage::testDecoder()
 #endif // Q_OS_LINUX
 }
 
+void tst_IrcMessage::testLearnedEncoding()
+{
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    const QString text = QStringLiteral("\u043f\u0440\u0438\u0432\u0435\u0442");
+    const QByteArray cp1251 = QTextCodec::codecForName("windows-1251")->fromUnicode(text);
+    const QString latin = QTextCodec::codecForName("ISO-8859-15")->toUnicode(cp1251);
+
+    IrcMessageDecoder decoder;
+    QVERIFY(decoder.learned("nick").isEmpty());
+
+    // what a source is known to send is tried first
+    decoder.learn("nick", "windows-1251");
+    QCOMPARE(decoder.learned("nick"), QByteArray("windows-1251"));
+    QCOMPARE(decoder.decode(cp1251, "ISO-8859-15", "nick"), text);
+    QCOMPARE(decoder.decode(cp1251, "ISO-8859-15"), latin);
+    QCOMPARE(decoder.decode(text.toUtf8(), "ISO-8859-15", "nick"), text);
+
+    // a learned encoding that fails is forgotten
+    decoder.learn("other", "UTF-8");
+    decoder.decode(cp1251, "ISO-8859-15", "other");
+    QVERIFY(decoder.learned("other") != "UTF-8");
+
+    decoder.learn("nick", "no-such-encoding");
+    QVERIFY(decoder.learned("nick").isEmpty());
+
+    // bounded, least recently used first out
+    decoder.learn("nick", "windows-1251");
+    for (int i = 0; i < 300; ++i) {
+        decoder.learn("source" + QByteArray::number(i), "KOI8-R");
+        QCOMPARE(decoder.decode(cp1251, "ISO-8859-15", "nick"), text);
+    }
+    QCOMPARE(decoder.learned("nick"), QByteArray("windows-1251"));
+    QVERIFY(decoder.learned("source0").isEmpty());
+    QCOMPARE(decoder.learned("source299"), QByteArray("KOI8-R"));
+#endif // Q_OS_LINUX
+}
+
+#ifdef Q_OS_LINUX
+class DecoderThread : public QThread
+{
+public:
+    DecoderThread(IrcMessageDecoder* decoder, const QByteArray& data, const QString& text)
+        : decoder(decoder), data(data), text(text) { }
+    void run() override
+    {
+        for (int i = 0; i < 1000; ++i) {
+            const QByteArray source = "source" + QByteArray::number(i % 300);
+            decoder->learn(source, "windows-1251");
+            if (decoder->decode(data, "ISO-8859-15", source) != text)
+                errors.ref();
+        }
+    }
+    IrcMessageDecoder* decoder;
+    QByteArray data;
+    QString text;
+    QAtomicInt errors;
+};
+#endif // Q_OS_LINUX
+
+void tst_IrcMessage::testLearnedEncodingThreads()
+{
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    const QString text = QStringLiteral("\u043f\u0440\u0438\u0432\u0435\u0442");
+    const QByteArray cp1251 = QTextCodec::codecForName("windows-1251")->fromUnicode(text);
+
+    IrcMessageDecoder decoder;
+    QList<DecoderThread*> threads;
+    for (int i = 0; i < 4; ++i)
+        threads += new DecoderThread(&decoder, cp1251, text);
+    foreach (DecoderThread* thread, threads)
+        thread->start();
+    foreach (DecoderThread* thread, threads) {
+        QVERIFY(thread->wait(10000));
+        QCOMPARE(thread->errors.loadAcquire(), 0);
+    }
+    qDeleteAll(threads);
+#endif // Q_OS_LINUX
+}
+
+void tst_IrcMessage::testEncodingDetection()
+{
+    const QString text = QStringLiteral("\u043f\u0440\u0438\u0432\u0435\u0442");
+    const QByteArray cp1251 = QTextCodec::codecForName("windows-1251")->fromUnicode(text);
+    const QString latin = QTextCodec::codecForName("ISO-8859-15")->toUnicode(cp1251);
+
+    IrcConnection connection;
+    QVERIFY(!connection.isEncodingDetectionEnabled());
+
+    // the configured fallback encoding is honored unless detection is enabled
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData(":nick!ident@host PRIVMSG #chan :" + cp1251, &connection));
+    message->setEncoding("ISO-8859-15");
+    QCOMPARE(message->parameters().value(1), latin);
+
+    connection.setEncodingDetectionEnabled(true);
+    QVERIFY(connection.isEncodingDetectionEnabled());
+}
+
+void tst_IrcMessage::testLineDecode_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<QString>("prefix");
+    QTest::addColumn<QString>("command");
+    QTest::addColumn<QStringList>("params");
+
+    QTest::newRow("ascii") << QByteArray("@a=b :nick!ident@host PRIVMSG #chan :hello world") << QString("nick!ident@host") << QString("PRIVMSG") << (QStringList() << "#chan" << "hello world");
+    QTest::newRow("no prefix") << QByteArray("PING :server") << QString("") << QString("PING") << (QStringList() << "server");
+    QTest::newRow("empty params") << QByteArray(":server 005 nick  :") << QString("server") << QString("005") << (QStringList() << "nick" << QString() << QString());
+    QTest::newRow("utf-8") << QStringLiteral(":nick!ident@h\u00f6st PRIVMSG #k\u00e4\u00e4k :\u00e4\u00f6 \u0434\u0430 \U0001F600 x").toUtf8()
+                           << QStringLiteral("nick!ident@h\u00f6st") << QString("PRIVMSG") << (QStringList() << QStringLiteral("#k\u00e4\u00e4k") << QStringLiteral("\u00e4\u00f6 \u0434\u0430 \U0001F600 x"));
+    QTest::newRow("utf-8 tags") << QStringLiteral("@msg=\u00e4 :n\u00e4 TOPIC #\u00e4 :\u00f6").toUtf8()
+                                << QStringLiteral("n\u00e4") << QString("TOPIC") << (QStringList() << QStringLiteral("#\u00e4") << QStringLiteral("\u00f6"));
+    QTest::newRow("latin-1") << QByteArray(":n\xe4 PRIVMSG #chan :\xe4\xf6")
+                             << QStringLiteral("n\u00e4") << QString("PRIVMSG") << (QStringList() << "#chan" << QStringLiteral("\u00e4\u00f6"));
+    QTest::newRow("mixed") << (QStringLiteral(":n\u00e4 PRIVMSG #chan :").toUtf8() + "\xe4\xf6")
+                           << QStringLiteral("n\u00e4") << QString("PRIVMSG") << (QStringList() << "#chan" << QStringLiteral("\u00e4\u00f6"));
+}
+
+void tst_IrcMessage::testLineDecode()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(QString, prefix);
+    QFETCH(QString, command);
+    QFETCH(QStringList, params);
+
+    IrcConnection connection;
+
+    // single parameters before and after all of them
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData(data, &connection));
+    for (int i = 0; i < params.count(); ++i) {
+        QCOMPARE(message->parameter(i), params.at(i));
+        QCOMPARE(message->parameter(i).isNull(), params.at(i).isNull());
+    }
+    QVERIFY(message->parameter(params.count()).isNull());
+    QVERIFY(message->parameter(-1).isNull());
+    QCOMPARE(message->prefix(), prefix);
+    QCOMPARE(message->command(), command);
+    QCOMPARE(message->parameters(), params);
+    for (int i = 0; i < params.count(); ++i)
+        QCOMPARE(message->parameter(i), params.at(i));
+    QCOMPARE(message->toData(), data);
+}
+
 void tst_IrcMessage::testTags()
 {
     QVariantMap tags;
@@ -1136,6 +1327,136 @@ void tst_IrcMessage::testClone()
     QCOMPARE(clone->account(), pm->account());
 }
 
+void tst_IrcMessage::testBinary_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("empty") << QByteArray("");
+    QTest::newRow("command") << QByteArray("PING");
+    QTest::newRow("privmsg") << QByteArray(":nick!ident@host PRIVMSG #chan :hello world");
+    QTest::newRow("empty trailing") << QByteArray(":nick!ident@host PRIVMSG #chan :");
+    QTest::newRow("colon trailing") << QByteArray(":nick!ident@host PRIVMSG #chan ::)");
+    QTest::newRow("tags") << QByteArray("@aaa=bbb;ccc;example.com/ddd=eee :nick!ident@host PRIVMSG me :Hello");
+    QTest::newRow("time") << QByteArray("@time=2011-10-19T16:40:51.620Z :Angel!angel@example.org PRIVMSG Wiz :Hello");
+    QTest::newRow("numeric") << QByteArray(":irc.ser.ver 001 nick :Welcome to the network");
+    QTest::newRow("latin1") << QByteArray(":nick!ident@host PRIVMSG #chan :caf\xe9");
+}
+
+void tst_IrcMessage::testBinary()
+{
+    QFETCH(QByteArray, data);
+
+    IrcConnection connection;
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData(data, &connection));
+    QVERIFY(message);
+    message->setEncoding("ISO-8859-15");
+
+    const QByteArray binary = message->toBinary();
+    QVERIFY(binary.startsWith("IRC"));
+
+    QScopedPointer<IrcMessage> decoded(IrcMessage::fromBinary(binary, &connection));
+    QVERIFY(decoded);
+    QCOMPARE(decoded->connection(), &connection);
+    QCOMPARE(decoded->metaObject(), message->metaObject());
+    QCOMPARE(decoded->type(), message->type());
+    QCOMPARE(decoded->flags(), message->flags());
+    QCOMPARE(decoded->encoding(), message->encoding());
+    QCOMPARE(decoded->timeStamp(), message->timeStamp());
+    QCOMPARE(decoded->tags(), message->tags());
+    QCOMPARE(decoded->prefix(), message->prefix());
+    QCOMPARE(decoded->nick(), message->nick());
+    QCOMPARE(decoded->ident(), message->ident());
+    QCOMPARE(decoded->host(), message->host());
+    QCOMPARE(decoded->command(), message->command());
+    QCOMPARE(decoded->parameters(), message->parameters());
+    QCOMPARE(decoded->isValid(), message->isValid());
+
+    // the raw line is not transferred, but formatted back on demand
+    QScopedPointer<IrcMessage> reparsed(IrcMessage::fromData(decoded->toData(), &connection));
+    QCOMPARE(reparsed->tags(), message->tags());
+    QCOMPARE(reparsed->prefix(), message->prefix());
+    QCOMPARE(reparsed->command(), message->command());
+    QCOMPARE(reparsed->parameters(), message->parameters());
+
+    // explicitly set values survive
+    message->setParameters(QStringList() << "#explicit" << "äöü");
+    message->setTag("explicit", "yes");
+    decoded.reset(IrcMessage::fromBinary(message->toBinary(), &connection));
+    QVERIFY(decoded);
+    QCOMPARE(decoded->parameters(), message->parameters());
+    QCOMPARE(decoded->tags(), message->tags());
+    QCOMPARE(decoded->toData(), message->toData());
+}
+
+void tst_IrcMessage::testBinaryBatch()
+{
+    IrcConnection connection;
+    QScopedPointer<IrcMessage> composed(new IrcNamesMessage(&connection));
+    composed->setPrefix("irc.ser.ver");
+    composed->setCommand("NAMES");
+    composed->setParameters(QStringList() << "#chan" << "a" << "b");
+
+    QScopedPointer<IrcMessage> decoded(IrcMessage::fromBinary(composed->toBinary(), &connection));
+    QVERIFY(decoded);
+    QCOMPARE(decoded->type(), IrcMessage::Names);
+    QVERIFY(qobject_cast<IrcNamesMessage*>(decoded.data()));
+    QCOMPARE(decoded->parameters(), composed->parameters());
+
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    // batched messages share the strings of the batch
+    QScopedPointer<IrcMessage> batch(IrcMessage::fromData(":irc.ser.ver BATCH +123 netsplit irc.hub other.host", &connection));
+    QList<IrcMessage*> children;
+    for (int i = 0; i < 10; ++i) {
+        IrcMessage* child = IrcMessage::fromData(QString("@batch=123 :nick%1!ident@host QUIT :irc.hub other.host").arg(i % 2).toUtf8(), &connection);
+        child->setParent(batch.data());
+        children += child;
+    }
+    IrcMessagePrivate::get(batch.data())->batch = children;
+
+    const QByteArray binary = batch->toBinary();
+    QVERIFY(binary.count("irc.hub other.host") == 1);
+    QVERIFY(binary.count("nick0!ident@host") == 1);
+
+    decoded.reset(IrcMessage::fromBinary(binary, &connection));
+    IrcBatchMessage* decodedBatch = qobject_cast<IrcBatchMessage*>(decoded.data());
+    QVERIFY(decodedBatch);
+    QCOMPARE(decodedBatch->batch(), QString("123"));
+    QCOMPARE(decodedBatch->messages().count(), 10);
+    for (int i = 0; i < 10; ++i) {
+        IrcMessage* child = decodedBatch->messages().at(i);
+        QCOMPARE(child->parent(), decoded.data());
+        QCOMPARE(child->type(), IrcMessage::Quit);
+        QCOMPARE(child->nick(), QString("nick%1").arg(i % 2));
+        QCOMPARE(child->tags(), children.at(i)->tags());
+        QCOMPARE(static_cast<IrcQuitMessage*>(child)->reason(), QString("irc.hub other.host"));
+    }
+#endif // Q_OS_LINUX
+}
+
+void tst_IrcMessage::testInvalidBinary()
+{
+    IrcConnection connection;
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData("@a=b :nick!ident@host PRIVMSG #chan :hello", &connection));
+    const QByteArray binary = message->toBinary();
+
+    QVERIFY(!IrcMessage::fromBinary(QByteArray(), &connection));
+    QVERIFY(!IrcMessage::fromBinary("IRC", &connection));
+    QVERIFY(!IrcMessage::fromBinary(message->toData(), &connection));
+
+    QByteArray version = binary;
+    version[3] = 2;
+    QVERIFY(!IrcMessage::fromBinary(version, &connection));
+
+    for (int i = 0; i < binary.length(); ++i)
+        QVERIFY(!IrcMessage::fromBinary(binary.left(i), &connection));
+    QVERIFY(!IrcMessage::fromBinary(binary + 'x', &connection));
+
+    QScopedPointer<IrcMessage> decoded(IrcMessage::fromBinary(binary, &connection));
+    QVERIFY(decoded);
+    QCOMPARE(decoded->parameters(), message->parameters());
+}
+
 void tst_IrcMessage::testNullConnection()
 {
     IrcMessage* pm = IrcMessage::fromData(":nick!ident@host PRIVMSG me :hello", nullptr);
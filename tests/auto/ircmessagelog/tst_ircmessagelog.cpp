@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircmessagelog.h"
+#include "ircbuffermodel.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include "ircbuffer.h"
+#include "tst_ircdata.h"
+#include "tst_ircclientserver.h"
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+
+static QByteArray line(int index)
+{
+    return QString(":nick!ident@host PRIVMSG #chan :line %1").arg(index).toUtf8();
+}
+
+static QDateTime stamp(int index)
+{
+    return QDateTime::fromMSecsSinceEpoch(1500000000000ll + index * 1000ll);
+}
+
+class tst_IrcMessageLog : public tst_IrcClientServer
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaults();
+    void testAppend();
+    void testLastMessages();
+    void testRange();
+    void testFind();
+    void testRotation();
+    void testReopen();
+    void testCompact();
+    void testModel();
+};
+
+void tst_IrcMessageLog::testDefaults()
+{
+    IrcMessageLog log;
+    QVERIFY(log.directory().isEmpty());
+    QVERIFY(!log.model());
+    QCOMPARE(log.segmentSize(), 32ll * 1024 * 1024);
+    QCOMPARE(log.indexInterval(), 64 * 1024);
+    QVERIFY(log.buffers().isEmpty());
+    QVERIFY(!log.append("#chan", line(0), stamp(0)));
+    QVERIFY(log.lastMessages("#chan", 10, connection).isEmpty());
+}
+
+void tst_IrcMessageLog::testAppend()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+
+    QVERIFY(!log.append("#chan", QByteArray(), stamp(0)));
+    QVERIFY(!log.append("#chan", "PRIVMSG #chan :a\r\nQUIT", stamp(0)));
+
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData(line(1), connection));
+    message->setTimeStamp(stamp(1));
+    QVERIFY(log.append("#Chan", message.data()));
+    QVERIFY(log.append("../escape", line(2), stamp(2), IrcMessage::Own));
+    log.flush();
+
+    QCOMPARE(log.buffers(), QStringList() << "#chan" << "../escape");
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Dirs | QDir::NoDotAndDotDot).count(), 2);
+
+    // plain text, one record per line
+    QFile file(dir.path() + "/%23chan/00000000.log");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray::number(stamp(1).toMSecsSinceEpoch()) + " 0 " + line(1) + "\n");
+
+    const QList<IrcMessage*> messages = log.lastMessages("../ESCAPE", 10, connection);
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.first()->toData(), line(2));
+    QCOMPARE(messages.first()->timeStamp(), stamp(2));
+    QCOMPARE(messages.first()->flags(), IrcMessage::Own);
+    qDeleteAll(messages);
+
+    // rfc1459 casemapping by default
+    QVERIFY(log.append("#[foo]", line(3), stamp(3)));
+    QVERIFY(log.append("#{FOO}", line(4), stamp(4)));
+    QCOMPARE(log.segmentCount("#[Foo]"), 1);
+    const QList<IrcMessage*> mapped = log.lastMessages("#{foo}", 10, connection);
+    QCOMPARE(mapped.count(), 2);
+    qDeleteAll(mapped);
+}
+
+void tst_IrcMessageLog::testLastMessages()
+{
+    QTemporaryDir dir;
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setSegmentSize(1024);
+
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(log.append("#chan", line(i), stamp(i)));
+    QVERIFY(log.segmentCount("#chan") > 1);
+
+    QList<IrcMessage*> messages = log.lastMessages("#chan", 30, connection);
+    QCOMPARE(messages.count(), 30);
+    for (int i = 0; i < 30; ++i) {
+        QCOMPARE(messages.at(i)->toData(), line(70 + i));
+        QCOMPARE(messages.at(i)->timeStamp(), stamp(70 + i));
+    }
+    qDeleteAll(messages);
+
+    messages = log.lastMessages("#chan", 1000, connection);
+    QCOMPARE(messages.count(), 100);
+    QCOMPARE(messages.first()->toData(), line(0));
+    qDeleteAll(messages);
+
+    QVERIFY(log.lastMessages("#other", 10, connection).isEmpty());
+}
+
+void tst_IrcMessageLog::testRange()
+{
+    QTemporaryDir dir;
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setSegmentSize(2048);
+    log.setIndexInterval(128);
+
+    for (int i = 0; i < 200; ++i)
+        QVERIFY(log.append("#chan", line(i), stamp(i)));
+
+    QList<IrcMessage*> messages = log.messages("#chan", stamp(50), stamp(59), connection);
+    QCOMPARE(messages.count(), 10);
+    for (int i = 0; i < 10; ++i)
+        QCOMPARE(messages.at(i)->toData(), line(50 + i));
+    qDeleteAll(messages);
+
+    messages = log.messages("#chan", stamp(195), QDateTime(), connection);
+    QCOMPARE(messages.count(), 5);
+    qDeleteAll(messages);
+
+    messages = log.messages("#chan", QDateTime(), stamp(4), connection);
+    QCOMPARE(messages.count(), 5);
+    qDeleteAll(messages);
+
+    QVERIFY(log.messages("#chan", stamp(300), stamp(400), connection).isEmpty());
+
+    // out of order time stamps are clamped, so the log stays ordered
+    QVERIFY(log.append("#chan", line(200), stamp(10)));
+    messages = log.messages("#chan", stamp(199), QDateTime(), connection);
+    QCOMPARE(messages.count(), 2);
+    QCOMPARE(messages.last()->toData(), line(200));
+    QCOMPARE(messages.last()->timeStamp(), stamp(199));
+    qDeleteAll(messages);
+}
+
+void tst_IrcMessageLog::testFind()
+{
+    QTemporaryDir dir;
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setSegmentSize(1024);
+
+    for (int i = 0; i < 50; ++i)
+        QVERIFY(log.append("#chan", QString("@msgid=id%1 ").arg(i).toUtf8() + line(i), stamp(i)));
+
+    QScopedPointer<IrcMessage> message(log.findMessage("#chan", "id1", connection));
+    QVERIFY(message);
+    QCOMPARE(message->tag("msgid").toString(), QString("id1"));
+    QCOMPARE(message->parameters().value(1), QString("line 1"));
+
+    message.reset(log.findMessage("#chan", "id42", connection));
+    QVERIFY(message);
+    QCOMPARE(message->parameters().value(1), QString("line 42"));
+
+    QVERIFY(!log.findMessage("#chan", "id", connection));
+    QVERIFY(!log.findMessage("#chan", "id100", connection));
+    QVERIFY(!log.findMessage("#chan", QString(), connection));
+
+    // only the msgid tag counts, not the same text elsewhere in the line
+    QVERIFY(log.append("#chan", ":nick!user@host PRIVMSG #chan :@msgid=fake", stamp(50)));
+    QVERIFY(log.append("#chan", "@+reply=fake;msgid=real :nick!user@host PRIVMSG #chan :fake", stamp(51)));
+    QVERIFY(!log.findMessage("#chan", "fake", connection));
+    message.reset(log.findMessage("#chan", "real", connection));
+    QVERIFY(message);
+    QCOMPARE(message->parameters().value(1), QString("fake"));
+
+    // the tag values are unescaped
+    QVERIFY(log.append("#chan", "@msgid=a\\:b\\sc :nick!user@host PRIVMSG #chan :escaped", stamp(52)));
+    message.reset(log.findMessage("#chan", "a;b c", connection));
+    QVERIFY(message);
+    QCOMPARE(message->parameters().value(1), QString("escaped"));
+}
+
+void tst_IrcMessageLog::testRotation()
+{
+    QTemporaryDir dir;
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setSegmentSize(500);
+
+    int lineSize = 0;
+    for (int i = 0; i < 10; ++i) {
+        QVERIFY(log.append("#chan", line(i), stamp(i)));
+        lineSize = QByteArray::number(stamp(i).toMSecsSinceEpoch()).size() + 3 + line(i).size() + 1;
+    }
+    log.flush();
+
+    const QStringList files = QDir(dir.path() + "/%23chan").entryList(QStringList("*.log"), QDir::Files, QDir::Name);
+    QCOMPARE(files.count(), log.segmentCount("#chan"));
+    QCOMPARE(files.first(), QString("00000000.log"));
+    foreach (const QString& file, files)
+        QVERIFY(QFileInfo(dir.path() + "/%23chan/" + file).size() < 500 + lineSize);
+}
+
+void tst_IrcMessageLog::testReopen()
+{
+    QTemporaryDir dir;
+    {
+        IrcMessageLog log;
+        log.setDirectory(dir.path());
+        for (int i = 0; i < 10; ++i)
+            QVERIFY(log.append("#chan", line(i), stamp(i)));
+    }
+
+    // simulate a crash in the middle of a record
+    QFile file(dir.path() + "/%23chan/00000000.log");
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+    file.write("1500000010000 0 :nick!ident@host PRIV");
+    file.close();
+
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    QCOMPARE(log.segmentCount("#chan"), 1);
+
+    // continues the same segment and time line
+    QVERIFY(log.append("#chan", line(10), stamp(5)));
+    QCOMPARE(log.segmentCount("#chan"), 1);
+
+    QList<IrcMessage*> messages = log.lastMessages("#chan", 3, connection);
+    QCOMPARE(messages.count(), 3);
+    QCOMPARE(messages.at(0)->toData(), line(9));
+    QCOMPARE(messages.at(1)->command(), QString("PRIV"));
+    QCOMPARE(messages.at(2)->toData(), line(10));
+    QCOMPARE(messages.at(2)->timeStamp(), stamp(10));
+    qDeleteAll(messages);
+}
+
+void tst_IrcMessageLog::testCompact()
+{
+    QTemporaryDir dir;
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setSegmentSize(1000);
+    log.setIndexInterval(100);
+
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(log.append("#chan", line(i), stamp(i)));
+    const int segments = log.segmentCount("#chan");
+    QVERIFY(segments > 4);
+
+    // drop whole segments before line 50
+    const int removed = log.compact("#chan", stamp(50));
+    QVERIFY(removed > 0);
+    QCOMPARE(log.segmentCount("#chan"), segments - removed);
+
+    QList<IrcMessage*> messages = log.lastMessages("#chan", 1000, connection);
+    QVERIFY(messages.count() < 100);
+    QVERIFY(messages.count() >= 50);
+    QCOMPARE(messages.last()->toData(), line(99));
+    qDeleteAll(messages);
+
+    // merge small segments, and keep the index working
+    log.setSegmentSize(100000);
+    QVERIFY(log.compact("#chan") > 0);
+    QCOMPARE(log.segmentCount("#chan"), 1);
+    messages = log.messages("#chan", stamp(80), stamp(84), connection);
+    QCOMPARE(messages.count(), 5);
+    QCOMPARE(messages.first()->toData(), line(80));
+    qDeleteAll(messages);
+
+    QCOMPARE(log.compact("#chan", stamp(1000)), 1);
+    QCOMPARE(log.segmentCount("#chan"), 0);
+}
+
+void tst_IrcMessageLog::testModel()
+{
+    QTemporaryDir dir;
+    IrcBufferModel model(connection);
+    IrcMessageLog log;
+    log.setDirectory(dir.path());
+    log.setModel(&model);
+    QCOMPARE(log.model(), &model);
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #communi :logged"));
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG communi :private"));
+
+    QList<IrcMessage*> messages = log.lastMessages("#communi", 10, connection);
+    QCOMPARE(messages.count(), 2);
+    QCOMPARE(messages.first()->type(), IrcMessage::Join);
+    QCOMPARE(messages.last()->parameters().value(1), QString("logged"));
+    qDeleteAll(messages);
+
+    messages = log.lastMessages("nick", 10, connection);
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.first()->parameters().value(1), QString("private"));
+    qDeleteAll(messages);
+
+    log.setModel(nullptr);
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #communi :not logged"));
+    messages = log.lastMessages("#communi", 10, connection);
+    QCOMPARE(messages.count(), 2);
+    qDeleteAll(messages);
+}
+
+QTEST_MAIN(tst_IrcMessageLog)
+
+#include "tst_ircmessagelog.moc"
@@ -0,0 +1,8 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircmessagering.cpp
+
+include(../shared/shared.pri)
+include(../auto.pri)
@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircmessagering.h"
+#include "ircmessage.h"
+#include "ircconnection.h"
+#include "tst_ircclientserver.h"
+#include <QtTest/QtTest>
+
+static const int MESSAGES = 1000;
+
+static QString ringKey(const QString& name)
+{
+    return QString("tst_ircmessagering_%1_%2").arg(QCoreApplication::applicationPid()).arg(name);
+}
+
+static QByteArray messageData(int index)
+{
+    return QString(":nick!ident@host PRIVMSG #channel :message %1").arg(index).toUtf8();
+}
+
+// the producer process: attaches to the ring and writes numbered messages
+static int produce(const QString& key, int count, bool retry)
+{
+    IrcConnection connection;
+    IrcMessageRing ring;
+    if (!ring.attach(key))
+        return 1;
+
+    for (int i = 0; i < count; ++i) {
+        QScopedPointer<IrcMessage> message(IrcMessage::fromData(messageData(i), &connection));
+        bool written = ring.writeMessage(message.data());
+        QElapsedTimer timer;
+        timer.start();
+        while (!written && retry && timer.elapsed() < 10000) {
+            QThread::yieldCurrentThread();
+            written = ring.writeMessage(message.data());
+        }
+        if (!written && retry)
+            return 2;
+    }
+    return 0;
+}
+
+class tst_IrcMessageRing : public tst_IrcClientServer
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaults();
+    void testCreate();
+    void testReadWrite();
+    void testOverrun();
+    void testMessages();
+    void testConnection();
+    void testProcesses();
+    void testProcessOverrun();
+
+private:
+    QProcess* startProducer(const QString& key, int count, bool retry);
+};
+
+QProcess* tst_IrcMessageRing::startProducer(const QString& key, int count, bool retry)
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("IRC_RING_PRODUCER", key);
+    env.insert("IRC_RING_COUNT", QString::number(count));
+    if (retry)
+        env.insert("IRC_RING_RETRY", "1");
+
+    QProcess* process = new QProcess(this);
+    process->setProcessEnvironment(env);
+    process->setProcessChannelMode(QProcess::ForwardedChannels);
+    process->start(QCoreApplication::applicationFilePath(), QStringList());
+    return process;
+}
+
+void tst_IrcMessageRing::testDefaults()
+{
+    IrcMessageRing ring;
+    QVERIFY(!ring.isAttached());
+    QCOMPARE(ring.capacity(), 0);
+    QCOMPARE(ring.bytesAvailable(), 0);
+    QCOMPARE(ring.bytesFree(), 0);
+    QCOMPARE(ring.overruns(), 0);
+    QCOMPARE(ring.pollInterval(), 0);
+    QVERIFY(!ring.connection());
+    QVERIFY(!ring.write("foo"));
+    QVERIFY(ring.read().isNull());
+    QVERIFY(!ring.readMessage(connection));
+}
+
+void tst_IrcMessageRing::testCreate()
+{
+    IrcMessageRing producer;
+    if (!producer.create(ringKey("create"), 1000))
+        QSKIP("Shared memory is not available");
+    QVERIFY(producer.isAttached());
+    QCOMPARE(producer.key(), ringKey("create"));
+    QCOMPARE(producer.capacity(), 1024);
+    QCOMPARE(producer.bytesFree(), 1024);
+
+    // the key is taken
+    IrcMessageRing other;
+    QVERIFY(!other.create(ringKey("create"), 1000));
+    QVERIFY(!other.attach(ringKey("nonexistent")));
+    QVERIFY(!other.isAttached());
+
+    // a foreign segment too small to hold the header
+    QSharedMemory foreign(ringKey("foreign"));
+    QVERIFY(foreign.create(4));
+    QVERIFY(!other.attach(ringKey("foreign")));
+    QVERIFY(!other.isAttached());
+
+    IrcMessageRing consumer;
+    QVERIFY(consumer.attach(ringKey("create")));
+    QCOMPARE(consumer.capacity(), 1024);
+
+    consumer.detach();
+    QVERIFY(!consumer.isAttached());
+    QCOMPARE(consumer.capacity(), 0);
+}
+
+void tst_IrcMessageRing::testReadWrite()
+{
+    IrcMessageRing producer;
+    if (!producer.create(ringKey("readwrite"), 64))
+        QSKIP("Shared memory is not available");
+    IrcMessageRing consumer;
+    QVERIFY(consumer.attach(ringKey("readwrite")));
+
+    QVERIFY(consumer.read().isNull());
+
+    // records of varying size wrap around the end of the ring many times
+    for (int i = 0; i < 200; ++i) {
+        const QByteArray data = QByteArray::number(i).repeated(i % 7 + 1);
+        QVERIFY(producer.write(data));
+        QCOMPARE(consumer.bytesAvailable(), data.size() + 4);
+        QCOMPARE(consumer.read(), data);
+        QCOMPARE(consumer.bytesAvailable(), 0);
+    }
+
+    QVERIFY(producer.write(QByteArray("")));
+    const QByteArray empty = consumer.read();
+    QVERIFY(!empty.isNull());
+    QVERIFY(empty.isEmpty());
+    QCOMPARE(producer.overruns(), 0);
+}
+
+void tst_IrcMessageRing::testOverrun()
+{
+    IrcMessageRing producer;
+    if (!producer.create(ringKey("overrun"), 64))
+        QSKIP("Shared memory is not available");
+    IrcMessageRing consumer;
+    QVERIFY(consumer.attach(ringKey("overrun")));
+
+    // never fits
+    QVERIFY(!producer.write(QByteArray(61, 'x')));
+    QCOMPARE(producer.overruns(), 1);
+    QCOMPARE(consumer.overruns(), 1);
+
+    // fills the ring exactly
+    QVERIFY(producer.write(QByteArray(28, 'a')));
+    QVERIFY(producer.write(QByteArray(28, 'b')));
+    QCOMPARE(producer.bytesFree(), 0);
+    QVERIFY(!producer.write(QByteArray()));
+    QCOMPARE(producer.overruns(), 2);
+
+    // reading makes room again
+    QCOMPARE(consumer.read(), QByteArray(28, 'a'));
+    QCOMPARE(producer.bytesFree(), 32);
+    QVERIFY(producer.write(QByteArray(28, 'c')));
+    QCOMPARE(consumer.read(), QByteArray(28, 'b'));
+    QCOMPARE(consumer.read(), QByteArray(28, 'c'));
+    QVERIFY(consumer.read().isNull());
+    QCOMPARE(consumer.overruns(), 2);
+}
+
+void tst_IrcMessageRing::testMessages()
+{
+    IrcMessageRing producer;
+    if (!producer.create(ringKey("messages"), 4096))
+        QSKIP("Shared memory is not available");
+    IrcMessageRing consumer;
+    QVERIFY(consumer.attach(ringKey("messages")));
+
+    QScopedPointer<IrcMessage> message(IrcMessage::fromData("@a=b :nick!ident@host PRIVMSG #chan :hello", connection));
+    QVERIFY(producer.writeMessage(message.data()));
+    QVERIFY(producer.write("garbage"));
+    QVERIFY(producer.writeMessage(message.data()));
+
+    QScopedPointer<IrcMessage> first(consumer.readMessage(connection));
+    QVERIFY(first);
+    QCOMPARE(first->type(), IrcMessage::Private);
+    QCOMPARE(first->tags(), message->tags());
+    QCOMPARE(first->prefix(), message->prefix());
+    QCOMPARE(first->parameters(), message->parameters());
+
+    // invalid records are skipped
+    QScopedPointer<IrcMessage> second(consumer.readMessage(connection));
+    QVERIFY(second);
+    QCOMPARE(second->parameters(), message->parameters());
+    QVERIFY(!consumer.readMessage(connection));
+}
+
+void tst_IrcMessageRing::testConnection()
+{
+    IrcMessageRing producer;
+    if (!producer.create(ringKey("connection"), 4096))
+        QSKIP("Shared memory is not available");
+    producer.setConnection(connection);
+    QCOMPARE(producer.connection(), connection.data());
+
+    IrcMessageRing consumer;
+    QVERIFY(consumer.attach(ringKey("connection")));
+    consumer.setPollInterval(1);
+    QSignalSpy readySpy(&consumer, SIGNAL(readyRead()));
+    QVERIFY(readySpy.isValid());
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #chan :published\r\n"));
+    QVERIFY(readySpy.wait());
+
+    IrcMessage* message = nullptr;
+    while (IrcMessage* msg = consumer.readMessage(connection)) {
+        if (msg->type() == IrcMessage::Private)
+            message = msg;
+    }
+    QVERIFY(message);
+    QCOMPARE(message->parameters(), QStringList() << "#chan" << "published");
+
+    producer.setConnection(nullptr);
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #chan :not published\r\n"));
+    QCOMPARE(consumer.bytesAvailable(), 0);
+}
+
+void tst_IrcMessageRing::testProcesses()
+{
+    // a small ring so that the producer has to wait for the consumer
+    IrcMessageRing consumer;
+    if (!consumer.create(ringKey("processes"), 1024))
+        QSKIP("Shared memory is not available");
+
+    QProcess* producer = startProducer(ringKey("processes"), MESSAGES, true);
+    QVERIFY(producer->waitForStarted());
+
+    int count = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (count < MESSAGES && timer.elapsed() < 20000) {
+        QScopedPointer<IrcMessage> message(consumer.readMessage(connection));
+        if (!message) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        QCOMPARE(message->toData(), messageData(count));
+        ++count;
+    }
+    QCOMPARE(count, MESSAGES);
+
+    QVERIFY(producer->waitForFinished());
+    QCOMPARE(producer->exitStatus(), QProcess::NormalExit);
+    QCOMPARE(producer->exitCode(), 0);
+    QVERIFY(consumer.read().isNull());
+}
+
+void tst_IrcMessageRing::testProcessOverrun()
+{
+    IrcMessageRing consumer;
+    if (!consumer.create(ringKey("processoverrun"), 1024))
+        QSKIP("Shared memory is not available");
+
+    // nobody reads while the producer writes without retrying
+    QProcess* producer = startProducer(ringKey("processoverrun"), MESSAGES, false);
+    QVERIFY(producer->waitForFinished());
+    QCOMPARE(producer->exitCode(), 0);
+
+    int count = 0;
+    while (IrcMessage* message = consumer.readMessage(connection)) {
+        QCOMPARE(message->toData(), messageData(count));
+        delete message;
+        ++count;
+    }
+    QVERIFY(count > 0);
+    QVERIFY(consumer.overruns() > 0);
+    QCOMPARE(count + consumer.overruns(), MESSAGES);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QString key = QString::fromLocal8Bit(qgetenv("IRC_RING_PRODUCER"));
+    if (!key.isEmpty())
+        return produce(key, qgetenv("IRC_RING_COUNT").toInt(), qEnvironmentVariableIsSet("IRC_RING_RETRY"));
+
+    tst_IrcMessageRing test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_ircmessagering.moc"
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircpipe.h"
+#include "ircmessage.h"
+#include "ircconnection.h"
+#include "tst_ircdata.h"
+#include <QtTest/QtTest>
+
+class tst_IrcPipe : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testSockets();
+    void testConnection();
+    void testRefused();
+};
+
+void tst_IrcPipe::testSockets()
+{
+    IrcPipe pipe;
+    QAbstractSocket* client = pipe.clientSocket();
+    QAbstractSocket* server = pipe.serverSocket();
+    QVERIFY(client);
+    QVERIFY(server);
+    QCOMPARE(client->state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(server->state(), QAbstractSocket::UnconnectedState);
+
+    QSignalSpy connectionSpy(&pipe, SIGNAL(newConnection()));
+    QSignalSpy connectedSpy(client, SIGNAL(connected()));
+    client->connectToHost("localhost", 6667);
+    QCOMPARE(client->state(), QAbstractSocket::ConnectingState);
+    QVERIFY(connectedSpy.wait());
+    QCOMPARE(connectionSpy.count(), 1);
+    QCOMPARE(client->state(), QAbstractSocket::ConnectedState);
+    QCOMPARE(server->state(), QAbstractSocket::ConnectedState);
+
+    // writes are delivered once per event loop pass
+    QSignalSpy readSpy(server, SIGNAL(readyRead()));
+    QSignalSpy writtenSpy(client, SIGNAL(bytesWritten(qint64)));
+    QCOMPARE(client->write("NICK communi\r\n"), qint64(14));
+    QCOMPARE(client->write("USER communi\r\n"), qint64(14));
+    QCOMPARE(client->bytesToWrite(), qint64(28));
+    QCOMPARE(readSpy.count(), 0);
+    QVERIFY(readSpy.wait());
+    QCOMPARE(readSpy.count(), 1);
+    QVERIFY(server->canReadLine());
+    QCOMPARE(server->readLine(), QByteArray("NICK communi\r\n"));
+    QCOMPARE(server->readAll(), QByteArray("USER communi\r\n"));
+    QCOMPARE(server->bytesAvailable(), qint64(0));
+
+    // until the other end reads them, the writes are queued
+    QCOMPARE(client->bytesToWrite(), qint64(0));
+    QTRY_VERIFY(!writtenSpy.isEmpty());
+    qint64 written = 0;
+    foreach (const QList<QVariant>& args, writtenSpy)
+        written += args.at(0).toLongLong();
+    QCOMPARE(written, qint64(28));
+
+    // closing one end disconnects the other
+    QSignalSpy disconnectedSpy(server, SIGNAL(disconnected()));
+    client->write("QUIT\r\n");
+    client->disconnectFromHost();
+    QCOMPARE(client->state(), QAbstractSocket::UnconnectedState);
+    QVERIFY(disconnectedSpy.wait());
+    QCOMPARE(server->state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(server->error(), QAbstractSocket::RemoteHostClosedError);
+    QCOMPARE(client->write("PING\r\n"), qint64(-1));
+
+    // and the pipe can be connected again
+    client->connectToHost("localhost", 6667);
+    QVERIFY(client->waitForConnected());
+    QCOMPARE(connectionSpy.count(), 2);
+    QCOMPARE(server->state(), QAbstractSocket::ConnectedState);
+}
+
+void tst_IrcPipe::testConnection()
+{
+    IrcPipe pipe;
+    IrcConnection connection;
+    connection.setSocket(pipe.clientSocket());
+    connection.setHost("bouncer");
+    connection.setUserName("communi");
+    connection.setNickName("communi");
+    connection.setRealName("Communi");
+    QCOMPARE(connection.socket(), pipe.clientSocket());
+    QVERIFY(!connection.isSecure());
+
+    QAbstractSocket* server = pipe.serverSocket();
+    QSignalSpy connectionSpy(&pipe, SIGNAL(newConnection()));
+    connection.open();
+    QVERIFY(connectionSpy.wait());
+
+    QTRY_VERIFY(server->canReadLine());
+    QByteArray handshake;
+    QTRY_VERIFY((handshake += server->readAll()).contains("USER communi"));
+    QVERIFY(handshake.contains("NICK communi"));
+
+    QSignalSpy messageSpy(&connection, SIGNAL(messageReceived(IrcMessage*)));
+    server->write(tst_IrcData::welcome());
+    QTRY_VERIFY(connection.isConnected());
+    QVERIFY(messageSpy.count() > 0);
+
+    server->write(":nick!user@host PRIVMSG communi :hello\r\n");
+    QSignalSpy privateSpy(&connection, SIGNAL(privateMessageReceived(IrcPrivateMessage*)));
+    QVERIFY(privateSpy.wait());
+
+    // writes reach the other end without a round trip
+    server->readAll();
+    connection.sendRaw("PRIVMSG nick :hi");
+    QCOMPARE(server->bytesAvailable(), qint64(18));
+    QCOMPARE(server->readAll(), QByteArray("PRIVMSG nick :hi\r\n"));
+
+    QSignalSpy disconnectedSpy(&connection, SIGNAL(disconnected()));
+    connection.close();
+    QCOMPARE(connection.status(), IrcConnection::Closed);
+    QTRY_COMPARE(server->state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(disconnectedSpy.count(), 1);
+}
+
+void tst_IrcPipe::testRefused()
+{
+    IrcPipe pipe;
+    QAbstractSocket* client = pipe.clientSocket();
+    QAbstractSocket* server = pipe.serverSocket();
+
+    client->connectToHost("localhost", 6667);
+    QVERIFY(client->waitForConnected());
+
+    // the server end is busy
+    server->disconnectFromHost();
+    server->connectToHost("localhost", 6667);
+    QSignalSpy errorSpy(server, SIGNAL(error(QAbstractSocket::SocketError)));
+    QVERIFY(!server->waitForConnected());
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(server->error(), QAbstractSocket::ConnectionRefusedError);
+    QCOMPARE(server->state(), QAbstractSocket::UnconnectedState);
+}
+
+QTEST_MAIN(tst_IrcPipe)
+
+#include "tst_ircpipe.moc"
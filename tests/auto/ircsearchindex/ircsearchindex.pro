@@ -0,0 +1,8 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircsearchindex.cpp
+
+include(../shared/shared.pri)
+include(../auto.pri)
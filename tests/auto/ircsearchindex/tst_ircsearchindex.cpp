@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircsearchindex.h"
+#include "ircbuffermodel.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include "ircbuffer.h"
+#include "tst_ircdata.h"
+#include "tst_ircclientserver.h"
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+
+static QDateTime stamp(int index)
+{
+    return QDateTime::fromMSecsSinceEpoch(1500000000000ll + index * 1000ll);
+}
+
+static QStringList nicks(const QList<IrcSearchResult>& results)
+{
+    QStringList nicks;
+    foreach (const IrcSearchResult& result, results)
+        nicks += result.nick();
+    return nicks;
+}
+
+class tst_IrcSearchIndex : public tst_IrcClientServer
+{
+    Q_OBJECT
+
+private slots:
+    void testDefaults();
+    void testWords();
+    void testPrefix();
+    void testPhrase();
+    void testFilters();
+    void testLimit();
+    void testMessages();
+    void testPersistence();
+    void testModel();
+    void testCasemapping();
+
+private:
+    void populate(IrcSearchIndex* index);
+};
+
+void tst_IrcSearchIndex::populate(IrcSearchIndex* index)
+{
+    QVERIFY(index->add("#communi", "alice", "Hello World", stamp(0)));
+    QVERIFY(index->add("#communi", "bob", "the \x02world\x02 says hello", stamp(1)));
+    QVERIFY(index->add("#qt", "carol", "Worldwide release of Qt", stamp(2)));
+    QVERIFY(index->add("#Qt", "dave", "hello-world example", stamp(3)));
+    QVERIFY(!index->add("#qt", "dave", "... !!! ...", stamp(4)));
+    QVERIFY(!index->add(QString(), "dave", "no buffer", stamp(4)));
+}
+
+void tst_IrcSearchIndex::testDefaults()
+{
+    IrcSearchIndex index;
+    QVERIFY(index.directory().isEmpty());
+    QVERIFY(!index.model());
+    QCOMPARE(index.documentCount(), 0);
+    QCOMPARE(index.termCount(), 0);
+    QVERIFY(index.search("hello").isEmpty());
+    QVERIFY(!index.add("#chan", nullptr));
+}
+
+void tst_IrcSearchIndex::testWords()
+{
+    IrcSearchIndex index;
+    populate(&index);
+    QCOMPARE(index.documentCount(), 4);
+
+    // most recent first, case insensitive, formatting stripped
+    QCOMPARE(nicks(index.search("hello")), QStringList() << "dave" << "bob" << "alice");
+    QCOMPARE(nicks(index.search("WORLD")), QStringList() << "dave" << "bob" << "alice");
+    QCOMPARE(nicks(index.search("hello says")), QStringList() << "bob");
+    QCOMPARE(nicks(index.search("qt")), QStringList() << "carol");
+    QVERIFY(index.search("hell").isEmpty());
+    QVERIFY(index.search("hello missing").isEmpty());
+    QVERIFY(index.search("").isEmpty());
+    QVERIFY(index.search("   ").isEmpty());
+
+    const IrcSearchResult result = index.search("release").value(0);
+    QVERIFY(result.isValid());
+    QCOMPARE(result.buffer(), QString("#qt"));
+    QCOMPARE(result.nick(), QString("carol"));
+    QCOMPARE(result.timeStamp(), stamp(2));
+}
+
+void tst_IrcSearchIndex::testPrefix()
+{
+    IrcSearchIndex index;
+    populate(&index);
+
+    QCOMPARE(nicks(index.search("world*")), QStringList() << "dave" << "carol" << "bob" << "alice");
+    QCOMPARE(nicks(index.search("worldw*")), QStringList() << "carol");
+    QCOMPARE(nicks(index.search("Rel* qt")), QStringList() << "carol");
+    QCOMPARE(nicks(index.search("hello-wor*")), QStringList() << "dave" << "bob" << "alice");
+    QVERIFY(index.search("worlds*").isEmpty());
+}
+
+void tst_IrcSearchIndex::testPhrase()
+{
+    IrcSearchIndex index;
+    populate(&index);
+
+    QCOMPARE(nicks(index.search("\"hello world\"")), QStringList() << "dave" << "alice");
+    QCOMPARE(nicks(index.search("hello-world")), QStringList() << "dave" << "alice");
+    QCOMPARE(nicks(index.search("\"world says hello\"")), QStringList() << "bob");
+    QCOMPARE(nicks(index.search("\"hello world")), QStringList() << "dave" << "alice");
+    QVERIFY(index.search("\"world hello\"").isEmpty());
+    QVERIFY(index.search("\"the hello\"").isEmpty());
+}
+
+void tst_IrcSearchIndex::testFilters()
+{
+    IrcSearchIndex index;
+    populate(&index);
+
+    QCOMPARE(nicks(index.search("hello nick:ALICE")), QStringList() << "alice");
+    QCOMPARE(nicks(index.search("hello nick:bob nick:alice")), QStringList() << "bob" << "alice");
+    QCOMPARE(nicks(index.search("world in:#QT")), QStringList() << "dave");
+    QCOMPARE(nicks(index.search("in:#communi")), QStringList() << "bob" << "alice");
+    QVERIFY(index.search("hello nick:nobody").isEmpty());
+    QVERIFY(index.search("hello in:#nowhere").isEmpty());
+
+    // rfc1459 casemapping by default
+    QVERIFY(index.add("#[foo]", "nick[a]", "mapped", stamp(4)));
+    QCOMPARE(nicks(index.search("mapped nick:NICK{A} in:#{foo}")), QStringList() << "nick[a]");
+
+    QCOMPARE(nicks(index.search("hello", stamp(1), QDateTime())), QStringList() << "dave" << "bob");
+    QCOMPARE(nicks(index.search("hello", QDateTime(), stamp(1))), QStringList() << "bob" << "alice");
+    QCOMPARE(nicks(index.search("", stamp(2), stamp(2))), QStringList() << "carol");
+}
+
+void tst_IrcSearchIndex::testLimit()
+{
+    IrcSearchIndex index;
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(index.add("#chan", QString::number(i), "spam", stamp(i)));
+
+    QCOMPARE(index.search("spam").count(), 100);
+    QCOMPARE(nicks(index.search("spam", 3)), QStringList() << "99" << "98" << "97");
+    QVERIFY(index.search("spam", 0).isEmpty());
+    QCOMPARE(index.termCount(), 1);
+}
+
+void tst_IrcSearchIndex::testMessages()
+{
+    IrcSearchIndex index;
+
+    QScopedPointer<IrcMessage> privmsg(IrcMessage::fromData(":nick!ident@host PRIVMSG #chan :\x01" "ACTION waves\x01", connection));
+    QVERIFY(index.add("#chan", privmsg.data()));
+    QScopedPointer<IrcMessage> request(IrcMessage::fromData(":nick!ident@host PRIVMSG #chan :\x01VERSION\x01", connection));
+    QVERIFY(!index.add("#chan", request.data()));
+    QScopedPointer<IrcMessage> notice(IrcMessage::fromData(":nick!ident@host NOTICE #chan :noticed", connection));
+    QVERIFY(index.add("#chan", notice.data()));
+    QScopedPointer<IrcMessage> topic(IrcMessage::fromData(":nick!ident@host TOPIC #chan :a new topic", connection));
+    QVERIFY(index.add("#chan", topic.data()));
+    QScopedPointer<IrcMessage> quit(IrcMessage::fromData(":nick!ident@host QUIT :gone fishing", connection));
+    QVERIFY(index.add("#chan", quit.data()));
+    QScopedPointer<IrcMessage> join(IrcMessage::fromData(":nick!ident@host JOIN #chan", connection));
+    QVERIFY(!index.add("#chan", join.data()));
+    QScopedPointer<IrcMessage> tagged(IrcMessage::fromData("@msgid=abc123 :nick!ident@host PRIVMSG #chan :tagged", connection));
+    QVERIFY(index.add("#chan", tagged.data()));
+
+    QCOMPARE(index.documentCount(), 5);
+    QCOMPARE(index.search("tagged").value(0).msgid(), QString("abc123"));
+    QVERIFY(index.search("waves").value(0).msgid().isEmpty());
+    QCOMPARE(nicks(index.search("waves")), QStringList() << "nick");
+    QVERIFY(index.search("action").isEmpty());
+    QCOMPARE(index.search("noticed").count(), 1);
+    QCOMPARE(index.search("\"new topic\"").count(), 1);
+    QCOMPARE(index.search("fish*").count(), 1);
+}
+
+void tst_IrcSearchIndex::testPersistence()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        IrcSearchIndex index;
+        index.setDirectory(dir.path());
+        populate(&index);
+    }
+
+    const QString path = dir.path() + "/search.idx";
+    QVERIFY(QFile::exists(path));
+
+    {
+        IrcSearchIndex index;
+        index.setDirectory(dir.path());
+        QCOMPARE(index.documentCount(), 4);
+        QCOMPARE(nicks(index.search("\"hello world\"")), QStringList() << "dave" << "alice");
+        QCOMPARE(index.search("release").value(0).timeStamp(), stamp(2));
+
+        // appends continue the loaded index
+        QVERIFY(index.add("#communi", "dave", "hello again", stamp(5), "xyz789"));
+        index.flush();
+    }
+
+    // a partial record left behind by a crash
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::Append));
+    const qint64 size = file.size();
+    file.write("D\x80");
+    file.close();
+
+    {
+        IrcSearchIndex index;
+        index.setDirectory(dir.path());
+        QCOMPARE(index.documentCount(), 5);
+        QCOMPARE(QFileInfo(path).size(), size);
+        QCOMPARE(nicks(index.search("hello again")), QStringList() << "dave");
+        QCOMPARE(index.search("hello again").value(0).msgid(), QString("xyz789"));
+        QVERIFY(index.search("release").value(0).msgid().isEmpty());
+
+        index.clear();
+        QCOMPARE(index.documentCount(), 0);
+        QVERIFY(index.search("hello").isEmpty());
+    }
+
+    {
+        IrcSearchIndex index;
+        index.setDirectory(dir.path());
+        QCOMPARE(index.documentCount(), 0);
+    }
+
+    // garbage is discarded
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write("garbage");
+    file.close();
+    QTest::ignoreMessage(QtWarningMsg, qPrintable("IrcSearchIndex: discarding an invalid index: " + path));
+
+    IrcSearchIndex index;
+    index.setDirectory(dir.path());
+    QCOMPARE(index.documentCount(), 0);
+    QVERIFY(index.add("#chan", "nick", "fresh start", stamp(0)));
+    index.setDirectory(QString());
+    QCOMPARE(index.documentCount(), 0);
+    index.setDirectory(dir.path());
+    QCOMPARE(index.documentCount(), 1);
+}
+
+void tst_IrcSearchIndex::testModel()
+{
+    IrcBufferModel model(connection);
+    IrcSearchIndex index;
+    index.setModel(&model);
+    QCOMPARE(index.model(), &model);
+
+    connection->open();
+    QVERIFY(waitForOpened());
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    QVERIFY(waitForWritten(":communi!communi@hidd.en JOIN :#communi"));
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #communi :indexed message"));
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG communi :private message"));
+
+    QList<IrcSearchResult> results = index.search("message");
+    QCOMPARE(results.count(), 2);
+    QCOMPARE(results.first().buffer(), QString("nick"));
+    QCOMPARE(results.last().buffer(), QString("#communi"));
+    QCOMPARE(results.last().nick(), QString("nick"));
+
+    index.setModel(nullptr);
+    QVERIFY(waitForWritten(":nick!ident@host PRIVMSG #communi :another message"));
+    QCOMPARE(index.search("message").count(), 2);
+}
+
+void tst_IrcSearchIndex::testCasemapping()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        IrcBufferModel model(connection);
+        IrcSearchIndex index;
+        index.setModel(&model);
+        index.setDirectory(dir.path());
+
+        connection->open();
+        QVERIFY(waitForOpened());
+        QVERIFY(waitForWritten(tst_IrcData::welcome("ircnet")));
+
+        // distinct names in CASEMAPPING=ascii
+        QVERIFY(index.add("#chan", "nick[", "one", stamp(0)));
+        QVERIFY(index.add("#chan", "nick{", "two", stamp(1)));
+        QVERIFY(index.add("#other", "dave", "three", stamp(2)));
+        QCOMPARE(index.search("nick:nick[").count(), 1);
+    }
+
+    // the same names in rfc1459 must not shift the rest of the names
+    IrcSearchIndex index;
+    index.setDirectory(dir.path());
+    QCOMPARE(index.documentCount(), 3);
+    QList<IrcSearchResult> results = index.search("three");
+    QCOMPARE(results.count(), 1);
+    QCOMPARE(results.first().buffer(), QString("#other"));
+    QCOMPARE(results.first().nick(), QString("dave"));
+    QCOMPARE(nicks(index.search("two")), QStringList() << "nick{");
+    QCOMPARE(nicks(index.search("nick:NICK[")), QStringList() << "nick{" << "nick[");
+}
+
+QTEST_MAIN(tst_IrcSearchIndex)
+
+#include "tst_ircsearchindex.moc"
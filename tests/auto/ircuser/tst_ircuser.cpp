@@ -21,6 +21,7 @@ class tst_IrcUser : public QObject
 private slots:
     void testDefaults();
     void testSignals();
+    void testTitle();
     void testDebug();
 };
 
@@ -53,6 +54,32 @@ void tst_IrcUser::testSignals()
     QVERIFY(awaySpy.isValid());
 }
 
+void tst_IrcUser::testTitle()
+{
+#ifdef Q_OS_LINUX
+    // others have problems with symbols (win) or private headers (osx frameworks)
+    IrcUser user;
+    QSignalSpy titleSpy(&user, SIGNAL(titleChanged(QString)));
+    QVERIFY(titleSpy.isValid());
+
+    IrcUserPrivate::get(&user)->setName("usr");
+    QCOMPARE(user.title(), QString("usr"));
+    QCOMPARE(titleSpy.count(), 1);
+    QCOMPARE(titleSpy.last().at(0).toString(), QString("usr"));
+
+    IrcUserPrivate::get(&user)->setPrefix("@+");
+    QCOMPARE(user.title(), QString("@usr"));
+    QCOMPARE(titleSpy.count(), 2);
+    QCOMPARE(titleSpy.last().at(0).toString(), QString("@usr"));
+
+    IrcUserPrivate::get(&user)->setName("nick");
+    QCOMPARE(user.title(), QString("@nick"));
+
+    IrcUserPrivate::get(&user)->setPrefix(QString());
+    QCOMPARE(user.title(), QString("nick"));
+#endif // Q_OS_LINUX
+}
+
 void tst_IrcUser::testDebug()
 {
     QString str;
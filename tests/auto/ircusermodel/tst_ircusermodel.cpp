@@ -40,6 +40,7 @@ public:
 private slots:
     void testDefaults();
     void testClear();
+    void testDeltas();
     void testSorting_data();
     void testSorting();
     void testActivity_freenode();
@@ -159,6 +160,63 @@ void tst_IrcUserModel::testClear()
     QVERIFY(!c);
 }
 
+void tst_IrcUserModel::testDeltas()
+{
+    IrcBufferModel bufferModel;
+    bufferModel.setConnection(connection);
+
+    connection->open();
+    QVERIFY(waitForOpened());
+
+    QVERIFY(waitForWritten(tst_IrcData::welcome()));
+    waitForWritten(":communi!communi@hidd.en JOIN :#channel");
+    QPointer<IrcChannel> channel = bufferModel.get(0)->toChannel();
+    QVERIFY(channel);
+
+    IrcUserModel userModel;
+    QSignalSpy addedSpy(&userModel, SIGNAL(namesAdded(QStringList)));
+    QSignalSpy removedSpy(&userModel, SIGNAL(namesRemoved(QStringList)));
+    QVERIFY(addedSpy.isValid());
+    QVERIFY(removedSpy.isValid());
+
+    userModel.setChannel(channel);
+    waitForWritten(":irc.ser.ver 353 communi = #channel :a @b +c");
+    waitForWritten(":irc.ser.ver 366 communi #channel :End of /NAMES list.");
+    QCOMPARE(addedSpy.count(), 1);
+    QCOMPARE(addedSpy.last().at(0).toStringList(), QStringList() << "a" << "b" << "c");
+    QCOMPARE(removedSpy.count(), 0);
+
+    // the full lists are built on demand when nobody listens to them
+    QCOMPARE(userModel.names(), QStringList() << "a" << "b" << "c");
+    QCOMPARE(userModel.titles(), QStringList() << "a" << "@b" << "+c");
+
+    waitForWritten(":d!d@hidd.en JOIN :#channel");
+    QCOMPARE(addedSpy.count(), 2);
+    QCOMPARE(addedSpy.last().at(0).toStringList(), QStringList("d"));
+    QCOMPARE(userModel.names(), QStringList() << "a" << "b" << "c" << "d");
+    QCOMPARE(userModel.titles(), QStringList() << "a" << "@b" << "+c" << "d");
+
+    waitForWritten(":a!a@hidd.en PART #channel");
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.last().at(0).toStringList(), QStringList("a"));
+    QCOMPARE(userModel.names(), QStringList() << "b" << "c" << "d");
+
+    waitForWritten(":d!d@hidd.en NICK :e");
+    QCOMPARE(removedSpy.count(), 2);
+    QCOMPARE(removedSpy.last().at(0).toStringList(), QStringList("d"));
+    QCOMPARE(addedSpy.count(), 3);
+    QCOMPARE(addedSpy.last().at(0).toStringList(), QStringList("e"));
+    QCOMPARE(userModel.names(), QStringList() << "b" << "c" << "e");
+
+    waitForWritten(":b!b@hidd.en MODE #channel -o b");
+    QCOMPARE(userModel.titles(), QStringList() << "b" << "+c" << "e");
+
+    userModel.clear();
+    QCOMPARE(removedSpy.count(), 3);
+    QCOMPARE(removedSpy.last().at(0).toStringList(), QStringList() << "b" << "c" << "e");
+    QVERIFY(userModel.titles().isEmpty());
+}
+
 void tst_IrcUserModel::testSorting_data()
 {
     QTest::addColumn<QByteArray>("welcomeData");
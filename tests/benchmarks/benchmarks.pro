@@ -4,7 +4,11 @@
 
 TEMPLATE = subdirs
 
+SUBDIRS += ircbuffermodel
+SUBDIRS += irccommand
 SUBDIRS += ircmessage
+SUBDIRS += ircmessagelog
+SUBDIRS += ircsearchindex
 SUBDIRS += irctextformat
 
 # - windows has problems with symbols
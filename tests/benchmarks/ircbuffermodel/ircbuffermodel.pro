@@ -0,0 +1,7 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircbuffermodel.cpp
+
+include(../benchmarks.pri)
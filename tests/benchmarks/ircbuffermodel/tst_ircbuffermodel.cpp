@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircbuffermodel.h"
+#include "ircusermodel.h"
+#include "ircfiltermodel.h"
+#include "ircconnection.h"
+#include "ircchannel.h"
+#include "ircmessage.h"
+#include "ircuser.h"
+#include <QtTest/QtTest>
+
+static const int CHANNELS = 500;
+static const int USERS = 200;
+
+class tst_IrcBufferModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testJoin_data();
+    void testJoin();
+    void testMemory_data();
+    void testMemory();
+    void testHibernate();
+    void testSort_data();
+    void testSort();
+    void testData_data();
+    void testData();
+    void testFilter_data();
+    void testFilter();
+
+private:
+    static void join(IrcConnection* connection, IrcBufferModel* model);
+};
+
+void tst_IrcBufferModel::join(IrcConnection* connection, IrcBufferModel* model)
+{
+    for (int c = 0; c < CHANNELS; ++c) {
+        const QString channel = QString("#channel%1").arg(c);
+
+        IrcMessage* msg = IrcMessage::fromData(":communi!communi@hidd.en JOIN :" + channel.toUtf8(), connection);
+        model->receiveMessage(msg);
+        delete msg;
+
+        QStringList names;
+        for (int u = 0; u < USERS; ++u)
+            names += QString(u % 10 ? "user%1" : "@user%1").arg(u);
+        IrcNamesMessage* namesMsg = new IrcNamesMessage(connection);
+        namesMsg->setPrefix("irc.ser.ver");
+        namesMsg->setCommand("353");
+        namesMsg->setParameters(QStringList() << channel << names);
+        model->receiveMessage(namesMsg);
+        delete namesMsg;
+    }
+}
+
+void tst_IrcBufferModel::testJoin_data()
+{
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("eager") << false;
+    QTest::newRow("lazy") << true;
+}
+
+void tst_IrcBufferModel::testJoin()
+{
+    QFETCH(bool, lazy);
+
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    QBENCHMARK {
+        IrcBufferModel model(&connection);
+        model.setLazyUsersEnabled(lazy);
+        join(&connection, &model);
+    }
+}
+
+void tst_IrcBufferModel::testMemory_data()
+{
+    QTest::addColumn<bool>("lazy");
+
+    QTest::newRow("eager") << false;
+    QTest::newRow("lazy") << true;
+}
+
+// reports the number of live IrcUser objects after joining all channels
+void tst_IrcBufferModel::testMemory()
+{
+    QFETCH(bool, lazy);
+
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    IrcBufferModel model(&connection);
+    model.setLazyUsersEnabled(lazy);
+    join(&connection, &model);
+    QCOMPARE(model.count(), CHANNELS);
+
+    // viewing a single channel creates its users only
+    IrcUserModel users(model.get(0)->toChannel());
+    QCOMPARE(users.count(), USERS);
+
+    const int objects = model.findChildren<IrcUser*>().count();
+    QCOMPARE(objects, lazy ? USERS : CHANNELS * USERS);
+    QTest::setBenchmarkResult(objects, QTest::Events);
+}
+
+// reports the number of live IrcUser objects once idle channels hibernate
+void tst_IrcBufferModel::testHibernate()
+{
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    IrcBufferModel model(&connection);
+    join(&connection, &model);
+
+    const int before = model.findChildren<IrcUser*>().count();
+    QCOMPARE(before, CHANNELS * USERS);
+
+    IrcUserModel users(model.get(0)->toChannel());
+    model.setHibernateDelay(1);
+    QTRY_VERIFY_WITH_TIMEOUT(model.findChildren<IrcUser*>().count() < before, 10000);
+
+    const int after = model.findChildren<IrcUser*>().count();
+    QCOMPARE(after, USERS);
+    QTest::setBenchmarkResult(after, QTest::Events);
+}
+
+void tst_IrcBufferModel::testSort_data()
+{
+    QTest::addColumn<int>("method");
+
+    QTest::newRow("name") << int(Irc::SortByName);
+    QTest::newRow("title") << int(Irc::SortByTitle);
+    QTest::newRow("activity") << int(Irc::SortByActivity);
+}
+
+// sorts a large channel back and forth while a view holds every row
+void tst_IrcBufferModel::testSort()
+{
+    QFETCH(int, method);
+
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    IrcBufferModel model(&connection);
+    IrcMessage* msg = IrcMessage::fromData(":communi!communi@hidd.en JOIN :#channel", &connection);
+    model.receiveMessage(msg);
+    delete msg;
+
+    QStringList names;
+    for (int u = 0; u < CHANNELS * USERS / 5; ++u)
+        names += QString(u % 10 ? "user%1" : "@user%1").arg(u);
+    IrcNamesMessage* namesMsg = new IrcNamesMessage(&connection);
+    namesMsg->setPrefix("irc.ser.ver");
+    namesMsg->setCommand("353");
+    namesMsg->setParameters(QStringList() << "#channel" << names);
+    model.receiveMessage(namesMsg);
+    delete namesMsg;
+
+    // some of the users speak up
+    for (int u = 0; u < names.count(); u += 7) {
+        msg = IrcMessage::fromData(QString(":user%1!user@hidd.en PRIVMSG #channel :hi").arg(u).toUtf8(), &connection);
+        model.receiveMessage(msg);
+        delete msg;
+    }
+
+    IrcUserModel users(model.get(0)->toChannel());
+    QCOMPARE(users.count(), names.count());
+
+    QList<IrcUser*> before;
+    QList<QPersistentModelIndex> persistent;
+    for (int i = 0; i < users.count(); ++i) {
+        before += users.get(i);
+        persistent += QPersistentModelIndex(users.index(i));
+    }
+
+    Qt::SortOrder order = Qt::AscendingOrder;
+    QBENCHMARK {
+        order = order == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder;
+        users.sort(static_cast<Irc::SortMethod>(method), order);
+    }
+
+    for (int i = 0; i < persistent.count(); ++i)
+        QCOMPARE(users.get(persistent.at(i).row()), before.at(i));
+}
+
+void tst_IrcBufferModel::testData_data()
+{
+    QTest::addColumn<int>("role");
+
+    QTest::newRow("display") << int(Qt::DisplayRole);
+    QTest::newRow("name") << int(Irc::NameRole);
+    QTest::newRow("title") << int(Irc::TitleRole);
+}
+
+// queries a role for every row the way a view does on each repaint
+void tst_IrcBufferModel::testData()
+{
+    QFETCH(int, role);
+
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    IrcBufferModel model(&connection);
+    join(&connection, &model);
+    model.setDisplayRole(Irc::TitleRole);
+
+    IrcUserModel users(model.get(0)->toChannel());
+    users.setDisplayRole(Irc::TitleRole);
+
+    QBENCHMARK {
+        for (int i = 0; i < model.count(); ++i)
+            model.index(i).data(role);
+        for (int i = 0; i < users.count(); ++i)
+            users.index(i).data(role);
+    }
+}
+
+void tst_IrcBufferModel::testFilter_data()
+{
+    QTest::addColumn<int>("flags");
+
+    QTest::newRow("prefix") << int(Qt::MatchStartsWith);
+    QTest::newRow("substring") << int(Qt::MatchContains);
+}
+
+// types a query into a search box over a large channel, one key at a time
+void tst_IrcBufferModel::testFilter()
+{
+    QFETCH(int, flags);
+
+    IrcConnection connection;
+    connection.setNickName("communi");
+
+    IrcBufferModel model(&connection);
+    IrcMessage* msg = IrcMessage::fromData(":communi!communi@hidd.en JOIN :#channel", &connection);
+    model.receiveMessage(msg);
+    delete msg;
+
+    QStringList names;
+    for (int u = 0; u < CHANNELS * USERS / 5; ++u)
+        names += QString(u % 10 ? "user%1" : "@user%1").arg(u);
+    IrcNamesMessage* namesMsg = new IrcNamesMessage(&connection);
+    namesMsg->setPrefix("irc.ser.ver");
+    namesMsg->setCommand("353");
+    namesMsg->setParameters(QStringList() << "#channel" << names);
+    model.receiveMessage(namesMsg);
+    delete namesMsg;
+
+    IrcUserModel users(model.get(0)->toChannel());
+    IrcFilterModel filter;
+    filter.setMatchFlags(Qt::MatchFlags(flags));
+    filter.setSourceModel(&users);
+
+    const QString query("user1999");
+    QBENCHMARK {
+        for (int i = 1; i <= query.length(); ++i)
+            filter.setFilter(query.left(i));
+        filter.setFilter(QString());
+    }
+}
+
+QTEST_MAIN(tst_IrcBufferModel)
+
+#include "tst_ircbuffermodel.moc"
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "irccommand.h"
+#include "ircconnection.h"
+#include "ircfilter.h"
+#include <QtTest/QtTest>
+
+static const int COMMANDS = 1000;
+
+class SinkFilter : public QObject, public IrcCommandFilter
+{
+    Q_OBJECT
+    Q_INTERFACES(IrcCommandFilter)
+
+public:
+    bool commandFilter(IrcCommand*) override { return true; }
+};
+
+class SinkValueFilter : public QObject, public IrcCommandValueFilter
+{
+    Q_OBJECT
+    Q_INTERFACES(IrcCommandValueFilter)
+
+public:
+    bool commandValueFilter(IrcCommandValue*) override { return true; }
+};
+
+class tst_IrcCommand : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testToString();
+    void testSend_data();
+    void testSend();
+};
+
+void tst_IrcCommand::testToString()
+{
+    const IrcCommandValue value = IrcCommandValue::createMessage("#communi", "Hello world!");
+    QBENCHMARK {
+        value.toString();
+    }
+}
+
+void tst_IrcCommand::testSend_data()
+{
+    QTest::addColumn<bool>("value");
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("command") << false << true;
+    QTest::newRow("value") << true << false;
+    QTest::newRow("value with legacy filter") << true << true;
+}
+
+void tst_IrcCommand::testSend()
+{
+    QFETCH(bool, value);
+    QFETCH(bool, legacy);
+
+    // the sink swallows the commands, so nothing gets queued for sending
+    IrcConnection connection;
+    SinkFilter sink;
+    SinkValueFilter valueSink;
+    if (legacy)
+        connection.installCommandFilter(&sink);
+    else
+        connection.installCommandFilter(&valueSink);
+
+    QBENCHMARK {
+        for (int i = 0; i < COMMANDS; ++i) {
+            if (value)
+                connection.sendCommand(IrcCommandValue::createMessage("#communi", "Hello world!"));
+            else
+                connection.sendCommand(IrcCommand::createMessage("#communi", "Hello world!"));
+        }
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+}
+
+QTEST_MAIN(tst_IrcCommand)
+
+#include "tst_irccommand.moc"
@@ -9,6 +9,7 @@
 
 #include "ircmessage.h"
 #include "ircconnection.h"
+#include "ircline.h"
 #include <QtTest/QtTest>
 
 static const QByteArray MSG_32_5("Vestibulum eu libero eget metus.");
@@ -24,6 +25,15 @@ class tst_IrcMessage : public QObject
 private slots:
     void testFromData_data();
     void testFromData();
+
+    void testFromBinary_data();
+    void testFromBinary();
+
+    void testAccessors_data();
+    void testAccessors();
+
+    void testLine_data();
+    void testLine();
 };
 
 void tst_IrcMessage::testFromData_data()
@@ -56,6 +66,62 @@ void tst_IrcMessage::testFromData()
     }
 }
 
+void tst_IrcMessage::testFromBinary_data()
+{
+    testFromData_data();
+}
+
+void tst_IrcMessage::testFromBinary()
+{
+    QFETCH(QByteArray, data);
+
+    IrcConnection connection;
+    IrcMessage* message = IrcMessage::fromData(":nick!ident@host PRIVMSG #channel :" + data, &connection);
+    const QByteArray binary = message->toBinary();
+    QBENCHMARK {
+        IrcMessage::fromBinary(binary, &connection);
+    }
+}
+
+void tst_IrcMessage::testAccessors_data()
+{
+    testFromData_data();
+    QTest::newRow("utf-8") << QByteArray("Hyvää päivää, добрый день, \xf0\x9f\x98\x80!");
+}
+
+void tst_IrcMessage::testAccessors()
+{
+    QFETCH(QByteArray, data);
+
+    IrcConnection connection;
+    const QByteArray line = "@time=2020-01-01T00:00:00.000Z :nick!ident@host PRIVMSG #channel :" + data;
+    QBENCHMARK {
+        QScopedPointer<IrcMessage> message(IrcMessage::fromData(line, &connection));
+        IrcPrivateMessage* privmsg = static_cast<IrcPrivateMessage*>(message.data());
+        privmsg->nick();
+        privmsg->target();
+        privmsg->content();
+    }
+}
+
+void tst_IrcMessage::testLine_data()
+{
+    testAccessors_data();
+}
+
+void tst_IrcMessage::testLine()
+{
+    QFETCH(QByteArray, data);
+
+    const QByteArray raw = "@time=2020-01-01T00:00:00.000Z :nick!ident@host PRIVMSG #channel :" + data;
+    QBENCHMARK {
+        IrcLine line(raw);
+        line.nick();
+        line.parameter(0);
+        line.parameter(1);
+    }
+}
+
 QTEST_MAIN(tst_IrcMessage)
 
 #include "tst_ircmessage.moc"
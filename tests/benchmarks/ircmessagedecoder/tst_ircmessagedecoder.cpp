@@ -25,6 +25,9 @@ class tst_IrcMessageDecoder : public QObject
 private slots:
     void testDecode_data();
     void testDecode();
+
+    void testLegacy_data();
+    void testLegacy();
 };
 
 void tst_IrcMessageDecoder::testDecode_data()
@@ -57,6 +60,55 @@ void tst_IrcMessageDecoder::testDecode()
     }
 }
 
+// mixed legacy traffic: a few senders, each in their own encoding
+void tst_IrcMessageDecoder::testLegacy_data()
+{
+    QTest::addColumn<QByteArray>("encoding");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("learn");
+
+    const QString cyrillic = QString::fromUtf8("\xd0\x9f\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82, \xd0\xba\xd0\xb0\xd0\xba \xd0\xb4\xd0\xb5\xd0\xbb\xd0\xb0? "
+                                               "\xd0\xa1\xd0\xb5\xd0\xb3\xd0\xbe\xd0\xb4\xd0\xbd\xd1\x8f \xd1\x85\xd0\xbe\xd1\x80\xd0\xbe\xd1\x88\xd0\xb0\xd1\x8f \xd0\xbf\xd0\xbe\xd0\xb3\xd0\xbe\xd0\xb4\xd0\xb0.");
+    const QString latin = QString::fromUtf8("Hyv\xc3\xa4\xc3\xa4 p\xc3\xa4iv\xc3\xa4\xc3\xa4, t\xc3\xa4n\xc3\xa4\xc3\xa4n on kaunis s\xc3\xa4\xc3\xa4 ja "
+                                            "\xc3\xa9t\xc3\xa9 \xc3\xa0 la fa\xc3\xa7on fran\xc3\xa7aise, \xc3\xbcber Stra\xc3\x9fe.");
+
+    QTest::newRow("windows-1251") << QByteArray("windows-1251") << cyrillic << false;
+    QTest::newRow("windows-1251 learned") << QByteArray("windows-1251") << cyrillic << true;
+    QTest::newRow("KOI8-R") << QByteArray("KOI8-R") << cyrillic << false;
+    QTest::newRow("KOI8-R learned") << QByteArray("KOI8-R") << cyrillic << true;
+    QTest::newRow("ISO-8859-1") << QByteArray("ISO-8859-1") << latin << false;
+    QTest::newRow("ISO-8859-1 learned") << QByteArray("ISO-8859-1") << latin << true;
+    QTest::newRow("ISO-8859-15") << QByteArray("ISO-8859-15") << latin << false;
+    QTest::newRow("ISO-8859-15 learned") << QByteArray("ISO-8859-15") << latin << true;
+}
+
+void tst_IrcMessageDecoder::testLegacy()
+{
+    QFETCH(QByteArray, encoding);
+    QFETCH(QString, text);
+    QFETCH(bool, learn);
+
+    QTextCodec* codec = QTextCodec::codecForName(encoding);
+    QVERIFY(codec);
+
+    QList<QByteArray> lines;
+    QList<QByteArray> sources;
+    for (int i = 0; i < 100; ++i) {
+        lines += codec->fromUnicode(QString::number(i) + QLatin1Char(' ') + text);
+        sources += "nick" + QByteArray::number(i % 10);
+    }
+
+    IrcMessageDecoder decoder;
+    if (learn) {
+        foreach (const QByteArray& source, sources)
+            decoder.learn(source, encoding);
+    }
+    QBENCHMARK {
+        for (int i = 0; i < lines.count(); ++i)
+            decoder.decode(lines.at(i), "ISO-8859-15", learn ? sources.at(i) : QByteArray());
+    }
+}
+
 QTEST_MAIN(tst_IrcMessageDecoder)
 
 #include "tst_ircmessagedecoder.moc"
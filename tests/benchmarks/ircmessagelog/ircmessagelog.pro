@@ -0,0 +1,7 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircmessagelog.cpp
+
+include(../benchmarks.pri)
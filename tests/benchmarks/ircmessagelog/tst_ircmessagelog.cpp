@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircmessagelog.h"
+#include "ircconnection.h"
+#include "ircmessage.h"
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+
+// IRC_LOG_LINES=10000000 for a full size log, the default keeps the run short
+static int logLines()
+{
+    const int lines = qgetenv("IRC_LOG_LINES").toInt();
+    return lines > 0 ? lines : 1000000;
+}
+
+static QDateTime stamp(int index)
+{
+    return QDateTime::fromMSecsSinceEpoch(1500000000000ll + index * 100ll);
+}
+
+class tst_IrcMessageLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testAppend();
+    void testLastMessages_data();
+    void testLastMessages();
+    void testRange();
+    void testFind();
+
+private:
+    QTemporaryDir dir;
+    IrcConnection connection;
+    IrcMessageLog log;
+    int lines = 0;
+};
+
+void tst_IrcMessageLog::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    log.setDirectory(dir.path());
+    lines = logLines();
+}
+
+void tst_IrcMessageLog::testAppend()
+{
+    const QByteArray prefix(":nick!ident@host PRIVMSG #communi :Vestibulum eu libero eget metus, ");
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < lines; ++i)
+            log.append("#communi", "@msgid=" + QByteArray::number(i) + ' ' + prefix + QByteArray::number(i), stamp(i));
+        log.flush();
+    }
+}
+
+void tst_IrcMessageLog::testLastMessages_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+void tst_IrcMessageLog::testLastMessages()
+{
+    QFETCH(int, count);
+
+    QBENCHMARK {
+        const QList<IrcMessage*> messages = log.lastMessages("#communi", count, &connection);
+        QCOMPARE(messages.count(), qMin(count, lines));
+        qDeleteAll(messages);
+    }
+}
+
+void tst_IrcMessageLog::testRange()
+{
+    // an hour in the middle of the log
+    const QDateTime from = stamp(lines / 2);
+    const QDateTime to = from.addSecs(3600);
+    QBENCHMARK {
+        const QList<IrcMessage*> messages = log.messages("#communi", from, to, &connection);
+        QVERIFY(!messages.isEmpty());
+        qDeleteAll(messages);
+    }
+}
+
+void tst_IrcMessageLog::testFind()
+{
+    const QString msgid = QString::number(lines / 2);
+    QBENCHMARK {
+        QScopedPointer<IrcMessage> message(log.findMessage("#communi", msgid, &connection));
+        QVERIFY(message);
+    }
+}
+
+QTEST_MAIN(tst_IrcMessageLog)
+
+#include "tst_ircmessagelog.moc"
@@ -0,0 +1,7 @@
+######################################################################
+# Communi
+######################################################################
+
+SOURCES += tst_ircsearchindex.cpp
+
+include(../benchmarks.pri)
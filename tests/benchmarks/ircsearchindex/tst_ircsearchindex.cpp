@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2008-2020 The Communi Project
+ *
+ * This test is free, and not covered by the BSD license. There is no
+ * restriction applied to their modification, redistribution, using and so on.
+ * You can study them, modify them, use them in your own program - either
+ * completely or partially.
+ */
+
+#include "ircsearchindex.h"
+#include <QtTest/QtTest>
+#include <QtCore/QTemporaryDir>
+
+// IRC_INDEX_LINES=10000000 for a full size index, the default keeps the run short
+static int indexLines()
+{
+    const int lines = qgetenv("IRC_INDEX_LINES").toInt();
+    return lines > 0 ? lines : 1000000;
+}
+
+static const char* const WORDS[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+    "vestibulum", "libero", "eget", "metus", "\x02" "bold\x02", "\x03" "4red\x03", "communi", "release",
+    "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et"
+};
+static const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+static QString text(int index)
+{
+    QString str;
+    quint32 seed = static_cast<quint32>(index) * 2654435761u;
+    for (int i = 0; i < 10; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        str += QLatin1String(WORDS[(seed >> 16) % WORD_COUNT]) + QLatin1Char(' ');
+    }
+    return str + QString::number(index);
+}
+
+class tst_IrcSearchIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void testAdd();
+    void testLoad();
+    void testSearch_data();
+    void testSearch();
+
+private:
+    QTemporaryDir dir;
+    IrcSearchIndex index;
+    int lines = 0;
+};
+
+void tst_IrcSearchIndex::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    index.setDirectory(dir.path());
+    lines = indexLines();
+}
+
+void tst_IrcSearchIndex::testAdd()
+{
+    const QStringList buffers = QStringList() << "#communi" << "#qt" << "#freenode" << "jpnurmi";
+    const QDateTime start = QDateTime::fromMSecsSinceEpoch(1500000000000ll);
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < lines; ++i)
+            index.add(buffers.at(i % buffers.count()), QString("nick%1").arg(i % 100), text(i), start.addMSecs(i * 100ll));
+        index.flush();
+    }
+    QCOMPARE(index.documentCount(), lines);
+}
+
+void tst_IrcSearchIndex::testLoad()
+{
+    QBENCHMARK_ONCE {
+        IrcSearchIndex loaded;
+        loaded.setDirectory(dir.path());
+        QCOMPARE(loaded.documentCount(), lines);
+    }
+}
+
+void tst_IrcSearchIndex::testSearch_data()
+{
+    QTest::addColumn<QString>("query");
+
+    QTest::newRow("word") << "communi";
+    QTest::newRow("rare") << QString::number(lines / 2);
+    QTest::newRow("words") << "communi release bold";
+    QTest::newRow("prefix") << "con*";
+    QTest::newRow("phrase") << "\"lorem ipsum dolor\"";
+    QTest::newRow("nick") << "release nick:nick42";
+    QTest::newRow("buffer") << "red in:jpnurmi";
+}
+
+void tst_IrcSearchIndex::testSearch()
+{
+    QFETCH(QString, query);
+
+    QBENCHMARK {
+        const QList<IrcSearchResult> results = index.search(query);
+        QVERIFY(!results.isEmpty());
+    }
+}
+
+QTEST_MAIN(tst_IrcSearchIndex)
+
+#include "tst_ircsearchindex.moc"